@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////
+// Benchmarks for bit field extraction
+//
+// Compares extracting one signal from a batch of messages bit by bit,
+// with the scalar extractor and with the batch extractor.
+///////////////////////////////////////////////////////////////////////
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include <can/include/bitfield.h>
+
+namespace
+{
+	constexpr std::size_t batch_size = 4096;
+
+	std::vector<can::Message> make_messages()
+	{
+		std::mt19937_64 random{ 1 };
+		std::vector<can::Message> messages(batch_size);
+		for(auto& message : messages)
+		{
+			message.set_size(8);
+			can::insert_bits(message.get_frame(), 0, 64, can::byte_order::little_endian, random());
+		}
+		return messages;
+	}
+
+	void BM_extract_bitwise(benchmark::State& state)
+	{
+		auto messages = make_messages();
+		std::vector<int64_t> values(batch_size);
+		for(auto _ : state)
+		{
+			for(std::size_t i = 0; i < batch_size; i++)
+			{
+				int64_t value = 0;
+				for(std::size_t bit = 0; bit < 12; bit++)
+					if(messages[i].get_frame().data[(bit + 19) / 8] & (1 << ((bit + 19) % 8)))
+						value |= int64_t{1} << bit;
+				values[i] = (value & 0x800) ? value - 0x1000 : value;
+			}
+			benchmark::DoNotOptimize(values.data());
+		}
+		state.SetItemsProcessed(state.iterations() * batch_size);
+	}
+	BENCHMARK(BM_extract_bitwise);
+
+	void BM_extract_scalar(benchmark::State& state)
+	{
+		auto messages = make_messages();
+		std::vector<int64_t> values(batch_size);
+		auto order = static_cast<can::byte_order>(state.range(0));
+		for(auto _ : state)
+		{
+			for(std::size_t i = 0; i < batch_size; i++)
+				values[i] = can::extract_signed(messages[i].get_frame(), 19, 12, order);
+			benchmark::DoNotOptimize(values.data());
+		}
+		state.SetItemsProcessed(state.iterations() * batch_size);
+	}
+	BENCHMARK(BM_extract_scalar)->Arg(0)->Arg(1);
+
+	void BM_extract_batch(benchmark::State& state)
+	{
+		auto messages = make_messages();
+		std::vector<int64_t> values(batch_size);
+		auto order = static_cast<can::byte_order>(state.range(0));
+		for(auto _ : state)
+		{
+			can::extract_signed(messages.data(), batch_size, 19, 12, order, values.data());
+			benchmark::DoNotOptimize(values.data());
+		}
+		state.SetItemsProcessed(state.iterations() * batch_size);
+	}
+	BENCHMARK(BM_extract_batch)->Arg(0)->Arg(1);
+}
@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////
+// Benchmarks for the candump log format
+///////////////////////////////////////////////////////////////////////
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include <logging/include/candump.h>
+
+// Parsing a line with a full classic payload
+static void BM_candump_parse_line(benchmark::State& state)
+{
+	const std::string line = "(1436509052.249713) vcan0 1F334455#1122334455667788";
+	can::logging::candump::interface_names names;
+	can::Message message;
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(can::logging::candump::parse_line(line.data(), line.data() + line.size(), message, names));
+		benchmark::DoNotOptimize(message);
+	}
+	state.SetBytesProcessed(state.iterations() * (line.size() + 1));
+}
+BENCHMARK(BM_candump_parse_line);
+
+// Formatting a line with a full classic payload
+static void BM_candump_format_line(benchmark::State& state)
+{
+	const std::string line = "(1436509052.249713) vcan0 1F334455#1122334455667788";
+	can::logging::candump::interface_names names;
+	can::Message message;
+	can::logging::candump::parse_line(line.data(), line.data() + line.size(), message, names);
+
+	char buffer[can::logging::candump::max_line_length];
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(can::logging::candump::format_line(message, names, buffer));
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(state.iterations() * (line.size() + 1));
+}
+BENCHMARK(BM_candump_format_line);
+
+// Decoding 8 bytes of hex payload
+static void BM_candump_decode_hex(benchmark::State& state)
+{
+	const char text[] = "1122334455667788";
+	uint8_t bytes[8];
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(can::logging::candump::decode_hex(text, 8, bytes));
+		benchmark::DoNotOptimize(bytes);
+	}
+}
+BENCHMARK(BM_candump_decode_hex);
@@ -0,0 +1,155 @@
+///////////////////////////////////////////////////////////////////////
+// Benchmarks for the CANOpen helpers
+//
+// Measures building frames with the canopen.h templates, encoding and
+// decoding expedited SDO transfers, and classifying received frames
+// with the predicates and software filters. The node IDs and indices
+// vary per iteration, so the constexpr helpers are measured at run
+// time rather than folded away.
+///////////////////////////////////////////////////////////////////////
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include <can/include/canopen.h>
+
+namespace
+{
+	// Expedited SDO traffic of all nodes, both directions
+	std::vector<can_frame> sdo_frames()
+	{
+		std::mt19937 random(7);
+		std::vector<can_frame> frames(4096);
+		for(auto& frame : frames)
+		{
+			auto node = static_cast<canopen::id_type>(random() % 127 + 1);
+			auto index = static_cast<canopen::index_type>(0x1000 + random() % 0x5000);
+			auto data = canopen::map_to_data<4>(static_cast<uint32_t>(random()));
+			frame = (random() & 1) ? canopen::message_sdo_request(node, canopen::as_data(canopen::sdo_type::write_4bytes), index, 1, data)
+								   : canopen::message_sdo_response(node, 0x43, index, 1, data);
+		}
+		return frames;
+	}
+
+	// Random traffic across the whole 11-bit ID range
+	std::vector<can_frame> mixed_frames()
+	{
+		std::mt19937 random(42);
+		std::vector<can_frame> frames(4096);
+		for(auto& frame : frames)
+		{
+			frame = can_frame{};
+			frame.can_id = random() & CAN_SFF_MASK;
+			frame.len = 8;
+		}
+		return frames;
+	}
+}
+
+// --------------------------------------------------------------------
+// Frame construction
+// --------------------------------------------------------------------
+static void BM_build_sdo_request(benchmark::State& state)
+{
+	uint32_t value = 0;
+	for(auto _ : state)
+	{
+		auto node = static_cast<canopen::id_type>(value % 127 + 1);
+		auto frame = canopen::message_sdo_request(node, canopen::as_data(canopen::sdo_type::write_4bytes),
+			static_cast<canopen::index_type>(0x2000 + (value & 0xFF)), 1, canopen::map_to_data<4>(value));
+		benchmark::DoNotOptimize(frame);
+		value++;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_build_sdo_request);
+
+static void BM_build_nmt(benchmark::State& state)
+{
+	canopen::id_type node = 1;
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(canopen::message_nmt<canopen::nmt_type::command_operational>(node));
+		node = static_cast<canopen::id_type>(node % 127 + 1);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_build_nmt);
+
+// Frame construction including the message wrapping it, as handed to an interface
+static void BM_build_message(benchmark::State& state)
+{
+	uint16_t code = 0;
+	for(auto _ : state)
+	{
+		can::Message message(canopen::message_emcy(static_cast<canopen::id_type>(code % 127 + 1), code, 0x01));
+		benchmark::DoNotOptimize(message);
+		code++;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_build_message);
+
+// --------------------------------------------------------------------
+// SDO encoding / decoding
+// --------------------------------------------------------------------
+static void BM_sdo_encode_expedited(benchmark::State& state)
+{
+	auto frames = sdo_frames();
+	std::size_t i = 0;
+	for(auto _ : state)
+	{
+		const auto& request = frames[i++ % frames.size()];
+		auto response = canopen::message_sdo_response(canopen::get_id(request), 0x60,
+			canopen::get_sdo_cobid(request), canopen::get_sdo_subindex(request));
+		benchmark::DoNotOptimize(response);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_sdo_encode_expedited);
+
+static void BM_sdo_decode_expedited(benchmark::State& state)
+{
+	auto frames = sdo_frames();
+	std::size_t i = 0;
+	for(auto _ : state)
+	{
+		const auto& frame = frames[i++ % frames.size()];
+		benchmark::DoNotOptimize(canopen::get_sdo_function_code(frame));
+		benchmark::DoNotOptimize(canopen::get_sdo_cobid(frame));
+		benchmark::DoNotOptimize(canopen::get_sdo_subindex(frame));
+		benchmark::DoNotOptimize(canopen::map_from_data<uint32_t>(std::array<canopen::data_type,4>{{ frame.data[4], frame.data[5], frame.data[6], frame.data[7] }}));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_sdo_decode_expedited);
+
+// --------------------------------------------------------------------
+// Classification
+// --------------------------------------------------------------------
+// Picking the SDO responses of one node out of random traffic, as an SDO client does
+static void BM_classify_sdo_response(benchmark::State& state)
+{
+	auto frames = mixed_frames();
+	std::size_t i = 0;
+	for(auto _ : state)
+	{
+		const auto& frame = frames[i++ % frames.size()];
+		benchmark::DoNotOptimize(canopen::is_sdo_response(frame) && canopen::get_id(frame) == 5);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_classify_sdo_response);
+
+// Software filtering with a combined filter set, as applied when kernel filters are not available
+static void BM_classify_filter_set(benchmark::State& state)
+{
+	constexpr auto filters = canopen::combine(canopen::filter_sdo_response(5), canopen::filter_emcy(), canopen::filter_nmt(), canopen::filter_tpdo<1>());
+	auto frames = mixed_frames();
+	std::size_t i = 0;
+	for(auto _ : state)
+		benchmark::DoNotOptimize(canopen::passes_filter(frames[i++ % frames.size()], filters));
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_classify_filter_set);
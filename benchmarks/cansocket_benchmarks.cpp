@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////
+// Benchmarks for the CAN socket interface
+//
+// Round trips over a virtual bus: frames sent on one socket and
+// received on another, single frames and batches. The benchmarks are
+// skipped, reporting an error, unless a "vcan0" device exists:
+// sudo ip link add dev vcan0 type vcan
+// sudo ifconfig vcan0 up
+///////////////////////////////////////////////////////////////////////
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include <can/include/canopen.h>
+#include <interfaces/include/CANSocket.h>
+
+namespace
+{
+	// Connects a sender and a receiver - returns false (and skips the benchmark) without vcan0
+	bool connect(benchmark::State& state, can::interfaces::CANSocket& sender, can::interfaces::CANSocket& receiver)
+	{
+		if(!sender.Connect("vcan0") || !receiver.Connect("vcan0"))
+		{
+			state.SkipWithError("vcan0 is not available");
+			return false;
+		}
+
+		receiver.SetBlockingMode(true);
+		return true;
+	}
+}
+
+static void BM_vcan_round_trip(benchmark::State& state)
+{
+	can::interfaces::CANSocket sender;
+	can::interfaces::CANSocket receiver;
+	if(!connect(state, sender, receiver))
+		return;
+
+	can::Message message(canopen::message_sdo_request(5, 0x40, 0x1000, 0));
+	can::Message received;
+	for(auto _ : state)
+	{
+		if(!sender.SendMessage(message) || !receiver.RequestMessage(received))
+		{
+			state.SkipWithError("round trip failed");
+			break;
+		}
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_vcan_round_trip)->UseRealTime();
+
+// Batches sent with sendmmsg and received with recvmmsg
+static void BM_vcan_round_trip_batch(benchmark::State& state)
+{
+	can::interfaces::CANSocket sender;
+	can::interfaces::CANSocket receiver;
+	if(!connect(state, sender, receiver))
+		return;
+
+	std::vector<can::Message> messages(state.range(0), can::Message(canopen::message_sdo_request(5, 0x40, 0x1000, 0)));
+	std::vector<can::Message> received(messages.size());
+	for(auto _ : state)
+	{
+		if(sender.SendMessages(messages.data(), messages.size()) != messages.size())
+		{
+			state.SkipWithError("sending failed");
+			break;
+		}
+
+		std::size_t total = 0;
+		while(total < received.size())
+			total += receiver.RequestMessages(received.data() + total, received.size() - total);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_vcan_round_trip_batch)->Arg(16)->Arg(64)->UseRealTime();
@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////
+// Benchmarks for the DBC database
+//
+// Loads a generated DBC of about 5 MB, and decodes frames of a mix of
+// its messages into physical values.
+///////////////////////////////////////////////////////////////////////
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <can/include/dbc.h>
+
+namespace
+{
+	constexpr std::size_t message_count = 2000;
+	constexpr std::size_t signals_per_message = 30;
+
+	// Generates messages with 8 byte signals and assorted layouts, plus comments
+	std::string make_dbc()
+	{
+		std::string text = "VERSION \"\"\n\nBU_: ECU\n\n";
+		for(std::size_t i = 0; i < message_count; i++)
+		{
+			auto id = (i < CAN_SFF_MASK) ? i : (0x80000000 | (0x10000 + i));
+			text += "BO_ " + std::to_string(id) + " Message" + std::to_string(i) + ": 8 ECU\n";
+			for(std::size_t j = 0; j < signals_per_message; j++)
+			{
+				auto start = (j * 7) % 56;
+				auto order = (j % 3 == 0) ? "@0" : "@1";
+				auto sign = (j % 2 == 0) ? "-" : "+";
+				if(j % 3 == 0)
+					start = start / 8 * 8 + 7;
+				text += " SG_ Signal" + std::to_string(i) + "_" + std::to_string(j) + " : " + std::to_string(start) + "|8" + order + sign
+					+ " (0.125,-40) [-56|-8.125] \"unit\" Vector__XXX\n";
+			}
+			text += "\n";
+		}
+		for(std::size_t i = 0; i < message_count; i++)
+			text += "CM_ BO_ " + std::to_string(i) + " \"Comment of message " + std::to_string(i) + " spanning\na second line\";\n";
+		return text;
+	}
+
+	void BM_dbc_load(benchmark::State& state)
+	{
+		auto text = make_dbc();
+		for(auto _ : state)
+		{
+			can::dbc::database database;
+			database.parse(text);
+			benchmark::DoNotOptimize(database.messages().data());
+		}
+		state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+	}
+	BENCHMARK(BM_dbc_load)->Unit(benchmark::kMillisecond);
+
+	void BM_dbc_decode(benchmark::State& state)
+	{
+		can::dbc::database database;
+		database.parse(make_dbc());
+
+		// Frames with random data of a mix of messages
+		std::mt19937 random{ 3 };
+		std::vector<can::Message> messages(1024);
+		for(auto& message : messages)
+		{
+			message.set_id(database.messages()[random() % 64].id);
+			message.set_size(8);
+			for(int i = 0; i < 8; i++)
+				message[i] = static_cast<uint8_t>(random());
+		}
+
+		std::vector<double> values(signals_per_message);
+		std::size_t i = 0;
+		for(auto _ : state)
+		{
+			benchmark::DoNotOptimize(database.decode(messages[i++ % messages.size()], values.data()));
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+	BENCHMARK(BM_dbc_decode);
+}
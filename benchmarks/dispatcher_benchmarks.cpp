@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////
+// Benchmarks for frame classification and dispatch
+//
+// Compares classifying frames by running the canopen.h predicates one
+// after another with the function code table, and dispatching through
+// the dispatcher.
+///////////////////////////////////////////////////////////////////////
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include <can/include/dispatcher.h>
+
+namespace
+{
+	// Random traffic across the whole 11-bit ID range
+	std::vector<can::Message> test_messages()
+	{
+		std::mt19937 random(42);
+		std::vector<can::Message> messages(4096);
+		for(auto& message : messages)
+			message.set_id(random() & CAN_SFF_MASK);
+		return messages;
+	}
+
+	canopen::function_code classify_chained(const can_frame& msg)
+	{
+		if(canopen::is_lss(msg)) return canopen::function_code::lss;
+		if(canopen::is_nmt(msg)) return (msg.can_id == 0) ? canopen::function_code::nmt : canopen::function_code::heartbeat;
+		if(canopen::is_emcy(msg)) return (msg.can_id == 0x80) ? canopen::function_code::sync : canopen::function_code::emcy;
+		if(canopen::is_tpdo<1>(msg)) return canopen::function_code::tpdo1;
+		if(canopen::is_tpdo<2>(msg)) return canopen::function_code::tpdo2;
+		if(canopen::is_tpdo<3>(msg)) return canopen::function_code::tpdo3;
+		if(canopen::is_tpdo<4>(msg)) return canopen::function_code::tpdo4;
+		if(canopen::is_rpdo<1>(msg)) return canopen::function_code::rpdo1;
+		if(canopen::is_rpdo<2>(msg)) return canopen::function_code::rpdo2;
+		if(canopen::is_rpdo<3>(msg)) return canopen::function_code::rpdo3;
+		if(canopen::is_rpdo<4>(msg)) return canopen::function_code::rpdo4;
+		if(canopen::is_sdo_response(msg)) return canopen::function_code::sdo_response;
+		if(canopen::is_sdo_request(msg)) return canopen::function_code::sdo_request;
+		return canopen::function_code::unknown;
+	}
+}
+
+static void BM_classify_chained(benchmark::State& state)
+{
+	auto messages = test_messages();
+	std::size_t i = 0;
+	for(auto _ : state)
+		benchmark::DoNotOptimize(classify_chained(messages[i++ % messages.size()].get_frame()));
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_classify_chained);
+
+static void BM_classify_table(benchmark::State& state)
+{
+	auto messages = test_messages();
+	std::size_t i = 0;
+	for(auto _ : state)
+		benchmark::DoNotOptimize(canopen::get_function_code(messages[i++ % messages.size()].get_frame()));
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_classify_table);
+
+static void BM_dispatch_batch(benchmark::State& state)
+{
+	auto messages = test_messages();
+	uint64_t counts[4] = {};
+	canopen::dispatcher dispatcher;
+	dispatcher.on(canopen::function_code::tpdo1, [&counts](const can::Message&) { counts[0]++; });
+	dispatcher.on(canopen::function_code::emcy, [&counts](const can::Message&) { counts[1]++; });
+	dispatcher.on(canopen::function_code::heartbeat, [&counts](const can::Message&) { counts[2]++; });
+	dispatcher.set_default([&counts](const can::Message&) { counts[3]++; });
+
+	for(auto _ : state)
+		benchmark::DoNotOptimize(dispatcher.dispatch(messages.data(), messages.size()));
+	state.SetItemsProcessed(state.iterations() * messages.size());
+}
+BENCHMARK(BM_dispatch_batch);
@@ -0,0 +1,34 @@
+///////////////////////////////////////////////////////////////////////
+// Benchmarks for the CANOpen emergency history
+//
+// Measures recording an emergency storm of many nodes and error codes.
+///////////////////////////////////////////////////////////////////////
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include <can/include/emcy_history.h>
+
+namespace
+{
+	void BM_emcy_process(benchmark::State& state)
+	{
+		canopen::emcy_history history;
+
+		std::mt19937 random{ 5 };
+		std::vector<can::Message> messages(4096);
+		for(auto& message : messages)
+		{
+			auto code = static_cast<uint16_t>(0x1000 * (1 + random() % 9) + random() % 16);
+			message = can::Message(canopen::message_emcy(static_cast<canopen::id_type>(1 + random() % 127), code, 0x01));
+			message.get_timestamp() = timespec{ 1, 0 };
+		}
+
+		std::size_t i = 0;
+		for(auto _ : state)
+			benchmark::DoNotOptimize(history.process(messages[i++ % messages.size()]));
+		state.SetItemsProcessed(state.iterations());
+	}
+	BENCHMARK(BM_emcy_process);
+}
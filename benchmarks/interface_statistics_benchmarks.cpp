@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////
+// Benchmarks for the interface statistics
+//
+// Measures the cost of counting received frames - counters and the
+// latency histogram - which is paid for every batch of frames handed
+// out by an interface, against copying the batch without counting.
+///////////////////////////////////////////////////////////////////////
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include <interfaces/include/interface_statistics.h>
+
+namespace
+{
+	std::vector<can::Message> make_batch(std::size_t count)
+	{
+		std::vector<can::Message> messages(count);
+		for(auto& message : messages)
+		{
+			message.set_id(0x181);
+			message.set_size(8);
+			clock_gettime(CLOCK_REALTIME, &message.get_timestamp());
+		}
+		return messages;
+	}
+
+	void BM_statistics_counter(benchmark::State& state)
+	{
+		can::interfaces::statistics_counter counter;
+		for(auto _ : state)
+		{
+			counter.add(1);
+			benchmark::ClobberMemory();
+		}
+		benchmark::DoNotOptimize(counter.value());
+		state.SetItemsProcessed(state.iterations());
+	}
+	BENCHMARK(BM_statistics_counter);
+
+	void BM_latency_record(benchmark::State& state)
+	{
+		can::interfaces::latency_histogram histogram;
+		uint64_t value = 12345;
+		for(auto _ : state)
+		{
+			histogram.record(value);
+			value = (value * 7 + 13) & 0xFFFFF;
+		}
+		benchmark::DoNotOptimize(histogram.count());
+		state.SetItemsProcessed(state.iterations());
+	}
+	BENCHMARK(BM_latency_record);
+
+	// A batch as received, copied out with and without counting
+	void BM_receive_batch_copy(benchmark::State& state)
+	{
+		auto batch = make_batch(state.range(0));
+		std::vector<can::Message> out(batch.size());
+		for(auto _ : state)
+		{
+			std::copy(batch.begin(), batch.end(), out.begin());
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+	BENCHMARK(BM_receive_batch_copy)->Arg(1)->Arg(64);
+
+	void BM_receive_batch_counted(benchmark::State& state)
+	{
+		can::interfaces::interface_statistics statistics;
+		auto batch = make_batch(state.range(0));
+		std::vector<can::Message> out(batch.size());
+		for(auto _ : state)
+		{
+			std::copy(batch.begin(), batch.end(), out.begin());
+			statistics.record_received(out.data(), out.size());
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+	BENCHMARK(BM_receive_batch_counted)->Arg(1)->Arg(64);
+
+	void BM_statistics_sample(benchmark::State& state)
+	{
+		can::interfaces::interface_statistics statistics;
+		for(auto _ : state)
+			benchmark::DoNotOptimize(statistics.sample());
+	}
+	BENCHMARK(BM_statistics_sample);
+}
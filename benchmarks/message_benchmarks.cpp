@@ -0,0 +1,131 @@
+///////////////////////////////////////////////////////////////////////
+// Benchmarks for the CAN message
+//
+// Compares the per-frame receive bookkeeping of the current message
+// layout with the former layout, which stored the interface name as a
+// std::string and, when bound to "any", looked the name up per frame.
+///////////////////////////////////////////////////////////////////////
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <can/include/Message.h>
+
+namespace
+{
+	// The former message layout
+	struct legacy_message
+	{
+		can_frame frame;
+		std::string interface;
+		timeval timestamp;
+	};
+
+	// An interface name too long for the small-string optimisation, as e.g. "can_usb_gateway0"
+	const std::string long_interface_name = "can_usb_gateway0";
+
+	can_frame test_frame()
+	{
+		can_frame frame{};
+		frame.can_id = 0x181;
+		frame.len = 8;
+		return frame;
+	}
+}
+
+// Receive bookkeeping with the former layout, bound to a specific interface
+static void BM_receive_legacy_named_interface(benchmark::State& state)
+{
+	std::vector<legacy_message> messages(64);
+	const auto frame = test_frame();
+	std::size_t i = 0;
+	for(auto _ : state)
+	{
+		auto& message = messages[i++ % messages.size()];
+		message.frame = frame;
+		message.interface = long_interface_name;
+		benchmark::DoNotOptimize(message);
+	}
+}
+BENCHMARK(BM_receive_legacy_named_interface);
+
+// Receive bookkeeping with the former layout, bound to "any" (name lookup per frame)
+static void BM_receive_legacy_any_interface(benchmark::State& state)
+{
+	std::vector<legacy_message> messages(64);
+	const auto frame = test_frame();
+	const auto index = static_cast<int>(if_nametoindex("lo"));
+
+	// The former code asked the receiving socket - any socket answers SIOCGIFNAME, and CAN sockets may be unavailable
+	auto socketHandle = socket(AF_INET, SOCK_DGRAM, 0);
+	if(socketHandle < 0)
+	{
+		state.SkipWithError("No socket for SIOCGIFNAME");
+		return;
+	}
+
+	std::size_t i = 0;
+	for(auto _ : state)
+	{
+		auto& message = messages[i++ % messages.size()];
+		message.frame = frame;
+		ifreq ifr;
+		ifr.ifr_ifindex = index;
+		ioctl(socketHandle, SIOCGIFNAME, &ifr);
+		message.interface = ifr.ifr_name;
+		benchmark::DoNotOptimize(message);
+	}
+
+	close(socketHandle);
+}
+BENCHMARK(BM_receive_legacy_any_interface);
+
+// Receive bookkeeping with the current layout - identical for named and "any" interfaces
+static void BM_receive_message(benchmark::State& state)
+{
+	std::vector<can::Message> messages(64);
+	const auto frame = test_frame();
+	std::size_t i = 0;
+	for(auto _ : state)
+	{
+		auto& message = messages[i++ % messages.size()];
+		message.get_frame() = frame;
+		message.set_interface(1);
+		benchmark::DoNotOptimize(message);
+	}
+}
+BENCHMARK(BM_receive_message);
+
+// Copying a batch of messages with the former layout
+static void BM_copy_legacy_messages(benchmark::State& state)
+{
+	std::vector<legacy_message> source(state.range(0), legacy_message{ test_frame(), long_interface_name, {} });
+	std::vector<legacy_message> destination(state.range(0));
+	for(auto _ : state)
+	{
+		destination = source;
+		benchmark::DoNotOptimize(destination.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_copy_legacy_messages)->Arg(64)->Arg(1024);
+
+// Copying a batch of messages with the current layout
+static void BM_copy_messages(benchmark::State& state)
+{
+	std::vector<can::Message> source(state.range(0), can::Message(test_frame()));
+	std::vector<can::Message> destination(state.range(0));
+	for(auto _ : state)
+	{
+		destination = source;
+		benchmark::DoNotOptimize(destination.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_copy_messages)->Arg(64)->Arg(1024);
@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////
+// Benchmarks for the CANOpen network state
+//
+// Measures processing heartbeats, and reading node states while the
+// processing thread keeps publishing, compared with a state guarded by
+// a mutex.
+///////////////////////////////////////////////////////////////////////
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <can/include/network_state.h>
+
+namespace
+{
+	std::vector<can::Message> make_heartbeats()
+	{
+		std::vector<can::Message> messages(1024);
+		for(std::size_t i = 0; i < messages.size(); i++)
+		{
+			messages[i].set_id(0x700 + 1 + i % 127);
+			messages[i].set_size(1);
+			messages[i][0] = 0x05;
+			messages[i].get_timestamp() = timespec{ static_cast<time_t>(i), 0 };
+		}
+		return messages;
+	}
+
+	// The network state behind a mutex, for comparison
+	struct locked_state
+	{
+		std::mutex mutex;
+		canopen::network_state::snapshot_type nodes{};
+
+		void process(const can::Message& message)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto& status = nodes[message.id() & 0x7F];
+			status.state = static_cast<canopen::nmt_type>(message.get_frame().data[0] & 0x7F);
+			status.heartbeats++;
+			status.last_heartbeat = message.get_timestamp();
+		}
+
+		canopen::node_status node(canopen::id_type node)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return nodes[node];
+		}
+	};
+
+	void BM_network_process(benchmark::State& state)
+	{
+		canopen::network_state network;
+		auto messages = make_heartbeats();
+		std::size_t i = 0;
+		for(auto _ : state)
+			benchmark::DoNotOptimize(network.process(messages[i++ % messages.size()]));
+		state.SetItemsProcessed(state.iterations());
+	}
+	BENCHMARK(BM_network_process);
+
+	// Readers of one node while a writer thread processes heartbeats of all nodes
+	template <typename T>
+	void read_while_writing(benchmark::State& state, T& network)
+	{
+		std::atomic<bool> done{ false };
+		std::thread writer([&]()
+		{
+			auto messages = make_heartbeats();
+			for(std::size_t i = 0; !done.load(std::memory_order_relaxed); i++)
+				network.process(messages[i % messages.size()]);
+		});
+
+		canopen::id_type node = 1;
+		for(auto _ : state)
+		{
+			benchmark::DoNotOptimize(network.node(node));
+			node = static_cast<canopen::id_type>(node % 127 + 1);
+		}
+		state.SetItemsProcessed(state.iterations());
+
+		done = true;
+		writer.join();
+	}
+
+	void BM_network_read_seqlock(benchmark::State& state)
+	{
+		canopen::network_state network;
+		read_while_writing(state, network);
+	}
+	BENCHMARK(BM_network_read_seqlock);
+
+	void BM_network_read_mutex(benchmark::State& state)
+	{
+		locked_state network;
+		read_while_writing(state, network);
+	}
+	BENCHMARK(BM_network_read_mutex);
+
+	void BM_network_snapshot(benchmark::State& state)
+	{
+		canopen::network_state network;
+		for(auto _ : state)
+			benchmark::DoNotOptimize(network.snapshot());
+		state.SetItemsProcessed(state.iterations());
+	}
+	BENCHMARK(BM_network_snapshot);
+}
@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////
+// Benchmarks for the simulated CANOpen nodes
+//
+// Cost of polling a node with a TPDO due, and the frame rate of a farm
+// of 127 operational nodes sending TPDOs every millisecond through the
+// simulated bus, received by a master on another thread.
+///////////////////////////////////////////////////////////////////////
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include <can/include/node_farm.h>
+#include <interfaces/include/CANSimulation.h>
+
+namespace
+{
+	void configure(canopen::simulated_node& node, std::chrono::milliseconds period)
+	{
+		node.set(0x6000, 1, { 0x01, 0x02, 0x03, 0x04 });
+		node.set(0x6000, 2, { 0x05, 0x06, 0x07, 0x08 });
+		node.set_tpdo(1, { 0x60000120, 0x60000220 }, period);
+	}
+
+	// One TPDO built per poll
+	void BM_simulated_node_poll(benchmark::State& state)
+	{
+		canopen::simulated_node node(5);
+		configure(node, std::chrono::milliseconds(1));
+
+		std::vector<can::Message> output;
+		node.start(0, output);
+		can_frame start{};
+		start.len = 2;
+		start.data[0] = static_cast<uint8_t>(canopen::nmt_type::command_operational);
+		node.process(can::Message(start), 0, output);
+
+		int64_t now = 0;
+		for(auto _ : state)
+		{
+			output.clear();
+			now += 1000000;
+			node.poll(now, output);
+			benchmark::DoNotOptimize(output.data());
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+	BENCHMARK(BM_simulated_node_poll);
+
+	// Frames received from a farm of 127 nodes per second, with the farm threads given
+	void BM_node_farm(benchmark::State& state)
+	{
+		can::interfaces::CANSimulation farmInterface;
+		can::interfaces::CANSimulation master;
+		farmInterface.Connect("bench_farm");
+		master.Connect("bench_farm");
+		master.SetBlockingMode(false);
+		master.SetTimeout(100);
+
+		canopen::node_farm farm(farmInterface, static_cast<std::size_t>(state.range(0)));
+		for(canopen::id_type id = 1; id < 128; id++)
+			configure(*farm.add(id), std::chrono::milliseconds(1));
+		farm.start();
+
+		can_frame start{};
+		start.len = 2;
+		start.data[0] = static_cast<uint8_t>(canopen::nmt_type::command_operational);
+		master.SendMessage(can::Message(start));
+
+		std::vector<can::Message> received(256);
+		std::size_t frames = 0;
+		for(auto _ : state)
+			frames += master.RequestMessages(received.data(), received.size());
+
+		farm.stop();
+		state.SetItemsProcessed(frames);
+		state.counters["drops"] = static_cast<double>(farm.dropped() + master.GetInterfaceStatistics()->counters().overflow_drops);
+	}
+	BENCHMARK(BM_node_farm)->Arg(1)->Arg(4)->UseRealTime()->MinTime(1.0);
+}
@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////
+// Benchmarks for PDO decoding
+//
+// Compares the compile-time PDO mapping with decoding driven by a
+// mapping table at runtime, extracting each value bit by bit.
+///////////////////////////////////////////////////////////////////////
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include <can/include/canopen.h>
+
+namespace
+{
+	using drive_status = canopen::pdo_mapping<
+		canopen::pdo_entry<0x6041, 0, 16>,
+		canopen::pdo_entry<0x6064, 0, 32, int32_t>,
+		canopen::pdo_entry<0x2000, 1, 1, bool>,
+		canopen::pdo_entry<0x2000, 2, 3>,
+		canopen::pdo_entry<0x2000, 3, 12, int16_t>>;
+
+	struct table_entry
+	{
+		std::size_t bits;
+		bool is_signed;
+	};
+
+	const std::vector<table_entry> drive_status_table{ { 16, false }, { 32, true }, { 1, false }, { 3, false }, { 12, true } };
+
+	// Decodes a PDO from a mapping table
+	void decode_table(const can_frame& frame, const std::vector<table_entry>& table, int64_t* values)
+	{
+		std::size_t offset = 0;
+		for(std::size_t i = 0; i < table.size(); i++)
+		{
+			uint64_t value = 0;
+			for(std::size_t bit = 0; bit < table[i].bits; bit++, offset++)
+				if(frame.data[offset / 8] & (1 << (offset % 8)))
+					value |= uint64_t{1} << bit;
+
+			if(table[i].is_signed && (value & (uint64_t{1} << (table[i].bits - 1))))
+				value |= ~uint64_t{0} << table[i].bits;
+			values[i] = static_cast<int64_t>(value);
+		}
+	}
+
+	std::vector<can_frame> test_frames()
+	{
+		std::vector<can_frame> frames(256);
+		for(std::size_t i = 0; i < frames.size(); i++)
+			frames[i] = drive_status::message(0x181, { static_cast<uint16_t>(i), -static_cast<int32_t>(i * 1000), (i & 1) != 0, static_cast<uint8_t>(i & 7), static_cast<int16_t>(i) - 128 });
+		return frames;
+	}
+}
+
+static void BM_pdo_decode_table(benchmark::State& state)
+{
+	auto frames = test_frames();
+	int64_t values[5];
+	std::size_t i = 0;
+	for(auto _ : state)
+	{
+		decode_table(frames[i++ % frames.size()], drive_status_table, values);
+		benchmark::DoNotOptimize(values);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_pdo_decode_table);
+
+static void BM_pdo_decode_mapping(benchmark::State& state)
+{
+	auto frames = test_frames();
+	std::size_t i = 0;
+	for(auto _ : state)
+	{
+		auto values = drive_status::unpack(frames[i++ % frames.size()]);
+		benchmark::DoNotOptimize(values);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_pdo_decode_mapping);
+
+static void BM_pdo_encode_mapping(benchmark::State& state)
+{
+	uint16_t statusword = 0;
+	for(auto _ : state)
+	{
+		auto frame = drive_status::message(0x181, { statusword++, -1000, true, 3, -5 });
+		benchmark::DoNotOptimize(frame);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_pdo_encode_mapping);
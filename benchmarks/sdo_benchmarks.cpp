@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////
+// Benchmarks for SDO transfers
+//
+// Downloads and uploads a firmware-sized object to a simulated node
+// with segmented and block transfers. Besides the processing rate,
+// the number of frames per transfer gives the rate achievable on a
+// 1 Mbit/s bus ("bus_bytes_per_second"), assuming 111 bits per 8-byte
+// frame without stuff bits, and a node answering immediately.
+///////////////////////////////////////////////////////////////////////
+#include <benchmark/benchmark.h>
+
+#include <deque>
+#include <vector>
+
+#include <can/include/sdo_client.h>
+#include <can/include/sdo_server.h>
+
+namespace
+{
+	constexpr double frame_time = 111e-6;
+
+	// Interface looping requests through a simulated node
+	class loopback_interface : public can::interfaces::ICANInterface
+	{
+		private:
+			canopen::sdo_server& _server;
+			std::vector<can::Message> _responses;
+			std::size_t _position = 0;
+			uint64_t _frames = 0;
+
+		public:
+			explicit loopback_interface(canopen::sdo_server& server) : _server(server) {}
+
+			uint64_t frames() const { return _frames; }
+
+			bool SendMessage(const can::Message& message) override { return (SendMessages(&message, 1) == 1); }
+			std::size_t SendMessages(const can::Message* messages, std::size_t count) override
+			{
+				for(std::size_t i = 0; i < count; i++)
+					_server.process(messages[i], _responses);
+				_frames += count;
+				return count;
+			}
+
+			bool RequestMessage(can::Message& message) override { return (RequestMessages(&message, 1) == 1); }
+			std::size_t RequestMessages(can::Message* messages, std::size_t count) override
+			{
+				std::size_t received = 0;
+				while(received < count && _position < _responses.size())
+					messages[received++] = _responses[_position++];
+				if(_position == _responses.size())
+				{
+					_responses.clear();
+					_position = 0;
+				}
+				_frames += received;
+				return received;
+			}
+
+			bool Connect(const std::string&) override { return true; }
+			void Disconnect() override {}
+			bool IsReady() const override { return true; }
+			int GetFileDescriptor() const override { return -1; }
+			void SetTimeout(int) override {}
+			void SetBlockingMode(bool) override {}
+	};
+
+	std::vector<canopen::data_type> firmware(std::size_t size)
+	{
+		std::vector<canopen::data_type> data(size);
+		for(std::size_t i = 0; i < size; i++)
+			data[i] = static_cast<canopen::data_type>(i * 31 + (i >> 10));
+		return data;
+	}
+
+	template <bool block, bool download>
+	void sdo_transfer(benchmark::State& state)
+	{
+		canopen::sdo_server server(1);
+		loopback_interface interface(server);
+		canopen::sdo_client client(interface);
+
+		auto data = firmware(static_cast<std::size_t>(state.range(0)));
+		server.set(0x1F50, 1, data);
+		for(auto _ : state)
+		{
+			if(download)
+				block ? client.write_block(1, 0x1F50, 1, data, nullptr) : client.write(1, 0x1F50, 1, data, nullptr);
+			else
+				block ? client.read_block(1, 0x1F50, 1, nullptr) : client.read(1, 0x1F50, 1, nullptr);
+			client.run_until_idle();
+		}
+
+		auto frames = static_cast<double>(interface.frames()) / static_cast<double>(state.iterations());
+		state.SetBytesProcessed(state.iterations() * state.range(0));
+		state.counters["frames"] = frames;
+		state.counters["bus_bytes_per_second"] = static_cast<double>(state.range(0)) / (frames * frame_time);
+	}
+}
+
+static void BM_sdo_segmented_download(benchmark::State& state) { sdo_transfer<false,true>(state); }
+static void BM_sdo_block_download(benchmark::State& state) { sdo_transfer<true,true>(state); }
+static void BM_sdo_segmented_upload(benchmark::State& state) { sdo_transfer<false,false>(state); }
+static void BM_sdo_block_upload(benchmark::State& state) { sdo_transfer<true,false>(state); }
+
+BENCHMARK(BM_sdo_segmented_download)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK(BM_sdo_block_download)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK(BM_sdo_segmented_upload)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK(BM_sdo_block_upload)->Arg(1 << 16)->Arg(1 << 20);
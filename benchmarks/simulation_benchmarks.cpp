@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////
+// Benchmarks for the simulated bus
+//
+// Frame rates through the in-memory bus without bus timing: sending
+// and receiving batches on one thread, and streaming from a sending
+// thread to a receiving thread.
+///////////////////////////////////////////////////////////////////////
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <interfaces/include/CANSimulation.h>
+
+namespace
+{
+	std::vector<can::Message> make_batch(std::size_t count)
+	{
+		std::vector<can::Message> messages(count);
+		for(std::size_t i = 0; i < count; i++)
+		{
+			messages[i].set_id(static_cast<uint32_t>(0x100 + i));
+			messages[i].set_size(8);
+		}
+		return messages;
+	}
+
+	void BM_simulation_batch(benchmark::State& state)
+	{
+		can::interfaces::CANSimulation sender;
+		can::interfaces::CANSimulation receiver;
+		sender.Connect("bench_batch");
+		receiver.Connect("bench_batch");
+
+		auto batch = make_batch(state.range(0));
+		std::vector<can::Message> received(batch.size());
+		for(auto _ : state)
+		{
+			sender.SendMessages(batch.data(), batch.size());
+			benchmark::DoNotOptimize(receiver.RequestMessages(received.data(), received.size()));
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+	BENCHMARK(BM_simulation_batch)->Arg(1)->Arg(64);
+
+	// Frames received per second while another thread sends as fast as possible
+	void BM_simulation_stream(benchmark::State& state)
+	{
+		can::interfaces::CANSimulation sender;
+		can::interfaces::CANSimulation receiver;
+		sender.Connect("bench_stream");
+		receiver.Connect("bench_stream");
+		receiver.SetBlockingMode(false);
+		receiver.SetTimeout(100);
+
+		std::atomic<bool> done{ false };
+		std::thread thread([&]()
+		{
+			auto batch = make_batch(64);
+			while(!done.load(std::memory_order_relaxed))
+			{
+				// Keep the receive queue from overflowing
+				if(receiver.GetInterfaceStatistics()->counters().frames_received + 2048 > sender.GetInterfaceStatistics()->counters().frames_sent)
+					sender.SendMessages(batch.data(), batch.size());
+			}
+		});
+
+		std::vector<can::Message> received(64);
+		std::size_t frames = 0;
+		for(auto _ : state)
+			frames += receiver.RequestMessages(received.data(), received.size());
+
+		done = true;
+		thread.join();
+		state.SetItemsProcessed(frames);
+		state.counters["drops"] = static_cast<double>(receiver.GetInterfaceStatistics()->counters().overflow_drops);
+	}
+	BENCHMARK(BM_simulation_stream)->UseRealTime();
+}
@@ -2,25 +2,73 @@
 // CAN Message
 //
 // Represents a CAN message, independent of the underlying structure.
+//
+// Messages are fixed-size and trivially copyable, so they can be kept
+// in arrays and ring buffers and copied with memcpy. The receiving
+// interface is stored as an interface index - use
+// can::interfaces::interface_table to translate it to a name.
+//
+// Classic and CAN FD frames share one slot: the frame is kept as a
+// canfd_frame, whose start is laid out as a can_frame, and CAN FD
+// frames are marked with CANFD_FDF (dual use, as documented in
+// linux/can.h). Interfaces and logs only transfer the bytes of the
+// frame type (mtu), so classic frames cost no more than before.
+//
+// Timestamps are in nanoseconds on CLOCK_REALTIME, as received from the
+// kernel. Hardware timestamps are aligned to that clock by the
+// receiving interface - see can/include/timestamp.h for conversions,
+// e.g. to CLOCK_MONOTONIC.
 ///////////////////////////////////////////////////////////////////////
 #pragma once
 
-#include <string>
-#include <linux/can.h>	// can_frame definition
+#include <linux/can.h>	// can_frame and canfd_frame definitions
+#include <ctime>	// timespec definition
+#include <cstddef>
 #include <cstdint>	// uintX_t definitions
+#include <type_traits>
+
+#ifndef CANFD_FDF
+#define CANFD_FDF 0x04	// Marks CAN FD frames in a canfd_frame (Linux 5.14)
+#endif
 
 namespace can
 {
+	// Smallest CAN FD payload length holding "length" bytes (0-8, 12, 16, 20, 24, 32, 48 or 64)
+	constexpr auto fd_length(std::size_t length) -> uint8_t
+	{
+		if(length <= 8)
+			return static_cast<uint8_t>(length);
+		if(length <= 24)
+			return static_cast<uint8_t>((length + 3) & ~std::size_t{3});
+		if(length <= 32)
+			return 32;
+		return (length <= 48) ? 48 : CANFD_MAX_DLEN;
+	}
+
+	// Clock a timestamp was taken with
+	enum class timestamp_source : uint8_t
+	{
+		software,	// Kernel receive time, or the time of logging
+		hardware	// CAN controller, aligned to CLOCK_REALTIME
+	};
+
 	class Message
 	{
 		private:
-			can_frame _message;
-			std::string _interface;
-			timeval _timestamp;
+			union
+			{
+				can_frame _message;
+				canfd_frame _fdMessage{};
+			};
+			timespec _timestamp{};
+			int _interface{ 0 };
+			timestamp_source _timestampSource{ timestamp_source::software };
 
 		public:
-			// Constructor
-			Message(can_frame& message);
+			// Constructors
+			Message() = default;
+			Message(const can_frame& message);
+			Message(const canfd_frame& message);	// Marked as CAN FD
 
 			// Operators
 			uint8_t& operator[](int index);
@@ -29,18 +77,28 @@ namespace can
 			uint32_t id() const;
 			uint8_t id_short() const;
 			uint8_t size() const;
+			bool is_fd() const;
+			uint8_t max_size() const;	// 8, or 64 for CAN FD frames
+			std::size_t mtu() const;	// Bytes of the frame on a socket - CAN_MTU or CANFD_MTU
 
 			// Setters
 			void set_id(uint32_t id);
 			void set_id_short(uint8_t id);
 			void set_size(uint8_t size);
+			void set_fd(bool fd);	// Classic frames are cut to 8 bytes
 
 			// Access to internal data, as required by interfaces
 			can_frame& get_frame();
-			const can_frame& get_frame() const;
-			std::string get_interface() const;
-			void set_interface(const std::string& interface);
-			timeval& get_timestamp();
-			const timeval& get_timestamp() const;
+			const can_frame& get_frame() const;	// Header and the first 8 data bytes of CAN FD frames
+			canfd_frame& get_fd_frame();
+			const canfd_frame& get_fd_frame() const;
+			int get_interface() const;
+			void set_interface(int interface);
+			timespec& get_timestamp();
+			const timespec& get_timestamp() const;
+			timestamp_source get_timestamp_source() const;
+			void set_timestamp_source(timestamp_source source);
 	};
+
+	static_assert(std::is_trivially_copyable<Message>::value);
 }
@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////
+// Bit fields
+//
+// Extraction and insertion of signals at any start bit and length in
+// the payload of a frame, in little-endian (Intel) or big-endian
+// (Motorola) byte order. Start bits are numbered as in DBC files: bit
+// i of data byte j is bit 8*j + i, and the start bit is the least
+// significant bit of a little-endian signal, and the most significant
+// bit of a big-endian signal.
+//
+// The payload is loaded as one 64-bit value (byte-swapped for
+// big-endian signals), so a signal is one load, a shift and a mask.
+// The batch variants decode one signal from many messages, using AVX2
+// when the processor supports it.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+#include <can/include/Message.h>
+
+namespace can
+{
+	enum class byte_order
+	{
+		little_endian,	// Intel
+		big_endian,	// Motorola
+	};
+
+	// The 8 data bytes of a frame as a little-endian value
+	constexpr auto load_payload(const __u8* data) -> uint64_t
+	{
+		uint64_t result = 0;
+		for(std::size_t i = 0; i < 8; i++)
+			result |= static_cast<uint64_t>(data[i]) << (8*i);
+		return result;
+	}
+
+	// The 8 data bytes of a frame as a value in the given byte order
+	constexpr auto load_payload(const __u8* data, byte_order order) -> uint64_t
+	{
+		auto result = load_payload(data);
+		return (order == byte_order::little_endian) ? result : __builtin_bswap64(result);
+	}
+
+	// Position of the least significant bit of a signal in the loaded payload
+	constexpr auto bitfield_shift(std::size_t start, std::size_t length, byte_order order) -> std::size_t
+	{
+		return (order == byte_order::little_endian) ? start : (7 - start/8)*8 + start%8 + 1 - length;
+	}
+
+	constexpr auto bitfield_mask(std::size_t length) -> uint64_t
+	{
+		return (length >= 64) ? ~uint64_t{0} : (uint64_t{1} << length) - 1;
+	}
+
+	// Checks whether a signal lies within the 8 data bytes
+	constexpr auto valid_bitfield(std::size_t start, std::size_t length, byte_order order) -> bool
+	{
+		if(length == 0 || length > 64 || start > 63)
+			return false;
+		if(order == byte_order::little_endian)
+			return (start + length <= 64);
+		return ((7 - start/8)*8 + start%8 + 1 >= length);
+	}
+
+	// Extracts a signal - the signal must be valid
+	constexpr auto extract_unsigned(const can_frame& frame, std::size_t start, std::size_t length, byte_order order = byte_order::little_endian) -> uint64_t
+	{
+		return (load_payload(frame.data, order) >> bitfield_shift(start, length, order)) & bitfield_mask(length);
+	}
+
+	// Extracts a two's complement signal - the signal must be valid
+	constexpr auto extract_signed(const can_frame& frame, std::size_t start, std::size_t length, byte_order order = byte_order::little_endian) -> int64_t
+	{
+		auto sign = uint64_t{1} << (length - 1);
+		return static_cast<int64_t>((extract_unsigned(frame, start, length, order) ^ sign) - sign);
+	}
+
+	// Extracts a signal checked at compile time, as an unsigned or sign-extended signed value
+	template <std::size_t start, std::size_t length, byte_order order = byte_order::little_endian, typename T = uint64_t>
+	constexpr auto extract_bits(const can_frame& frame) -> T
+	{
+		static_assert(valid_bitfield(start, length, order), "Signal outside the payload");
+		static_assert(std::is_integral<T>::value && sizeof(T)*8 >= length);
+
+		if constexpr (std::is_signed<T>::value)
+			return static_cast<T>(extract_signed(frame, start, length, order));
+		else
+			return static_cast<T>(extract_unsigned(frame, start, length, order));
+	}
+
+	// Sets a signal, leaving the other bits of the payload - the signal must be valid
+	constexpr void insert_bits(can_frame& frame, std::size_t start, std::size_t length, byte_order order, uint64_t value)
+	{
+		auto shift = bitfield_shift(start, length, order);
+		auto mask = bitfield_mask(length) << shift;
+		auto payload = (load_payload(frame.data, order) & ~mask) | ((value << shift) & mask);
+		if(order == byte_order::big_endian)
+			payload = __builtin_bswap64(payload);
+
+		for(std::size_t i = 0; i < 8; i++)
+			frame.data[i] = static_cast<__u8>(payload >> (8*i));
+	}
+
+	// Extracts a signal from each message - the signal must be valid
+	void extract_unsigned(const Message* messages, std::size_t count, std::size_t start, std::size_t length, byte_order order, uint64_t* values);
+	void extract_signed(const Message* messages, std::size_t count, std::size_t start, std::size_t length, byte_order order, int64_t* values);
+}
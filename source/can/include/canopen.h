@@ -6,9 +6,12 @@
 #pragma once
 
 #include <can/include/Message.h>
+#include <can/include/bitfield.h>
 
 #include <array>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace canopen
 {
@@ -26,7 +29,31 @@ namespace canopen
 		read = 0x40,
 		write_1byte = 0x2f,
 		write_2bytes = 0x2b,
+		write_3bytes = 0x27,
 		write_4bytes = 0x23,
+		abort = 0x80,
+	};
+
+	// Communication objects of the predefined connection set, by COB-ID
+	enum class function_code : uint8_t
+	{
+		unknown = 0,
+		nmt,	// NMT commands (0x000)
+		sync,	// 0x080
+		emcy,	// 0x080 + node
+		time,	// 0x100
+		tpdo1,
+		rpdo1,
+		tpdo2,
+		rpdo2,
+		tpdo3,
+		rpdo3,
+		tpdo4,
+		rpdo4,
+		sdo_response,	// 0x580 + node
+		sdo_request,	// 0x600 + node
+		heartbeat,	// NMT error control, 0x700 + node
+		lss,	// 0x7E4 and 0x7E5
 	};
 
 	enum class nmt_type
@@ -47,6 +74,32 @@ namespace canopen
 		state_preoperational = 0x7F,
 	};
 
+	// Error code classes of emergency frames (upper byte of the error code)
+	enum class emcy_class : uint8_t
+	{
+		no_error = 0x00,	// Error reset
+		generic = 0x10,
+		current = 0x20,
+		voltage = 0x30,
+		temperature = 0x40,
+		hardware = 0x50,
+		software = 0x60,
+		additional_modules = 0x70,
+		monitoring = 0x80,	// Including communication (0x81xx) and protocol (0x82xx) errors
+		external = 0x90,
+		additional_functions = 0xF0,
+		device_specific = 0xFF,
+		unknown = 0xDD,
+	};
+
+	// Contents of an emergency frame
+	struct emcy_data
+	{
+		uint16_t error_code{ 0 };	// 0x0000 when the errors are reset
+		uint8_t error_register{ 0 };	// Object 0x1001
+		std::array<data_type,5> manufacturer{};
+	};
+
 	// --------------------------------------------------------------------
 	// Utility
 	// --------------------------------------------------------------------
@@ -62,7 +115,7 @@ namespace canopen
 	{
 		static_assert(sizeof(T) >= data_length);
 
-		std::array<data_type, data_length> result;
+		std::array<data_type, data_length> result{};
 		for(std::size_t i = 0; i < data_length; i++)
 			result[i] = (value >> 8*i) & 0xFF;
 
@@ -76,14 +129,14 @@ namespace canopen
 		static_assert(std::is_integral<T>::value);
 		T result{ 0 };
 		for(std::size_t i = 0; i < data_length; i++)
-			result += (static_cast<T>(data[i]) >> i*8);
+			result |= static_cast<T>(static_cast<T>(data[i]) << i*8);
 		return result;
 	}
 
 	template <typename T, std::size_t l1, std::size_t l2>
 	constexpr auto operator|(const std::array<T,l1>& a1, const std::array<T,l2>& a2)
 	{
-		std::array<T,l1+l2> result;
+		std::array<T,l1+l2> result{};
 		for(std::size_t i = 0; i < l1+l2; i++)
 			result[i] = (i < l1) ? a1[i] : a2[i - l1];
 
@@ -93,7 +146,7 @@ namespace canopen
 	template <typename T, std::size_t l>
 	constexpr auto operator|(data_type d, const std::array<T,l>& a)
 	{
-		std::array<T,l+1> result;
+		std::array<T,l+1> result{};
 		for(std::size_t i = 0; i < l+1; i++)
 			result[i] = (i < 1) ? d : a[i - 1];
 
@@ -103,7 +156,7 @@ namespace canopen
 	template <typename T, std::size_t l>
 	constexpr auto operator|(const std::array<T,l>& a, data_type d)
 	{
-		std::array<T,l+1> result;
+		std::array<T,l+1> result{};
 		for(std::size_t i = 0; i < l+1; i++)
 			result[i] = (i < l) ? a[i] : d;
 
@@ -116,7 +169,7 @@ namespace canopen
 	template <std::size_t data_length>
 	constexpr auto message(id_type id, std::array<data_type,data_length> data) -> can_frame
 	{
-		static_assert(data_length > 0 && data_length <= 8);
+		static_assert(data_length > 0 && data_length <= 8, "Use message_fd for more than 8 bytes");
 
 		can_frame result{id, {data_length}, 0, 0, 0, {0,0,0,0,0,0,0,0}};
 		for(std::size_t i = 0; i < data_length; i++)
@@ -125,12 +178,135 @@ namespace canopen
 		return result;
 	}
 
+	// CAN FD frame with up to 64 bytes, padded with zeros to the next CAN FD length - e.g. for CANopen FD (CiA 1301)
+	template <std::size_t data_length>
+	constexpr auto message_fd(canid_t cobid, std::array<data_type,data_length> data, uint8_t flags = CANFD_BRS) -> canfd_frame
+	{
+		static_assert(data_length <= CANFD_MAX_DLEN);
+
+		canfd_frame result{};
+		result.can_id = cobid;
+		result.len = can::fd_length(data_length);
+		result.flags = static_cast<__u8>(flags | CANFD_FDF);
+		for(std::size_t i = 0; i < data_length; i++)
+			result.data[i] = data[i];
+
+		return result;
+	}
+
 	template <sdo_type T>
 	constexpr auto message_sdo(id_type id, index_type cobid, subindex_type subindex) -> can_frame
 	{
 		return message(id, as_data(T) | map_to_data<2>(cobid) | map_to_data<1>(subindex) | 0 | 0 | 0 | 0);
 	}
 
+	// COB-IDs of the default PDOs of a node
+	template <int tpdo_number>
+	constexpr auto tpdo_id(id_type id) -> canid_t
+	{
+		static_assert(tpdo_number >= 1 && tpdo_number <= 4);
+		return 0x080 + 0x100*tpdo_number + (id & 0x7F);
+	}
+
+	template <int rpdo_number>
+	constexpr auto rpdo_id(id_type id) -> canid_t
+	{
+		static_assert(rpdo_number >= 1 && rpdo_number <= 4);
+		return 0x100 + 0x100*rpdo_number + (id & 0x7F);
+	}
+
+	// COB-IDs of the default SDO channel of a node
+	constexpr auto sdo_request_id(id_type id) -> canid_t
+	{
+		return 0x600 + (id & 0x7F);
+	}
+
+	constexpr auto sdo_response_id(id_type id) -> canid_t
+	{
+		return 0x580 + (id & 0x7F);
+	}
+
+	// COB-ID of the emergency frames of a node
+	constexpr auto emcy_id(id_type id) -> canid_t
+	{
+		return 0x080 + (id & 0x7F);
+	}
+
+	// Emergency frame from a node
+	constexpr auto message_emcy(id_type id, uint16_t code, uint8_t error_register, std::array<data_type,5> manufacturer = {}) -> can_frame
+	{
+		auto result = message(0, map_to_data<2>(code) | error_register | manufacturer);
+		result.can_id = emcy_id(id);
+		return result;
+	}
+
+	// COB-ID of the heartbeat (NMT error control) frames of a node
+	constexpr auto heartbeat_id(id_type id) -> canid_t
+	{
+		return 0x700 + (id & 0x7F);
+	}
+
+	// Heartbeat frame from a node - the boot-up message has state_boot_up
+	constexpr auto message_heartbeat(id_type id, nmt_type state) -> can_frame
+	{
+		auto result = message(0, std::array<data_type,1>{{ as_data(state) }});
+		result.can_id = heartbeat_id(id);
+		return result;
+	}
+
+	// SDO request from the client to a node, with the command byte and up to 4 bytes of data
+	constexpr auto message_sdo_request(id_type id, data_type command, index_type index, subindex_type subindex, std::array<data_type,4> data = {}) -> can_frame
+	{
+		auto result = message(0, command | map_to_data<2>(index) | map_to_data<1>(subindex) | data);
+		result.can_id = sdo_request_id(id);
+		return result;
+	}
+
+	// SDO response from a node to the client, with the command byte and up to 4 bytes of data
+	constexpr auto message_sdo_response(id_type id, data_type command, index_type index, subindex_type subindex, std::array<data_type,4> data = {}) -> can_frame
+	{
+		auto result = message(0, command | map_to_data<2>(index) | map_to_data<1>(subindex) | data);
+		result.can_id = sdo_response_id(id);
+		return result;
+	}
+
+	// SDO abort from the client to a node
+	constexpr auto message_sdo_abort(id_type id, index_type index, subindex_type subindex, uint32_t code) -> can_frame
+	{
+		return message_sdo_request(id, as_data(sdo_type::abort), index, subindex, map_to_data<4>(code));
+	}
+
+	// SDO segment of a segmented or block transfer, with the command byte and up to 7 bytes of data
+	constexpr auto message_sdo_segment(canid_t cobid, data_type command, const data_type* data, std::size_t size) -> can_frame
+	{
+		can_frame result{cobid, {8}, 0, 0, 0, {command,0,0,0,0,0,0,0}};
+		for(std::size_t i = 0; i < size && i < 7; i++)
+			result.data[i+1] = data[i];
+
+		return result;
+	}
+
+	// CRC-16-CCITT (polynomial 0x1021, initial value 0) of SDO block transfers
+	constexpr auto sdo_crc_table = []()
+	{
+		std::array<uint16_t,256> table{};
+		for(uint16_t i = 0; i < 256; i++)
+		{
+			uint16_t crc = static_cast<uint16_t>(i << 8);
+			for(int bit = 0; bit < 8; bit++)
+				crc = static_cast<uint16_t>((crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1));
+			table[i] = crc;
+		}
+		return table;
+	}();
+
+	constexpr auto sdo_crc(const data_type* data, std::size_t size, uint16_t crc = 0) -> uint16_t
+	{
+		for(std::size_t i = 0; i < size; i++)
+			crc = static_cast<uint16_t>((crc << 8) ^ sdo_crc_table[((crc >> 8) ^ data[i]) & 0xFF]);
+		return crc;
+	}
+
 	template <nmt_type T>
 	constexpr auto message_nmt(id_type id) -> can_frame
 	{
@@ -227,7 +403,9 @@ namespace canopen
 				case as_data(sdo_type::read):
 				case as_data(sdo_type::write_1byte):
 				case as_data(sdo_type::write_2bytes):
+				case as_data(sdo_type::write_3bytes):
 				case as_data(sdo_type::write_4bytes):
+				case as_data(sdo_type::abort):
 					result = static_cast<sdo_type>(msg.data[0]);
 					break;
 			}
@@ -251,4 +429,371 @@ namespace canopen
 
 		return static_cast<subindex_type>(msg.data[3]);
 	}
+
+	// Contents of an emergency frame - missing bytes are 0
+	constexpr auto get_emcy(const can_frame& msg) -> emcy_data
+	{
+		emcy_data result{};
+		if(msg.len >= 2)
+			result.error_code = map_from_data<uint16_t>(std::array<data_type,2>{{ as_data(msg.data[0]), as_data(msg.data[1]) }});
+		if(msg.len >= 3)
+			result.error_register = msg.data[2];
+		for(std::size_t i = 3; i < msg.len && i < 8; i++)
+			result.manufacturer[i - 3] = msg.data[i];
+
+		return result;
+	}
+
+	constexpr auto get_emcy_class(uint16_t code) -> emcy_class
+	{
+		auto high = static_cast<uint8_t>(code >> 8);
+		if(high == 0x00 || high == 0x10 || high == 0xFF)
+			return static_cast<emcy_class>(high);
+		if(high >= 0x20 && high < 0xA0)
+			return static_cast<emcy_class>(high & 0xF0);
+		if(high >= 0xF0)
+			return emcy_class::additional_functions;
+		return emcy_class::unknown;
+	}
+
+	// Function code of every 11-bit COB-ID, built from the classifiers above
+	constexpr auto function_code_table = []()
+	{
+		std::array<function_code,CAN_SFF_MASK+1> table{};
+		for(canid_t id = 0; id <= CAN_SFF_MASK; id++)
+		{
+			can_frame msg{id, {0}, 0, 0, 0, {0,0,0,0,0,0,0,0}};
+			auto& code = table[id];
+			if(is_lss(msg))
+				code = function_code::lss;
+			else if(id == 0x000)
+				code = function_code::nmt;
+			else if(is_nmt(msg))
+				code = function_code::heartbeat;
+			else if(id == 0x080)
+				code = function_code::sync;
+			else if(is_emcy(msg))
+				code = function_code::emcy;
+			else if(id == 0x100)
+				code = function_code::time;
+			else if(is_tpdo<1>(msg))
+				code = function_code::tpdo1;
+			else if(is_tpdo<2>(msg))
+				code = function_code::tpdo2;
+			else if(is_tpdo<3>(msg))
+				code = function_code::tpdo3;
+			else if(is_tpdo<4>(msg))
+				code = function_code::tpdo4;
+			else if(is_rpdo<1>(msg))
+				code = function_code::rpdo1;
+			else if(is_rpdo<2>(msg))
+				code = function_code::rpdo2;
+			else if(is_rpdo<3>(msg))
+				code = function_code::rpdo3;
+			else if(is_rpdo<4>(msg))
+				code = function_code::rpdo4;
+			else if(is_sdo_response(msg))
+				code = function_code::sdo_response;
+			else if(is_sdo_request(msg))
+				code = function_code::sdo_request;
+		}
+		return table;
+	}();
+
+	// Classifies a frame with a single table lookup - extended frames are not part of the predefined connection set, and remote requests carry no data
+	constexpr auto get_function_code(const can_frame& msg) -> function_code
+	{
+		if((msg.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) != 0)
+			return function_code::unknown;
+		return function_code_table[msg.can_id & CAN_SFF_MASK];
+	}
+
+	// Base COB-ID of a function code, to which the node ID is added
+	constexpr auto get_function_base(function_code code) -> canid_t
+	{
+		switch(code)
+		{
+			case function_code::nmt: return 0x000;
+			case function_code::sync: return 0x080;
+			case function_code::emcy: return 0x080;
+			case function_code::time: return 0x100;
+			case function_code::tpdo1: return 0x180;
+			case function_code::rpdo1: return 0x200;
+			case function_code::tpdo2: return 0x280;
+			case function_code::rpdo2: return 0x300;
+			case function_code::tpdo3: return 0x380;
+			case function_code::rpdo3: return 0x400;
+			case function_code::tpdo4: return 0x480;
+			case function_code::rpdo4: return 0x500;
+			case function_code::sdo_response: return 0x580;
+			case function_code::sdo_request: return 0x600;
+			case function_code::heartbeat: return 0x700;
+			case function_code::lss: return 0x7E4;
+			default: break;
+		}
+		return CAN_SFF_MASK + 1;
+	}
+
+	// --------------------------------------------------------------------
+	// Kernel filters
+	//
+	// Filters for CAN_RAW_FILTER, using the same mask/value pairs as the
+	// classifiers above. A frame passes a filter when
+	// (can_id & can_mask) == (filter.can_id & can_mask), so a filter built
+	// from has_masked_value<mask,value> passes exactly the frames the
+	// classifier accepts. Filter sets are combined with combine, e.g.
+	// combine(filter_sdo_response(5), filter_emcy()).
+	// --------------------------------------------------------------------
+	template <canid_t mask, canid_t value>
+	constexpr auto filter() -> std::array<can_filter,1>
+	{
+		static_assert((value & ~mask) == 0, "Value has bits outside the mask");
+		return {{ can_filter{ value, mask } }};
+	}
+
+	// Filter for a single function code and node, e.g. 0x580 + 5
+	constexpr auto filter(canid_t function_code, id_type id) -> std::array<can_filter,1>
+	{
+		return {{ can_filter{ function_code + (id & 0x7F), 0xFFF } }};
+	}
+
+	constexpr auto filter_all() -> std::array<can_filter,1>
+	{
+		return filter<0x000,0x000>();
+	}
+
+	constexpr auto filter_nmt()
+	{
+		return filter<0xFFF,0x000>() | filter<0xF80,0x700>();
+	}
+
+	constexpr auto filter_heartbeat(id_type id)
+	{
+		return filter(0x700, id);
+	}
+
+	constexpr auto filter_emcy()
+	{
+		return filter<0xF80,0x080>();
+	}
+
+	constexpr auto filter_emcy(id_type id)
+	{
+		return filter(0x080, id);
+	}
+
+	constexpr auto filter_lss()
+	{
+		return filter<0xFFF,0x7E4>() | filter<0xFFF,0x7E5>();
+	}
+
+	template <int tpdo_number>
+	constexpr auto filter_tpdo()
+	{
+		static_assert(tpdo_number >= 1 && tpdo_number <= 4);
+		return filter<0xF80,0x080 + 0x100*tpdo_number>();
+	}
+
+	template <int tpdo_number>
+	constexpr auto filter_tpdo(id_type id)
+	{
+		static_assert(tpdo_number >= 1 && tpdo_number <= 4);
+		return filter(0x080 + 0x100*tpdo_number, id);
+	}
+
+	template <int rpdo_number>
+	constexpr auto filter_rpdo()
+	{
+		static_assert(rpdo_number >= 1 && rpdo_number <= 4);
+		return filter<0xF80,0x100 + 0x100*rpdo_number>();
+	}
+
+	template <int rpdo_number>
+	constexpr auto filter_rpdo(id_type id)
+	{
+		static_assert(rpdo_number >= 1 && rpdo_number <= 4);
+		return filter(0x100 + 0x100*rpdo_number, id);
+	}
+
+	constexpr auto filter_sdo_request()
+	{
+		return filter<0xF80,0x600>();
+	}
+
+	constexpr auto filter_sdo_request(id_type id)
+	{
+		return filter(0x600, id);
+	}
+
+	constexpr auto filter_sdo_response()
+	{
+		return filter<0xF80,0x580>();
+	}
+
+	constexpr auto filter_sdo_response(id_type id)
+	{
+		return filter(0x580, id);
+	}
+
+	constexpr auto filter_sdo()
+	{
+		return filter_sdo_request() | filter_sdo_response();
+	}
+
+	// Combines filter sets into a single set
+	template <std::size_t count, typename... filter_sets>
+	constexpr auto combine(const std::array<can_filter,count>& filters, const filter_sets&... others)
+	{
+		if constexpr (sizeof...(others) == 0)
+			return filters;
+		else
+			return filters | combine(others...);
+	}
+
+	// Checks a frame against a filter set, as the kernel would
+	template <std::size_t count>
+	constexpr auto passes_filter(const can_frame& msg, const std::array<can_filter,count>& filters)
+	{
+		for(const auto& f : filters)
+			if((msg.can_id & f.can_mask) == (f.can_id & f.can_mask))
+				return true;
+		return false;
+	}
+
+	// --------------------------------------------------------------------
+	// PDO mapping
+	//
+	// A PDO mapping lists the mapped objects in the order they appear in
+	// the payload, packed LSB first without gaps, as in the mapping
+	// parameters (0x1600/0x1A00). The mapping is a type, so unpack and
+	// pack compile to one 64-bit load or store and a constant shift and
+	// mask per entry, e.g.
+	//   using drive_status = pdo_mapping<pdo_entry<0x6041,0,16>, pdo_entry<0x6064,0,32,int32_t>>;
+	//   auto [statusword, position] = drive_status::unpack(frame);
+	// --------------------------------------------------------------------
+	template <std::size_t bits>
+	using pdo_value_type = std::conditional_t<(bits <= 8), uint8_t,
+		std::conditional_t<(bits <= 16), uint16_t,
+		std::conditional_t<(bits <= 32), uint32_t, uint64_t>>>;
+
+	// Mapped object - signed value types are sign-extended from the bit length
+	template <index_type object_index, subindex_type object_subindex, std::size_t bits, typename T = pdo_value_type<bits>>
+	struct pdo_entry
+	{
+		static_assert(bits > 0 && bits <= 64);
+		static_assert(std::is_integral<T>::value && sizeof(T)*8 >= bits, "Value type too small for the bit length");
+
+		using value_type = T;
+		static constexpr index_type index = object_index;
+		static constexpr subindex_type subindex = object_subindex;
+		static constexpr std::size_t bit_length = bits;
+
+		// Value of the mapping parameter, as written to 0x1600/0x1A00
+		static constexpr uint32_t mapping = (static_cast<uint32_t>(index) << 16) | (static_cast<uint32_t>(subindex) << 8) | bits;
+	};
+
+	template <typename... entries>
+	class pdo_mapping
+	{
+		public:
+			using values_type = std::tuple<typename entries::value_type...>;
+			static constexpr std::size_t size = sizeof...(entries);
+			static constexpr std::size_t bit_length = (entries::bit_length + ... + 0);
+			static constexpr std::size_t data_length = (bit_length + 7) / 8;
+			static_assert(size > 0 && bit_length <= 64, "A PDO carries 1-64 bits");
+
+		private:
+			template <std::size_t i>
+			using entry = std::tuple_element_t<i, std::tuple<entries...>>;
+
+			template <std::size_t i>
+			static constexpr std::size_t offset()
+			{
+				constexpr std::array<std::size_t,size> lengths{{ entries::bit_length... }};
+				std::size_t result = 0;
+				for(std::size_t j = 0; j < i; j++)
+					result += lengths[j];
+				return result;
+			}
+
+			template <std::size_t i>
+			static constexpr uint64_t mask()
+			{
+				return (entry<i>::bit_length == 64) ? ~uint64_t{0} : (uint64_t{1} << entry<i>::bit_length) - 1;
+			}
+
+			template <std::size_t i>
+			static constexpr auto extract(uint64_t raw)
+			{
+				using T = typename entry<i>::value_type;
+				auto value = (raw >> offset<i>()) & mask<i>();
+				if constexpr (std::is_signed<T>::value && entry<i>::bit_length < 64)
+				{
+					constexpr auto sign = uint64_t{1} << (entry<i>::bit_length - 1);
+					value = (value ^ sign) - sign;
+				}
+				return static_cast<T>(value);
+			}
+
+			template <std::size_t i>
+			static constexpr auto insert(typename entry<i>::value_type value) -> uint64_t
+			{
+				return (static_cast<uint64_t>(value) & mask<i>()) << offset<i>();
+			}
+
+			template <std::size_t... i>
+			static constexpr auto unpack(uint64_t raw, std::index_sequence<i...>) -> values_type
+			{
+				return values_type{ extract<i>(raw)... };
+			}
+
+			template <std::size_t... i>
+			static constexpr auto pack(const values_type& values, std::index_sequence<i...>) -> uint64_t
+			{
+				return (insert<i>(std::get<i>(values)) | ... | uint64_t{0});
+			}
+
+		public:
+			// Mapping parameter values, e.g. to configure a node through SDO
+			static constexpr auto mapping() -> std::array<uint32_t,size>
+			{
+				return {{ entries::mapping... }};
+			}
+
+			// Checks whether a frame carries the whole mapping
+			static constexpr auto matches(const can_frame& frame)
+			{
+				return (frame.len >= data_length);
+			}
+
+			// Decodes all mapped values - check the length with matches first
+			static constexpr auto unpack(const can_frame& frame) -> values_type
+			{
+				return unpack(can::load_payload(frame.data), std::index_sequence_for<entries...>{});
+			}
+
+			// Decodes a single mapped value
+			template <std::size_t i>
+			static constexpr auto get(const can_frame& frame) -> typename entry<i>::value_type
+			{
+				return extract<i>(can::load_payload(frame.data));
+			}
+
+			// Encodes the mapped values as PDO data
+			static constexpr auto pack(const values_type& values) -> std::array<data_type,data_length>
+			{
+				return map_to_data<data_length>(pack(values, std::index_sequence_for<entries...>{}));
+			}
+
+			// Encodes the mapped values as a PDO with the given COB-ID
+			static constexpr auto message(canid_t cobid, const values_type& values) -> can_frame
+			{
+				auto data = pack(values);
+				can_frame result{cobid, {data_length}, 0, 0, 0, {0,0,0,0,0,0,0,0}};
+				for(std::size_t i = 0; i < data_length; i++)
+					result.data[i] = data[i];
+
+				return result;
+			}
+	};
 }
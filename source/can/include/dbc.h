@@ -0,0 +1,125 @@
+///////////////////////////////////////////////////////////////////////
+// DBC database
+//
+// Loads the messages and signals of a DBC file, and decodes received
+// frames into physical values. The signal layouts are compiled into
+// flat decode programs, one step per signal, indexed by CAN ID in the
+// same way as the CANOpen dispatcher: standard IDs through a table of
+// 2048 entries, extended IDs through a sorted table. Decoding a frame
+// is one lookup followed by a load, shift, mask and scale per signal.
+//
+// Only the statements needed for decoding are read (BO_, SG_ and
+// SIG_VALTYPE_); other statements are ignored.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <can/include/Message.h>
+#include <can/include/bitfield.h>
+
+namespace can::dbc
+{
+	// Representation of the raw value of a signal
+	enum class value_type : uint8_t
+	{
+		integer,
+		float32,
+		float64,
+	};
+
+	enum class multiplexing : uint8_t
+	{
+		none,
+		multiplexor,	// Selects which multiplexed signals are present
+		multiplexed,	// Present when the multiplexor has the value "mux_value"
+	};
+
+	struct signal
+	{
+		std::string name;
+		uint16_t start{ 0 };	// DBC start bit
+		uint8_t length{ 0 };
+		byte_order order{ byte_order::little_endian };
+		bool is_signed{ false };
+		value_type type{ value_type::integer };
+		double factor{ 1.0 };
+		double offset{ 0.0 };
+		double minimum{ 0.0 };
+		double maximum{ 0.0 };
+		std::string unit;
+		multiplexing mux{ multiplexing::none };
+		uint32_t mux_value{ 0 };
+	};
+
+	struct message
+	{
+		canid_t id{ 0 };	// Extended IDs have the CAN_EFF_FLAG set
+		std::string name;
+		uint8_t size{ 0 };
+		std::string transmitter;
+		std::vector<signal> signals;
+	};
+
+	// Decoding of one signal - physical value = raw value * factor + offset
+	struct decode_step
+	{
+		uint64_t mask;
+		uint64_t sign;	// Sign bit of signed integers, otherwise 0
+		double factor;
+		double offset;
+		uint32_t mux_value;
+		uint8_t shift;
+		bool swap;	// Big-endian
+		bool multiplexed;
+		value_type type;
+	};
+
+	// Decoding of one message
+	struct decode_program
+	{
+		uint32_t first;	// First step
+		uint32_t count;	// Number of steps, one per signal of the message
+		int32_t multiplexor;	// Step of the multiplexor signal, or -1
+		uint8_t size;	// Minimum number of data bytes
+	};
+
+	class database
+	{
+		private:
+			std::vector<message> _messages;
+			std::vector<decode_step> _steps;
+			std::vector<decode_program> _programs;	// One per message
+			std::array<uint32_t,CAN_SFF_MASK+1> _standard;	// Message index + 1, 0 for none
+			std::vector<std::pair<canid_t,uint32_t>> _extended;	// Sorted by ID
+			uint64_t _skipped;
+
+			void Compile();
+			int64_t FindMessage(canid_t id) const;
+
+		public:
+			// Constructor / destructor
+			database();
+			~database() = default;
+
+			// Loading - returns false if the file cannot be read, or statements were skipped as invalid
+			bool load(const std::string& path);
+			bool parse(std::string_view text);	// Adds to the messages already loaded
+			void clear();
+			uint64_t skipped() const;	// Number of statements skipped as invalid
+
+			// Lookup
+			const std::vector<message>& messages() const;
+			const message* find(canid_t id) const;	// Returns nullptr if the ID is unknown
+			const message* find(std::string_view name) const;
+
+			// Decodes the physical values of the signals of a frame, in the order of the signals of its
+			// message - signals of other multiplexor values are NaN. Returns the number of values, or 0
+			// if the ID is unknown or the frame is shorter than the message.
+			std::size_t decode(const can::Message& message, double* values) const;
+	};
+}
@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////////////////////////
+// CANOpen frame dispatcher
+//
+// Routes received frames to handlers registered per function code,
+// per function code and node, or per COB-ID. Standard IDs are routed
+// through a flat table of 2048 handler slots, so dispatching a frame
+// is one indexed load; extended IDs are looked up in a sorted table.
+// Frames without a handler go to the default handler, if any, as do
+// error frames and remote requests (RTR), which carry no data.
+//
+// Later registrations replace earlier ones for the same IDs. Handlers
+// are registered before dispatching starts.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <can/include/canopen.h>
+
+namespace canopen
+{
+	class dispatcher
+	{
+		public:
+			using handler_type = std::function<void(const can::Message& message)>;
+
+		private:
+			// Handler slot 0 is the default handler
+			std::vector<handler_type> _handlers;
+			std::array<uint16_t,CAN_SFF_MASK+1> _standard;
+			std::vector<std::pair<canid_t,uint16_t>> _extended;	// Sorted by ID
+
+			bool AddHandler(handler_type&& handler, uint16_t& slot);
+			uint16_t FindSlot(canid_t id) const;
+
+		public:
+			// Constructor / destructor
+			dispatcher();
+			~dispatcher() = default;
+
+			// Registration - returns false if the ID is not part of the function code, or the slots are exhausted
+			bool on(function_code code, handler_type handler);
+			bool on(function_code code, id_type node, handler_type handler);	// The node is ignored for NMT, SYNC, TIME and LSS
+			bool on_id(canid_t id, handler_type handler);	// Extended IDs have the CAN_EFF_FLAG set
+			void set_default(handler_type handler);
+			void clear();
+
+			// Calls the handler of a frame - returns false if there is none
+			bool dispatch(const can::Message& message) const;
+
+			// Calls the handler of each frame - returns the number of frames handled
+			std::size_t dispatch(const can::Message* messages, std::size_t count) const;
+	};
+}
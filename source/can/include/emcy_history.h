@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////
+// CANOpen emergency history
+//
+// Decodes emergency (EMCY) frames and keeps the latest events of each
+// node in a ring of fixed size, together with counters per node and
+// error code. All memory is allocated on construction, so processing
+// a frame never allocates, whatever the rate of emergencies.
+//
+// Counters are kept in an open-addressing table of fixed size; error
+// codes which do not fit any more are counted as untracked. The
+// history is processed and queried by one thread.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <ctime>
+#include <vector>
+
+#include <can/include/canopen.h>
+
+namespace canopen
+{
+	struct emcy_event
+	{
+		timespec timestamp{};	// Of the message, or the time of processing if it has none
+		emcy_data emcy;
+	};
+
+	struct emcy_count
+	{
+		id_type node;
+		uint16_t error_code;
+		uint64_t count;
+	};
+
+	class emcy_history
+	{
+		public:
+			static constexpr std::size_t max_nodes = 128;	// Node 0 is unused
+
+		private:
+			struct counter
+			{
+				uint32_t key;	// (node << 16 | error code) + 1, or 0 for unused counters
+				uint64_t count;
+			};
+
+			std::size_t _capacity;	// Events per node
+			std::vector<emcy_event> _events;	// Ring of "_capacity" events per node
+			std::array<uint64_t,max_nodes> _totals;	// Events received per node
+			std::vector<counter> _counters;	// Power of two size
+			unsigned int _counterShift;	// Hash shift for the size of the counter table
+			std::size_t _maxCodes;
+			std::size_t _codes;	// Counters in use
+			uint64_t _untracked;
+
+			counter* FindCounter(uint32_t key);
+			const counter* FindCounter(uint32_t key) const;
+
+		public:
+			// Constructor / destructor
+			explicit emcy_history(std::size_t events_per_node = 64, std::size_t tracked_codes = 1024);
+			~emcy_history() = default;
+
+			// Processing - returns false if the frame is not an emergency frame
+			bool process(const can::Message& message);
+			std::size_t process(const can::Message* messages, std::size_t count);	// Returns the number of frames used
+			void clear();
+
+			// History of a node - index 0 is the latest event
+			std::size_t size(id_type node) const;	// Number of events kept
+			std::size_t capacity() const;
+			const emcy_event& event(id_type node, std::size_t index) const;	// The index must be below size(node)
+			uint64_t total(id_type node) const;	// Number of events received
+
+			// Counters
+			uint64_t count(id_type node, uint16_t code) const;
+			uint64_t count(uint16_t code) const;	// Of all nodes
+			uint64_t count(emcy_class type) const;	// Of all nodes
+			std::vector<emcy_count> counts() const;	// Ordered by node and error code
+			uint64_t untracked() const;	// Events of error codes beyond the tracked codes
+	};
+}
@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////
+// CANOpen network state
+//
+// Tracks the NMT state of each node from heartbeat frames (boot-up
+// messages included) and NMT commands, and detects nodes whose
+// heartbeats stop. Heartbeat times are the timestamps of the received
+// messages, or the time of processing if a message has none.
+//
+// Frames are processed, and timeouts checked, by one thread (e.g. the
+// receive path). The state of each node is published through a
+// seqlock, so any number of threads can read node states without
+// locking, and without slowing down the processing thread.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+
+#include <can/include/canopen.h>
+#include <utility/include/seqlock.h>
+
+namespace canopen
+{
+	struct node_status
+	{
+		nmt_type state{ nmt_type::unknown };	// Last reported state - unknown before the first heartbeat
+		nmt_type command{ nmt_type::unknown };	// Last NMT command addressed to the node
+		bool timed_out{ false };	// No heartbeat within the heartbeat timeout
+		uint32_t boot_ups{ 0 };
+		uint32_t timeouts{ 0 };	// Number of times the heartbeat timed out
+		uint64_t heartbeats{ 0 };
+		timespec last_heartbeat{};
+	};
+
+	class network_state
+	{
+		public:
+			static constexpr std::size_t max_nodes = 128;	// Node 0 is unused
+			using snapshot_type = std::array<node_status,max_nodes>;
+
+		private:
+			snapshot_type _nodes;	// Written by the processing thread only
+			std::array<utility::seqlock<node_status>,max_nodes> _published;
+			std::array<int64_t,max_nodes> _timeouts;	// Heartbeat timeouts in nanoseconds, 0 if disabled
+			std::atomic<uint64_t> _changes;
+
+			void Publish(id_type node);
+
+		public:
+			// Constructor / destructor
+			network_state();
+			~network_state() = default;
+
+			// Do not allow copying
+			network_state(const network_state&) = delete;
+			network_state& operator=(const network_state&) = delete;
+
+			// Configuration - a timeout of 0 disables the detection
+			void set_heartbeat_timeout(std::chrono::milliseconds timeout);	// For all nodes
+			void set_heartbeat_timeout(id_type node, std::chrono::milliseconds timeout);
+			void reset();
+
+			// Processing thread - returns false if the frame is not a heartbeat or NMT command
+			bool process(const can::Message& message);
+			std::size_t process(const can::Message* messages, std::size_t count);	// Returns the number of frames used
+
+			// Processing thread - marks nodes without heartbeats within their timeout, returns the number of new timeouts
+			std::size_t check_timeouts(const timespec& now);
+			std::size_t check_timeouts();	// At the current time
+
+			// Any thread
+			node_status node(id_type node) const;
+			snapshot_type snapshot() const;
+			uint64_t changes() const;	// Number of node updates published, to skip unchanged snapshots
+	};
+}
@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////
+// Farm of simulated CANOpen nodes
+//
+// Runs up to 127 simulated nodes against an interface, so one machine
+// can emulate a full, busy network. A receive thread routes NMT
+// commands and SDO requests to the workers owning the addressed nodes,
+// through a lock-free queue per worker; each worker thread drives its
+// share of the nodes, sleeping until the next frame arrives or the
+// next heartbeat or TPDO of its nodes is due.
+//
+// Nodes are added and configured before starting. The counters may be
+// read from any thread.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <can/include/simulated_node.h>
+#include <interfaces/include/ICANInterface.h>
+#include <utility/include/lockfree_ring.h>
+
+namespace canopen
+{
+	class node_farm
+	{
+		public:
+			static constexpr std::size_t max_nodes = 128;	// Node 0 is unused
+			static constexpr std::size_t queue_size = 1024;	// Frames queued per worker
+
+		private:
+			// Maximum number of messages received at a time
+			static constexpr std::size_t _batchSize = 256;
+
+			struct worker
+			{
+				std::vector<simulated_node*> nodes;
+				utility::spsc_ring<can::Message,queue_size> queue;
+				std::atomic<bool> armed{ false };	// Set while the worker sleeps
+				int event{ -1 };	// eventfd, readable after frames were queued for an armed worker
+				std::thread thread;
+			};
+
+			can::interfaces::ICANInterface& _interface;
+			std::size_t _threads;
+			int _stopLatency;
+
+			std::array<std::unique_ptr<simulated_node>,max_nodes> _nodes;
+			std::array<worker*,max_nodes> _owners;	// Worker of each node, while running
+			std::vector<std::unique_ptr<worker>> _workers;
+			std::thread _receiver;
+			std::mutex _sendMutex;
+			std::atomic<bool> _running;
+
+			// Counters
+			std::atomic<uint64_t> _received;
+			std::atomic<uint64_t> _sent;
+			std::atomic<uint64_t> _dropped;
+
+			void Receive();
+			void Work(worker& w);
+			void Send(std::vector<can::Message>& output);
+			bool Queue(worker& w, const can::Message& message);
+
+		public:
+			// Constructor / destructor - "stopLatency" is the maximum time (ms) a stop request may wait for
+			node_farm(can::interfaces::ICANInterface& interface, std::size_t threads, int stopLatency = 50);
+			~node_farm();
+
+			// Do not allow copying
+			node_farm(const node_farm&) = delete;
+			node_farm& operator=(const node_farm&) = delete;
+
+			// Nodes, before starting - add returns nullptr for invalid or existing node IDs
+			simulated_node* add(id_type node);
+			simulated_node* node(id_type node);
+			std::size_t size() const;
+
+			// Starts the threads, and powers up all nodes - returns false if running already, or without nodes
+			bool start();
+			void stop();
+			bool running() const;
+
+			// Counters - dropped frames include those rejected by the interface and those not fitting a worker queue
+			uint64_t received() const;	// Frames routed to a node
+			uint64_t sent() const;
+			uint64_t dropped() const;
+	};
+}
@@ -0,0 +1,206 @@
+///////////////////////////////////////////////////////////////////////
+// CANOpen SDO client
+//
+// Runs SDO transfers to many nodes concurrently, with one outstanding
+// transfer per node (as the default SDO channel allows) and a queue of
+// further transfers behind it. Responses are matched to the transfer
+// by node ID, index and subindex; responses that do not match the
+// outstanding transfer are ignored. Transfers that are not answered
+// within the timeout are aborted towards the node.
+//
+// Transfers may be queued from any thread. The client itself is
+// driven from one thread, either by run_once/run_until_idle, or by
+// feeding received messages to process and calling poll regularly,
+// e.g. from an event loop. Results are delivered through callbacks,
+// called on the driving thread, or futures.
+//
+// Reads start as an upload, which the node answers as an expedited or
+// segmented transfer; writes of more than 4 bytes are segmented. Block
+// transfers (with CRC, when the node supports it) are requested with
+// read_block/write_block - a whole block of segments is sent in one
+// batch, so large downloads run close to the bus rate.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <vector>
+
+#include <can/include/canopen.h>
+#include <interfaces/include/ICANInterface.h>
+
+namespace canopen
+{
+	enum class sdo_status
+	{
+		success,
+		timeout,	// No response from the node - the transfer was aborted
+		aborted,	// Aborted by the node, or by the client on an invalid response
+		failed,	// The request could not be sent, or was invalid
+	};
+
+	// SDO abort codes used by the client
+	namespace sdo_abort_code
+	{
+		constexpr uint32_t toggle_bit = 0x05030000;
+		constexpr uint32_t timeout = 0x05040000;
+		constexpr uint32_t invalid_command = 0x05040001;
+		constexpr uint32_t invalid_block_size = 0x05040002;
+		constexpr uint32_t invalid_sequence = 0x05040003;
+		constexpr uint32_t crc_error = 0x05040004;
+		constexpr uint32_t no_object = 0x06020000;
+		constexpr uint32_t length_mismatch = 0x06070010;
+		constexpr uint32_t general_error = 0x08000000;
+	}
+
+	struct sdo_result
+	{
+		id_type node = 0;
+		index_type index = 0;
+		subindex_type subindex = 0;
+		sdo_status status = sdo_status::failed;
+		uint32_t abort_code = 0;
+		std::vector<data_type> data;	// Data read by an upload
+
+		// Returns the data as a little-endian value
+		uint32_t value() const;
+	};
+
+	class sdo_client
+	{
+		public:
+			using callback_type = std::function<void(const sdo_result& result)>;
+			using clock_type = std::chrono::steady_clock;
+
+		private:
+			// Maximum number of messages requested from the interface at a time
+			static constexpr std::size_t _batchSize = 64;
+
+			// Number of node IDs
+			static constexpr std::size_t _nodeCount = 128;
+
+			enum class transfer_type
+			{
+				upload,
+				download,
+				block_upload,
+				block_download,
+			};
+
+			enum class transfer_phase
+			{
+				initiate,	// Waiting for the response to the initiate request
+				segment,	// Segmented transfer
+				block,	// Block transfer
+				end,	// Waiting for the end of a block transfer
+			};
+
+			struct transfer
+			{
+				transfer_type type;
+				index_type index;
+				subindex_type subindex;
+				std::vector<data_type> data;
+				callback_type callback;
+
+				// Progress of segmented and block transfers
+				transfer_phase phase = transfer_phase::initiate;
+				std::size_t offset = 0;	// Bytes sent, or acknowledged in block downloads
+				std::size_t size = 0;	// Size indicated by the node on uploads, 0 when unknown
+				std::size_t blockStart = 0;	// Offset of the current block of a block download
+				bool toggle = false;
+				bool crc = false;	// Whether the node supports CRC in block transfers
+				uint8_t blockSize = 0;
+				uint8_t sequence = 0;	// Last sequence number received, or sent, in the current block
+				uint8_t lastSequence = 0;	// Sequence number of the last segment of a block download, 0 until sent
+			};
+
+			struct node_state
+			{
+				std::deque<transfer> queue;	// The front transfer is outstanding when "active" is set
+				bool active = false;
+				clock_type::time_point deadline;
+			};
+
+			using completion = std::pair<callback_type,sdo_result>;
+
+			can::interfaces::ICANInterface& _interface;
+			std::chrono::milliseconds _timeout;
+			uint8_t _blockSize;
+
+			mutable std::mutex _mutex;
+			std::array<node_state,_nodeCount> _nodes;
+			std::size_t _queued;	// Transfers queued or outstanding, on all nodes
+
+			std::array<can::Message,_batchSize> _batch;
+			std::vector<can::Message> _outgoing;
+			std::vector<id_type> _outgoingNodes;	// Node of each outgoing request, 0 for aborts
+			std::vector<completion> _completions;
+			std::vector<completion> _delivering;
+
+			void Queue(id_type node, transfer&& request);
+			void Push(const can_frame& frame, id_type node);
+			void Start(id_type node, node_state& state, clock_type::time_point now);
+			void Complete(id_type node, node_state& state, sdo_status status, uint32_t abortCode, std::vector<data_type>&& data = {});
+			void Abort(id_type node, node_state& state, sdo_status status, uint32_t abortCode);
+			void SendSegment(id_type node, transfer& request);
+			void SendBlock(id_type node, transfer& request);
+			void HandleResponse(id_type node, node_state& state, const can_frame& frame);
+			void HandleUpload(id_type node, node_state& state, const can_frame& frame);
+			void HandleDownload(id_type node, node_state& state, const can_frame& frame);
+			void HandleBlockUpload(id_type node, node_state& state, const can_frame& frame);
+			void HandleBlockDownload(id_type node, node_state& state, const can_frame& frame);
+			void Flush();
+
+		public:
+			// Constructor / destructor
+			sdo_client(can::interfaces::ICANInterface& interface, std::chrono::milliseconds timeout = std::chrono::milliseconds(500));
+			~sdo_client() = default;
+
+			// Do not allow copying
+			sdo_client(const sdo_client&) = delete;
+			sdo_client& operator=(const sdo_client&) = delete;
+
+			// Response timeout, for each response of a transfer
+			void set_timeout(std::chrono::milliseconds timeout);
+
+			// Number of segments per block requested by block uploads (1-127)
+			void set_block_size(uint8_t size);
+
+			// Queues an upload (read) from the object dictionary of a node
+			void read(id_type node, index_type index, subindex_type subindex, callback_type callback);
+			std::future<sdo_result> read(id_type node, index_type index, subindex_type subindex);
+
+			// Queues a download (write) to the object dictionary of a node - expedited for up to 4 bytes, segmented otherwise
+			void write(id_type node, index_type index, subindex_type subindex, std::vector<data_type> data, callback_type callback);
+			std::future<sdo_result> write(id_type node, index_type index, subindex_type subindex, std::vector<data_type> data);
+
+			// Queues a block upload from the object dictionary of a node
+			void read_block(id_type node, index_type index, subindex_type subindex, callback_type callback);
+			std::future<sdo_result> read_block(id_type node, index_type index, subindex_type subindex);
+
+			// Queues a block download to the object dictionary of a node
+			void write_block(id_type node, index_type index, subindex_type subindex, std::vector<data_type> data, callback_type callback);
+			std::future<sdo_result> write_block(id_type node, index_type index, subindex_type subindex, std::vector<data_type> data);
+
+			// Handles received messages - messages other than SDO responses are ignored
+			void process(const can::Message* messages, std::size_t count);
+
+			// Starts queued transfers and aborts timed out ones
+			void poll();
+
+			// Receives one batch from the interface and processes it - the interface should not block beyond the SDO timeout
+			std::size_t run_once();
+
+			// Runs until all queued transfers are complete
+			void run_until_idle();
+
+			// Number of transfers queued or outstanding
+			std::size_t pending() const;
+			bool idle() const;
+	};
+}
@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////
+// CANOpen SDO server
+//
+// Simulated node answering SDO requests from an object dictionary in
+// memory, with expedited, segmented and block transfers (with CRC).
+// Used to test SDO clients, and to benchmark them without a bus.
+//
+// Downloads create objects that do not exist; uploads of objects that
+// do not exist are aborted. One transfer is served at a time, as on
+// the default SDO channel.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <can/include/canopen.h>
+
+namespace canopen
+{
+	class sdo_server
+	{
+		private:
+			enum class server_state
+			{
+				idle,
+				upload_segment,
+				download_segment,
+				block_upload_start,
+				block_upload,
+				block_upload_end,
+				block_download,
+				block_download_end,
+			};
+
+			using object_key = std::pair<index_type,subindex_type>;
+
+			id_type _node;
+			uint8_t _blockSize;
+			std::map<object_key,std::vector<data_type>> _objects;
+
+			// Transfer in progress
+			server_state _state;
+			index_type _index;
+			subindex_type _subindex;
+			std::vector<data_type> _buffer;
+			std::size_t _offset;
+			std::size_t _blockStart;
+			bool _toggle;
+			bool _crc;
+			uint8_t _sequence;
+			uint8_t _transferBlockSize;
+			uint8_t _lastSequence;
+
+			void Respond(std::vector<can::Message>& responses, data_type command, std::array<data_type,4> data = {});
+			void Segment(std::vector<can::Message>& responses, data_type command, const data_type* data, std::size_t size);
+			void Abort(std::vector<can::Message>& responses, uint32_t code);
+			void SendBlock(std::vector<can::Message>& responses);
+
+			void UploadInitiate(const can_frame& frame, std::vector<can::Message>& responses);
+			void UploadSegment(const can_frame& frame, std::vector<can::Message>& responses);
+			void DownloadInitiate(const can_frame& frame, std::vector<can::Message>& responses);
+			void DownloadSegment(const can_frame& frame, std::vector<can::Message>& responses);
+			void BlockUpload(const can_frame& frame, std::vector<can::Message>& responses);
+			void BlockDownload(const can_frame& frame, std::vector<can::Message>& responses);
+			void BlockDownloadSegment(const can_frame& frame, std::vector<can::Message>& responses);
+
+		public:
+			// Constructor / destructor
+			explicit sdo_server(id_type node);
+			~sdo_server() = default;
+
+			id_type node() const;
+
+			// Object dictionary
+			void set(index_type index, subindex_type subindex, std::vector<data_type> data);
+			const std::vector<data_type>* get(index_type index, subindex_type subindex) const;
+
+			// Number of segments per block requested by block downloads (1-127)
+			void set_block_size(uint8_t size);
+
+			// Handles a request, adding the responses - returns false when it is not an SDO request to this node
+			bool process(const can::Message& request, std::vector<can::Message>& responses);
+	};
+}
@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////
+// Simulated CANOpen node
+//
+// Slave node with an object dictionary, the NMT state machine, a
+// heartbeat producer and up to four TPDOs sent on their event timers.
+// SDO requests are answered by an sdo_server holding the object
+// dictionary, so the communication parameters can be configured over
+// SDO as on a real node:
+//   0x1017       producer heartbeat time (ms)
+//   0x1800+n     TPDO communication parameters - COB-ID (sub 1, bit 31
+//                disables the PDO) and event timer (sub 5, ms)
+//   0x1A00+n     TPDO mapping - number of entries (sub 0) and entries
+//                as index << 16 | subindex << 8 | bit length
+// Mapped objects are read from the object dictionary whenever a TPDO
+// is sent. The dictionary survives NMT resets, as if it was stored.
+//
+// The node is driven by one thread: frames are fed to process, and
+// poll sends the heartbeats and TPDOs that are due. Times are
+// CLOCK_MONOTONIC in nanoseconds.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <can/include/sdo_server.h>
+
+namespace canopen
+{
+	class simulated_node
+	{
+		public:
+			static constexpr std::size_t tpdo_count = 4;
+
+		private:
+			struct tpdo_state
+			{
+				bool enabled = false;
+				canid_t cobid = 0;
+				int64_t period = 0;	// Event timer in nanoseconds, 0 if disabled
+				int64_t next = 0;
+				std::vector<uint32_t> mapping;
+			};
+
+			sdo_server _server;
+			nmt_type _state;	// unknown until started
+			int64_t _heartbeatPeriod;	// Nanoseconds, 0 if disabled
+			int64_t _nextHeartbeat;
+			std::array<tpdo_state,tpdo_count> _tpdos;
+			bool _dirty;	// Set when the dictionary may have changed since the configuration was loaded
+
+			void Boot(int64_t now, std::vector<can::Message>& output);
+			void LoadConfiguration(int64_t now);
+			bool BuildTpdo(const tpdo_state& tpdo, can_frame& frame) const;
+
+		public:
+			// Constructor / destructor - the dictionary holds the mandatory objects and disabled TPDOs
+			explicit simulated_node(id_type node);
+			~simulated_node() = default;
+
+			id_type node() const;
+			nmt_type state() const;	// As sent in heartbeats
+
+			// Object dictionary
+			void set(index_type index, subindex_type subindex, std::vector<data_type> data);
+			const std::vector<data_type>* get(index_type index, subindex_type subindex) const;
+
+			// Configuration through the object dictionary - takes effect when processing or polling next
+			void set_heartbeat(std::chrono::milliseconds period);	// 0 disables heartbeats
+			bool set_tpdo(std::size_t number, const std::vector<uint32_t>& mapping, std::chrono::milliseconds period);	// TPDO 1-4, 0 disables it
+
+			// Powers up the node, sending the boot-up message
+			void start(int64_t now, std::vector<can::Message>& output);
+
+			// Handles NMT commands and SDO requests - returns false if the frame is not for this node
+			bool process(const can::Message& message, int64_t now, std::vector<can::Message>& output);
+
+			// Sends the heartbeat and TPDOs that are due
+			void poll(int64_t now, std::vector<can::Message>& output);
+
+			// Time of the next heartbeat or TPDO, or INT64_MAX if none
+			int64_t next_deadline() const;
+	};
+}
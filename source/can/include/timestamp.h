@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////
+// Timestamps
+//
+// Conversions between timespec and nanoseconds, and alignment of
+// receive timestamps with CLOCK_MONOTONIC. Messages are stamped in
+// CLOCK_REALTIME, which jumps when the system time is set; mapping
+// them to CLOCK_MONOTONIC makes frame latencies comparable across
+// buses, and with times taken by the application.
+//
+// Hardware timestamps run on the clock of the CAN controller. A
+// clock_alignment estimates its offset to another clock from pairs of
+// readings of the same events, e.g. the hardware and software receive
+// timestamps of a frame: the software timestamp is taken later, by a
+// varying delay, so the smallest difference within the recent windows
+// is the best estimate. Short windows follow the drift of the clocks.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+
+#include <can/include/Message.h>
+
+namespace can
+{
+	constexpr auto to_nanoseconds(const timespec& time) -> int64_t
+	{
+		return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+	}
+
+	constexpr auto to_timespec(int64_t nanoseconds) -> timespec
+	{
+		auto seconds = nanoseconds / 1000000000;
+		auto remainder = nanoseconds % 1000000000;
+		if(remainder < 0)
+		{
+			seconds--;
+			remainder += 1000000000;
+		}
+		return timespec{ static_cast<time_t>(seconds), static_cast<long>(remainder) };
+	}
+
+	// Current time of a clock in nanoseconds
+	int64_t clock_nanoseconds(clockid_t clock);
+
+	// CLOCK_MONOTONIC minus CLOCK_REALTIME, from the closest of a few back-to-back readings
+	int64_t monotonic_offset();
+
+	// Maps a CLOCK_REALTIME time (e.g. a message timestamp) to CLOCK_MONOTONIC, with the current offset
+	int64_t to_monotonic(const timespec& realtime);
+
+	// Timestamp of a message, or the current CLOCK_REALTIME time for messages without one (e.g. created locally)
+	timespec message_time(const can::Message& message);
+
+	class clock_alignment
+	{
+		private:
+			int64_t _window;	// Length of a window in source clock nanoseconds
+			int64_t _windowStart;
+			int64_t _current;	// Smallest difference in the current window
+			int64_t _previous;	// Smallest difference in the previous window
+			uint64_t _samples;
+
+		public:
+			// Constructor / destructor
+			explicit clock_alignment(std::chrono::nanoseconds window = std::chrono::milliseconds(100));
+			~clock_alignment() = default;
+
+			// Adds a pair of readings of one event - the reference reading is the later one
+			void update(int64_t source, int64_t reference);
+			void reset();
+
+			bool valid() const;
+			int64_t offset() const;	// Reference minus source clock
+			int64_t to_reference(int64_t source) const;
+	};
+}
@@ -6,12 +6,25 @@
 #include <can/include/Message.h>
 
 // --------------------------------------------------------------------
-// Constructor
+// Constructors
 // --------------------------------------------------------------------
-can::Message::Message(can_frame& message) :
-	_message(message),
-	_interface("")
+can::Message::Message(const can_frame& message) :
+	_fdMessage{},
+	_timestamp{},
+	_interface(0),
+	_timestampSource(timestamp_source::software)
 {
+	_message = message;
+	_fdMessage.flags = 0;
+}
+
+can::Message::Message(const canfd_frame& message) :
+	_fdMessage(message),
+	_timestamp{},
+	_interface(0),
+	_timestampSource(timestamp_source::software)
+{
+	_fdMessage.flags |= CANFD_FDF;
 }
 
 // --------------------------------------------------------------------
@@ -22,11 +35,11 @@ uint8_t& can::Message::operator[](int index)
 {
 	// TODO: Handle out-of-bounds properly
 	if(index < 0)
-		return _message.data[0];
-	else if(index > 7)
-		return _message.data[7];
+		return _fdMessage.data[0];
+	else if(index >= max_size())
+		return _fdMessage.data[max_size() - 1];
 
-	return _message.data[index];
+	return _fdMessage.data[index];
 }
 
 // --------------------------------------------------------------------
@@ -50,6 +63,24 @@ uint8_t can::Message::size() const
 	return _message.len;
 }
 
+// Checks whether the frame is a CAN FD frame
+bool can::Message::is_fd() const
+{
+	return (_fdMessage.flags & CANFD_FDF) != 0;
+}
+
+// Returns the largest number of data bytes of the frame type
+uint8_t can::Message::max_size() const
+{
+	return is_fd() ? CANFD_MAX_DLEN : CAN_MAX_DLEN;
+}
+
+// Returns the size of the frame structure exchanged with the kernel
+std::size_t can::Message::mtu() const
+{
+	return is_fd() ? CANFD_MTU : CAN_MTU;
+}
+
 // Sets the CAN ID
 void can::Message::set_id(uint32_t id)
 {
@@ -68,6 +99,14 @@ void can::Message::set_size(uint8_t size)
 	_message.len = size;
 }
 
+// Switches between classic and CAN FD frames - the flags of CAN FD frames are cleared
+void can::Message::set_fd(bool fd)
+{
+	_fdMessage.flags = fd ? CANFD_FDF : 0;
+	if(!fd && _fdMessage.len > CAN_MAX_DLEN)
+		_fdMessage.len = CAN_MAX_DLEN;
+}
+
 // --------------------------------------------------------------------
 // Access to internal
 // --------------------------------------------------------------------
@@ -83,24 +122,46 @@ const can_frame& can::Message::get_frame() const
 	return _message;
 }
 
-std::string can::Message::get_interface() const
+// Provides access to the frame as a CAN FD frame - the flags hold CANFD_FDF for CAN FD frames
+canfd_frame& can::Message::get_fd_frame()
+{
+	return _fdMessage;
+}
+
+const canfd_frame& can::Message::get_fd_frame() const
+{
+	return _fdMessage;
+}
+
+// Returns the index of the interface that received the message
+int can::Message::get_interface() const
 {
 	return _interface;
 }
 
-void can::Message::set_interface(const std::string& interface)
+void can::Message::set_interface(int interface)
 {
 	_interface = interface;
 }
 
-timeval& can::Message::get_timestamp()
+timespec& can::Message::get_timestamp()
 {
 	return _timestamp;
 }
 
-const timeval& can::Message::get_timestamp() const
+const timespec& can::Message::get_timestamp() const
 {
 	return _timestamp;
 }
 
+can::timestamp_source can::Message::get_timestamp_source() const
+{
+	return _timestampSource;
+}
+
+void can::Message::set_timestamp_source(timestamp_source source)
+{
+	_timestampSource = source;
+}
+
 // --------------------------------------------------------------------
@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////
+// Bit fields
+//
+// Batch extraction of one signal from many messages, with an AVX2
+// implementation selected at runtime on x86-64.
+///////////////////////////////////////////////////////////////////////
+#include <can/include/bitfield.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	// Extracts a signal from each message, one at a time
+	template <bool is_signed>
+	void extract_scalar(const can::Message* messages, std::size_t count, std::size_t shift, std::size_t length, can::byte_order order, uint64_t* values)
+	{
+		auto mask = can::bitfield_mask(length);
+		auto sign = is_signed ? uint64_t{1} << (length - 1) : 0;
+		for(std::size_t i = 0; i < count; i++)
+		{
+			auto value = (can::load_payload(messages[i].get_frame().data, order) >> shift) & mask;
+			values[i] = (value ^ sign) - sign;
+		}
+	}
+
+#if defined(__x86_64__)
+	// Extracts a signal from four messages at a time - the payloads are gathered at the stride of the messages
+	template <bool is_signed, bool swap>
+	__attribute__((target("avx2")))
+	void extract_avx2(const can::Message* messages, std::size_t count, std::size_t shift, std::size_t length, uint64_t* values)
+	{
+		constexpr long long stride = sizeof(can::Message);
+		const auto* base = reinterpret_cast<const long long*>(messages[0].get_frame().data);
+
+		const auto step = _mm256_set1_epi64x(4 * stride);
+		const auto mask = _mm256_set1_epi64x(static_cast<long long>(can::bitfield_mask(length)));
+		const auto sign = _mm256_set1_epi64x(static_cast<long long>(uint64_t{1} << (length - 1)));
+		const auto shiftCount = _mm_cvtsi64_si128(static_cast<long long>(shift));
+		const auto byteSwap = _mm256_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+			8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+		auto offsets = _mm256_set_epi64x(3 * stride, 2 * stride, stride, 0);
+
+		std::size_t i = 0;
+		for(; i + 4 <= count; i += 4)
+		{
+			auto payload = _mm256_i64gather_epi64(base, offsets, 1);
+			if constexpr (swap)
+				payload = _mm256_shuffle_epi8(payload, byteSwap);
+
+			auto value = _mm256_and_si256(_mm256_srl_epi64(payload, shiftCount), mask);
+			if constexpr (is_signed)
+				value = _mm256_sub_epi64(_mm256_xor_si256(value, sign), sign);
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(values + i), value);
+			offsets = _mm256_add_epi64(offsets, step);
+		}
+
+		extract_scalar<is_signed>(messages + i, count - i, shift, length, swap ? can::byte_order::big_endian : can::byte_order::little_endian, values + i);
+	}
+#endif
+
+	template <bool is_signed>
+	void extract_batch(const can::Message* messages, std::size_t count, std::size_t start, std::size_t length, can::byte_order order, uint64_t* values)
+	{
+		auto shift = can::bitfield_shift(start, length, order);
+#if defined(__x86_64__)
+		static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+		if(hasAVX2 && count >= 4)
+		{
+			if(order == can::byte_order::big_endian)
+				extract_avx2<is_signed,true>(messages, count, shift, length, values);
+			else
+				extract_avx2<is_signed,false>(messages, count, shift, length, values);
+			return;
+		}
+#endif
+		extract_scalar<is_signed>(messages, count, shift, length, order, values);
+	}
+}
+
+// Extracts an unsigned signal from each message
+void can::extract_unsigned(const Message* messages, std::size_t count, std::size_t start, std::size_t length, byte_order order, uint64_t* values)
+{
+	extract_batch<false>(messages, count, start, length, order, values);
+}
+
+// Extracts a two's complement signal from each message
+void can::extract_signed(const Message* messages, std::size_t count, std::size_t start, std::size_t length, byte_order order, int64_t* values)
+{
+	extract_batch<true>(messages, count, start, length, order, reinterpret_cast<uint64_t*>(values));
+}
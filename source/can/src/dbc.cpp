@@ -0,0 +1,488 @@
+///////////////////////////////////////////////////////////////////////
+// DBC database implementation
+//
+// The file is memory mapped and parsed line by line in place. Comments
+// (CM_) may contain line breaks, and are skipped as a whole.
+///////////////////////////////////////////////////////////////////////
+#include <can/include/dbc.h>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+	// ID of the pseudo-message holding signals which belong to no message
+	constexpr uint32_t independent_signals_id = 0xC0000000;
+
+	// Parsing of the tokens of a statement
+	class cursor
+	{
+		private:
+			const char* _position;
+			const char* _end;
+
+		public:
+			cursor(const char* begin, const char* end) : _position(begin), _end(end) {}
+
+			void skip_spaces()
+			{
+				while(_position < _end && (*_position == ' ' || *_position == '\t' || *_position == '\r'))
+					_position++;
+			}
+
+			// Consumes a character, after any spaces
+			bool literal(char c)
+			{
+				skip_spaces();
+				if(_position == _end || *_position != c)
+					return false;
+				_position++;
+				return true;
+			}
+
+			// Checks the next character, after any spaces
+			bool peek(char c)
+			{
+				skip_spaces();
+				return (_position < _end && *_position == c);
+			}
+
+			bool identifier(std::string_view& value)
+			{
+				skip_spaces();
+				auto begin = _position;
+				while(_position < _end && (std::isalnum(static_cast<unsigned char>(*_position)) || *_position == '_'))
+					_position++;
+				value = std::string_view(begin, static_cast<std::size_t>(_position - begin));
+				return !value.empty();
+			}
+
+			bool number(uint64_t& value)
+			{
+				skip_spaces();
+				auto result = std::from_chars(_position, _end, value);
+				if(result.ec != std::errc())
+					return false;
+				_position = result.ptr;
+				return true;
+			}
+
+			bool number(double& value)
+			{
+				skip_spaces();
+				if(_position < _end && *_position == '+')
+					_position++;
+				auto result = std::from_chars(_position, _end, value);
+				if(result.ec != std::errc())
+					return false;
+				_position = result.ptr;
+				return true;
+			}
+
+			// A string in double quotes, without escapes
+			bool quoted(std::string_view& value)
+			{
+				if(!literal('"'))
+					return false;
+				auto begin = _position;
+				while(_position < _end && *_position != '"')
+					_position++;
+				if(_position == _end)
+					return false;
+				value = std::string_view(begin, static_cast<std::size_t>(_position - begin));
+				_position++;
+				return true;
+			}
+	};
+
+	// Checks whether a line starts with a keyword followed by a space
+	bool starts_with(const char* begin, const char* end, std::string_view keyword)
+	{
+		auto length = keyword.size();
+		return (static_cast<std::size_t>(end - begin) > length && std::memcmp(begin, keyword.data(), length) == 0
+			&& (begin[length] == ' ' || begin[length] == '\t'));
+	}
+
+	// Converts a DBC message ID - bit 31 marks extended IDs
+	canid_t message_id(uint64_t id)
+	{
+		if(id & 0x80000000)
+			return static_cast<canid_t>((id & CAN_EFF_MASK) | CAN_EFF_FLAG);
+		return static_cast<canid_t>(id & CAN_SFF_MASK);
+	}
+
+	// Parses "BO_ id name: size transmitter"
+	bool parse_message(cursor& c, uint64_t& id, can::dbc::message& message)
+	{
+		std::string_view name, transmitter;
+		uint64_t size = 0;
+		if(!c.number(id) || !c.identifier(name) || !c.literal(':') || !c.number(size) || size > 64)
+			return false;
+		c.identifier(transmitter);
+
+		message.id = message_id(id);
+		message.name = std::string(name);
+		message.size = static_cast<uint8_t>(size);
+		message.transmitter = std::string(transmitter);
+		return true;
+	}
+
+	// Parses "SG_ name [M|mX] : start|length@order sign (factor,offset) [minimum|maximum] "unit" receivers"
+	bool parse_signal(cursor& c, can::dbc::signal& signal)
+	{
+		std::string_view name, mux, unit;
+		if(!c.identifier(name))
+			return false;
+		signal.name = std::string(name);
+
+		// Multiplexing: "M" for the multiplexor, "mX" for signals present when the multiplexor is X
+		if(!c.peek(':'))
+		{
+			if(!c.identifier(mux))
+				return false;
+			if(mux == "M")
+				signal.mux = can::dbc::multiplexing::multiplexor;
+			else if(mux[0] == 'm' && mux.size() > 1)
+			{
+				auto result = std::from_chars(mux.data() + 1, mux.data() + mux.size(), signal.mux_value);
+				if(result.ec != std::errc())
+					return false;
+				signal.mux = can::dbc::multiplexing::multiplexed;
+			}
+			else
+				return false;
+		}
+
+		uint64_t start = 0, length = 0;
+		if(!c.literal(':') || !c.number(start) || !c.literal('|') || !c.number(length) || !c.literal('@'))
+			return false;
+
+		if(c.literal('1'))
+			signal.order = can::byte_order::little_endian;
+		else if(c.literal('0'))
+			signal.order = can::byte_order::big_endian;
+		else
+			return false;
+
+		if(c.literal('-'))
+			signal.is_signed = true;
+		else if(!c.literal('+'))
+			return false;
+
+		if(!c.literal('(') || !c.number(signal.factor) || !c.literal(',') || !c.number(signal.offset) || !c.literal(')'))
+			return false;
+		if(!c.literal('[') || !c.number(signal.minimum) || !c.literal('|') || !c.number(signal.maximum) || !c.literal(']'))
+			return false;
+		if(!c.quoted(unit))
+			return false;
+
+		if(start > 63 || length == 0 || length > 64 || !can::valid_bitfield(start, length, signal.order))
+			return false;
+
+		signal.start = static_cast<uint16_t>(start);
+		signal.length = static_cast<uint8_t>(length);
+		signal.unit = std::string(unit);
+		return true;
+	}
+}
+
+namespace can::dbc
+{
+	// --------------------------------------------------------------------
+	// Constructor
+	// --------------------------------------------------------------------
+	database::database() :
+		_messages(),
+		_steps(),
+		_programs(),
+		_standard{},
+		_extended(),
+		_skipped(0)
+	{
+	}
+
+	// --------------------------------------------------------------------
+	// Loading
+	// --------------------------------------------------------------------
+	// Maps a DBC file and parses it
+	bool database::load(const std::string& path)
+	{
+		auto file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if(file < 0)
+			return false;
+
+		struct stat status;
+		if(fstat(file, &status) < 0)
+		{
+			::close(file);
+			return false;
+		}
+
+		auto size = static_cast<std::size_t>(status.st_size);
+		if(size == 0)
+		{
+			::close(file);
+			return parse(std::string_view());
+		}
+
+		void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+		::close(file);
+		if(data == MAP_FAILED)
+			return false;
+
+		madvise(data, size, MADV_SEQUENTIAL);
+		auto result = parse(std::string_view(static_cast<const char*>(data), size));
+		munmap(data, size);
+		return result;
+	}
+
+	// Parses the text of a DBC file
+	bool database::parse(std::string_view text)
+	{
+		auto skipped = _skipped;
+		auto p = text.data();
+		auto end = p + text.size();
+		message* current = nullptr;	// Message of the following signals
+
+		while(p < end)
+		{
+			auto lineEnd = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+			if(lineEnd == nullptr)
+				lineEnd = end;
+
+			auto line = p;
+			while(line < lineEnd && (*line == ' ' || *line == '\t'))
+				line++;
+			p = lineEnd + 1;
+
+			if(starts_with(line, lineEnd, "BO_"))
+			{
+				cursor c(line + 3, lineEnd);
+				uint64_t id = 0;
+				message parsed;
+				current = nullptr;
+				if(!parse_message(c, id, parsed))
+					_skipped++;
+				else if(id != independent_signals_id)
+				{
+					_messages.push_back(std::move(parsed));
+					current = &_messages.back();
+				}
+			}
+			else if(starts_with(line, lineEnd, "SG_"))
+			{
+				cursor c(line + 3, lineEnd);
+				signal parsed;
+				if(!parse_signal(c, parsed))
+					_skipped++;
+				else if(current != nullptr)
+					current->signals.push_back(std::move(parsed));
+			}
+			else if(starts_with(line, lineEnd, "SIG_VALTYPE_"))
+			{
+				// "SIG_VALTYPE_ id name : type;" - 1 for float, 2 for double
+				cursor c(line + 12, lineEnd);
+				uint64_t id = 0, type = 0;
+				std::string_view name;
+				if(!c.number(id) || !c.identifier(name) || !c.literal(':') || !c.number(type) || type < 1 || type > 2)
+				{
+					_skipped++;
+					continue;
+				}
+
+				auto found = std::find_if(_messages.rbegin(), _messages.rend(), [&](const message& m) { return m.id == message_id(id); });
+				if(found == _messages.rend())
+					continue;
+				// A float must fill the signal exactly - other lengths are invalid, and the signal stays an integer
+				for(auto& s : found->signals)
+				{
+					if(s.name != name)
+						continue;
+					if(s.length == ((type == 1) ? 32 : 64))
+						s.type = (type == 1) ? value_type::float32 : value_type::float64;
+					else
+						_skipped++;
+				}
+			}
+			else if(starts_with(line, lineEnd, "CM_"))
+			{
+				// The comment string may span lines - continue after its closing quote
+				auto quote = static_cast<const char*>(std::memchr(line, '"', static_cast<std::size_t>(lineEnd - line)));
+				if(quote == nullptr)
+					continue;
+				for(quote++; quote < end && *quote != '"'; quote++)
+					if(*quote == '\\' && quote + 1 < end)
+						quote++;
+				if(quote >= end)
+					break;
+
+				auto next = static_cast<const char*>(std::memchr(quote, '\n', static_cast<std::size_t>(end - quote)));
+				p = (next == nullptr) ? end : next + 1;
+			}
+		}
+
+		Compile();
+		return (_skipped == skipped);
+	}
+
+	// Removes all messages
+	void database::clear()
+	{
+		_messages.clear();
+		_skipped = 0;
+		Compile();
+	}
+
+	// Returns the number of statements skipped as invalid
+	uint64_t database::skipped() const
+	{
+		return _skipped;
+	}
+
+	// --------------------------------------------------------------------
+	// Lookup
+	// --------------------------------------------------------------------
+	// Returns all messages
+	const std::vector<message>& database::messages() const
+	{
+		return _messages;
+	}
+
+	// Returns the message of an ID
+	const message* database::find(canid_t id) const
+	{
+		auto index = FindMessage(id);
+		return (index < 0) ? nullptr : &_messages[static_cast<std::size_t>(index)];
+	}
+
+	// Returns the message of a name
+	const message* database::find(std::string_view name) const
+	{
+		for(const auto& m : _messages)
+			if(m.name == name)
+				return &m;
+		return nullptr;
+	}
+
+	// --------------------------------------------------------------------
+	// Decoding
+	// --------------------------------------------------------------------
+	// Runs the decode program of a frame
+	std::size_t database::decode(const can::Message& message, double* values) const
+	{
+		auto index = FindMessage(message.id());
+		if(index < 0)
+			return 0;
+
+		const auto& program = _programs[static_cast<std::size_t>(index)];
+		if(message.size() < program.size)
+			return 0;
+
+		auto little = load_payload(message.get_frame().data);
+		auto big = __builtin_bswap64(little);
+		auto steps = _steps.data() + program.first;
+
+		auto raw = [&](const decode_step& step)
+		{
+			return (((step.swap ? big : little) >> step.shift) & step.mask);
+		};
+
+		uint64_t muxValue = (program.multiplexor < 0) ? 0 : raw(steps[program.multiplexor]);
+		for(uint32_t i = 0; i < program.count; i++)
+		{
+			const auto& step = steps[i];
+			auto value = raw(step);
+
+			double physical;
+			if(step.type == value_type::float32)
+			{
+				float f;
+				auto bits = static_cast<uint32_t>(value);
+				std::memcpy(&f, &bits, sizeof(f));
+				physical = f;
+			}
+			else if(step.type == value_type::float64)
+				std::memcpy(&physical, &value, sizeof(physical));
+			else if(step.sign != 0)
+				physical = static_cast<double>(static_cast<int64_t>((value ^ step.sign) - step.sign));
+			else
+				physical = static_cast<double>(value);
+
+			values[i] = (step.multiplexed && step.mux_value != muxValue) ? std::numeric_limits<double>::quiet_NaN() : physical * step.factor + step.offset;
+		}
+
+		return program.count;
+	}
+
+	// --------------------------------------------------------------------
+	// Private methods
+	// --------------------------------------------------------------------
+	// Builds the decode programs and the ID index - later messages replace earlier ones with the same ID
+	void database::Compile()
+	{
+		_steps.clear();
+		_programs.clear();
+		_standard.fill(0);
+		_extended.clear();
+
+		for(uint32_t i = 0; i < _messages.size(); i++)
+		{
+			const auto& m = _messages[i];
+			decode_program program{ static_cast<uint32_t>(_steps.size()), static_cast<uint32_t>(m.signals.size()), -1, std::min<uint8_t>(m.size, 8) };
+
+			for(uint32_t j = 0; j < m.signals.size(); j++)
+			{
+				const auto& s = m.signals[j];
+				decode_step step{};
+				step.mask = bitfield_mask(s.length);
+				step.sign = (s.is_signed && s.type == value_type::integer) ? uint64_t{1} << (s.length - 1) : 0;
+				step.factor = s.factor;
+				step.offset = s.offset;
+				step.mux_value = s.mux_value;
+				step.shift = static_cast<uint8_t>(bitfield_shift(s.start, s.length, s.order));
+				step.swap = (s.order == byte_order::big_endian);
+				step.multiplexed = (s.mux == multiplexing::multiplexed);
+				step.type = s.type;
+				_steps.push_back(step);
+
+				if(s.mux == multiplexing::multiplexor)
+					program.multiplexor = static_cast<int32_t>(j);
+			}
+			_programs.push_back(program);
+
+			if(m.id & CAN_EFF_FLAG)
+				_extended.emplace_back(m.id, i);
+			else
+				_standard[m.id] = i + 1;
+		}
+
+		// Keep the last message of each extended ID
+		std::stable_sort(_extended.begin(), _extended.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+		auto last = std::unique(_extended.rbegin(), _extended.rend(), [](const auto& a, const auto& b) { return a.first == b.first; });
+		_extended.erase(_extended.begin(), last.base());
+	}
+
+	// Returns the index of the message of an ID, or -1
+	int64_t database::FindMessage(canid_t id) const
+	{
+		if(id & (CAN_RTR_FLAG | CAN_ERR_FLAG))
+			return -1;
+
+		if(!(id & CAN_EFF_FLAG))
+			return static_cast<int64_t>(_standard[id & CAN_SFF_MASK]) - 1;
+
+		id &= (CAN_EFF_FLAG | CAN_EFF_MASK);
+		auto found = std::lower_bound(_extended.begin(), _extended.end(), id, [](const auto& e, canid_t value) { return e.first < value; });
+		if(found == _extended.end() || found->first != id)
+			return -1;
+		return found->second;
+	}
+}
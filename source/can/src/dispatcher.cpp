@@ -0,0 +1,144 @@
+///////////////////////////////////////////////////////////////////////
+// CANOpen frame dispatcher
+//
+// Routes received frames to handlers through a flat table of 2048
+// handler slots, with a sorted table for extended IDs.
+///////////////////////////////////////////////////////////////////////
+#include <can/include/dispatcher.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+	// Function codes with a single COB-ID (or two for LSS), without a node ID
+	bool without_node(canopen::function_code code)
+	{
+		return (code == canopen::function_code::nmt || code == canopen::function_code::sync
+			|| code == canopen::function_code::time || code == canopen::function_code::lss);
+	}
+}
+
+namespace canopen
+{
+	// Constructor
+	dispatcher::dispatcher() :
+		_handlers(1),
+		_standard(),
+		_extended()
+	{
+	}
+
+	// --------------------------------------------------------------------
+	// Private methods
+	// --------------------------------------------------------------------
+	// Stores a handler in a new slot
+	bool dispatcher::AddHandler(handler_type&& handler, uint16_t& slot)
+	{
+		if(_handlers.size() > std::numeric_limits<uint16_t>::max())
+			return false;
+
+		slot = static_cast<uint16_t>(_handlers.size());
+		_handlers.push_back(std::move(handler));
+		return true;
+	}
+
+	// Returns the handler slot of an ID
+	uint16_t dispatcher::FindSlot(canid_t id) const
+	{
+		if((id & CAN_EFF_FLAG) == 0)
+			return _standard[id & CAN_SFF_MASK];
+
+		auto key = id & CAN_EFF_MASK;
+		auto entry = std::lower_bound(_extended.begin(), _extended.end(), key, [](const auto& e, canid_t k) { return e.first < k; });
+		return (entry != _extended.end() && entry->first == key) ? entry->second : 0;
+	}
+
+	// --------------------------------------------------------------------
+	// Registration
+	// --------------------------------------------------------------------
+	// Registers a handler for all IDs of a function code
+	bool dispatcher::on(function_code code, handler_type handler)
+	{
+		uint16_t slot;
+		if(code == function_code::unknown || !AddHandler(std::move(handler), slot))
+			return false;
+
+		for(std::size_t id = 0; id < _standard.size(); id++)
+			if(function_code_table[id] == code)
+				_standard[id] = slot;
+		return true;
+	}
+
+	// Registers a handler for the ID of a function code and node
+	bool dispatcher::on(function_code code, id_type node, handler_type handler)
+	{
+		if(without_node(code))
+			return on(code, std::move(handler));
+
+		auto id = get_function_base(code) + (node & 0x7F);
+		if(id > CAN_SFF_MASK || function_code_table[id] != code)
+			return false;
+		return on_id(id, std::move(handler));
+	}
+
+	// Registers a handler for a COB-ID
+	bool dispatcher::on_id(canid_t id, handler_type handler)
+	{
+		uint16_t slot;
+		if(!AddHandler(std::move(handler), slot))
+			return false;
+
+		if((id & CAN_EFF_FLAG) == 0)
+		{
+			_standard[id & CAN_SFF_MASK] = slot;
+			return true;
+		}
+
+		auto key = id & CAN_EFF_MASK;
+		auto entry = std::lower_bound(_extended.begin(), _extended.end(), key, [](const auto& e, canid_t k) { return e.first < k; });
+		if(entry != _extended.end() && entry->first == key)
+			entry->second = slot;
+		else
+			_extended.emplace(entry, key, slot);
+		return true;
+	}
+
+	// Registers the handler of frames without a handler
+	void dispatcher::set_default(handler_type handler)
+	{
+		_handlers[0] = std::move(handler);
+	}
+
+	// Removes all handlers
+	void dispatcher::clear()
+	{
+		_handlers.resize(1);
+		_handlers[0] = nullptr;
+		_standard.fill(0);
+		_extended.clear();
+	}
+
+	// --------------------------------------------------------------------
+	// Dispatching
+	// --------------------------------------------------------------------
+	bool dispatcher::dispatch(const can::Message& message) const
+	{
+		// Error frames and remote requests are not data frames of the ID
+		auto id = message.id();
+		const auto& handler = _handlers[(id & (CAN_RTR_FLAG | CAN_ERR_FLAG)) ? 0 : FindSlot(id)];
+		if(!handler)
+			return false;
+
+		handler(message);
+		return true;
+	}
+
+	std::size_t dispatcher::dispatch(const can::Message* messages, std::size_t count) const
+	{
+		std::size_t handled = 0;
+		for(std::size_t i = 0; i < count; i++)
+			handled += dispatch(messages[i]) ? 1 : 0;
+		return handled;
+	}
+}
@@ -0,0 +1,206 @@
+///////////////////////////////////////////////////////////////////////
+// CANOpen emergency history implementation
+///////////////////////////////////////////////////////////////////////
+#include <can/include/emcy_history.h>
+
+#include <algorithm>
+
+#include <can/include/timestamp.h>
+
+namespace
+{
+	// Bits of the counter table size for a number of codes, keeping it at most half full
+	unsigned int table_bits(std::size_t codes)
+	{
+		unsigned int bits = 4;
+		while((std::size_t{1} << bits) < 2 * codes)
+			bits++;
+		return bits;
+	}
+
+	uint32_t counter_key(canopen::id_type node, uint16_t code)
+	{
+		return ((static_cast<uint32_t>(node) << 16) | code) + 1;
+	}
+}
+
+namespace canopen
+{
+	// --------------------------------------------------------------------
+	// Constructor
+	// --------------------------------------------------------------------
+	emcy_history::emcy_history(std::size_t events_per_node, std::size_t tracked_codes) :
+		_capacity(std::max<std::size_t>(events_per_node, 1)),
+		_events(max_nodes * _capacity),
+		_totals{},
+		_counters(std::size_t{1} << table_bits(tracked_codes), counter{ 0, 0 }),
+		_counterShift(32 - table_bits(tracked_codes)),
+		_maxCodes(tracked_codes),
+		_codes(0),
+		_untracked(0)
+	{
+	}
+
+	// --------------------------------------------------------------------
+	// Processing
+	// --------------------------------------------------------------------
+	// Records an emergency frame
+	bool emcy_history::process(const can::Message& message)
+	{
+		const auto& frame = message.get_frame();
+		if((frame.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) || !is_emcy(frame))
+			return false;
+
+		// 0x080 itself is SYNC
+		auto node = get_id(frame);
+		if(node == 0)
+			return false;
+
+		auto& event = _events[node * _capacity + _totals[node] % _capacity];
+		event.emcy = get_emcy(frame);
+		event.timestamp = can::message_time(message);
+		_totals[node]++;
+
+		auto counter = FindCounter(counter_key(node, event.emcy.error_code));
+		if(counter != nullptr)
+			counter->count++;
+		else
+			_untracked++;
+
+		return true;
+	}
+
+	// Records a number of frames
+	std::size_t emcy_history::process(const can::Message* messages, std::size_t count)
+	{
+		std::size_t used = 0;
+		for(std::size_t i = 0; i < count; i++)
+			used += process(messages[i]) ? 1 : 0;
+		return used;
+	}
+
+	// Forgets all events and counters
+	void emcy_history::clear()
+	{
+		_totals.fill(0);
+		std::fill(_counters.begin(), _counters.end(), counter{ 0, 0 });
+		_codes = 0;
+		_untracked = 0;
+	}
+
+	// --------------------------------------------------------------------
+	// History
+	// --------------------------------------------------------------------
+	// Returns the number of events kept for a node
+	std::size_t emcy_history::size(id_type node) const
+	{
+		return (node < max_nodes) ? static_cast<std::size_t>(std::min<uint64_t>(_totals[node], _capacity)) : 0;
+	}
+
+	// Returns the number of events kept per node
+	std::size_t emcy_history::capacity() const
+	{
+		return _capacity;
+	}
+
+	// Returns an event of a node, counting back from the latest
+	const emcy_event& emcy_history::event(id_type node, std::size_t index) const
+	{
+		auto position = (_totals[node] - 1 - index) % _capacity;
+		return _events[node * _capacity + position];
+	}
+
+	// Returns the number of events received from a node
+	uint64_t emcy_history::total(id_type node) const
+	{
+		return (node < max_nodes) ? _totals[node] : 0;
+	}
+
+	// --------------------------------------------------------------------
+	// Counters
+	// --------------------------------------------------------------------
+	// Returns the number of events of a node with an error code
+	uint64_t emcy_history::count(id_type node, uint16_t code) const
+	{
+		auto counter = FindCounter(counter_key(node, code));
+		return (counter != nullptr) ? counter->count : 0;
+	}
+
+	// Returns the number of events with an error code
+	uint64_t emcy_history::count(uint16_t code) const
+	{
+		uint64_t result = 0;
+		for(const auto& c : _counters)
+			if(c.key != 0 && static_cast<uint16_t>(c.key - 1) == code)
+				result += c.count;
+		return result;
+	}
+
+	// Returns the number of events with error codes of a class
+	uint64_t emcy_history::count(emcy_class type) const
+	{
+		uint64_t result = 0;
+		for(const auto& c : _counters)
+			if(c.key != 0 && get_emcy_class(static_cast<uint16_t>(c.key - 1)) == type)
+				result += c.count;
+		return result;
+	}
+
+	// Returns all non-zero counters
+	std::vector<emcy_count> emcy_history::counts() const
+	{
+		std::vector<emcy_count> result;
+		for(const auto& c : _counters)
+			if(c.key != 0 && c.count > 0)
+				result.push_back(emcy_count{ static_cast<id_type>((c.key - 1) >> 16), static_cast<uint16_t>(c.key - 1), c.count });
+
+		std::sort(result.begin(), result.end(), [](const auto& a, const auto& b)
+		{
+			return (a.node < b.node) || (a.node == b.node && a.error_code < b.error_code);
+		});
+		return result;
+	}
+
+	// Returns the number of events which could not be counted per error code
+	uint64_t emcy_history::untracked() const
+	{
+		return _untracked;
+	}
+
+	// --------------------------------------------------------------------
+	// Private methods
+	// --------------------------------------------------------------------
+	// Returns the counter of a key, taking an unused counter if there is room - returns nullptr otherwise
+	emcy_history::counter* emcy_history::FindCounter(uint32_t key)
+	{
+		auto mask = _counters.size() - 1;
+		for(auto i = (key * 0x9E3779B1u) >> _counterShift;; i = (i + 1) & mask)
+		{
+			auto& c = _counters[i];
+			if(c.key == key)
+				return &c;
+			if(c.key == 0)
+			{
+				if(_codes == _maxCodes)
+					return nullptr;
+				_codes++;
+				c.key = key;
+				return &c;
+			}
+		}
+	}
+
+	// Returns the counter of a key - returns nullptr if there is none
+	const emcy_history::counter* emcy_history::FindCounter(uint32_t key) const
+	{
+		auto mask = _counters.size() - 1;
+		for(auto i = (key * 0x9E3779B1u) >> _counterShift;; i = (i + 1) & mask)
+		{
+			const auto& c = _counters[i];
+			if(c.key == key)
+				return &c;
+			if(c.key == 0)
+				return nullptr;
+		}
+	}
+}
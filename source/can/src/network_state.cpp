@@ -0,0 +1,161 @@
+///////////////////////////////////////////////////////////////////////
+// CANOpen network state implementation
+///////////////////////////////////////////////////////////////////////
+#include <can/include/network_state.h>
+
+#include <can/include/timestamp.h>
+
+namespace canopen
+{
+	// --------------------------------------------------------------------
+	// Constructor
+	// --------------------------------------------------------------------
+	network_state::network_state() :
+		_nodes{},
+		_published(),
+		_timeouts{},
+		_changes(0)
+	{
+	}
+
+	// --------------------------------------------------------------------
+	// Configuration
+	// --------------------------------------------------------------------
+	// Sets the heartbeat timeout of all nodes
+	void network_state::set_heartbeat_timeout(std::chrono::milliseconds timeout)
+	{
+		_timeouts.fill(std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count());
+	}
+
+	// Sets the heartbeat timeout of a node
+	void network_state::set_heartbeat_timeout(id_type node, std::chrono::milliseconds timeout)
+	{
+		if(node > 0 && node < max_nodes)
+			_timeouts[node] = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+	}
+
+	// Forgets the state of all nodes
+	void network_state::reset()
+	{
+		for(id_type node = 1; node < max_nodes; node++)
+		{
+			_nodes[node] = node_status{};
+			Publish(node);
+		}
+	}
+
+	// --------------------------------------------------------------------
+	// Processing
+	// --------------------------------------------------------------------
+	// Updates the state of a node from a heartbeat or NMT command
+	bool network_state::process(const can::Message& message)
+	{
+		const auto& frame = message.get_frame();
+		if((frame.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) || !is_nmt(frame))
+			return false;
+
+		// NMT command to one node, or to all nodes (node 0)
+		if(frame.can_id == 0x000)
+		{
+			if(frame.len < 2 || frame.data[1] >= max_nodes)
+				return false;
+
+			auto command = static_cast<nmt_type>(frame.data[0]);
+			auto target = static_cast<id_type>(frame.data[1]);
+			for(id_type node = (target == 0) ? 1 : target; node <= ((target == 0) ? max_nodes - 1 : target); node++)
+			{
+				_nodes[node].command = command;
+				Publish(node);
+			}
+			return true;
+		}
+
+		// Heartbeat - the top bit is the toggle bit of node guarding
+		auto node = get_id(frame);
+		if(node == 0 || frame.len < 1)
+			return false;
+
+		auto& status = _nodes[node];
+		status.state = static_cast<nmt_type>(frame.data[0] & 0x7F);
+		if(status.state == nmt_type::state_boot_up)
+			status.boot_ups++;
+		status.heartbeats++;
+		status.timed_out = false;
+
+		status.last_heartbeat = can::message_time(message);
+
+		Publish(node);
+		return true;
+	}
+
+	// Processes a number of frames
+	std::size_t network_state::process(const can::Message* messages, std::size_t count)
+	{
+		std::size_t used = 0;
+		for(std::size_t i = 0; i < count; i++)
+			used += process(messages[i]) ? 1 : 0;
+		return used;
+	}
+
+	// Marks nodes whose last heartbeat is older than their timeout
+	std::size_t network_state::check_timeouts(const timespec& now)
+	{
+		auto time = can::to_nanoseconds(now);
+		std::size_t count = 0;
+		for(id_type node = 1; node < max_nodes; node++)
+		{
+			auto& status = _nodes[node];
+			if(_timeouts[node] <= 0 || status.heartbeats == 0 || status.timed_out)
+				continue;
+
+			if(time - can::to_nanoseconds(status.last_heartbeat) > _timeouts[node])
+			{
+				status.timed_out = true;
+				status.timeouts++;
+				Publish(node);
+				count++;
+			}
+		}
+		return count;
+	}
+
+	// Checks the timeouts at the current time
+	std::size_t network_state::check_timeouts()
+	{
+		return check_timeouts(can::to_timespec(can::clock_nanoseconds(CLOCK_REALTIME)));
+	}
+
+	// --------------------------------------------------------------------
+	// Reading
+	// --------------------------------------------------------------------
+	// Returns the state of a node
+	node_status network_state::node(id_type node) const
+	{
+		return (node < max_nodes) ? _published[node].load() : node_status{};
+	}
+
+	// Returns the state of all nodes - each node is consistent in itself
+	network_state::snapshot_type network_state::snapshot() const
+	{
+		snapshot_type nodes;
+		for(std::size_t node = 0; node < max_nodes; node++)
+			nodes[node] = _published[node].load();
+		return nodes;
+	}
+
+	// Returns the number of updates published
+	uint64_t network_state::changes() const
+	{
+		return _changes.load(std::memory_order_acquire);
+	}
+
+	// --------------------------------------------------------------------
+	// Private methods
+	// --------------------------------------------------------------------
+	// Publishes the state of a node to readers
+	void network_state::Publish(id_type node)
+	{
+		_published[node].store(_nodes[node]);
+		_changes.store(_changes.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+}
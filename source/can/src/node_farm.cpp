@@ -0,0 +1,302 @@
+///////////////////////////////////////////////////////////////////////
+// Farm of simulated CANOpen nodes
+//
+// Routes received frames to worker threads, which drive the nodes and
+// send their responses, heartbeats and TPDOs.
+///////////////////////////////////////////////////////////////////////
+#include <can/include/node_farm.h>
+
+#include <algorithm>
+#include <climits>
+#include <ctime>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace
+{
+	int64_t monotonic_time()
+	{
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+	}
+
+	void notify(int event)
+	{
+		uint64_t one = 1;
+		auto written = write(event, &one, sizeof(one));
+		(void)written;
+	}
+}
+
+namespace canopen
+{
+	// --------------------------------------------------------------------
+	// Constructor / destructor
+	// --------------------------------------------------------------------
+	node_farm::node_farm(can::interfaces::ICANInterface& interface, std::size_t threads, int stopLatency) :
+		_interface(interface),
+		_threads(std::max<std::size_t>(threads, 1)),
+		_stopLatency(stopLatency),
+		_nodes(),
+		_owners(),
+		_workers(),
+		_receiver(),
+		_sendMutex(),
+		_running(false),
+		_received(0),
+		_sent(0),
+		_dropped(0)
+	{
+	}
+
+	node_farm::~node_farm()
+	{
+		stop();
+	}
+
+	// --------------------------------------------------------------------
+	// Private methods
+	// --------------------------------------------------------------------
+	// Receive thread - routes NMT commands and SDO requests to the workers of the addressed nodes
+	void node_farm::Receive()
+	{
+		std::array<can::Message,_batchSize> batch;
+		std::vector<worker*> woken;
+
+		while(_running.load(std::memory_order_relaxed))
+		{
+			auto received = _interface.RequestMessages(batch.data(), batch.size());
+			for(std::size_t i = 0; i < received; i++)
+			{
+				const auto& frame = batch[i].get_frame();
+				if(frame.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG))
+					continue;
+
+				// NMT commands for all nodes go to every worker
+				if(frame.can_id == 0 && frame.len >= 2 && frame.data[1] == 0)
+				{
+					for(auto& w : _workers)
+						if(Queue(*w, batch[i]))
+							woken.push_back(w.get());
+					continue;
+				}
+
+				id_type target = 0;
+				if(frame.can_id == 0 && frame.len >= 2)
+					target = frame.data[1];
+				else if(is_sdo_request(frame))
+					target = get_id(frame);
+
+				auto owner = (target > 0 && target < max_nodes) ? _owners[target] : nullptr;
+				if(owner != nullptr && Queue(*owner, batch[i]))
+					woken.push_back(owner);
+			}
+
+			// Wake the workers that sleep
+			std::sort(woken.begin(), woken.end());
+			woken.erase(std::unique(woken.begin(), woken.end()), woken.end());
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			for(auto w : woken)
+				if(w->armed.load(std::memory_order_relaxed) && w->armed.exchange(false))
+					notify(w->event);
+			woken.clear();
+		}
+	}
+
+	// Worker thread - processes queued frames, polls the nodes and sleeps until the next deadline
+	void node_farm::Work(worker& w)
+	{
+		std::vector<can::Message> output;
+		std::array<can::Message,_batchSize> batch;
+
+		auto now = monotonic_time();
+		for(auto n : w.nodes)
+			n->start(now, output);
+		Send(output);
+
+		while(_running.load(std::memory_order_relaxed))
+		{
+			now = monotonic_time();
+			while(auto count = w.queue.pop(batch.data(), batch.size()))
+			{
+				for(std::size_t i = 0; i < count; i++)
+				{
+					const auto& frame = batch[i].get_frame();
+					if(frame.can_id == 0 && frame.data[1] == 0)
+					{
+						for(auto n : w.nodes)
+							n->process(batch[i], now, output);
+					}
+					else
+					{
+						auto target = (frame.can_id == 0) ? frame.data[1] : get_id(frame);
+						_nodes[target]->process(batch[i], now, output);
+					}
+				}
+				_received.fetch_add(count, std::memory_order_relaxed);
+			}
+
+			int64_t deadline = INT64_MAX;
+			for(auto n : w.nodes)
+			{
+				n->poll(now, output);
+				deadline = std::min(deadline, n->next_deadline());
+			}
+			Send(output);
+
+			// Ask for a wake-up, then check again for frames queued meanwhile
+			uint64_t value;
+			auto cleared = read(w.event, &value, sizeof(value));
+			(void)cleared;
+			w.armed.store(true);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if(!w.queue.empty())
+			{
+				w.armed.store(false);
+				continue;
+			}
+
+			auto wait = std::min<int64_t>(deadline - monotonic_time(), static_cast<int64_t>(_stopLatency) * 1000000);
+			if(wait <= 0)
+			{
+				w.armed.store(false);
+				continue;
+			}
+
+			pollfd p;
+			p.fd = w.event;
+			p.events = POLLIN;
+			timespec timeout{ static_cast<time_t>(wait / 1000000000), static_cast<long>(wait % 1000000000) };
+			ppoll(&p, 1, &timeout, nullptr);
+			w.armed.store(false);
+		}
+	}
+
+	// Sends the output of a worker, one worker at a time
+	void node_farm::Send(std::vector<can::Message>& output)
+	{
+		if(output.empty())
+			return;
+
+		std::size_t sent;
+		{
+			std::lock_guard<std::mutex> lock(_sendMutex);
+			sent = _interface.SendMessages(output.data(), output.size());
+		}
+
+		_sent.fetch_add(sent, std::memory_order_relaxed);
+		_dropped.fetch_add(output.size() - sent, std::memory_order_relaxed);
+		output.clear();
+	}
+
+	// Queues a frame for a worker - returns false if the queue is full
+	bool node_farm::Queue(worker& w, const can::Message& message)
+	{
+		if(w.queue.push(message))
+			return true;
+
+		_dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	// --------------------------------------------------------------------
+	// Nodes
+	// --------------------------------------------------------------------
+	simulated_node* node_farm::add(id_type node)
+	{
+		if(node == 0 || node >= max_nodes || _nodes[node] || running())
+			return nullptr;
+
+		_nodes[node] = std::make_unique<simulated_node>(node);
+		return _nodes[node].get();
+	}
+
+	simulated_node* node_farm::node(id_type node)
+	{
+		return (node < max_nodes) ? _nodes[node].get() : nullptr;
+	}
+
+	std::size_t node_farm::size() const
+	{
+		return static_cast<std::size_t>(std::count_if(_nodes.begin(), _nodes.end(), [](const auto& n) { return n != nullptr; }));
+	}
+
+	// --------------------------------------------------------------------
+	// Running
+	// --------------------------------------------------------------------
+	// Shares the nodes between the workers, and starts the threads - the interface is switched to non-blocking mode
+	bool node_farm::start()
+	{
+		if(running() || size() == 0)
+			return false;
+
+		_workers.clear();
+		for(std::size_t i = 0; i < std::min(_threads, size()); i++)
+		{
+			_workers.push_back(std::make_unique<worker>());
+			_workers.back()->event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		}
+
+		std::size_t count = 0;
+		for(std::size_t i = 0; i < max_nodes; i++)
+		{
+			_owners[i] = nullptr;
+			if(!_nodes[i])
+				continue;
+
+			_owners[i] = _workers[count++ % _workers.size()].get();
+			_owners[i]->nodes.push_back(_nodes[i].get());
+		}
+
+		_interface.SetTimeout(_stopLatency);
+		_interface.SetBlockingMode(false);
+
+		_running.store(true);
+		for(auto& w : _workers)
+			w->thread = std::thread(&node_farm::Work, this, std::ref(*w));
+		_receiver = std::thread(&node_farm::Receive, this);
+		return true;
+	}
+
+	// Stops the threads - nodes keep their state, and power up again when restarted
+	void node_farm::stop()
+	{
+		if(!_running.exchange(false))
+			return;
+
+		_receiver.join();
+		for(auto& w : _workers)
+		{
+			notify(w->event);
+			w->thread.join();
+			close(w->event);
+		}
+		_workers.clear();
+		_owners.fill(nullptr);
+	}
+
+	bool node_farm::running() const
+	{
+		return _running.load(std::memory_order_relaxed);
+	}
+
+	// --------------------------------------------------------------------
+	// Counters
+	// --------------------------------------------------------------------
+	uint64_t node_farm::received() const
+	{
+		return _received.load(std::memory_order_relaxed);
+	}
+
+	uint64_t node_farm::sent() const
+	{
+		return _sent.load(std::memory_order_relaxed);
+	}
+
+	uint64_t node_farm::dropped() const
+	{
+		return _dropped.load(std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,624 @@
+///////////////////////////////////////////////////////////////////////
+// CANOpen SDO client
+//
+// Runs SDO transfers to many nodes concurrently, with one outstanding
+// transfer per node.
+///////////////////////////////////////////////////////////////////////
+#include <can/include/sdo_client.h>
+
+#include <algorithm>
+#include <memory>
+
+namespace
+{
+	// SDO command specifiers of requests from the client
+	constexpr canopen::data_type download_segmented = 0x21;	// Size indicated
+	constexpr canopen::data_type upload_segment = 0x60;
+	constexpr canopen::data_type block_download_initiate = 0xC6;	// CRC supported, size indicated
+	constexpr canopen::data_type block_download_end = 0xC1;
+	constexpr canopen::data_type block_upload_initiate = 0xA4;	// CRC supported
+	constexpr canopen::data_type block_upload_start = 0xA3;
+	constexpr canopen::data_type block_upload_ack = 0xA2;
+	constexpr canopen::data_type block_upload_end = 0xA1;
+
+	// SDO command specifiers of responses from the server
+	constexpr canopen::data_type upload_response = 0x40;
+	constexpr canopen::data_type download_response = 0x60;
+	constexpr canopen::data_type upload_segment_response = 0x00;
+	constexpr canopen::data_type download_segment_response = 0x20;
+	constexpr canopen::data_type command_mask = 0xE0;
+	constexpr canopen::data_type block_download_response = 0xA0;
+	constexpr canopen::data_type block_download_ack = 0xA2;
+	constexpr canopen::data_type block_download_done = 0xA1;
+	constexpr canopen::data_type block_upload_response = 0xC0;
+	constexpr canopen::data_type block_upload_done = 0xC1;
+	constexpr canopen::data_type block_mask = 0xE3;
+
+	// Bits of the command byte
+	constexpr canopen::data_type toggle_bit = 0x10;
+	constexpr canopen::data_type crc_bit = 0x04;
+	constexpr canopen::data_type last_segment = 0x80;
+
+	// Maximum number of segments per block
+	constexpr uint8_t max_block_size = 127;
+
+	// Data bytes per segment
+	constexpr std::size_t segment_size = 7;
+
+	uint32_t response_value(const can_frame& frame)
+	{
+		return static_cast<uint32_t>(frame.data[4]) | (static_cast<uint32_t>(frame.data[5]) << 8)
+			| (static_cast<uint32_t>(frame.data[6]) << 16) | (static_cast<uint32_t>(frame.data[7]) << 24);
+	}
+
+	bool valid_block_size(uint8_t size)
+	{
+		return (size > 0 && size <= max_block_size);
+	}
+}
+
+// --------------------------------------------------------------------
+// SDO result
+// --------------------------------------------------------------------
+// Returns the data as a little-endian value
+uint32_t canopen::sdo_result::value() const
+{
+	uint32_t result = 0;
+	for(std::size_t i = 0; i < data.size() && i < sizeof(result); i++)
+		result |= static_cast<uint32_t>(data[i]) << (8*i);
+	return result;
+}
+
+namespace canopen
+{
+	// Constructor
+	sdo_client::sdo_client(can::interfaces::ICANInterface& interface, std::chrono::milliseconds timeout) :
+		_interface(interface),
+		_timeout(timeout),
+		_blockSize(max_block_size),
+		_mutex(),
+		_nodes(),
+		_queued(0),
+		_batch(),
+		_outgoing(),
+		_outgoingNodes(),
+		_completions(),
+		_delivering()
+	{
+	}
+
+	// --------------------------------------------------------------------
+	// Private methods
+	// --------------------------------------------------------------------
+	// Queues a transfer - requests to invalid nodes fail at once
+	void sdo_client::Queue(id_type node, transfer&& request)
+	{
+		if(node == 0 || node >= _nodeCount)
+		{
+			sdo_result result;
+			result.node = node;
+			result.index = request.index;
+			result.subindex = request.subindex;
+			if(request.callback)
+				request.callback(result);
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		_nodes[node].queue.push_back(std::move(request));
+		_queued++;
+	}
+
+	// Adds a frame to the next batch - "node" is the node whose transfer fails if the frame cannot be sent, or 0
+	void sdo_client::Push(const can_frame& frame, id_type node)
+	{
+		_outgoing.emplace_back(frame);
+		_outgoingNodes.push_back(node);
+	}
+
+	// Sends the initiate request of the first queued transfer of a node
+	void sdo_client::Start(id_type node, node_state& state, clock_type::time_point now)
+	{
+		auto& request = state.queue.front();
+		auto size = static_cast<uint32_t>(request.data.size());
+		switch(request.type)
+		{
+			case transfer_type::upload:
+				Push(message_sdo_request(node, as_data(sdo_type::read), request.index, request.subindex), node);
+				break;
+
+			case transfer_type::download:
+				if(size <= 4)
+				{
+					// Expedited download, with the number of unused bytes in the command
+					std::array<data_type,4> data{};
+					std::copy(request.data.begin(), request.data.end(), data.begin());
+					auto command = static_cast<data_type>(as_data(sdo_type::write_4bytes) | ((4 - size) << 2));
+					Push(message_sdo_request(node, command, request.index, request.subindex, data), node);
+				}
+				else
+				{
+					Push(message_sdo_request(node, download_segmented, request.index, request.subindex, map_to_data<4>(size)), node);
+				}
+				break;
+
+			case transfer_type::block_upload:
+				request.blockSize = _blockSize;
+				Push(message_sdo_request(node, block_upload_initiate, request.index, request.subindex, {{ _blockSize, 0 }}), node);
+				break;
+
+			case transfer_type::block_download:
+				Push(message_sdo_request(node, block_download_initiate, request.index, request.subindex, map_to_data<4>(size)), node);
+				break;
+		}
+
+		state.active = true;
+		state.deadline = now + _timeout;
+	}
+
+	// Completes the outstanding transfer of a node - the callback is called when the mutex is released
+	void sdo_client::Complete(id_type node, node_state& state, sdo_status status, uint32_t abortCode, std::vector<data_type>&& data)
+	{
+		auto& request = state.queue.front();
+
+		sdo_result result;
+		result.node = node;
+		result.index = request.index;
+		result.subindex = request.subindex;
+		result.status = status;
+		result.abort_code = abortCode;
+		result.data = std::move(data);
+		_completions.emplace_back(std::move(request.callback), std::move(result));
+
+		state.queue.pop_front();
+		state.active = false;
+		_queued--;
+	}
+
+	// Aborts the outstanding transfer of a node, and tells the node
+	void sdo_client::Abort(id_type node, node_state& state, sdo_status status, uint32_t abortCode)
+	{
+		const auto& request = state.queue.front();
+		Push(message_sdo_abort(node, request.index, request.subindex, abortCode), 0);
+
+		Complete(node, state, status, abortCode);
+	}
+
+	// Sends the next segment of a segmented download
+	void sdo_client::SendSegment(id_type node, transfer& request)
+	{
+		auto bytes = std::min(segment_size, request.data.size() - request.offset);
+		auto last = (request.offset + bytes == request.data.size());
+		auto command = static_cast<data_type>((request.toggle ? toggle_bit : 0) | ((segment_size - bytes) << 1) | (last ? 1 : 0));
+
+		Push(message_sdo_segment(sdo_request_id(node), command, request.data.data() + request.offset, bytes), node);
+		request.offset += bytes;
+	}
+
+	// Sends the next block of a block download, starting at the last acknowledged byte
+	void sdo_client::SendBlock(id_type node, transfer& request)
+	{
+		request.blockStart = request.offset;
+		request.sequence = 0;
+		request.lastSequence = 0;
+		while(request.sequence < request.blockSize && request.offset < request.data.size())
+		{
+			auto bytes = std::min(segment_size, request.data.size() - request.offset);
+			auto last = (request.offset + bytes == request.data.size());
+			request.sequence++;
+			if(last)
+				request.lastSequence = request.sequence;
+
+			auto command = static_cast<data_type>(request.sequence | (last ? last_segment : 0));
+			Push(message_sdo_segment(sdo_request_id(node), command, request.data.data() + request.offset, bytes), node);
+			request.offset += bytes;
+		}
+	}
+
+	// Handles a response to the outstanding transfer of a node
+	void sdo_client::HandleResponse(id_type node, node_state& state, const can_frame& frame)
+	{
+		const auto& request = state.queue.front();
+		if(frame.len != 8)
+			return;
+
+		// Aborts and initiate responses carry the index and subindex of the transfer
+		auto matches = (get_sdo_cobid(frame) == request.index && frame.data[3] == request.subindex);
+		if(frame.data[0] == as_data(sdo_type::abort))
+		{
+			if(matches)
+				Complete(node, state, sdo_status::aborted, response_value(frame));
+			return;
+		}
+		if(request.phase == transfer_phase::initiate && !matches)
+			return;
+
+		switch(request.type)
+		{
+			case transfer_type::upload:
+				HandleUpload(node, state, frame);
+				break;
+			case transfer_type::download:
+				HandleDownload(node, state, frame);
+				break;
+			case transfer_type::block_upload:
+				HandleBlockUpload(node, state, frame);
+				break;
+			case transfer_type::block_download:
+				HandleBlockDownload(node, state, frame);
+				break;
+		}
+	}
+
+	// Handles a response to an upload - expedited, or segmented
+	void sdo_client::HandleUpload(id_type node, node_state& state, const can_frame& frame)
+	{
+		auto& request = state.queue.front();
+		auto command = frame.data[0];
+
+		if(request.phase == transfer_phase::initiate)
+		{
+			if((command & command_mask) != upload_response)
+				return Abort(node, state, sdo_status::aborted, sdo_abort_code::invalid_command);
+
+			// Expedited upload, with the number of unused bytes in the command when the size is indicated
+			if((command & 0x02) != 0)
+			{
+				std::size_t size = (command & 0x01) ? 4 - ((command >> 2) & 0x03) : 4;
+				return Complete(node, state, sdo_status::success, 0, std::vector<data_type>(frame.data + 4, frame.data + 4 + size));
+			}
+
+			request.size = (command & 0x01) ? response_value(frame) : 0;
+			request.data.reserve(std::min<std::size_t>(request.size, 1 << 24));
+			request.phase = transfer_phase::segment;
+		}
+		else
+		{
+			if((command & command_mask) != upload_segment_response)
+				return Abort(node, state, sdo_status::aborted, sdo_abort_code::invalid_command);
+			if(((command & toggle_bit) != 0) != request.toggle)
+				return Abort(node, state, sdo_status::aborted, sdo_abort_code::toggle_bit);
+
+			auto bytes = segment_size - ((command >> 1) & 0x07);
+			request.data.insert(request.data.end(), frame.data + 1, frame.data + 1 + bytes);
+			if((command & 0x01) != 0)
+			{
+				if(request.size != 0 && request.data.size() != request.size)
+					return Abort(node, state, sdo_status::aborted, sdo_abort_code::length_mismatch);
+				return Complete(node, state, sdo_status::success, 0, std::move(request.data));
+			}
+
+			request.toggle = !request.toggle;
+		}
+
+		auto segmentRequest = static_cast<data_type>(upload_segment | (request.toggle ? toggle_bit : 0));
+		Push(message_sdo_segment(sdo_request_id(node), segmentRequest, nullptr, 0), node);
+	}
+
+	// Handles a response to a download - expedited, or segmented
+	void sdo_client::HandleDownload(id_type node, node_state& state, const can_frame& frame)
+	{
+		auto& request = state.queue.front();
+		auto command = frame.data[0];
+
+		if(request.phase == transfer_phase::initiate)
+		{
+			if(command != download_response)
+				return Abort(node, state, sdo_status::aborted, sdo_abort_code::invalid_command);
+			if(request.data.size() <= 4)
+				return Complete(node, state, sdo_status::success, 0);
+
+			request.phase = transfer_phase::segment;
+		}
+		else
+		{
+			if((command & command_mask) != download_segment_response)
+				return Abort(node, state, sdo_status::aborted, sdo_abort_code::invalid_command);
+			if(((command & toggle_bit) != 0) != request.toggle)
+				return Abort(node, state, sdo_status::aborted, sdo_abort_code::toggle_bit);
+			if(request.offset == request.data.size())
+				return Complete(node, state, sdo_status::success, 0);
+
+			request.toggle = !request.toggle;
+		}
+
+		SendSegment(node, request);
+	}
+
+	// Handles the segments and end of a block upload
+	void sdo_client::HandleBlockUpload(id_type node, node_state& state, const can_frame& frame)
+	{
+		auto& request = state.queue.front();
+		auto command = frame.data[0];
+
+		if(request.phase == transfer_phase::initiate)
+		{
+			if((command & 0xE1) != block_upload_response)
+				return Abort(node, state, sdo_status::aborted, sdo_abort_code::invalid_command);
+
+			request.crc = (command & crc_bit) != 0;
+			request.size = (command & 0x02) ? response_value(frame) : 0;
+			request.data.reserve(std::min<std::size_t>(request.size, 1 << 24));
+			request.phase = transfer_phase::block;
+			request.sequence = 0;
+			Push(message_sdo_segment(sdo_request_id(node), block_upload_start, nullptr, 0), node);
+		}
+		else if(request.phase == transfer_phase::block)
+		{
+			// Segments out of sequence are dropped, and sent again after the acknowledgement
+			auto sequence = static_cast<uint8_t>(command & ~last_segment);
+			auto last = (command & last_segment) != 0;
+			auto inSequence = (sequence == request.sequence + 1);
+			if(inSequence)
+			{
+				request.data.insert(request.data.end(), frame.data + 1, frame.data + 8);
+				request.sequence = sequence;
+			}
+
+			if(last || sequence >= request.blockSize)
+			{
+				std::array<data_type,2> ack{{ request.sequence, request.blockSize }};
+				Push(message_sdo_segment(sdo_request_id(node), block_upload_ack, ack.data(), ack.size()), node);
+				request.sequence = 0;
+				if(last && inSequence)
+					request.phase = transfer_phase::end;
+			}
+		}
+		else
+		{
+			if((command & block_mask) != block_upload_done)
+				return Abort(node, state, sdo_status::aborted, sdo_abort_code::invalid_command);
+
+			// Remove the unused bytes of the last segment
+			std::size_t unused = (command >> 2) & 0x07;
+			if(unused > request.data.size() || (request.size != 0 && request.data.size() - unused != request.size))
+				return Abort(node, state, sdo_status::aborted, sdo_abort_code::length_mismatch);
+			request.data.resize(request.data.size() - unused);
+
+			auto crc = static_cast<uint16_t>(frame.data[1] | (frame.data[2] << 8));
+			if(request.crc && crc != sdo_crc(request.data.data(), request.data.size()))
+				return Abort(node, state, sdo_status::aborted, sdo_abort_code::crc_error);
+
+			Push(message_sdo_segment(sdo_request_id(node), block_upload_end, nullptr, 0), 0);
+			Complete(node, state, sdo_status::success, 0, std::move(request.data));
+		}
+	}
+
+	// Handles the acknowledgements and end of a block download
+	void sdo_client::HandleBlockDownload(id_type node, node_state& state, const can_frame& frame)
+	{
+		auto& request = state.queue.front();
+		auto command = frame.data[0];
+
+		if(request.phase == transfer_phase::initiate)
+		{
+			if((command & block_mask) != block_download_response)
+				return Abort(node, state, sdo_status::aborted, sdo_abort_code::invalid_command);
+			if(!valid_block_size(frame.data[4]))
+				return Abort(node, state, sdo_status::aborted, sdo_abort_code::invalid_block_size);
+
+			request.crc = (command & crc_bit) != 0;
+			request.blockSize = frame.data[4];
+			request.phase = transfer_phase::block;
+			SendBlock(node, request);
+		}
+		else if(request.phase == transfer_phase::block)
+		{
+			if((command & block_mask) != block_download_ack)
+				return Abort(node, state, sdo_status::aborted, sdo_abort_code::invalid_command);
+
+			auto acknowledged = frame.data[1];
+			if(acknowledged > request.sequence)
+				return Abort(node, state, sdo_status::aborted, sdo_abort_code::invalid_sequence);
+			if(!valid_block_size(frame.data[2]))
+				return Abort(node, state, sdo_status::aborted, sdo_abort_code::invalid_block_size);
+
+			// Continue after the last segment received by the node
+			request.offset = std::min(request.blockStart + acknowledged * segment_size, request.data.size());
+			if(request.lastSequence == 0 || acknowledged != request.lastSequence)
+			{
+				request.blockSize = frame.data[2];
+				return SendBlock(node, request);
+			}
+
+			// All data received - end with the number of unused bytes in the last segment, and the CRC
+			auto unused = (segment_size - request.data.size() % segment_size) % segment_size;
+			auto crc = request.crc ? sdo_crc(request.data.data(), request.data.size()) : 0;
+			std::array<data_type,2> end{{ static_cast<data_type>(crc & 0xFF), static_cast<data_type>(crc >> 8) }};
+			auto endCommand = static_cast<data_type>(block_download_end | (unused << 2));
+			Push(message_sdo_segment(sdo_request_id(node), endCommand, end.data(), end.size()), node);
+			request.phase = transfer_phase::end;
+		}
+		else
+		{
+			if((command & block_mask) != block_download_done)
+				return Abort(node, state, sdo_status::aborted, sdo_abort_code::invalid_command);
+			Complete(node, state, sdo_status::success, 0);
+		}
+	}
+
+	// Sends the collected frames in one batch, and calls the callbacks of completed transfers
+	void sdo_client::Flush()
+	{
+		if(!_outgoing.empty())
+		{
+			auto sent = _interface.SendMessages(_outgoing.data(), _outgoing.size());
+			if(sent < _outgoing.size())
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				for(std::size_t i = sent; i < _outgoing.size(); i++)
+				{
+					auto node = _outgoingNodes[i];
+					if(node != 0 && _nodes[node].active)
+						Complete(node, _nodes[node], sdo_status::failed, 0);
+				}
+			}
+
+			_outgoing.clear();
+			_outgoingNodes.clear();
+		}
+
+		// Callbacks may queue further transfers
+		_delivering.swap(_completions);
+		for(auto& entry : _delivering)
+			if(entry.first)
+				entry.first(entry.second);
+		_delivering.clear();
+	}
+
+	// --------------------------------------------------------------------
+	// Public methods
+	// --------------------------------------------------------------------
+	void sdo_client::set_timeout(std::chrono::milliseconds timeout)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_timeout = timeout;
+	}
+
+	void sdo_client::set_block_size(uint8_t size)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if(valid_block_size(size))
+			_blockSize = size;
+	}
+
+	// Queues an upload, with the result passed to the callback
+	void sdo_client::read(id_type node, index_type index, subindex_type subindex, callback_type callback)
+	{
+		Queue(node, transfer{ transfer_type::upload, index, subindex, {}, std::move(callback) });
+	}
+
+	// Queues an upload, with the result provided by the future
+	std::future<sdo_result> sdo_client::read(id_type node, index_type index, subindex_type subindex)
+	{
+		auto promise = std::make_shared<std::promise<sdo_result>>();
+		auto result = promise->get_future();
+		read(node, index, subindex, [promise](const sdo_result& r) { promise->set_value(r); });
+		return result;
+	}
+
+	// Queues a download, with the result passed to the callback
+	void sdo_client::write(id_type node, index_type index, subindex_type subindex, std::vector<data_type> data, callback_type callback)
+	{
+		if(data.empty())
+			node = 0;	// Fails at once
+		Queue(node, transfer{ transfer_type::download, index, subindex, std::move(data), std::move(callback) });
+	}
+
+	// Queues a download, with the result provided by the future
+	std::future<sdo_result> sdo_client::write(id_type node, index_type index, subindex_type subindex, std::vector<data_type> data)
+	{
+		auto promise = std::make_shared<std::promise<sdo_result>>();
+		auto result = promise->get_future();
+		write(node, index, subindex, std::move(data), [promise](const sdo_result& r) { promise->set_value(r); });
+		return result;
+	}
+
+	// Queues a block upload, with the result passed to the callback
+	void sdo_client::read_block(id_type node, index_type index, subindex_type subindex, callback_type callback)
+	{
+		Queue(node, transfer{ transfer_type::block_upload, index, subindex, {}, std::move(callback) });
+	}
+
+	// Queues a block upload, with the result provided by the future
+	std::future<sdo_result> sdo_client::read_block(id_type node, index_type index, subindex_type subindex)
+	{
+		auto promise = std::make_shared<std::promise<sdo_result>>();
+		auto result = promise->get_future();
+		read_block(node, index, subindex, [promise](const sdo_result& r) { promise->set_value(r); });
+		return result;
+	}
+
+	// Queues a block download, with the result passed to the callback
+	void sdo_client::write_block(id_type node, index_type index, subindex_type subindex, std::vector<data_type> data, callback_type callback)
+	{
+		if(data.empty())
+			node = 0;	// Fails at once
+		Queue(node, transfer{ transfer_type::block_download, index, subindex, std::move(data), std::move(callback) });
+	}
+
+	// Queues a block download, with the result provided by the future
+	std::future<sdo_result> sdo_client::write_block(id_type node, index_type index, subindex_type subindex, std::vector<data_type> data)
+	{
+		auto promise = std::make_shared<std::promise<sdo_result>>();
+		auto result = promise->get_future();
+		write_block(node, index, subindex, std::move(data), [promise](const sdo_result& r) { promise->set_value(r); });
+		return result;
+	}
+
+	// Matches received SDO responses to outstanding transfers, and starts the next transfer of each node answered
+	void sdo_client::process(const can::Message* messages, std::size_t count)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto now = clock_type::now();
+			for(std::size_t i = 0; i < count; i++)
+			{
+				const auto& frame = messages[i].get_frame();
+				if((frame.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) != 0 || !is_sdo_response(frame))
+					continue;
+
+				auto node = get_id(frame);
+				auto& state = _nodes[node];
+				if(!state.active)
+					continue;
+
+				// The timeout applies to each response
+				HandleResponse(node, state, frame);
+				if(state.active)
+					state.deadline = now + _timeout;
+				else if(!state.queue.empty())
+					Start(node, state, now);
+			}
+		}
+
+		Flush();
+	}
+
+	// Aborts timed out transfers, and starts transfers on idle nodes
+	void sdo_client::poll()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto now = clock_type::now();
+			for(id_type node = 1; _queued > 0 && node < _nodeCount; node++)
+			{
+				auto& state = _nodes[node];
+				if(state.active && now >= state.deadline)
+					Abort(node, state, sdo_status::timeout, sdo_abort_code::timeout);
+				if(!state.active && !state.queue.empty())
+					Start(node, state, now);
+			}
+		}
+
+		Flush();
+	}
+
+	// Receives and processes one batch of messages
+	std::size_t sdo_client::run_once()
+	{
+		poll();
+
+		auto count = _interface.RequestMessages(_batch.data(), _batch.size());
+		process(_batch.data(), count);
+		return count;
+	}
+
+	// Runs until all transfers are complete
+	void sdo_client::run_until_idle()
+	{
+		while(!idle())
+			run_once();
+	}
+
+	std::size_t sdo_client::pending() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _queued;
+	}
+
+	bool sdo_client::idle() const
+	{
+		return (pending() == 0);
+	}
+}
@@ -0,0 +1,354 @@
+///////////////////////////////////////////////////////////////////////
+// CANOpen SDO server
+//
+// Simulated node answering SDO requests from an object dictionary in
+// memory.
+///////////////////////////////////////////////////////////////////////
+#include <can/include/sdo_server.h>
+
+#include <algorithm>
+
+#include <can/include/sdo_client.h>
+
+namespace
+{
+	// Data bytes per segment
+	constexpr std::size_t segment_size = 7;
+
+	// Bits of the command byte
+	constexpr canopen::data_type toggle_bit = 0x10;
+	constexpr canopen::data_type last_segment = 0x80;
+
+	uint32_t request_value(const can_frame& frame)
+	{
+		return static_cast<uint32_t>(frame.data[4]) | (static_cast<uint32_t>(frame.data[5]) << 8)
+			| (static_cast<uint32_t>(frame.data[6]) << 16) | (static_cast<uint32_t>(frame.data[7]) << 24);
+	}
+}
+
+namespace canopen
+{
+	// Constructor
+	sdo_server::sdo_server(id_type node) :
+		_node(node),
+		_blockSize(127),
+		_objects(),
+		_state(server_state::idle),
+		_index(0),
+		_subindex(0),
+		_buffer(),
+		_offset(0),
+		_blockStart(0),
+		_toggle(false),
+		_crc(false),
+		_sequence(0),
+		_transferBlockSize(0),
+		_lastSequence(0)
+	{
+	}
+
+	// --------------------------------------------------------------------
+	// Private methods
+	// --------------------------------------------------------------------
+	// Adds a response with the index and subindex of the transfer
+	void sdo_server::Respond(std::vector<can::Message>& responses, data_type command, std::array<data_type,4> data)
+	{
+		responses.emplace_back(message_sdo_response(_node, command, _index, _subindex, data));
+	}
+
+	// Adds a segment response
+	void sdo_server::Segment(std::vector<can::Message>& responses, data_type command, const data_type* data, std::size_t size)
+	{
+		responses.emplace_back(message_sdo_segment(sdo_response_id(_node), command, data, size));
+	}
+
+	// Aborts the transfer in progress
+	void sdo_server::Abort(std::vector<can::Message>& responses, uint32_t code)
+	{
+		Respond(responses, as_data(sdo_type::abort), map_to_data<4>(code));
+		_state = server_state::idle;
+	}
+
+	// Sends the next block of a block upload, starting at the last acknowledged byte
+	void sdo_server::SendBlock(std::vector<can::Message>& responses)
+	{
+		_blockStart = _offset;
+		_sequence = 0;
+		_lastSequence = 0;
+		do
+		{
+			auto bytes = std::min(segment_size, _buffer.size() - _offset);
+			auto last = (_offset + bytes == _buffer.size());
+			_sequence++;
+			if(last)
+				_lastSequence = _sequence;
+
+			Segment(responses, static_cast<data_type>(_sequence | (last ? last_segment : 0)), _buffer.data() + _offset, bytes);
+			_offset += bytes;
+		} while(_sequence < _transferBlockSize && _lastSequence == 0);
+	}
+
+	// Upload initiate - expedited for up to 4 bytes, segmented otherwise
+	void sdo_server::UploadInitiate(const can_frame&, std::vector<can::Message>& responses)
+	{
+		auto object = get(_index, _subindex);
+		if(object == nullptr)
+			return Abort(responses, sdo_abort_code::no_object);
+
+		auto size = object->size();
+		if(size > 0 && size <= 4)
+		{
+			std::array<data_type,4> data{};
+			std::copy(object->begin(), object->end(), data.begin());
+			return Respond(responses, static_cast<data_type>(0x43 | ((4 - size) << 2)), data);
+		}
+
+		_buffer = *object;
+		_offset = 0;
+		_toggle = false;
+		_state = server_state::upload_segment;
+		Respond(responses, 0x41, map_to_data<4>(static_cast<uint32_t>(size)));
+	}
+
+	// Upload segment request
+	void sdo_server::UploadSegment(const can_frame& frame, std::vector<can::Message>& responses)
+	{
+		if(_state != server_state::upload_segment)
+			return Abort(responses, sdo_abort_code::invalid_command);
+		if(((frame.data[0] & toggle_bit) != 0) != _toggle)
+			return Abort(responses, sdo_abort_code::toggle_bit);
+
+		auto bytes = std::min(segment_size, _buffer.size() - _offset);
+		auto last = (_offset + bytes == _buffer.size());
+		Segment(responses, static_cast<data_type>((_toggle ? toggle_bit : 0) | ((segment_size - bytes) << 1) | (last ? 1 : 0)), _buffer.data() + _offset, bytes);
+
+		_offset += bytes;
+		_toggle = !_toggle;
+		if(last)
+			_state = server_state::idle;
+	}
+
+	// Download initiate - expedited, or segmented
+	void sdo_server::DownloadInitiate(const can_frame& frame, std::vector<can::Message>& responses)
+	{
+		auto command = frame.data[0];
+		if((command & 0x02) != 0)
+		{
+			std::size_t size = (command & 0x01) ? 4 - ((command >> 2) & 0x03) : 4;
+			set(_index, _subindex, std::vector<data_type>(frame.data + 4, frame.data + 4 + size));
+		}
+		else
+		{
+			_buffer.clear();
+			_toggle = false;
+			_state = server_state::download_segment;
+		}
+
+		Respond(responses, 0x60);
+	}
+
+	// Download segment
+	void sdo_server::DownloadSegment(const can_frame& frame, std::vector<can::Message>& responses)
+	{
+		auto command = frame.data[0];
+		if(_state != server_state::download_segment)
+			return Abort(responses, sdo_abort_code::invalid_command);
+		if(((command & toggle_bit) != 0) != _toggle)
+			return Abort(responses, sdo_abort_code::toggle_bit);
+
+		auto bytes = segment_size - ((command >> 1) & 0x07);
+		_buffer.insert(_buffer.end(), frame.data + 1, frame.data + 1 + bytes);
+		Segment(responses, static_cast<data_type>(0x20 | (_toggle ? toggle_bit : 0)), nullptr, 0);
+
+		_toggle = !_toggle;
+		if((command & 0x01) != 0)
+		{
+			set(_index, _subindex, std::move(_buffer));
+			_state = server_state::idle;
+		}
+	}
+
+	// Block upload initiate, start, acknowledgement and end
+	void sdo_server::BlockUpload(const can_frame& frame, std::vector<can::Message>& responses)
+	{
+		switch(frame.data[0] & 0x03)
+		{
+			case 0:	// Initiate
+			{
+				auto object = get(_index, _subindex);
+				if(object == nullptr)
+					return Abort(responses, sdo_abort_code::no_object);
+				if(frame.data[4] == 0 || frame.data[4] > 127)
+					return Abort(responses, sdo_abort_code::invalid_block_size);
+
+				_buffer = *object;
+				_offset = 0;
+				_crc = (frame.data[0] & 0x04) != 0;
+				_transferBlockSize = frame.data[4];
+				_state = server_state::block_upload_start;
+				return Respond(responses, 0xC6, map_to_data<4>(static_cast<uint32_t>(_buffer.size())));
+			}
+
+			case 3:	// Start
+				if(_state != server_state::block_upload_start)
+					return Abort(responses, sdo_abort_code::invalid_command);
+				_state = server_state::block_upload;
+				return SendBlock(responses);
+
+			case 2:	// Acknowledgement
+			{
+				if(_state != server_state::block_upload)
+					return Abort(responses, sdo_abort_code::invalid_command);
+
+				auto acknowledged = frame.data[1];
+				if(acknowledged > _sequence)
+					return Abort(responses, sdo_abort_code::invalid_sequence);
+				if(frame.data[2] == 0 || frame.data[2] > 127)
+					return Abort(responses, sdo_abort_code::invalid_block_size);
+
+				_offset = std::min(_blockStart + acknowledged * segment_size, _buffer.size());
+				_transferBlockSize = frame.data[2];
+				if(_lastSequence == 0 || acknowledged != _lastSequence)
+					return SendBlock(responses);
+
+				// All data received - end with the number of unused bytes in the last segment, and the CRC
+				auto unused = (segment_size - _buffer.size() % segment_size) % segment_size;
+				if(_buffer.empty())
+					unused = segment_size;
+				auto crc = _crc ? sdo_crc(_buffer.data(), _buffer.size()) : 0;
+				std::array<data_type,2> end{{ static_cast<data_type>(crc & 0xFF), static_cast<data_type>(crc >> 8) }};
+				_state = server_state::block_upload_end;
+				return Segment(responses, static_cast<data_type>(0xC1 | (unused << 2)), end.data(), end.size());
+			}
+
+			case 1:	// End
+				if(_state != server_state::block_upload_end)
+					return Abort(responses, sdo_abort_code::invalid_command);
+				_state = server_state::idle;
+				return;
+		}
+	}
+
+	// Block download initiate and end
+	void sdo_server::BlockDownload(const can_frame& frame, std::vector<can::Message>& responses)
+	{
+		auto command = frame.data[0];
+		if((command & 0x01) == 0)	// Initiate
+		{
+			_buffer.clear();
+			if((command & 0x02) != 0)
+				_buffer.reserve(std::min<std::size_t>(request_value(frame), 1 << 24));
+			_crc = (command & 0x04) != 0;
+			_sequence = 0;
+			_state = server_state::block_download;
+			return Respond(responses, 0xA4, {{ _blockSize }});
+		}
+
+		// End
+		if(_state != server_state::block_download_end)
+			return Abort(responses, sdo_abort_code::invalid_command);
+
+		std::size_t unused = (command >> 2) & 0x07;
+		if(unused > _buffer.size())
+			return Abort(responses, sdo_abort_code::length_mismatch);
+		_buffer.resize(_buffer.size() - unused);
+
+		auto crc = static_cast<uint16_t>(frame.data[1] | (frame.data[2] << 8));
+		if(_crc && crc != sdo_crc(_buffer.data(), _buffer.size()))
+			return Abort(responses, sdo_abort_code::crc_error);
+
+		set(_index, _subindex, std::move(_buffer));
+		_state = server_state::idle;
+		Segment(responses, 0xA1, nullptr, 0);
+	}
+
+	// Block download segment - acknowledged at the end of each block
+	void sdo_server::BlockDownloadSegment(const can_frame& frame, std::vector<can::Message>& responses)
+	{
+		auto sequence = static_cast<uint8_t>(frame.data[0] & ~last_segment);
+		auto last = (frame.data[0] & last_segment) != 0;
+		auto inSequence = (sequence == _sequence + 1);
+		if(inSequence)
+		{
+			_buffer.insert(_buffer.end(), frame.data + 1, frame.data + 8);
+			_sequence = sequence;
+		}
+
+		if(last || sequence >= _blockSize)
+		{
+			std::array<data_type,2> ack{{ _sequence, _blockSize }};
+			Segment(responses, 0xA2, ack.data(), ack.size());
+			_sequence = 0;
+			if(last && inSequence)
+				_state = server_state::block_download_end;
+		}
+	}
+
+	// --------------------------------------------------------------------
+	// Public methods
+	// --------------------------------------------------------------------
+	id_type sdo_server::node() const
+	{
+		return _node;
+	}
+
+	void sdo_server::set(index_type index, subindex_type subindex, std::vector<data_type> data)
+	{
+		_objects[object_key(index, subindex)] = std::move(data);
+	}
+
+	const std::vector<data_type>* sdo_server::get(index_type index, subindex_type subindex) const
+	{
+		auto object = _objects.find(object_key(index, subindex));
+		return (object != _objects.end()) ? &object->second : nullptr;
+	}
+
+	void sdo_server::set_block_size(uint8_t size)
+	{
+		if(size > 0 && size <= 127)
+			_blockSize = size;
+	}
+
+	// Handles a request to this node
+	bool sdo_server::process(const can::Message& request, std::vector<can::Message>& responses)
+	{
+		const auto& frame = request.get_frame();
+		if(frame.can_id != sdo_request_id(_node) || frame.len != 8)
+			return false;
+
+		auto command = frame.data[0];
+		if(command == as_data(sdo_type::abort))
+		{
+			_state = server_state::idle;
+			return true;
+		}
+
+		// Segments of a block download have no command specifier
+		if(_state == server_state::block_download)
+		{
+			BlockDownloadSegment(frame, responses);
+			return true;
+		}
+
+		// Initiate requests carry the index and subindex of the transfer
+		auto specifier = command >> 5;
+		if(specifier == 1 || specifier == 2 || (specifier == 5 && (command & 0x03) == 0) || (specifier == 6 && (command & 0x01) == 0))
+		{
+			_index = get_sdo_cobid(frame);
+			_subindex = frame.data[3];
+		}
+
+		switch(specifier)
+		{
+			case 0: DownloadSegment(frame, responses); break;
+			case 1: DownloadInitiate(frame, responses); break;
+			case 2: UploadInitiate(frame, responses); break;
+			case 3: UploadSegment(frame, responses); break;
+			case 5: BlockUpload(frame, responses); break;
+			case 6: BlockDownload(frame, responses); break;
+			default: Abort(responses, sdo_abort_code::invalid_command); break;
+		}
+
+		return true;
+	}
+}
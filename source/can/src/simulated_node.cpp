@@ -0,0 +1,314 @@
+///////////////////////////////////////////////////////////////////////
+// Simulated CANOpen node implementation
+///////////////////////////////////////////////////////////////////////
+#include <can/include/simulated_node.h>
+
+#include <algorithm>
+#include <climits>
+
+#include <can/include/bitfield.h>
+
+namespace
+{
+	constexpr canopen::index_type heartbeat_index = 0x1017;
+	constexpr canopen::index_type tpdo_communication_index = 0x1800;
+	constexpr canopen::index_type tpdo_mapping_index = 0x1A00;
+	constexpr uint32_t pdo_invalid = 0x80000000;
+
+	std::vector<canopen::data_type> to_data(uint32_t value, std::size_t size)
+	{
+		std::vector<canopen::data_type> data(size);
+		for(std::size_t i = 0; i < size; i++)
+			data[i] = static_cast<canopen::data_type>(value >> (8*i));
+		return data;
+	}
+
+	// Little-endian value of up to 8 bytes
+	uint64_t to_value(const std::vector<canopen::data_type>* data)
+	{
+		uint64_t value = 0;
+		if(data != nullptr)
+			for(std::size_t i = 0; i < std::min<std::size_t>(data->size(), 8); i++)
+				value |= static_cast<uint64_t>((*data)[i]) << (8*i);
+		return value;
+	}
+
+	// Moves a timer to a new period, keeping its schedule if the period is unchanged
+	void reschedule(int64_t& period, int64_t& next, int64_t newPeriod, int64_t now)
+	{
+		if(newPeriod != period)
+			next = now + newPeriod;
+		period = newPeriod;
+	}
+
+	// Advances a timer past the current time, without catching up on missed periods
+	void advance(int64_t& next, int64_t period, int64_t now)
+	{
+		next += period;
+		if(next <= now)
+			next = now + period;
+	}
+}
+
+namespace canopen
+{
+	// --------------------------------------------------------------------
+	// Constructor
+	// --------------------------------------------------------------------
+	simulated_node::simulated_node(id_type node) :
+		_server(node),
+		_state(nmt_type::unknown),
+		_heartbeatPeriod(0),
+		_nextHeartbeat(0),
+		_tpdos(),
+		_dirty(true)
+	{
+		// Device type, error register and identity
+		_server.set(0x1000, 0, to_data(0x00000191, 4));
+		_server.set(0x1001, 0, to_data(0, 1));
+		_server.set(heartbeat_index, 0, to_data(0, 2));
+		_server.set(0x1018, 0, to_data(4, 1));
+		_server.set(0x1018, 1, to_data(0x00000000, 4));	// Vendor ID
+		_server.set(0x1018, 2, to_data(0x00000001, 4));	// Product code
+		_server.set(0x1018, 3, to_data(0x00010000, 4));	// Revision number
+		_server.set(0x1018, 4, to_data(node, 4));	// Serial number
+
+		// Disabled TPDOs with the default COB-IDs, sent on their event timer (transmission type 0xFE)
+		const canid_t cobids[tpdo_count] = { tpdo_id<1>(node), tpdo_id<2>(node), tpdo_id<3>(node), tpdo_id<4>(node) };
+		for(std::size_t i = 0; i < tpdo_count; i++)
+		{
+			auto communication = static_cast<index_type>(tpdo_communication_index + i);
+			_server.set(communication, 0, to_data(5, 1));
+			_server.set(communication, 1, to_data(cobids[i] | pdo_invalid, 4));
+			_server.set(communication, 2, to_data(0xFE, 1));
+			_server.set(communication, 5, to_data(0, 2));
+			_server.set(static_cast<index_type>(tpdo_mapping_index + i), 0, to_data(0, 1));
+		}
+	}
+
+	// --------------------------------------------------------------------
+	// Properties
+	// --------------------------------------------------------------------
+	id_type simulated_node::node() const
+	{
+		return _server.node();
+	}
+
+	nmt_type simulated_node::state() const
+	{
+		return _state;
+	}
+
+	// --------------------------------------------------------------------
+	// Object dictionary
+	// --------------------------------------------------------------------
+	void simulated_node::set(index_type index, subindex_type subindex, std::vector<data_type> data)
+	{
+		_server.set(index, subindex, std::move(data));
+		_dirty = true;
+	}
+
+	const std::vector<data_type>* simulated_node::get(index_type index, subindex_type subindex) const
+	{
+		return _server.get(index, subindex);
+	}
+
+	// Sets the producer heartbeat time
+	void simulated_node::set_heartbeat(std::chrono::milliseconds period)
+	{
+		_server.set(heartbeat_index, 0, to_data(static_cast<uint32_t>(period.count()), 2));
+		_dirty = true;
+	}
+
+	// Maps objects to a TPDO and sets its event timer - returns false for invalid TPDO numbers or mappings
+	bool simulated_node::set_tpdo(std::size_t number, const std::vector<uint32_t>& mapping, std::chrono::milliseconds period)
+	{
+		if(number < 1 || number > tpdo_count || mapping.size() > 64)
+			return false;
+
+		uint32_t bits = 0;
+		for(auto entry : mapping)
+			bits += entry & 0xFF;
+		if(bits > 64)
+			return false;
+
+		auto communication = static_cast<index_type>(tpdo_communication_index + number - 1);
+		auto mappingIndex = static_cast<index_type>(tpdo_mapping_index + number - 1);
+		auto cobid = static_cast<uint32_t>(to_value(_server.get(communication, 1))) & ~pdo_invalid;
+		auto enabled = !mapping.empty() && period.count() > 0;
+
+		_server.set(mappingIndex, 0, to_data(static_cast<uint32_t>(mapping.size()), 1));
+		for(std::size_t i = 0; i < mapping.size(); i++)
+			_server.set(mappingIndex, static_cast<subindex_type>(i + 1), to_data(mapping[i], 4));
+		_server.set(communication, 1, to_data(cobid | (enabled ? 0 : pdo_invalid), 4));
+		_server.set(communication, 5, to_data(static_cast<uint32_t>(period.count()), 2));
+		_dirty = true;
+		return true;
+	}
+
+	// --------------------------------------------------------------------
+	// Processing
+	// --------------------------------------------------------------------
+	// Powers up the node
+	void simulated_node::start(int64_t now, std::vector<can::Message>& output)
+	{
+		Boot(now, output);
+	}
+
+	// Handles NMT commands and SDO requests addressed to the node
+	bool simulated_node::process(const can::Message& message, int64_t now, std::vector<can::Message>& output)
+	{
+		const auto& frame = message.get_frame();
+		if((frame.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) || _state == nmt_type::unknown)
+			return false;
+
+		// NMT commands, to this node or to all nodes
+		if(frame.can_id == 0)
+		{
+			if(frame.len < 2 || (frame.data[1] != 0 && frame.data[1] != node()))
+				return false;
+
+			switch(static_cast<nmt_type>(frame.data[0]))
+			{
+				case nmt_type::command_operational:
+					if(_state != nmt_type::state_operational)
+						for(auto& tpdo : _tpdos)
+							tpdo.next = now + tpdo.period;
+					_state = nmt_type::state_operational;
+					break;
+				case nmt_type::command_stopped:
+					_state = nmt_type::state_stopped;
+					break;
+				case nmt_type::command_preoperational:
+					_state = nmt_type::state_preoperational;
+					break;
+				case nmt_type::command_reset_node:
+				case nmt_type::command_reset_communication:
+					Boot(now, output);
+					break;
+				default:
+					break;
+			}
+			return true;
+		}
+
+		// SDO is not available while stopped
+		if(!is_sdo_request(frame) || get_id(frame) != node())
+			return false;
+
+		if(_state != nmt_type::state_stopped)
+		{
+			_server.process(message, output);
+			_dirty = true;
+			LoadConfiguration(now);
+		}
+		return true;
+	}
+
+	// Sends what is due
+	void simulated_node::poll(int64_t now, std::vector<can::Message>& output)
+	{
+		if(_state == nmt_type::unknown)
+			return;
+
+		LoadConfiguration(now);
+
+		if(_heartbeatPeriod > 0 && now >= _nextHeartbeat)
+		{
+			output.emplace_back(message_heartbeat(node(), _state));
+			advance(_nextHeartbeat, _heartbeatPeriod, now);
+		}
+
+		if(_state != nmt_type::state_operational)
+			return;
+
+		for(auto& tpdo : _tpdos)
+		{
+			if(!tpdo.enabled || tpdo.period == 0 || now < tpdo.next)
+				continue;
+
+			can_frame frame{};
+			if(BuildTpdo(tpdo, frame))
+				output.emplace_back(frame);
+			advance(tpdo.next, tpdo.period, now);
+		}
+	}
+
+	// Returns the time of the next heartbeat or TPDO
+	int64_t simulated_node::next_deadline() const
+	{
+		if(_state == nmt_type::unknown)
+			return INT64_MAX;
+
+		auto deadline = (_heartbeatPeriod > 0) ? _nextHeartbeat : INT64_MAX;
+		if(_state == nmt_type::state_operational)
+			for(const auto& tpdo : _tpdos)
+				if(tpdo.enabled && tpdo.period > 0)
+					deadline = std::min(deadline, tpdo.next);
+		return deadline;
+	}
+
+	// --------------------------------------------------------------------
+	// Private methods
+	// --------------------------------------------------------------------
+	// Sends the boot-up message and enters pre-operational
+	void simulated_node::Boot(int64_t now, std::vector<can::Message>& output)
+	{
+		_state = nmt_type::state_preoperational;
+		output.emplace_back(message_heartbeat(node(), nmt_type::state_boot_up));
+
+		_heartbeatPeriod = 0;
+		for(auto& tpdo : _tpdos)
+			tpdo.period = 0;
+		_dirty = true;
+		LoadConfiguration(now);
+	}
+
+	// Reads the heartbeat time and the TPDO parameters from the object dictionary, if it may have changed
+	void simulated_node::LoadConfiguration(int64_t now)
+	{
+		if(!_dirty)
+			return;
+		_dirty = false;
+
+		reschedule(_heartbeatPeriod, _nextHeartbeat, static_cast<int64_t>(to_value(_server.get(heartbeat_index, 0))) * 1000000, now);
+
+		for(std::size_t i = 0; i < tpdo_count; i++)
+		{
+			auto& tpdo = _tpdos[i];
+			auto communication = static_cast<index_type>(tpdo_communication_index + i);
+			auto mappingIndex = static_cast<index_type>(tpdo_mapping_index + i);
+
+			auto cobid = static_cast<uint32_t>(to_value(_server.get(communication, 1)));
+			tpdo.enabled = !(cobid & pdo_invalid);
+			tpdo.cobid = cobid & CAN_SFF_MASK;
+			reschedule(tpdo.period, tpdo.next, static_cast<int64_t>(to_value(_server.get(communication, 5))) * 1000000, now);
+
+			auto entries = std::min<std::size_t>(to_value(_server.get(mappingIndex, 0)), 64);
+			tpdo.mapping.resize(entries);
+			for(std::size_t j = 0; j < entries; j++)
+				tpdo.mapping[j] = static_cast<uint32_t>(to_value(_server.get(mappingIndex, static_cast<subindex_type>(j + 1))));
+		}
+	}
+
+	// Packs the mapped objects into a frame - returns false if the mapping does not fit
+	bool simulated_node::BuildTpdo(const tpdo_state& tpdo, can_frame& frame) const
+	{
+		frame.can_id = tpdo.cobid;
+
+		std::size_t bits = 0;
+		for(auto entry : tpdo.mapping)
+		{
+			auto length = static_cast<std::size_t>(entry & 0xFF);
+			if(length == 0 || bits + length > 64)
+				return false;
+
+			auto value = to_value(_server.get(static_cast<index_type>(entry >> 16), static_cast<subindex_type>(entry >> 8)));
+			can::insert_bits(frame, bits, length, can::byte_order::little_endian, value);
+			bits += length;
+		}
+
+		frame.len = static_cast<__u8>((bits + 7) / 8);
+		return true;
+	}
+}
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////
+// Timestamps
+//
+// Clock readings and the alignment of timestamps between clocks.
+///////////////////////////////////////////////////////////////////////
+#include <can/include/timestamp.h>
+
+#include <algorithm>
+#include <climits>
+
+namespace can
+{
+	// --------------------------------------------------------------------
+	// Clocks
+	// --------------------------------------------------------------------
+	int64_t clock_nanoseconds(clockid_t clock)
+	{
+		timespec now;
+		clock_gettime(clock, &now);
+		return to_nanoseconds(now);
+	}
+
+	// Reads CLOCK_MONOTONIC between two CLOCK_REALTIME readings - the tightest bracket is the most accurate
+	int64_t monotonic_offset()
+	{
+		int64_t best = INT64_MAX;
+		int64_t offset = 0;
+		for(int i = 0; i < 3; i++)
+		{
+			auto before = clock_nanoseconds(CLOCK_REALTIME);
+			auto monotonic = clock_nanoseconds(CLOCK_MONOTONIC);
+			auto after = clock_nanoseconds(CLOCK_REALTIME);
+			if(after - before < best)
+			{
+				best = after - before;
+				offset = monotonic - (before + (after - before) / 2);
+			}
+		}
+		return offset;
+	}
+
+	int64_t to_monotonic(const timespec& realtime)
+	{
+		return to_nanoseconds(realtime) + monotonic_offset();
+	}
+
+	timespec message_time(const can::Message& message)
+	{
+		const auto& timestamp = message.get_timestamp();
+		if(timestamp.tv_sec != 0 || timestamp.tv_nsec != 0)
+			return timestamp;
+
+		return to_timespec(clock_nanoseconds(CLOCK_REALTIME));
+	}
+
+	// --------------------------------------------------------------------
+	// Clock alignment
+	// --------------------------------------------------------------------
+	clock_alignment::clock_alignment(std::chrono::nanoseconds window) :
+		_window(std::max<int64_t>(window.count(), 1)),
+		_windowStart(0),
+		_current(INT64_MAX),
+		_previous(INT64_MAX),
+		_samples(0)
+	{
+	}
+
+	// Keeps the smallest difference per window, starting a new window once the source clock has passed it
+	void clock_alignment::update(int64_t source, int64_t reference)
+	{
+		if(_samples == 0 || source - _windowStart >= _window || source < _windowStart)
+		{
+			// A source clock going back (e.g. a reset controller) invalidates the previous estimate
+			_previous = (_samples > 0 && source >= _windowStart) ? _current : INT64_MAX;
+			_current = INT64_MAX;
+			_windowStart = source;
+		}
+
+		_current = std::min(_current, reference - source);
+		_samples++;
+	}
+
+	void clock_alignment::reset()
+	{
+		_windowStart = 0;
+		_current = INT64_MAX;
+		_previous = INT64_MAX;
+		_samples = 0;
+	}
+
+	bool clock_alignment::valid() const
+	{
+		return (_samples > 0);
+	}
+
+	int64_t clock_alignment::offset() const
+	{
+		return valid() ? std::min(_current, _previous) : 0;
+	}
+
+	int64_t clock_alignment::to_reference(int64_t source) const
+	{
+		return source + offset();
+	}
+}
@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////
+// CAN Log File Interface
+//
+// Uses a log file as a CAN interface, for recording and for replaying
+// as fast as possible. The interface name is the path of the file.
+// Requesting messages reads the file from the start; sending messages
+// creates (or truncates) the file and appends to it. The first request
+// or send decides whether the file is read or written.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <interfaces/include/ICANInterface.h>
+#include <logging/include/binary_log_reader.h>
+#include <logging/include/binary_log_writer.h>
+#include <logging/include/candump_reader.h>
+#include <logging/include/candump_writer.h>
+
+namespace can::interfaces
+{
+	class CANLogFile : public ICANInterface
+	{
+		public:
+			enum class log_format
+			{
+				candump,	// Text format of "candump -l"
+				binary,		// Indexed binary capture log
+			};
+
+		private:
+			log_format _format;
+			std::string _path;
+			bool _connected;
+
+			// Opened on first use
+			std::unique_ptr<logging::candump_reader> _candumpReader;
+			std::unique_ptr<logging::candump_writer> _candumpWriter;
+			std::unique_ptr<logging::binary_log_reader> _binaryReader;
+			std::unique_ptr<logging::binary_log_writer> _binaryWriter;
+
+			bool OpenReader();
+			bool OpenWriter();
+
+		public:
+			// Constructor / destructor
+			CANLogFile(log_format format);
+			~CANLogFile();
+
+			// Public methods
+			log_format GetFormat() const;
+
+			// ICANInterface interface
+			bool SendMessage(const can::Message &message) override;
+			std::size_t SendMessages(const can::Message* messages, std::size_t count) override;
+			bool RequestMessage(can::Message &message) override;
+			std::size_t RequestMessages(can::Message* messages, std::size_t count) override;
+			bool Connect(const std::string& interfaceName) override;
+			void Disconnect() override;
+			void SetTimeout(int timeout) override;
+			void SetBlockingMode(bool blocking) override;
+			bool IsReady() const override;
+			int GetFileDescriptor() const override;
+	};
+}
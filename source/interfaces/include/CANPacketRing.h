@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////
+// CAN Packet Ring Interface
+//
+// Receive-only interface for high-rate bus captures. Frames are read
+// from a memory-mapped TPACKET_V3 ring shared with the kernel, so
+// whole blocks of frames are handed out without per-frame syscalls.
+//
+// Note: see https://www.kernel.org/doc/html/latest/networking/packet_mmap.html
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <interfaces/include/ICANInterface.h>
+
+namespace can::interfaces
+{
+	class CANPacketRing : public ICANInterface
+	{
+		private:
+			// Ring geometry - block size must be a multiple of the page size
+			static constexpr unsigned int _blockSize = 1 << 16;
+			static constexpr unsigned int _blockCount = 64;
+			static constexpr unsigned int _frameSize = 1 << 7;
+			static constexpr unsigned int _blockTimeout = 10;	// Milliseconds before a partially filled block is retired
+
+			int _socket;
+			std::string _interfaceName;
+			int _interfaceIndex;
+			int _pollTimeout;
+			bool _blocking;
+
+			// Memory-mapped ring and the read position within it
+			uint8_t* _ring;
+			std::size_t _ringSize;
+			unsigned int _currentBlock;
+			uint8_t* _currentPacket;
+			uint32_t _remainingPackets;
+
+			interface_statistics _statistics;
+			uint64_t _dropped;	// Frames dropped by the kernel - the kernel counter is reset on reading
+
+			bool PollSocket(int timeout);	// Timeout is in milliseconds
+			bool AcquireBlock();
+			void ReleaseBlock();
+			void ReadDrops();
+
+		public:
+			// Constructor / destructor
+			CANPacketRing();
+			~CANPacketRing();
+
+			// Do not allow copying, as the ring is owned by the instance
+			CANPacketRing(const CANPacketRing&) = delete;
+			CANPacketRing& operator=(const CANPacketRing&) = delete;
+
+			// ICANInterface interface
+			bool SendMessage(const can::Message &message) override;
+			std::size_t SendMessages(const can::Message* messages, std::size_t count) override;
+			bool RequestMessage(can::Message &message) override;
+			std::size_t RequestMessages(can::Message* messages, std::size_t count) override;
+			bool Connect(const std::string& interfaceName) override;
+			void Disconnect() override;
+			void SetTimeout(int timeout) override;
+			void SetBlockingMode(bool blocking) override;
+			bool IsReady() const override;
+			int GetFileDescriptor() const override;
+			const interface_statistics* GetInterfaceStatistics() const override;
+	};
+}
@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////
+// CAN Replay Interface
+//
+// Replays a log file (binary or candump format, detected from the
+// contents) with the timing of the recording, scaled by a speed
+// factor, or as fast as possible. The interface name is the path of
+// the file. Messages keep their recorded timestamps.
+//
+// Messages are paced against absolute deadlines on CLOCK_MONOTONIC:
+// the thread sleeps with clock_nanosleep until shortly before the
+// deadline, and spins for the remainder. The difference between the
+// deadline and the time a message is handed out is collected as
+// jitter statistics.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <interfaces/include/CANLogFile.h>
+
+namespace can::interfaces
+{
+	// Timing fidelity of a replay - jitter values are in nanoseconds
+	struct replay_statistics
+	{
+		uint64_t frames = 0;
+		int64_t min_jitter = 0;
+		int64_t max_jitter = 0;
+		double mean_jitter = 0.0;
+		double stddev_jitter = 0.0;
+	};
+
+	class CANReplay : public ICANInterface
+	{
+		private:
+			// Number of messages read ahead from the log
+			static constexpr std::size_t _bufferSize = 256;
+
+			std::unique_ptr<CANLogFile> _source;
+			double _speed;
+			int64_t _spinThreshold;	// Nanoseconds before a deadline to stop sleeping and start spinning
+			int _pollTimeout;
+			bool _blocking;
+
+			// Read-ahead buffer
+			std::array<can::Message,_bufferSize> _buffer;
+			std::size_t _bufferPosition;
+			std::size_t _bufferCount;
+
+			// Time base - recorded time of the first message and monotonic time when it was handed out
+			bool _started;
+			uint64_t _firstTimestamp;
+			int64_t _startTime;
+
+			// Jitter statistics, accumulated with Welford's method
+			uint64_t _frames;
+			int64_t _minJitter;
+			int64_t _maxJitter;
+			double _meanJitter;
+			double _sumSquares;
+
+			can::Message* PeekMessage();
+			int64_t GetDeadline(const can::Message& message) const;
+			bool WaitUntil(int64_t deadline, int64_t limit);
+			void AddJitter(int64_t jitter);
+
+		public:
+			// Constructor / destructor
+			CANReplay();
+			~CANReplay();
+
+			// Public methods
+			void SetReplaySpeed(double speed);	// 1.0 replays with the recorded timing, 0 as fast as possible
+			double GetReplaySpeed() const;
+			void SetSpinThreshold(int64_t nanoseconds);
+			replay_statistics GetStatistics() const;
+
+			// ICANInterface interface
+			bool SendMessage(const can::Message &message) override;
+			std::size_t SendMessages(const can::Message* messages, std::size_t count) override;
+			bool RequestMessage(can::Message &message) override;
+			std::size_t RequestMessages(can::Message* messages, std::size_t count) override;
+			bool Connect(const std::string& interfaceName) override;
+			void Disconnect() override;
+			void SetTimeout(int timeout) override;
+			void SetBlockingMode(bool blocking) override;
+			bool IsReady() const override;
+			int GetFileDescriptor() const override;
+	};
+}
@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////
+// CAN Simulation Interface
+//
+// Connects to an in-memory simulated bus, shared with every other
+// simulation interface of the process connected to the same name, so
+// protocol engines can be tested at high rates without a kernel
+// device or privileges. The interface name is the bus name, optionally
+// followed by a bitrate to model the bus timing, e.g. "sim0@500000";
+// without a bitrate frames are delivered immediately.
+//
+// As with a socket, frames sent are received by all other interfaces
+// on the bus, but not by the sending interface itself.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <interfaces/include/ICANInterface.h>
+#include <interfaces/include/simulated_bus.h>
+
+namespace can::interfaces
+{
+	class CANSimulation : public ICANInterface
+	{
+		private:
+			std::shared_ptr<simulated_bus> _bus;
+			simulated_bus::endpoint* _endpoint;
+			uint64_t _droppedBefore;	// Drops of the receive queue before connecting
+			int _pollTimeout;
+			bool _blocking;
+
+			interface_statistics _statistics;
+
+			std::size_t WaitForMessages(can::Message* messages, std::size_t count);
+
+		public:
+			// Constructor / destructor
+			CANSimulation();
+			~CANSimulation();
+
+			// Public methods
+			const simulated_bus* GetBus() const;	// nullptr unless connected
+
+			// ICANInterface interface
+			bool SendMessage(const can::Message &message) override;
+			std::size_t SendMessages(const can::Message* messages, std::size_t count) override;
+			bool RequestMessage(can::Message &message) override;
+			std::size_t RequestMessages(can::Message* messages, std::size_t count) override;
+			bool Connect(const std::string& interfaceName) override;
+			void Disconnect() override;
+			void SetTimeout(int timeout) override;
+			void SetBlockingMode(bool blocking) override;
+			bool IsReady() const override;
+			int GetFileDescriptor() const override;
+			const interface_statistics* GetInterfaceStatistics() const override;
+	};
+}
@@ -4,12 +4,24 @@
 // Uses a socket connection to communicate with a directly attached
 // CAN bus.
 //
+// Frames are stamped by the kernel with SO_TIMESTAMPING, in nanoseconds.
+// Hardware receive timestamps are used when enabled and supported by
+// the driver; they are aligned to the software timestamps, so all
+// messages carry CLOCK_REALTIME times.
+//
 // Note: see https://www.kernel.org/doc/html/v5.11/networking/can.html
 ///////////////////////////////////////////////////////////////////////
 #pragma once
 
+#include <array>
 #include <string>
+#include <vector>
+#include <linux/can/raw.h>
+#include <linux/errqueue.h>	// scm_timestamping definition
+#include <linux/net_tstamp.h>
+#include <sys/socket.h>
 
+#include <can/include/timestamp.h>
 #include <interfaces/include/ICANInterface.h>
 
 namespace can::interfaces
@@ -17,13 +29,41 @@ namespace can::interfaces
 	class CANSocket : public ICANInterface
 	{
 		private:
+			// Maximum number of frames handled by a single recvmmsg/sendmmsg call
+			static constexpr std::size_t _batchSize = 32;
+			static constexpr std::size_t _controlSize = CMSG_SPACE(sizeof(scm_timestamping)) + CMSG_SPACE(sizeof(uint32_t));
+
 			int _socket;
 			std::string _interfaceName;
 			int _interfaceIndex;
 			int _pollTimeout;
 			bool _blocking;
+			bool _hardwareTimestamps;
+
+			// Offset of the hardware clock of the controller to the software timestamps
+			can::clock_alignment _hardwareClock;
+
+			// Kernel-side filters, kept so they can be applied when connecting
+			std::vector<can_filter> _filters;
+			can_err_mask_t _errorMask;
+
+			// Message headers used for batched receiving
+			std::array<mmsghdr,_batchSize> _receiveHeaders;
+			std::array<iovec,_batchSize> _receiveVectors;
+			std::array<sockaddr_can,_batchSize> _receiveAddresses;
+			std::array<std::array<char,_controlSize>,_batchSize> _receiveControl;
+
+			// Message headers used for batched sending
+			std::array<mmsghdr,_batchSize> _sendHeaders;
+			std::array<iovec,_batchSize> _sendVectors;
+
+			interface_statistics _statistics;
 
 			bool PollSocket(int timeout);	// Timeout is in milliseconds
+			bool WaitForTransmitQueue(int timeout, bool backOff);	// Timeout is in milliseconds, negative to wait indefinitely
+			bool ApplyFilters();
+			bool EnableTimestamps();
+			void ReadControlMessages(msghdr& header, can::Message& message);
 
 		public:
 			// Constructor / destructor
@@ -33,13 +73,32 @@ namespace can::interfaces
 			// Public methods
 			constexpr bool InterfaceIsAny() const;
 
+			// Kernel-side filtering - may be changed at any time, also while connected
+			bool SetFilters(const can_filter* filters, std::size_t count);
+			bool ClearFilters();	// Receive all frames
+			bool SetErrorFilter(can_err_mask_t mask);	// Error frames to receive, e.g. CAN_ERR_MASK
+
+			// Hardware receive timestamps, where the driver supports them - off by default
+			bool SetHardwareTimestamps(bool enable);
+			const can::clock_alignment& GetHardwareClock() const;
+
+			template <std::size_t count>
+			bool SetFilters(const std::array<can_filter,count>& filters)
+			{
+				return SetFilters(filters.data(), count);
+			}
+
 			// ICANInterface interface
 			bool SendMessage(const can::Message &message) override;
+			std::size_t SendMessages(const can::Message* messages, std::size_t count) override;
 			bool RequestMessage(can::Message &message) override;
+			std::size_t RequestMessages(can::Message* messages, std::size_t count) override;
 			bool Connect(const std::string& interfaceName) override;
 			void Disconnect() override;
 			void SetTimeout(int timeout) override;
 			void SetBlockingMode(bool blocking) override;
 			bool IsReady() const override;
+			int GetFileDescriptor() const override;
+			const interface_statistics* GetInterfaceStatistics() const override;
 	};
 }
@@ -3,7 +3,10 @@
 ///////////////////////////////////////////////////////////////////////
 #pragma once
 
+#include <cstddef>
+
 #include <can/include/Message.h>
+#include <interfaces/include/interface_statistics.h>
 
 namespace can::interfaces
 {
@@ -12,16 +15,20 @@ namespace can::interfaces
 		public:
 			// Messages
 			virtual bool SendMessage(const can::Message& message) = 0;
+			virtual std::size_t SendMessages(const can::Message* messages, std::size_t count) = 0;	// Returns the number of accepted messages
 			virtual bool RequestMessage(can::Message& message) = 0;
+			virtual std::size_t RequestMessages(can::Message* messages, std::size_t count) = 0;	// Returns the number of received messages
 
 			// Connection
 			virtual bool Connect(const std::string& interfaceName) = 0;
 			virtual void Disconnect() = 0;
 			virtual bool IsReady() const = 0;
+			virtual int GetFileDescriptor() const = 0;	// Descriptor that becomes readable when messages arrive, or -1
 
 			// Other methods
 			virtual void SetTimeout(int timeout) = 0;
 			virtual void SetBlockingMode(bool blocking) = 0;
+			virtual const interface_statistics* GetInterfaceStatistics() const { return nullptr; }	// Performance counters, if kept
 
 			// Destructor
 			virtual ~ICANInterface() {}
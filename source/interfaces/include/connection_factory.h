@@ -14,6 +14,11 @@ namespace can::interfaces
 	enum class interface_type
 	{
 		socket_can,	// Using the SocketCAN interface
+		socket_can_mmap,	// Using a memory-mapped packet ring (receive only)
+		candump_file,	// Using a candump text log file
+		binary_log_file,	// Using a binary log file
+		log_replay,	// Replaying a log file with its recorded timing
+		simulation,	// Using an in-memory simulated bus
 	};
 
 	class connection_factory
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////
+// Event loop
+//
+// Waits on any number of CAN interfaces with a single epoll instance,
+// and dispatches received messages to the handler registered with
+// each interface. Interfaces are registered edge-triggered and drained
+// in batches, with a limit per wake-up so a busy bus cannot starve the
+// others.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <interfaces/include/ICANInterface.h>
+
+namespace can::interfaces
+{
+	class event_loop
+	{
+		public:
+			// Called with each batch of messages received by an interface
+			using handler_type = std::function<void(ICANInterface& interface, const can::Message* messages, std::size_t count)>;
+
+		private:
+			// Maximum number of messages requested from an interface at a time
+			static constexpr std::size_t _batchSize = 64;
+
+			// Maximum number of batches read from one interface per wake-up
+			static constexpr std::size_t _batchesPerWakeup = 16;
+
+			struct registration
+			{
+				ICANInterface* interface;
+				handler_type handler;
+				bool pending;	// Not yet drained since the last edge
+			};
+
+			int _epoll;
+			std::vector<std::unique_ptr<registration>> _registrations;
+			std::vector<registration*> _pending;
+			std::vector<registration*> _ready;
+			std::array<can::Message,_batchSize> _batch;
+			std::atomic<bool> _running;
+
+			std::size_t Drain(registration& entry);
+
+		public:
+			// Constructor / destructor
+			event_loop();
+			~event_loop();
+
+			// Do not allow copying
+			event_loop(const event_loop&) = delete;
+			event_loop& operator=(const event_loop&) = delete;
+
+			// Registration - interfaces must be connected, and are switched to non-blocking mode without timeout
+			bool add(ICANInterface& interface, handler_type handler);
+			bool remove(ICANInterface& interface);
+			std::size_t size() const;
+
+			// Waits up to "timeout" milliseconds (-1 for indefinitely) and dispatches - returns the number of messages
+			std::size_t run_once(int timeout);
+
+			// Dispatches until stop is called (from a handler or another thread)
+			void run();
+			void stop();
+	};
+}
@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////
+// Gateway
+//
+// Forwards messages from an input interface to an output interface,
+// in batches. Each CAN ID can be routed (forwarded or dropped) and
+// rewritten to another ID. Standard IDs are looked up in a flat table,
+// extended IDs in a hash map; IDs without a rule take the default
+// route. Error frames are never forwarded.
+//
+// Rules must be set up before forwarding starts. The counters may be
+// read from any thread.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include <interfaces/include/ICANInterface.h>
+
+namespace can::interfaces
+{
+	class gateway
+	{
+		private:
+			// Maximum number of messages forwarded at a time
+			static constexpr std::size_t _batchSize = 256;
+
+			struct route
+			{
+				bool forward = true;
+				bool rewrite = false;
+				canid_t id = 0;	// The ID to rewrite to, including the CAN_EFF_FLAG for extended IDs
+				bool assigned = false;	// Set by a rule, rather than following the default route
+			};
+
+			ICANInterface& _input;
+			ICANInterface& _output;
+			int _stopLatency;
+			std::atomic<bool> _running;
+
+			// Routing rules
+			route _default;
+			std::array<route,CAN_SFF_MASK+1> _standard;
+			std::unordered_map<canid_t,route> _extended;
+
+			std::array<can::Message,_batchSize> _batch;
+
+			// Counters
+			std::atomic<uint64_t> _received;
+			std::atomic<uint64_t> _forwarded;
+			std::atomic<uint64_t> _dropped;
+			std::atomic<uint64_t> _failed;
+
+			route& GetRoute(canid_t id);
+			const route& FindRoute(canid_t id) const;
+
+		public:
+			// Constructor - "stopLatency" is the maximum time (ms) a stop request may wait for
+			gateway(ICANInterface& input, ICANInterface& output, int stopLatency = 50);
+			~gateway() = default;
+
+			// Do not allow copying
+			gateway(const gateway&) = delete;
+			gateway& operator=(const gateway&) = delete;
+
+			// Routing rules - IDs above CAN_SFF_MASK, or with the CAN_EFF_FLAG set, are extended IDs
+			void forward(canid_t id);
+			void drop(canid_t id);
+			void rewrite(canid_t id, canid_t newId);
+			void set_default(bool forward);	// Route for IDs without a rule
+			void clear_rules();
+
+			// Parses rules as "<id>=<action>,..." where the action is "pass", "drop" or a new ID, and "*" is the default
+			bool parse_rules(const std::string& rules);
+
+			// Forwards one batch of messages - returns the number of messages received
+			std::size_t forward_once();
+
+			// Forwards until the input has no more messages, e.g. for log files - returns the number of messages received
+			uint64_t forward_all();
+
+			// Forwards until stop is called (from another thread, or a signal handler)
+			void run();
+			void stop();
+			bool running() const;
+
+			// Counters - dropped messages include those rejected by the output
+			uint64_t received() const;
+			uint64_t forwarded() const;
+			uint64_t dropped() const;
+			uint64_t failed() const;	// Rejected by the output
+	};
+}
@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////////////////////////
+// Interface statistics
+//
+// Performance counters and a receive latency histogram of an
+// interface. The receive counters are written by the thread receiving
+// from the interface, and the send counters by the thread sending; each
+// counter has a single writer, so counting is a plain load and store,
+// and any thread may read the counters at any time.
+//
+// The latency histogram is log-linear, as HDR histograms: values are
+// counted exactly up to 64 ns, and above that in 32 buckets per power
+// of two, i.e. with a resolution of about 3%.
+//
+// Samples of the statistics can be formatted as a stats line (rates
+// and latency percentiles between two samples), or in the Prometheus
+// text exposition format.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <can/include/Message.h>
+
+namespace can::interfaces
+{
+	// Counter with a single writing thread
+	class statistics_counter
+	{
+		private:
+			std::atomic<uint64_t> _value{ 0 };
+
+		public:
+			void add(uint64_t count)
+			{
+				_value.store(_value.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+			}
+
+			void set(uint64_t value)
+			{
+				_value.store(value, std::memory_order_relaxed);
+			}
+
+			uint64_t value() const
+			{
+				return _value.load(std::memory_order_relaxed);
+			}
+	};
+
+	// Histogram of latencies in nanoseconds, with a single writing thread
+	class latency_histogram
+	{
+		public:
+			static constexpr unsigned int sub_bucket_bits = 5;
+			static constexpr unsigned int max_bits = 40;	// Larger values (above 18 minutes) are counted in the last bucket
+			static constexpr std::size_t sub_buckets = std::size_t{1} << sub_bucket_bits;
+			static constexpr std::size_t bucket_count = (max_bits - sub_bucket_bits + 1) * sub_buckets;
+			using bucket_array = std::array<uint64_t,bucket_count>;
+
+		private:
+			std::array<statistics_counter,bucket_count> _buckets;
+			statistics_counter _count;
+			statistics_counter _sum;
+			statistics_counter _max;
+
+		public:
+			// Bucket of a value
+			static constexpr std::size_t bucket_index(uint64_t value)
+			{
+				if(value < sub_buckets)
+					return static_cast<std::size_t>(value);
+
+				auto exponent = static_cast<unsigned int>(63 - __builtin_clzll(value));
+				if(exponent >= max_bits)
+					return bucket_count - 1;
+
+				return (exponent - sub_bucket_bits + 1) * sub_buckets + ((value >> (exponent - sub_bucket_bits)) & (sub_buckets - 1));
+			}
+
+			// Smallest and largest value of a bucket
+			static constexpr uint64_t bucket_lower(std::size_t index)
+			{
+				if(index < 2 * sub_buckets)
+					return index;
+
+				auto shift = index / sub_buckets - 1;
+				return (sub_buckets + index % sub_buckets) << shift;
+			}
+
+			static constexpr uint64_t bucket_upper(std::size_t index)
+			{
+				if(index < 2 * sub_buckets)
+					return index;
+
+				return bucket_lower(index) + (uint64_t{1} << (index / sub_buckets - 1)) - 1;
+			}
+
+			// Writing thread
+			void record(uint64_t value)
+			{
+				_buckets[bucket_index(value)].add(1);
+				_count.add(1);
+				_sum.add(value);
+				if(value > _max.value())
+					_max.set(value);
+			}
+
+			// Any thread
+			uint64_t count() const { return _count.value(); }
+			uint64_t sum() const { return _sum.value(); }
+			uint64_t max() const { return _max.value(); }
+			void copy_buckets(bucket_array& buckets) const;
+			uint64_t percentile(double percent) const;	// Of all values so far - the largest value of the bucket
+
+			// Percentile of counted buckets, e.g. the difference of two copies
+			static uint64_t percentile(const bucket_array& buckets, double percent);
+	};
+
+	// Plain copy of the counters
+	struct interface_counters
+	{
+		// Receiving
+		uint64_t frames_received{ 0 };
+		uint64_t bytes_received{ 0 };	// Data bytes
+		uint64_t receive_calls{ 0 };	// System calls reading frames
+		uint64_t poll_timeouts{ 0 };	// Requests without frames within the timeout
+		uint64_t short_reads{ 0 };	// Frames of unexpected size
+		uint64_t receive_errors{ 0 };
+		uint64_t overflow_drops{ 0 };	// Frames dropped by the kernel (e.g. SO_RXQ_OVFL)
+
+		// Sending
+		uint64_t frames_sent{ 0 };
+		uint64_t bytes_sent{ 0 };	// Data bytes
+		uint64_t send_calls{ 0 };	// System calls writing frames
+		uint64_t send_retries{ 0 };	// Waits for a full transmit queue
+		uint64_t write_failures{ 0 };	// Requests not sent completely
+	};
+
+	// Counters and latency buckets at a point in time
+	struct statistics_sample
+	{
+		int64_t time{ 0 };	// CLOCK_MONOTONIC in nanoseconds
+		interface_counters counters;
+		latency_histogram::bucket_array latency{};
+		uint64_t latency_count{ 0 };
+		uint64_t latency_sum{ 0 };
+	};
+
+	class interface_statistics
+	{
+		public:
+			// Receiving thread
+			alignas(64) statistics_counter frames_received;
+			statistics_counter bytes_received;
+			statistics_counter receive_calls;
+			statistics_counter poll_timeouts;
+			statistics_counter short_reads;
+			statistics_counter receive_errors;
+			statistics_counter overflow_drops;
+			latency_histogram receive_latency;	// From the kernel timestamp to handing out the frame
+
+			// Sending thread
+			alignas(64) statistics_counter frames_sent;
+			statistics_counter bytes_sent;
+			statistics_counter send_calls;
+			statistics_counter send_retries;
+			statistics_counter write_failures;
+
+			// Receiving thread - counts frames handed out, with their latency since the kernel timestamp
+			void record_received(const can::Message* messages, std::size_t count);
+
+			// Any thread
+			interface_counters counters() const;
+			statistics_sample sample() const;
+	};
+
+	// Formats the rates and latencies between two samples as one line, e.g. "can0: rx 1000 fr/s ..."
+	std::string format_statistics_line(const std::string& name, const statistics_sample& current, const statistics_sample& previous);
+
+	// Formats samples of named interfaces as Prometheus metrics
+	std::string format_prometheus(const std::vector<std::pair<std::string,statistics_sample>>& samples);
+}
@@ -0,0 +1,29 @@
+///////////////////////////////////////////////////////////////////////
+// Interface table
+//
+// Translates between interface indices, as stored in can::Message,
+// and interface names. Kernel interfaces are looked up once and then
+// cached, so the receive path only ever handles the integer index.
+// Names unknown to the kernel (e.g. from log files) are assigned
+// synthetic indices.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <string>
+
+namespace can::interfaces
+{
+	class interface_table
+	{
+		public:
+			// First index handed out for names that are unknown to the kernel
+			static constexpr int synthetic_index_base = 0x40000000;
+
+			// Static-only class
+			interface_table() = delete;
+
+			// Public static interface
+			static std::string name(int index);
+			static int index(const std::string& name);
+	};
+}
@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////
+// Receive thread
+//
+// Dedicated thread reading batches of messages from an ICANInterface
+// and pushing them into a lock-free ring. Consumers drain the ring on
+// other threads, so slow consumers never block the socket reader -
+// when they fall behind, the ring policy decides what is lost, and
+// the ring counts it.
+//
+// Several receive threads may share an MPSC ring.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <poll.h>
+
+#include <interfaces/include/ICANInterface.h>
+
+namespace can::interfaces
+{
+	template <typename ring_type>
+	class receive_thread
+	{
+		private:
+			// Maximum number of messages requested from the interface at a time
+			static constexpr std::size_t _batchSize = 64;
+
+			ICANInterface& _interface;
+			ring_type& _ring;
+			std::thread _thread;
+			std::atomic<bool> _running;
+			std::atomic<uint64_t> _received;
+			int _stopLatency;
+
+			// Waits for more messages after an empty request - interfaces that cannot wait (e.g. log files at their end) return at once
+			void wait()
+			{
+				pollfd p;
+				p.fd = _interface.GetFileDescriptor();
+				p.events = POLLIN;
+				if(p.fd < 0 || poll(&p, 1, _stopLatency) < 0)
+					std::this_thread::sleep_for(std::chrono::milliseconds(_stopLatency));
+			}
+
+			// Thread function
+			void run()
+			{
+				std::array<can::Message,_batchSize> batch;
+				while(_running.load(std::memory_order_relaxed))
+				{
+					auto count = _interface.RequestMessages(batch.data(), batch.size());
+					if(count == 0)
+					{
+						wait();
+						continue;
+					}
+
+					_ring.push(batch.data(), count);
+					_received.fetch_add(count, std::memory_order_relaxed);
+				}
+			}
+
+		public:
+			// Constructor / destructor - "stopLatency" is the maximum time (ms) a stop request may wait for
+			receive_thread(ICANInterface& interface, ring_type& ring, int stopLatency = 50) :
+				_interface(interface),
+				_ring(ring),
+				_thread(),
+				_running(false),
+				_received(0),
+				_stopLatency(stopLatency)
+			{
+			}
+
+			~receive_thread()
+			{
+				stop();
+			}
+
+			// Do not allow copying
+			receive_thread(const receive_thread&) = delete;
+			receive_thread& operator=(const receive_thread&) = delete;
+
+			// Starts receiving - the interface is switched to non-blocking mode, so stop requests are noticed
+			bool start()
+			{
+				if(_running || !_interface.IsReady())
+					return false;
+
+				_interface.SetTimeout(_stopLatency);
+				_interface.SetBlockingMode(false);
+				_running = true;
+				_thread = std::thread(&receive_thread::run, this);
+				return true;
+			}
+
+			// Stops receiving and waits for the thread to finish
+			void stop()
+			{
+				_running = false;
+				if(_thread.joinable())
+					_thread.join();
+			}
+
+			bool running() const
+			{
+				return _running;
+			}
+
+			// Number of messages received from the interface, including messages dropped by the ring
+			uint64_t received() const
+			{
+				return _received.load(std::memory_order_relaxed);
+			}
+	};
+}
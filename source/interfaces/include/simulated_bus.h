@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////
+// Simulated bus
+//
+// In-memory CAN bus shared by any number of endpoints in the process,
+// looked up by name. Every frame sent is delivered to all other
+// endpoints, through a lock-free receive queue per endpoint; a full
+// queue drops frames, as a full socket receive queue does.
+//
+// Without a bitrate, frames are delivered immediately by the sending
+// thread, so the rate is only limited by copying. With a bitrate, a
+// bus thread models the bus: the first frame queued by each endpoint
+// takes part in arbitration whenever the bus becomes idle, the lowest
+// identifier wins, and the frame is delivered when its transmission
+// (with exact stuff bits) has ended. Bus time is kept as exact frame
+// durations, so delays in waking up the bus thread do not reduce the
+// modelled throughput. Each endpoint has a bounded transmit queue, as
+// a CAN controller does: a sender faster than the bus finds it full.
+// Frames still queued when an endpoint is detached are sent, unless its
+// slot is reused by a new connection first.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <can/include/Message.h>
+#include <utility/include/lockfree_ring.h>
+
+namespace can::interfaces
+{
+	class simulated_bus
+	{
+		public:
+			static constexpr std::size_t max_endpoints = 64;
+			static constexpr std::size_t queue_size = 4096;	// Frames per receive queue, and on the way to the bus thread
+			static constexpr std::size_t transmit_queue_size = 256;	// Frames waiting for the bus per endpoint, with a bitrate
+
+			// Receiving side of a connection to the bus
+			struct endpoint
+			{
+				utility::mpsc_ring<can::Message,queue_size> queue;
+				std::atomic<bool> armed{ false };	// Set while the receiver waits for frames
+				std::atomic<bool> active{ false };
+				std::atomic<uint64_t> transmitting{ 0 };	// Connection generation (high 32 bits) and frames accepted but not yet transmitted
+				std::size_t slot{ 0 };
+				int event{ -1 };	// eventfd, readable after frames arrived for an armed receiver
+			};
+
+		private:
+			struct pending
+			{
+				can::Message message;
+				int64_t arrival;	// CLOCK_MONOTONIC in nanoseconds
+				std::size_t sender;
+				uint32_t generation;	// Connection of the sender's endpoint
+			};
+
+			std::string _name;
+			int _index;	// Interface index of the bus name
+			uint32_t _bitrate;
+
+			// Endpoints are kept until the bus is destroyed, so senders may use them without locking
+			std::mutex _endpointMutex;
+			std::array<std::unique_ptr<endpoint>,max_endpoints> _storage;
+			std::array<std::atomic<endpoint*>,max_endpoints> _endpoints;	// Connected endpoints
+			std::atomic<std::size_t> _endpointCount;	// Highest used slot + 1
+
+			// Transmission through the bus thread, with a bitrate only
+			utility::mpsc_ring<pending,queue_size> _pending;
+			std::thread _thread;
+			std::mutex _wakeMutex;
+			std::condition_variable _wake;
+			std::atomic<bool> _idle;
+			std::atomic<bool> _running;
+
+			std::atomic<uint64_t> _frames;
+			std::atomic<uint64_t> _bits;
+
+			void Deliver(const can::Message* messages, std::size_t count, std::size_t sender, const timespec& timestamp);
+			void Run();
+
+		public:
+			// Constructor / destructor - use open() to share buses by name
+			simulated_bus(const std::string& name, uint32_t bitrate);
+			~simulated_bus();
+
+			// Do not allow copying
+			simulated_bus(const simulated_bus&) = delete;
+			simulated_bus& operator=(const simulated_bus&) = delete;
+
+			// Returns the bus of a name, creating it if needed - a bitrate of 0 joins the bus at any bitrate,
+			// otherwise nullptr is returned if the bus exists with a different bitrate
+			static std::shared_ptr<simulated_bus> open(const std::string& name, uint32_t bitrate);
+
+			// Number of bits a frame takes on the bus, including stuff bits and the interframe space - the
+			// data phase of CAN FD frames is counted at the same bitrate, as bit rate switching is not modelled
+			static unsigned int frame_bits(const can_frame& frame);
+			static unsigned int frame_bits(const canfd_frame& frame);
+
+			// Endpoints - returns nullptr if all endpoints are in use
+			endpoint* attach();
+			void detach(endpoint* e);
+
+			// Sends frames from an endpoint - returns the number of frames accepted for transmission
+			std::size_t transmit(const endpoint& sender, const can::Message* messages, std::size_t count);
+
+			// Properties
+			const std::string& name() const;
+			int index() const;
+			uint32_t bitrate() const;
+			uint64_t frames() const;	// Frames transmitted
+			uint64_t bits() const;	// Bits transmitted, with a bitrate only
+	};
+}
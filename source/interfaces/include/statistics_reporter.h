@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////
+// Statistics reporter
+//
+// Thread sampling the statistics of interfaces periodically, writing
+// a stats line per interface to a stream and/or the statistics of all
+// interfaces in the Prometheus text format to a file (e.g. for the
+// textfile collector of the node exporter). The file is replaced
+// atomically, so readers never see a partial file.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <interfaces/include/ICANInterface.h>
+
+namespace can::interfaces
+{
+	class statistics_reporter
+	{
+		private:
+			struct entry
+			{
+				std::string name;
+				const interface_statistics* statistics;
+				statistics_sample previous;
+			};
+
+			std::vector<entry> _entries;
+			std::chrono::milliseconds _interval;
+			std::ostream* _output;
+			std::string _path;
+
+			std::thread _thread;
+			std::mutex _mutex;
+			std::condition_variable _wake;
+			bool _running;
+
+			void Run();
+
+		public:
+			// Constructor / destructor
+			explicit statistics_reporter(std::chrono::milliseconds interval);
+			~statistics_reporter();
+
+			// Do not allow copying
+			statistics_reporter(const statistics_reporter&) = delete;
+			statistics_reporter& operator=(const statistics_reporter&) = delete;
+
+			// Configuration, before starting - returns false if the interface keeps no statistics
+			bool add(const std::string& name, const ICANInterface& interface);
+			void set_output(std::ostream* output);	// nullptr for no stats lines
+			void set_file(const std::string& path);	// Empty for no Prometheus file
+
+			// Reporting
+			bool start();
+			void stop();	// Reports a last time
+			bool report();	// Reports now - returns false if the file could not be written
+	};
+}
@@ -0,0 +1,166 @@
+///////////////////////////////////////////////////////////////////////
+// CAN Log File Interface
+//
+// Uses a log file as a CAN interface, for recording and for replaying
+// as fast as possible. The interface name is the path of the file.
+///////////////////////////////////////////////////////////////////////
+#include <interfaces/include/CANLogFile.h>
+
+// --------------------------------------------------------------------
+// Constructors / destructor
+// --------------------------------------------------------------------
+// Constructor
+can::interfaces::CANLogFile::CANLogFile(log_format format) :
+	_format(format),
+	_path(),
+	_connected(false)
+{
+}
+
+// Destructor
+can::interfaces::CANLogFile::~CANLogFile()
+{
+	Disconnect();
+}
+
+// --------------------------------------------------------------------
+// Private methods
+// --------------------------------------------------------------------
+// Opens the file for reading, unless already open - a file being written cannot be read
+bool can::interfaces::CANLogFile::OpenReader()
+{
+	if(!_connected || _candumpWriter || _binaryWriter)
+		return false;
+
+	if(_format == log_format::candump)
+	{
+		if(!_candumpReader)
+		{
+			_candumpReader = std::make_unique<logging::candump_reader>();
+			_candumpReader->open(_path);
+		}
+		return _candumpReader->is_open();
+	}
+
+	if(!_binaryReader)
+	{
+		_binaryReader = std::make_unique<logging::binary_log_reader>();
+		_binaryReader->open(_path);
+	}
+	return _binaryReader->is_open();
+}
+
+// Opens the file for writing, unless already open - a file being read is not overwritten
+bool can::interfaces::CANLogFile::OpenWriter()
+{
+	if(!_connected || _candumpReader || _binaryReader)
+		return false;
+
+	if(_format == log_format::candump)
+	{
+		if(!_candumpWriter)
+		{
+			_candumpWriter = std::make_unique<logging::candump_writer>();
+			_candumpWriter->open(_path);
+		}
+		return _candumpWriter->is_open();
+	}
+
+	if(!_binaryWriter)
+	{
+		_binaryWriter = std::make_unique<logging::binary_log_writer>();
+		_binaryWriter->open(_path);
+	}
+	return _binaryWriter->is_open();
+}
+
+// --------------------------------------------------------------------
+// Public methods
+// --------------------------------------------------------------------
+// Returns the format of the log file
+can::interfaces::CANLogFile::log_format can::interfaces::CANLogFile::GetFormat() const
+{
+	return _format;
+}
+
+// Sets the path of the log file - the file is opened on first use
+bool can::interfaces::CANLogFile::Connect(const std::string& interfaceName)
+{
+	if(_connected || interfaceName.empty())
+		return false;
+
+	_path = interfaceName;
+	_connected = true;
+	return true;
+}
+
+// Completes and closes the log file
+void can::interfaces::CANLogFile::Disconnect()
+{
+	_candumpReader.reset();
+	_candumpWriter.reset();
+	_binaryReader.reset();
+	_binaryWriter.reset();
+	_connected = false;
+}
+
+// Files never wait, so there is no timeout
+void can::interfaces::CANLogFile::SetTimeout(int)
+{
+}
+
+// Files never wait, so blocking mode has no effect
+void can::interfaces::CANLogFile::SetBlockingMode(bool)
+{
+}
+
+// Checks whether a file has been specified
+bool can::interfaces::CANLogFile::IsReady() const
+{
+	return _connected;
+}
+
+// Files cannot be waited upon
+int can::interfaces::CANLogFile::GetFileDescriptor() const
+{
+	return -1;
+}
+
+// --------------------------------------------------------------------
+// ICANInterface interface
+// --------------------------------------------------------------------
+// Appends a message to the log file
+bool can::interfaces::CANLogFile::SendMessage(const can::Message& message)
+{
+	return (SendMessages(&message, 1) == 1);
+}
+
+// Appends a number of messages to the log file
+std::size_t can::interfaces::CANLogFile::SendMessages(const can::Message* messages, std::size_t count)
+{
+	if(messages == nullptr || !OpenWriter())
+		return 0;
+
+	if(_format == log_format::candump)
+		return _candumpWriter->write(messages, count);
+
+	return _binaryWriter->write(messages, count);
+}
+
+// Reads the next message from the log file
+bool can::interfaces::CANLogFile::RequestMessage(can::Message& message)
+{
+	return (RequestMessages(&message, 1) == 1);
+}
+
+// Reads up to "count" messages from the log file
+std::size_t can::interfaces::CANLogFile::RequestMessages(can::Message* messages, std::size_t count)
+{
+	if(messages == nullptr || !OpenReader())
+		return 0;
+
+	if(_format == log_format::candump)
+		return _candumpReader->read(messages, count);
+
+	return _binaryReader->read(messages, count);
+}
@@ -0,0 +1,323 @@
+///////////////////////////////////////////////////////////////////////
+// CAN Packet Ring Interface
+//
+// Receive-only interface for high-rate bus captures. Frames are read
+// from a memory-mapped TPACKET_V3 ring shared with the kernel, so
+// whole blocks of frames are handed out without per-frame syscalls.
+///////////////////////////////////////////////////////////////////////
+#include <interfaces/include/CANPacketRing.h>
+
+#include <cstring>
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// --------------------------------------------------------------------
+// Constructors / destructor
+// --------------------------------------------------------------------
+// Constructor
+can::interfaces::CANPacketRing::CANPacketRing() :
+	_socket(0),
+	_interfaceName("any"),
+	_interfaceIndex(0),
+	_pollTimeout(200),
+	_blocking(true),
+	_ring(nullptr),
+	_ringSize(0),
+	_currentBlock(0),
+	_currentPacket(nullptr),
+	_remainingPackets(0),
+	_statistics(),
+	_dropped(0)
+{
+}
+
+// Destructor
+can::interfaces::CANPacketRing::~CANPacketRing()
+{
+	Disconnect();
+}
+
+// --------------------------------------------------------------------
+// Private methods
+// --------------------------------------------------------------------
+// Uses the poll function to wait for the kernel to hand over a block
+bool can::interfaces::CANPacketRing::PollSocket(int timeout)
+{
+	// Setup the polling data structure
+	pollfd p;
+	p.fd = _socket;
+	p.events = POLLIN | POLLERR;
+
+	// Poll
+	auto result = poll(&p, 1, timeout);
+
+	return (result > 0);
+}
+
+// Starts reading the current block, if the kernel has handed it over to user space
+bool can::interfaces::CANPacketRing::AcquireBlock()
+{
+	auto block = reinterpret_cast<tpacket_block_desc*>(_ring + _currentBlock * _blockSize);
+	if((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0)
+		return false;
+
+	// Blocks without any packets are returned immediately
+	_remainingPackets = block->hdr.bh1.num_pkts;
+	if(_remainingPackets == 0)
+	{
+		ReleaseBlock();
+		return false;
+	}
+
+	_currentPacket = reinterpret_cast<uint8_t*>(block) + block->hdr.bh1.offset_to_first_pkt;
+	return true;
+}
+
+// Returns the current block to the kernel and moves on to the next one
+void can::interfaces::CANPacketRing::ReleaseBlock()
+{
+	auto block = reinterpret_cast<tpacket_block_desc*>(_ring + _currentBlock * _blockSize);
+	__atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+
+	_currentBlock = (_currentBlock + 1) % _blockCount;
+	_currentPacket = nullptr;
+	_remainingPackets = 0;
+}
+
+// Adds the frames the kernel dropped for a full ring since the last reading
+void can::interfaces::CANPacketRing::ReadDrops()
+{
+	tpacket_stats_v3 statistics{};
+	socklen_t length = sizeof(statistics);
+	if(getsockopt(_socket, SOL_PACKET, PACKET_STATISTICS, &statistics, &length) == 0)
+	{
+		_dropped += statistics.tp_drops;
+		_statistics.overflow_drops.set(_dropped);
+	}
+}
+
+// --------------------------------------------------------------------
+// Public methods
+// --------------------------------------------------------------------
+// Connect method - "any" captures all CAN interfaces
+bool can::interfaces::CANPacketRing::Connect(const std::string& interfaceName)
+{
+	// Check whether a connection is already active
+	if(_socket > 0)
+		return false;
+
+	// Make sure that the interfaceName does not cause a buffer overflow
+	if(interfaceName.size() >= IFNAMSIZ)
+		return false;
+
+	// Get interface index, where index 0 captures all interfaces
+	_interfaceName = interfaceName;
+	_interfaceIndex = (interfaceName.compare("any") == 0) ? 0 : static_cast<int>(if_nametoindex(interfaceName.c_str()));
+	if(_interfaceIndex == 0 && interfaceName.compare("any") != 0)
+		return false;
+
+	// Create a packet socket, receiving nothing until bound
+	_socket = socket(AF_PACKET, SOCK_RAW, 0);
+
+	// Validate the socket
+	if(_socket == -1)
+	{
+		_socket = 0;
+		return false;
+	}
+
+	// Only let classic and CAN FD frames into the ring, as binding to one protocol would miss either
+	sock_filter code[] = {
+		BPF_STMT(BPF_LD | BPF_H | BPF_ABS, static_cast<__u32>(SKF_AD_OFF + SKF_AD_PROTOCOL)),
+		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_CAN, 1, 0),
+		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_CANFD, 0, 1),
+		BPF_STMT(BPF_RET | BPF_K, 0xFFFFFFFF),
+		BPF_STMT(BPF_RET | BPF_K, 0),
+	};
+	sock_fprog program{ static_cast<unsigned short>(sizeof(code) / sizeof(code[0])), code };
+	if(setsockopt(_socket, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program)) < 0)
+	{
+		Disconnect();
+		return false;
+	}
+
+	// Setup the TPACKET_V3 receive ring
+	int version = TPACKET_V3;
+	tpacket_req3 request{};
+	request.tp_block_size = _blockSize;
+	request.tp_block_nr = _blockCount;
+	request.tp_frame_size = _frameSize;
+	request.tp_frame_nr = (_blockSize * _blockCount) / _frameSize;
+	request.tp_retire_blk_tov = _blockTimeout;
+	if(setsockopt(_socket, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0
+		|| setsockopt(_socket, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)) < 0)
+	{
+		Disconnect();
+		return false;
+	}
+
+	// Map the ring into user space
+	_ringSize = static_cast<std::size_t>(_blockSize) * _blockCount;
+	void* ring = mmap(nullptr, _ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, _socket, 0);
+	if(ring == MAP_FAILED)
+		ring = mmap(nullptr, _ringSize, PROT_READ | PROT_WRITE, MAP_SHARED, _socket, 0);	// Locking may not be permitted
+	if(ring == MAP_FAILED)
+	{
+		Disconnect();
+		return false;
+	}
+	_ring = static_cast<uint8_t*>(ring);
+	_currentBlock = 0;
+	_remainingPackets = 0;
+
+	// Bind the socket
+	sockaddr_ll address{};
+	address.sll_family = AF_PACKET;
+	address.sll_protocol = htons(ETH_P_ALL);
+	address.sll_ifindex = _interfaceIndex;
+	if(bind(_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+	{
+		Disconnect();
+		return false;
+	}
+
+	return true;
+}
+
+// Disconnect method
+void can::interfaces::CANPacketRing::Disconnect()
+{
+	// Unmap the ring before closing the socket owning it
+	if(_ring != nullptr)
+	{
+		munmap(_ring, _ringSize);
+		_ring = nullptr;
+		_ringSize = 0;
+		_currentPacket = nullptr;
+		_remainingPackets = 0;
+	}
+
+	// Check whether the socket is open
+	if(_socket > 0)
+	{
+		// "close" returns 0 on success, and -1 on failure
+		if(close(_socket) == 0)
+			_socket = 0;	// Reset _socket to 0 if successfully closed
+	}
+}
+
+// Returns the performance counters
+const can::interfaces::interface_statistics* can::interfaces::CANPacketRing::GetInterfaceStatistics() const
+{
+	return &_statistics;
+}
+
+// Sets the timeout used while waiting for blocks
+void can::interfaces::CANPacketRing::SetTimeout(int timeout)
+{
+	_pollTimeout = timeout;
+}
+
+// Sets whether waiting for blocks is indefinite or limited by the timeout
+void can::interfaces::CANPacketRing::SetBlockingMode(bool blocking)
+{
+	_blocking = blocking;
+}
+
+// Checks whether the ring is mapped and ready for reading
+bool can::interfaces::CANPacketRing::IsReady() const
+{
+	return (_socket > 0 && _ring != nullptr);
+}
+
+// Returns the socket, which becomes readable when the kernel hands over a block
+int can::interfaces::CANPacketRing::GetFileDescriptor() const
+{
+	return IsReady() ? _socket : -1;
+}
+
+// --------------------------------------------------------------------
+// ICANInterface interface
+// --------------------------------------------------------------------
+// Sending is not supported by the capture interface
+bool can::interfaces::CANPacketRing::SendMessage(const can::Message&)
+{
+	return false;
+}
+
+// Sending is not supported by the capture interface
+std::size_t can::interfaces::CANPacketRing::SendMessages(const can::Message*, std::size_t)
+{
+	return 0;
+}
+
+// Requests a message from the ring
+bool can::interfaces::CANPacketRing::RequestMessage(can::Message& message)
+{
+	return (RequestMessages(&message, 1) == 1);
+}
+
+// Requests up to "count" messages from the ring - syscalls are only made when waiting for a block
+std::size_t can::interfaces::CANPacketRing::RequestMessages(can::Message* messages, std::size_t count)
+{
+	// Ensure that the ring is mapped
+	if(!IsReady() || messages == nullptr || count == 0)
+		return 0;
+
+	std::size_t received = 0;
+	while(received < count)
+	{
+		// Move to the next block once the current block has been read
+		if(_remainingPackets == 0 && !AcquireBlock())
+		{
+			// Return what has been read so far, rather than waiting for more
+			if(received > 0)
+				break;
+
+			// Only waiting for blocks takes system calls
+			ReadDrops();
+			_statistics.receive_calls.add(1);
+			if(!PollSocket(_blocking ? -1 : _pollTimeout) || !AcquireBlock())
+			{
+				_statistics.poll_timeouts.add(1);
+				break;
+			}
+		}
+
+		// Copy the frame, skipping packets of unexpected size
+		auto header = reinterpret_cast<const tpacket3_hdr*>(_currentPacket);
+		if(header->tp_snaplen == CAN_MTU || header->tp_snaplen == CANFD_MTU)
+		{
+			auto address = reinterpret_cast<const sockaddr_ll*>(_currentPacket + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+			can::Message& message = messages[received++];
+			std::memcpy(&message.get_fd_frame(), _currentPacket + header->tp_mac, header->tp_snaplen);
+			if(header->tp_snaplen == CANFD_MTU)
+				message.get_fd_frame().flags |= CANFD_FDF;
+			else
+				message.set_fd(false);
+			message.set_interface(address->sll_ifindex);
+			message.get_timestamp().tv_sec = header->tp_sec;
+			message.get_timestamp().tv_nsec = header->tp_nsec;
+		}
+		else
+		{
+			_statistics.short_reads.add(1);
+		}
+
+		// Advance within the block, handing it back to the kernel when done
+		_currentPacket += header->tp_next_offset;
+		if(--_remainingPackets == 0)
+			ReleaseBlock();
+	}
+
+	_statistics.record_received(messages, received);
+
+	return received;
+}
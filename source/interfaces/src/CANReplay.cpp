@@ -0,0 +1,294 @@
+///////////////////////////////////////////////////////////////////////
+// CAN Replay Interface
+//
+// Replays a log file with the timing of the recording, scaled by a
+// speed factor, or as fast as possible.
+///////////////////////////////////////////////////////////////////////
+#include <interfaces/include/CANReplay.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <time.h>
+
+#include <logging/include/binary_log.h>
+
+namespace
+{
+	int64_t monotonic_now()
+	{
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return static_cast<int64_t>(now.tv_sec) * 1000000000ll + now.tv_nsec;
+	}
+
+	uint64_t timestamp_ns(const can::Message& message)
+	{
+		const timespec& time = message.get_timestamp();
+		return static_cast<uint64_t>(time.tv_sec) * 1000000000ull + static_cast<uint64_t>(time.tv_nsec);
+	}
+
+	// Detects the format of a log file from its first bytes
+	can::interfaces::CANLogFile::log_format detect_format(const std::string& path)
+	{
+		std::array<char,8> magic{};
+		std::ifstream file(path, std::ios::binary);
+		file.read(magic.data(), magic.size());
+
+		if(file && magic == can::logging::binary_log::file_magic)
+			return can::interfaces::CANLogFile::log_format::binary;
+		return can::interfaces::CANLogFile::log_format::candump;
+	}
+}
+
+// --------------------------------------------------------------------
+// Constructors / destructor
+// --------------------------------------------------------------------
+// Constructor
+can::interfaces::CANReplay::CANReplay() :
+	_source(),
+	_speed(1.0),
+	_spinThreshold(100000),
+	_pollTimeout(200),
+	_blocking(true),
+	_buffer(),
+	_bufferPosition(0),
+	_bufferCount(0),
+	_started(false),
+	_firstTimestamp(0),
+	_startTime(0),
+	_frames(0),
+	_minJitter(0),
+	_maxJitter(0),
+	_meanJitter(0.0),
+	_sumSquares(0.0)
+{
+}
+
+// Destructor
+can::interfaces::CANReplay::~CANReplay()
+{
+	Disconnect();
+}
+
+// --------------------------------------------------------------------
+// Private methods
+// --------------------------------------------------------------------
+// Returns the next message to replay, without consuming it - nullptr at the end of the log
+can::Message* can::interfaces::CANReplay::PeekMessage()
+{
+	if(_bufferPosition == _bufferCount)
+	{
+		_bufferPosition = 0;
+		_bufferCount = _source ? _source->RequestMessages(_buffer.data(), _buffer.size()) : 0;
+	}
+
+	return (_bufferPosition < _bufferCount) ? &_buffer[_bufferPosition] : nullptr;
+}
+
+// Returns the monotonic time at which a message is due
+int64_t can::interfaces::CANReplay::GetDeadline(const can::Message& message) const
+{
+	if(_speed <= 0.0)
+		return _startTime;
+
+	// Messages recorded out of order are due immediately
+	auto timestamp = timestamp_ns(message);
+	auto offset = (timestamp > _firstTimestamp) ? static_cast<double>(timestamp - _firstTimestamp) : 0.0;
+	return _startTime + static_cast<int64_t>(offset / _speed);
+}
+
+// Waits until the deadline, but not beyond the limit - returns whether the deadline was reached
+bool can::interfaces::CANReplay::WaitUntil(int64_t deadline, int64_t limit)
+{
+	auto target = std::min(deadline, limit);
+
+	// Sleep until shortly before the target, as waking up takes a while
+	auto now = monotonic_now();
+	if(target - now > _spinThreshold)
+	{
+		auto wakeup = target - _spinThreshold;
+		timespec time{ static_cast<time_t>(wakeup / 1000000000ll), static_cast<long>(wakeup % 1000000000ll) };
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr) == EINTR) {}
+	}
+
+	// Spin for the remainder
+	do
+	{
+		now = monotonic_now();
+	} while(now < target);
+
+	return (now >= deadline);
+}
+
+// Adds the jitter of a message to the statistics
+void can::interfaces::CANReplay::AddJitter(int64_t jitter)
+{
+	_frames++;
+	if(_frames == 1)
+	{
+		_minJitter = _maxJitter = jitter;
+	}
+	else
+	{
+		_minJitter = std::min(_minJitter, jitter);
+		_maxJitter = std::max(_maxJitter, jitter);
+	}
+
+	auto delta = static_cast<double>(jitter) - _meanJitter;
+	_meanJitter += delta / static_cast<double>(_frames);
+	_sumSquares += delta * (static_cast<double>(jitter) - _meanJitter);
+}
+
+// --------------------------------------------------------------------
+// Public methods
+// --------------------------------------------------------------------
+// Sets the replay speed - takes effect from the next message
+void can::interfaces::CANReplay::SetReplaySpeed(double speed)
+{
+	// Rebase the time line, so the next message stays due when it was
+	auto message = _started ? PeekMessage() : nullptr;
+	if(message != nullptr && _speed > 0.0 && speed > 0.0)
+	{
+		auto offset = static_cast<double>(GetDeadline(*message) - _startTime) * _speed;
+		_startTime = GetDeadline(*message) - static_cast<int64_t>(offset / speed);
+	}
+
+	_speed = std::max(speed, 0.0);
+}
+
+double can::interfaces::CANReplay::GetReplaySpeed() const
+{
+	return _speed;
+}
+
+// Sets how long before a deadline sleeping ends and spinning begins
+void can::interfaces::CANReplay::SetSpinThreshold(int64_t nanoseconds)
+{
+	_spinThreshold = std::max<int64_t>(nanoseconds, 0);
+}
+
+// Returns the jitter statistics of the messages replayed so far
+can::interfaces::replay_statistics can::interfaces::CANReplay::GetStatistics() const
+{
+	replay_statistics statistics;
+	statistics.frames = _frames;
+	statistics.min_jitter = _minJitter;
+	statistics.max_jitter = _maxJitter;
+	statistics.mean_jitter = _meanJitter;
+	statistics.stddev_jitter = (_frames > 1) ? std::sqrt(_sumSquares / static_cast<double>(_frames - 1)) : 0.0;
+	return statistics;
+}
+
+// Opens the log file to replay
+bool can::interfaces::CANReplay::Connect(const std::string& interfaceName)
+{
+	if(IsReady())
+		return false;
+
+	_source = std::make_unique<CANLogFile>(detect_format(interfaceName));
+	if(!_source->Connect(interfaceName) || PeekMessage() == nullptr)
+	{
+		Disconnect();
+		return false;
+	}
+
+	_started = false;
+	_frames = 0;
+	_meanJitter = _sumSquares = 0.0;
+	return true;
+}
+
+// Closes the log file
+void can::interfaces::CANReplay::Disconnect()
+{
+	_source.reset();
+	_bufferPosition = _bufferCount = 0;
+	_started = false;
+}
+
+// Sets the maximum time (ms) to wait for the next message in non-blocking mode
+void can::interfaces::CANReplay::SetTimeout(int timeout)
+{
+	_pollTimeout = timeout;
+}
+
+// Sets whether requests wait for the next message to be due, or at most the timeout
+void can::interfaces::CANReplay::SetBlockingMode(bool blocking)
+{
+	_blocking = blocking;
+}
+
+// Checks whether a log file is open
+bool can::interfaces::CANReplay::IsReady() const
+{
+	return (_source != nullptr);
+}
+
+// Replay is paced by timers, not by a descriptor
+int can::interfaces::CANReplay::GetFileDescriptor() const
+{
+	return -1;
+}
+
+// --------------------------------------------------------------------
+// ICANInterface interface
+// --------------------------------------------------------------------
+// Sending is not supported by the replay interface
+bool can::interfaces::CANReplay::SendMessage(const can::Message&)
+{
+	return false;
+}
+
+// Sending is not supported by the replay interface
+std::size_t can::interfaces::CANReplay::SendMessages(const can::Message*, std::size_t)
+{
+	return 0;
+}
+
+// Waits for the next message to be due and returns it
+bool can::interfaces::CANReplay::RequestMessage(can::Message& message)
+{
+	return (RequestMessages(&message, 1) == 1);
+}
+
+// Waits for the next message to be due, and returns it along with any further messages already due
+std::size_t can::interfaces::CANReplay::RequestMessages(can::Message* messages, std::size_t count)
+{
+	if(!IsReady() || messages == nullptr || count == 0)
+		return 0;
+
+	auto next = PeekMessage();
+	if(next == nullptr)
+		return 0;
+
+	// The time line starts with the first message
+	if(!_started)
+	{
+		_started = true;
+		_firstTimestamp = timestamp_ns(*next);
+		_startTime = monotonic_now();
+	}
+
+	// Wait for the first message, limited by the timeout in non-blocking mode
+	auto limit = _blocking ? GetDeadline(*next) : monotonic_now() + static_cast<int64_t>(_pollTimeout) * 1000000ll;
+	if(!WaitUntil(GetDeadline(*next), limit))
+		return 0;
+
+	std::size_t received = 0;
+	auto now = monotonic_now();
+	while(received < count && next != nullptr)
+	{
+		auto deadline = GetDeadline(*next);
+		if(deadline > now)
+			break;
+
+		AddJitter(now - deadline);
+		messages[received++] = *next;
+		_bufferPosition++;
+		next = PeekMessage();
+	}
+
+	return received;
+}
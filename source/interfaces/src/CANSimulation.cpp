@@ -0,0 +1,210 @@
+///////////////////////////////////////////////////////////////////////
+// CAN Simulation Interface
+//
+// Connects to an in-memory simulated bus, shared with every other
+// simulation interface of the process connected to the same name.
+///////////////////////////////////////////////////////////////////////
+#include <interfaces/include/CANSimulation.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <poll.h>
+#include <thread>
+#include <unistd.h>
+
+// --------------------------------------------------------------------
+// Constructors / destructor
+// --------------------------------------------------------------------
+// Constructor
+can::interfaces::CANSimulation::CANSimulation() :
+	_bus(),
+	_endpoint(nullptr),
+	_droppedBefore(0),
+	_pollTimeout(200),
+	_blocking(true),
+	_statistics()
+{
+}
+
+// Destructor
+can::interfaces::CANSimulation::~CANSimulation()
+{
+	Disconnect();
+}
+
+// --------------------------------------------------------------------
+// Private methods
+// --------------------------------------------------------------------
+// Waits for frames to arrive, as the socket is polled - returns the number of frames received
+std::size_t can::interfaces::CANSimulation::WaitForMessages(can::Message* messages, std::size_t count)
+{
+	auto timeout = _blocking ? -1 : _pollTimeout;
+	for(;;)
+	{
+		// Ask senders for a wake-up, then check again for frames queued meanwhile
+		uint64_t value;
+		auto cleared = read(_endpoint->event, &value, sizeof(value));
+		(void)cleared;
+		_endpoint->armed.store(true);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		auto received = _endpoint->queue.pop(messages, count);
+		if(received > 0)
+			return received;
+
+		pollfd p;
+		p.fd = _endpoint->event;
+		p.events = POLLIN;
+		_statistics.receive_calls.add(1);
+		if(poll(&p, 1, timeout) <= 0)
+		{
+			_statistics.poll_timeouts.add(1);
+			return 0;
+		}
+	}
+}
+
+// --------------------------------------------------------------------
+// Public methods
+// --------------------------------------------------------------------
+// Connects to a bus, named as "name" or "name@bitrate"
+bool can::interfaces::CANSimulation::Connect(const std::string& interfaceName)
+{
+	if(IsReady())
+		return false;
+
+	auto separator = interfaceName.find('@');
+	auto name = interfaceName.substr(0, separator);
+	uint32_t bitrate = 0;
+	if(separator != std::string::npos)
+	{
+		char* end = nullptr;
+		auto value = std::strtoul(interfaceName.c_str() + separator + 1, &end, 10);
+		if(end == interfaceName.c_str() + separator + 1 || *end != '\0' || value == 0 || value > 10000000)
+			return false;
+		bitrate = static_cast<uint32_t>(value);
+	}
+
+	if(name.empty())
+		return false;
+
+	_bus = simulated_bus::open(name, bitrate);
+	_endpoint = _bus ? _bus->attach() : nullptr;
+	if(_endpoint == nullptr)
+	{
+		_bus.reset();
+		return false;
+	}
+
+	_droppedBefore = _endpoint->queue.dropped();
+	return true;
+}
+
+// Disconnects from the bus
+void can::interfaces::CANSimulation::Disconnect()
+{
+	if(_bus)
+		_bus->detach(_endpoint);
+
+	_endpoint = nullptr;
+	_bus.reset();
+}
+
+// Sets the timeout used while waiting for frames, in milliseconds
+void can::interfaces::CANSimulation::SetTimeout(int timeout)
+{
+	_pollTimeout = timeout;
+}
+
+// Sets blocking mode - requests then wait until frames arrive
+void can::interfaces::CANSimulation::SetBlockingMode(bool blocking)
+{
+	_blocking = blocking;
+}
+
+// Checks whether the interface is connected to a bus
+bool can::interfaces::CANSimulation::IsReady() const
+{
+	return (_endpoint != nullptr);
+}
+
+// Returns the eventfd signalling frames for a waiting receiver
+int can::interfaces::CANSimulation::GetFileDescriptor() const
+{
+	return IsReady() ? _endpoint->event : -1;
+}
+
+// Returns the performance counters
+const can::interfaces::interface_statistics* can::interfaces::CANSimulation::GetInterfaceStatistics() const
+{
+	return &_statistics;
+}
+
+// Returns the connected bus
+const can::interfaces::simulated_bus* can::interfaces::CANSimulation::GetBus() const
+{
+	return _bus.get();
+}
+
+// --------------------------------------------------------------------
+// ICANInterface interface
+// --------------------------------------------------------------------
+// Attempt to send a message
+bool can::interfaces::CANSimulation::SendMessage(const can::Message& message)
+{
+	return (SendMessages(&message, 1) == 1);
+}
+
+// Attempt to send "count" messages - with bus timing, waits up to the timeout while the transmit queue is full
+std::size_t can::interfaces::CANSimulation::SendMessages(const can::Message* messages, std::size_t count)
+{
+	if(!IsReady() || messages == nullptr || count == 0)
+		return 0;
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_pollTimeout);
+
+	std::size_t sent = 0;
+	while(sent < count)
+	{
+		auto result = _bus->transmit(*_endpoint, messages + sent, count - sent);
+		_statistics.send_calls.add(1);
+		for(std::size_t i = 0; i < result; i++)
+			_statistics.bytes_sent.add(messages[sent + i].size());
+		sent += result;
+
+		if(sent < count && std::chrono::steady_clock::now() < deadline)
+		{
+			_statistics.send_retries.add(1);
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			continue;
+		}
+		break;
+	}
+
+	_statistics.frames_sent.add(sent);
+	if(sent < count)
+		_statistics.write_failures.add(1);
+
+	return sent;
+}
+
+// Requests a message from the bus
+bool can::interfaces::CANSimulation::RequestMessage(can::Message& message)
+{
+	return (RequestMessages(&message, 1) == 1);
+}
+
+// Requests up to "count" messages, waiting only if none are queued
+std::size_t can::interfaces::CANSimulation::RequestMessages(can::Message* messages, std::size_t count)
+{
+	if(!IsReady() || messages == nullptr || count == 0)
+		return 0;
+
+	auto received = _endpoint->queue.pop(messages, count);
+	if(received == 0)
+		received = WaitForMessages(messages, count);
+
+	_statistics.overflow_drops.set(_endpoint->queue.dropped() - _droppedBefore);
+	_statistics.record_received(messages, received);
+	return received;
+}
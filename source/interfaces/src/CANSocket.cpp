@@ -6,6 +6,9 @@
 ///////////////////////////////////////////////////////////////////////
 #include <interfaces/include/CANSocket.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
 #include <cstring>
 #include <net/if.h>
 #include <sys/ioctl.h>
@@ -13,7 +16,8 @@
 #include <linux/sockios.h>
 #include <poll.h>
 #include <fcntl.h>
-//#include <linux/can/raw.h>
+#include <linux/can/raw.h>
+#include <linux/net_tstamp.h>
 
 // --------------------------------------------------------------------
 // Constructors / destructor
@@ -24,7 +28,18 @@ can::interfaces::CANSocket::CANSocket() :
 	_interfaceName("any"),
 	_interfaceIndex(0),
 	_pollTimeout(200),
-	_blocking(true)
+	_blocking(true),
+	_hardwareTimestamps(false),
+	_hardwareClock(),
+	_filters{ can_filter{ 0, 0 } },
+	_errorMask(0),
+	_receiveHeaders(),
+	_receiveVectors(),
+	_receiveAddresses(),
+	_receiveControl(),
+	_sendHeaders(),
+	_sendVectors(),
+	_statistics()
 {
 }
 
@@ -55,6 +70,121 @@ bool can::interfaces::CANSocket::PollSocket(int timeout)
 	return false;
 }
 
+// Waits for the transmit queue of the interface to accept frames again
+bool can::interfaces::CANSocket::WaitForTransmitQueue(int timeout, bool backOff)
+{
+	// The socket may report POLLOUT while the device queue is still full - after such a wait, back off briefly instead of spinning
+	if(backOff)
+		usleep(100);
+
+	// Setup the polling data structure
+	pollfd p;
+	p.fd = _socket;
+	p.events = POLLOUT;
+
+	auto result = poll(&p, 1, timeout);
+	return (result > 0 && (p.revents & POLLOUT));
+}
+
+// Installs the filters in the kernel - frames not passing are dropped before reaching the socket
+bool can::interfaces::CANSocket::ApplyFilters()
+{
+	// Filters are applied when connecting
+	if(!IsReady())
+		return true;
+
+	auto filtersSet = setsockopt(_socket, SOL_CAN_RAW, CAN_RAW_FILTER, _filters.data(), _filters.size() * sizeof(can_filter));
+	auto errorMaskSet = setsockopt(_socket, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &_errorMask, sizeof(_errorMask));
+
+	return (filtersSet == 0 && errorMaskSet == 0);
+}
+
+// Requests nanosecond receive timestamps, falling back to SO_TIMESTAMPNS on kernels without SO_TIMESTAMPING
+bool can::interfaces::CANSocket::EnableTimestamps()
+{
+	int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+	if(_hardwareTimestamps)
+	{
+		// Let the driver stamp all received frames - requires CAP_NET_ADMIN, and may already be configured
+		if(!InterfaceIsAny())
+		{
+			hwtstamp_config config{};
+			config.tx_type = HWTSTAMP_TX_OFF;
+			config.rx_filter = HWTSTAMP_FILTER_ALL;
+
+			ifreq ifr{};
+			std::strncpy(ifr.ifr_name, _interfaceName.c_str(), IFNAMSIZ - 1);
+			ifr.ifr_data = reinterpret_cast<char*>(&config);
+			ioctl(_socket, SIOCSHWTSTAMP, &ifr);
+		}
+
+		flags |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+	}
+
+	if(setsockopt(_socket, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0)
+		return true;
+
+	int enable = 1;
+	setsockopt(_socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+	return false;
+}
+
+// Copies the kernel receive timestamp and the drop counter from the control messages of a received frame
+void can::interfaces::CANSocket::ReadControlMessages(msghdr& header, can::Message& message)
+{
+	// The message slot is reused between reads - a previous timestamp must not survive a frame without one
+	message.get_timestamp() = timespec{};
+	message.set_timestamp_source(can::timestamp_source::software);
+
+	for(cmsghdr* cmsg = CMSG_FIRSTHDR(&header); cmsg != nullptr; cmsg = CMSG_NXTHDR(&header, cmsg))
+	{
+		if(cmsg->cmsg_level != SOL_SOCKET)
+			continue;
+
+		if(cmsg->cmsg_type == SCM_TIMESTAMPING)
+		{
+			// The software timestamp is first, the raw hardware timestamp last - unset ones are zero
+			scm_timestamping stamps;
+			std::memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+			const timespec& software = stamps.ts[0];
+			const timespec& hardware = stamps.ts[2];
+
+			if(hardware.tv_sec != 0 || hardware.tv_nsec != 0)
+			{
+				auto time = can::to_nanoseconds(hardware);
+				if(software.tv_sec != 0 || software.tv_nsec != 0)
+					_hardwareClock.update(time, can::to_nanoseconds(software));
+
+				// Hardware timestamps are only used once they can be related to the software clock
+				if(_hardwareClock.valid())
+				{
+					message.get_timestamp() = can::to_timespec(_hardwareClock.to_reference(time));
+					message.set_timestamp_source(can::timestamp_source::hardware);
+					continue;
+				}
+			}
+
+			message.get_timestamp() = software;
+		}
+		else if(cmsg->cmsg_type == SCM_TIMESTAMPNS)
+		{
+			std::memcpy(&message.get_timestamp(), CMSG_DATA(cmsg), sizeof(timespec));
+		}
+		else if(cmsg->cmsg_type == SO_RXQ_OVFL)
+		{
+			// Number of frames the kernel dropped on this socket so far
+			uint32_t dropped;
+			std::memcpy(&dropped, CMSG_DATA(cmsg), sizeof(dropped));
+			_statistics.overflow_drops.set(dropped);
+		}
+	}
+
+	// Without a kernel timestamp (e.g. truncated control data), the time of reading is the closest estimate
+	auto& timestamp = message.get_timestamp();
+	if(timestamp.tv_sec == 0 && timestamp.tv_nsec == 0)
+		timestamp = can::to_timespec(can::clock_nanoseconds(CLOCK_REALTIME));
+}
+
 // --------------------------------------------------------------------
 // Public methods
 // --------------------------------------------------------------------
@@ -94,17 +224,35 @@ bool can::interfaces::CANSocket::Connect(const std::string& interfaceName)
 		ifreq ifr;
 		std::strcpy(ifr.ifr_name, interfaceName.c_str());
 		if(ioctl(_socket, SIOCGIFINDEX, &ifr) < 0)
+		{
+			Disconnect();
 			return false;
+		}
 
 		// Set the index
 		address.can_ifindex = ifr.ifr_ifindex;
 		_interfaceIndex = ifr.ifr_ifindex;
 	}
 
-	// Bind the socket
-	bind(_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+	// Nanosecond receive timestamps, delivered with every frame
+	EnableTimestamps();
+	_hardwareClock.reset();
 
-	return false;
+	// Let the kernel report the frames dropped due to a full receive queue
+	int enable = 1;
+	setsockopt(_socket, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable));
+
+	// Exchange CAN FD frames as well - classic frames are still exchanged as CAN_MTU bytes
+	setsockopt(_socket, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable));
+
+	// Bind the socket, with filters in place before any frames are received
+	if(!ApplyFilters() || bind(_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+	{
+		Disconnect();
+		return false;
+	}
+
+	return true;
 }
 
 // Disconnect method
@@ -140,6 +288,61 @@ bool can::interfaces::CANSocket::IsReady() const
 	return (_socket > 0);
 }
 
+// Sets the kernel-side filters - an empty set receives no frames at all
+bool can::interfaces::CANSocket::SetFilters(const can_filter* filters, std::size_t count)
+{
+	if(filters == nullptr && count > 0)
+		return false;
+
+	_filters.assign(filters, filters + count);
+	return ApplyFilters();
+}
+
+// Removes all kernel-side filtering
+bool can::interfaces::CANSocket::ClearFilters()
+{
+	_filters.assign(1, can_filter{ 0, 0 });
+	return ApplyFilters();
+}
+
+// Sets the error classes received as error frames
+bool can::interfaces::CANSocket::SetErrorFilter(can_err_mask_t mask)
+{
+	_errorMask = mask;
+	return ApplyFilters();
+}
+
+// Enables or disables hardware receive timestamps - returns false if the socket rejects them
+bool can::interfaces::CANSocket::SetHardwareTimestamps(bool enable)
+{
+	_hardwareTimestamps = enable;
+	_hardwareClock.reset();
+
+	// Applied when connecting
+	if(!IsReady())
+		return true;
+
+	return EnableTimestamps();
+}
+
+// Returns the alignment of the hardware clock, e.g. to check whether hardware timestamps are received
+const can::clock_alignment& can::interfaces::CANSocket::GetHardwareClock() const
+{
+	return _hardwareClock;
+}
+
+// Returns the socket, for waiting on several interfaces at once
+int can::interfaces::CANSocket::GetFileDescriptor() const
+{
+	return IsReady() ? _socket : -1;
+}
+
+// Returns the performance counters
+const can::interfaces::interface_statistics* can::interfaces::CANSocket::GetInterfaceStatistics() const
+{
+	return &_statistics;
+}
+
 // Checks whether the interface index is set to "any"
 constexpr bool can::interfaces::CANSocket::InterfaceIsAny() const
 {
@@ -151,71 +354,163 @@ constexpr bool can::interfaces::CANSocket::InterfaceIsAny() const
 // --------------------------------------------------------------------
 // Attempt to send a message
 bool can::interfaces::CANSocket::SendMessage(const can::Message& message)
+{
+	return (SendMessages(&message, 1) == 1);
+}
+
+// Attempt to send "count" messages, using as few system calls as possible
+std::size_t can::interfaces::CANSocket::SendMessages(const can::Message* messages, std::size_t count)
 {
 	// Ensure that the socket is connected
-	if(!IsReady())
-		return false;
+	if(!IsReady() || messages == nullptr || count == 0)
+		return 0;
 
 	// TODO: Handle the "any" case - send to all?
 	if(InterfaceIsAny())
-		return false;
+		return 0;
 
-	// Get the internal frame structure
-	const can_frame& frame = message.get_frame();
+	// When the transmit queue is full, keep retrying until the poll timeout has expired - blocking sends have no deadline
+	auto unlimited = _blocking || _pollTimeout < 0;
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(_pollTimeout, 0));
+	bool ready = false;	// The last wait reported the socket writable
 
-	// Write frame to the CAN socket
-	auto count = write(_socket, &frame, sizeof(can_frame));
+	std::size_t sent = 0;
+	while(sent < count)
+	{
+		// Setup the message headers, sending directly from the supplied messages
+		auto batch = std::min(count - sent, _batchSize);
+		for(std::size_t i = 0; i < batch; i++)
+		{
+			_sendVectors[i].iov_base = const_cast<canfd_frame*>(&messages[sent + i].get_fd_frame());
+			_sendVectors[i].iov_len = messages[sent + i].mtu();
 
-	// Check whether the write was successful
-	return (count == sizeof(can_frame));
+			msghdr& header = _sendHeaders[i].msg_hdr;
+			header = msghdr{};
+			header.msg_iov = &_sendVectors[i];
+			header.msg_iovlen = 1;
+		}
+
+		auto result = sendmmsg(_socket, _sendHeaders.data(), batch, 0);
+		_statistics.send_calls.add(1);
+		if(result > 0)
+		{
+			for(std::size_t i = 0; i < static_cast<std::size_t>(result); i++)
+				_statistics.bytes_sent.add(messages[sent + i].size());
+			sent += result;
+			ready = false;
+			continue;
+		}
+
+		// Interrupted sends are repeated, regardless of the deadline
+		if(result < 0 && errno == EINTR)
+			continue;
+
+		// A full transmit queue is reported as ENOBUFS (or EAGAIN in non-blocking mode)
+		if(result < 0 && (errno == ENOBUFS || errno == EAGAIN))
+		{
+			auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+			if(unlimited || remaining > 0)
+			{
+				_statistics.send_retries.add(1);
+				ready = WaitForTransmitQueue(unlimited ? -1 : static_cast<int>(remaining), ready);
+				continue;
+			}
+		}
+
+		break;
+	}
+
+	_statistics.frames_sent.add(sent);
+	if(sent < count)
+		_statistics.write_failures.add(1);
+
+	return sent;
 }
 
 // Requests a message from the CAN bus
 bool can::interfaces::CANSocket::RequestMessage(can::Message& message)
+{
+	return (RequestMessages(&message, 1) == 1);
+}
+
+// Requests up to "count" messages from the CAN bus, using as few system calls as possible
+std::size_t can::interfaces::CANSocket::RequestMessages(can::Message* messages, std::size_t count)
 {
 	// Ensure that the socket is connected
-	if(!IsReady())
-		return false;
+	if(!IsReady() || messages == nullptr || count == 0)
+		return 0;
 
 	// If the socket is not in blocking mode, poll the socket to see if data is available
 	if(!_blocking && !PollSocket(_pollTimeout))
-		return false;
-
-	// Get message reference
-	can_frame& frame = message.get_frame();
-	ssize_t count = 0;
+	{
+		_statistics.poll_timeouts.add(1);
+		return 0;
+	}
 
-	// Check whether the socket is setup for "any" or a specific interface
-	if(_interfaceIndex == 0)
+	std::size_t received = 0;
+	while(received < count)
 	{
-		// Receive from any CAN interface
-		sockaddr_can address;
-		socklen_t len = sizeof(address);
-		count = recvfrom(_socket, &frame, sizeof(can_frame), 0, reinterpret_cast<sockaddr*>(&address), &len);
+		// Setup the message headers, receiving frames directly into the supplied messages
+		auto batch = std::min(count - received, _batchSize);
+		for(std::size_t i = 0; i < batch; i++)
+		{
+			_receiveVectors[i].iov_base = &messages[received + i].get_fd_frame();
+			_receiveVectors[i].iov_len = CANFD_MTU;
+
+			msghdr& header = _receiveHeaders[i].msg_hdr;
+			header.msg_name = &_receiveAddresses[i];
+			header.msg_namelen = sizeof(sockaddr_can);
+			header.msg_iov = &_receiveVectors[i];
+			header.msg_iovlen = 1;
+			header.msg_control = _receiveControl[i].data();
+			header.msg_controllen = _receiveControl[i].size();
+			header.msg_flags = 0;
+		}
 
-		// Get the name of the interface that received the message
-		if(count > 0)
+		// Only the first frame is waited for - the remaining frames are collected if already queued
+		auto flags = (received == 0) ? MSG_WAITFORONE : MSG_DONTWAIT;
+		auto result = recvmmsg(_socket, _receiveHeaders.data(), batch, flags, nullptr);
+		_statistics.receive_calls.add(1);
+		if(result <= 0)
 		{
-			ifreq ifr;
-			ifr.ifr_ifindex = address.can_ifindex;
-			ioctl(_socket, SIOCGIFNAME, &ifr);
-			message.set_interface(ifr.ifr_name);
+			if(result < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				_statistics.receive_errors.add(1);
+			break;
 		}
-		else
+
+		// Unpack the received frames, skipping frames of unexpected size
+		std::size_t valid = 0;
+		for(std::size_t i = 0; i < static_cast<std::size_t>(result); i++)
 		{
-			message.set_interface("unknown");
+			auto length = _receiveHeaders[i].msg_len;
+			if(length != CAN_MTU && length != CANFD_MTU)
+			{
+				_statistics.short_reads.add(1);
+				continue;
+			}
+
+			can::Message& message = messages[received + valid];
+			if(valid != i)
+				message.get_fd_frame() = messages[received + i].get_fd_frame();
+			if(length == CANFD_MTU)
+				message.get_fd_frame().flags |= CANFD_FDF;
+			else
+				message.set_fd(false);
+
+			// The source address holds the receiving interface, also when bound to "any"
+			message.set_interface(_receiveAddresses[i].can_ifindex);
+
+			ReadControlMessages(_receiveHeaders[i].msg_hdr, message);
+			valid++;
 		}
-	}
-	else
-	{
-		// Just read message from the specified interface
-		count = read(_socket, &frame, sizeof(can_frame));
-		message.set_interface(_interfaceName);
+		received += valid;
+
+		// Stop when the socket queue has been drained
+		if(static_cast<std::size_t>(result) < batch)
+			break;
 	}
 
-	// Get the timestamp
-	if(count > 0)
-		ioctl(_socket, SIOCGSTAMP, &message.get_timestamp());
+	_statistics.record_received(messages, received);
 
-	return (count == CAN_MTU);
+	return received;
 }
@@ -5,6 +5,10 @@
 ///////////////////////////////////////////////////////////////////////
 #include <interfaces/include/connection_factory.h>
 #include <interfaces/include/CANSocket.h>
+#include <interfaces/include/CANPacketRing.h>
+#include <interfaces/include/CANLogFile.h>
+#include <interfaces/include/CANReplay.h>
+#include <interfaces/include/CANSimulation.h>
 
 namespace can::interfaces
 {
@@ -12,6 +16,16 @@ namespace can::interfaces
 	{
 		if(type.compare("can") == 0)
 			return std::make_unique<CANSocket>();
+		if(type.compare("can-mmap") == 0)
+			return std::make_unique<CANPacketRing>();
+		if(type.compare("candump") == 0)
+			return std::make_unique<CANLogFile>(CANLogFile::log_format::candump);
+		if(type.compare("canlog") == 0)
+			return std::make_unique<CANLogFile>(CANLogFile::log_format::binary);
+		if(type.compare("replay") == 0)
+			return std::make_unique<CANReplay>();
+		if(type.compare("sim") == 0)
+			return std::make_unique<CANSimulation>();
 		return nullptr;
 	}
 
@@ -19,6 +33,16 @@ namespace can::interfaces
 	{
 		if(type == interface_type::socket_can)
 			return std::make_unique<CANSocket>();
+		if(type == interface_type::socket_can_mmap)
+			return std::make_unique<CANPacketRing>();
+		if(type == interface_type::candump_file)
+			return std::make_unique<CANLogFile>(CANLogFile::log_format::candump);
+		if(type == interface_type::binary_log_file)
+			return std::make_unique<CANLogFile>(CANLogFile::log_format::binary);
+		if(type == interface_type::log_replay)
+			return std::make_unique<CANReplay>();
+		if(type == interface_type::simulation)
+			return std::make_unique<CANSimulation>();
 		return nullptr;
 	}
 }
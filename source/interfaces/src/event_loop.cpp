@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////
+// Event loop implementation
+//
+// Waits on any number of CAN interfaces with a single epoll instance,
+// and dispatches received messages to the handler registered with
+// each interface. Interfaces are registered edge-triggered and drained
+// in batches, with a limit per wake-up so a busy bus cannot starve the
+// others.
+///////////////////////////////////////////////////////////////////////
+#include <interfaces/include/event_loop.h>
+
+#include <algorithm>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace can::interfaces
+{
+	// --------------------------------------------------------------------
+	// Constructors / destructor
+	// --------------------------------------------------------------------
+	event_loop::event_loop() :
+		_epoll(epoll_create1(EPOLL_CLOEXEC)),
+		_registrations(),
+		_pending(),
+		_ready(),
+		_batch(),
+		_running(false)
+	{
+	}
+
+	event_loop::~event_loop()
+	{
+		if(_epoll >= 0)
+			close(_epoll);
+	}
+
+	// --------------------------------------------------------------------
+	// Private methods
+	// --------------------------------------------------------------------
+	// Reads batches from an interface until it is empty, or the limit per wake-up is reached
+	std::size_t event_loop::Drain(registration& entry)
+	{
+		std::size_t total = 0;
+		for(std::size_t i = 0; i < _batchesPerWakeup; i++)
+		{
+			auto count = entry.interface->RequestMessages(_batch.data(), _batch.size());
+			if(count == 0)
+			{
+				entry.pending = false;
+				return total;
+			}
+
+			entry.handler(*entry.interface, _batch.data(), count);
+			total += count;
+		}
+
+		// More data may be waiting - no new edge will be reported for it, so revisit later
+		entry.pending = true;
+		return total;
+	}
+
+	// --------------------------------------------------------------------
+	// Public methods
+	// --------------------------------------------------------------------
+	// Registers an interface with the handler receiving its messages
+	bool event_loop::add(ICANInterface& interface, handler_type handler)
+	{
+		auto fd = interface.GetFileDescriptor();
+		if(_epoll < 0 || fd < 0 || !handler)
+			return false;
+
+		// Draining relies on requests returning immediately when no data is available
+		interface.SetBlockingMode(false);
+		interface.SetTimeout(0);
+
+		auto entry = std::make_unique<registration>(registration{ &interface, std::move(handler), true });
+		epoll_event event{};
+		event.events = EPOLLIN | EPOLLET;
+		event.data.ptr = entry.get();
+		if(epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) < 0)
+			return false;
+
+		// Messages may have arrived before registering, so the first drain is not edge-triggered
+		_pending.push_back(entry.get());
+		_registrations.push_back(std::move(entry));
+		return true;
+	}
+
+	// Unregisters an interface - must not be called from a handler
+	bool event_loop::remove(ICANInterface& interface)
+	{
+		auto entry = std::find_if(_registrations.begin(), _registrations.end(), [&interface](const auto& r) { return r->interface == &interface; });
+		if(entry == _registrations.end())
+			return false;
+
+		auto fd = interface.GetFileDescriptor();
+		if(fd >= 0)
+			epoll_ctl(_epoll, EPOLL_CTL_DEL, fd, nullptr);
+
+		_pending.erase(std::remove(_pending.begin(), _pending.end(), entry->get()), _pending.end());
+		_registrations.erase(entry);
+		return true;
+	}
+
+	// Returns the number of registered interfaces
+	std::size_t event_loop::size() const
+	{
+		return _registrations.size();
+	}
+
+	// Waits for messages and dispatches them
+	std::size_t event_loop::run_once(int timeout)
+	{
+		if(_epoll < 0)
+			return 0;
+
+		// Do not wait while interfaces still have undrained data
+		std::array<epoll_event,_batchSize> events;
+		auto count = epoll_wait(_epoll, events.data(), events.size(), _pending.empty() ? timeout : 0);
+
+		// Collect the interfaces that received an edge
+		for(int i = 0; i < count; i++)
+		{
+			auto entry = static_cast<registration*>(events[i].data.ptr);
+			if(!entry->pending)
+			{
+				entry->pending = true;
+				_pending.push_back(entry);
+			}
+		}
+
+		// Drain each ready interface once, keeping those with remaining data for the next round
+		std::size_t dispatched = 0;
+		_ready.swap(_pending);
+		_pending.clear();
+		for(auto entry : _ready)
+		{
+			dispatched += Drain(*entry);
+			if(entry->pending)
+				_pending.push_back(entry);
+		}
+
+		return dispatched;
+	}
+
+	// Dispatches until stopped
+	void event_loop::run()
+	{
+		_running = true;
+		while(_running.load(std::memory_order_relaxed))
+			run_once(100);
+	}
+
+	// Requests run to return
+	void event_loop::stop()
+	{
+		_running = false;
+	}
+}
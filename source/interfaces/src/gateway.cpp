@@ -0,0 +1,270 @@
+///////////////////////////////////////////////////////////////////////
+// Gateway
+//
+// Forwards messages from an input interface to an output interface,
+// with per-ID routing and rewrite rules.
+///////////////////////////////////////////////////////////////////////
+#include <interfaces/include/gateway.h>
+
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+	bool is_extended(canid_t id)
+	{
+		return (id & CAN_EFF_FLAG) != 0 || (id & CAN_EFF_MASK) > CAN_SFF_MASK;
+	}
+
+	// Parses a CAN ID in decimal, or hexadecimal with a 0x prefix
+	bool parse_id(const std::string& text, canid_t& id)
+	{
+		if(text.empty())
+			return false;
+
+		char* end = nullptr;
+		auto value = std::strtoul(text.c_str(), &end, 0);
+		if(*end != '\0' || value > CAN_EFF_MASK)
+			return false;
+
+		id = static_cast<canid_t>(value);
+		return true;
+	}
+}
+
+namespace can::interfaces
+{
+	// Constructor
+	gateway::gateway(ICANInterface& input, ICANInterface& output, int stopLatency) :
+		_input(input),
+		_output(output),
+		_stopLatency(stopLatency),
+		_running(false),
+		_default(),
+		_standard(),
+		_extended(),
+		_batch(),
+		_received(0),
+		_forwarded(0),
+		_dropped(0),
+		_failed(0)
+	{
+	}
+
+	// --------------------------------------------------------------------
+	// Private methods
+	// --------------------------------------------------------------------
+	// Returns the rule for an ID, creating it when needed
+	gateway::route& gateway::GetRoute(canid_t id)
+	{
+		if(!is_extended(id))
+			return _standard[id & CAN_SFF_MASK];
+
+		return _extended[id & CAN_EFF_MASK];
+	}
+
+	// Looks up the route of a received ID
+	const gateway::route& gateway::FindRoute(canid_t id) const
+	{
+		if((id & CAN_EFF_FLAG) == 0)
+			return _standard[id & CAN_SFF_MASK];
+
+		auto rule = _extended.find(id & CAN_EFF_MASK);
+		return (rule != _extended.end()) ? rule->second : _default;
+	}
+
+	// --------------------------------------------------------------------
+	// Routing rules
+	// --------------------------------------------------------------------
+	// Forwards messages with the ID unchanged
+	void gateway::forward(canid_t id)
+	{
+		GetRoute(id) = route{ true, false, 0, true };
+	}
+
+	// Drops messages with the ID
+	void gateway::drop(canid_t id)
+	{
+		GetRoute(id) = route{ false, false, 0, true };
+	}
+
+	// Forwards messages with the ID as another ID
+	void gateway::rewrite(canid_t id, canid_t newId)
+	{
+		newId &= CAN_EFF_FLAG | CAN_EFF_MASK;
+		if(is_extended(newId))
+			newId |= CAN_EFF_FLAG;
+		GetRoute(id) = route{ true, true, newId, true };
+	}
+
+	// Sets the route of IDs without a rule - standard IDs with a rule keep it
+	void gateway::set_default(bool forward)
+	{
+		for(auto& rule : _standard)
+			if(!rule.assigned)
+				rule.forward = forward;
+		_default.forward = forward;
+	}
+
+	// Removes all rules, and forwards everything
+	void gateway::clear_rules()
+	{
+		_default = route();
+		_standard.fill(route());
+		_extended.clear();
+	}
+
+	// Parses a comma-separated list of rules - no rules are changed unless all are valid
+	bool gateway::parse_rules(const std::string& rules)
+	{
+		struct parsed_rule
+		{
+			bool isDefault;
+			canid_t id;
+			route action;
+		};
+		std::vector<parsed_rule> parsed;
+
+		std::size_t begin = 0;
+		while(begin < rules.size())
+		{
+			auto end = rules.find(',', begin);
+			if(end == std::string::npos)
+				end = rules.size();
+
+			auto rule = rules.substr(begin, end - begin);
+			auto separator = rule.find('=');
+			if(separator == std::string::npos)
+				return false;
+
+			auto key = rule.substr(0, separator);
+			auto action = rule.substr(separator + 1);
+
+			parsed_rule entry{ key == "*", 0, route() };
+			if(!entry.isDefault && !parse_id(key, entry.id))
+				return false;
+
+			if(action == "drop")
+				entry.action.forward = false;
+			else if(action != "pass")
+			{
+				if(entry.isDefault || !parse_id(action, entry.action.id))
+					return false;
+				entry.action.rewrite = true;
+			}
+
+			parsed.push_back(entry);
+			begin = end + 1;
+		}
+
+		// Apply the default route first, so it does not override the rules
+		for(const auto& entry : parsed)
+			if(entry.isDefault)
+				set_default(entry.action.forward);
+		for(const auto& entry : parsed)
+		{
+			if(entry.isDefault)
+				continue;
+			if(entry.action.rewrite)
+				rewrite(entry.id, entry.action.id);
+			else if(entry.action.forward)
+				forward(entry.id);
+			else
+				drop(entry.id);
+		}
+
+		return true;
+	}
+
+	// --------------------------------------------------------------------
+	// Forwarding
+	// --------------------------------------------------------------------
+	// Forwards one batch of messages, compacting the routed messages in place
+	std::size_t gateway::forward_once()
+	{
+		auto received = _input.RequestMessages(_batch.data(), _batch.size());
+		if(received == 0)
+			return 0;
+
+		std::size_t count = 0;
+		for(std::size_t i = 0; i < received; i++)
+		{
+			auto& message = _batch[i];
+			auto id = message.id();
+			if((id & CAN_ERR_FLAG) != 0)
+				continue;
+
+			const auto& rule = FindRoute(id);
+			if(!rule.forward)
+				continue;
+
+			if(rule.rewrite)
+				message.set_id(rule.id | (id & CAN_RTR_FLAG));
+			if(count != i)
+				_batch[count] = message;
+			count++;
+		}
+
+		auto sent = (count > 0) ? _output.SendMessages(_batch.data(), count) : 0;
+
+		_received.fetch_add(received, std::memory_order_relaxed);
+		_forwarded.fetch_add(sent, std::memory_order_relaxed);
+		_dropped.fetch_add(received - sent, std::memory_order_relaxed);
+		_failed.fetch_add(count - sent, std::memory_order_relaxed);
+		return received;
+	}
+
+	// Forwards until a request returns no messages
+	uint64_t gateway::forward_all()
+	{
+		uint64_t total = 0;
+		while(auto received = forward_once())
+			total += received;
+		return total;
+	}
+
+	// Forwards until stopped - the input is switched to non-blocking mode, so stop requests are noticed
+	void gateway::run()
+	{
+		_input.SetTimeout(_stopLatency);
+		_input.SetBlockingMode(false);
+
+		_running.store(true, std::memory_order_relaxed);
+		while(_running.load(std::memory_order_relaxed))
+			forward_once();
+	}
+
+	// Requests run to return - safe to call from a signal handler
+	void gateway::stop()
+	{
+		_running.store(false, std::memory_order_relaxed);
+	}
+
+	bool gateway::running() const
+	{
+		return _running.load(std::memory_order_relaxed);
+	}
+
+	// --------------------------------------------------------------------
+	// Counters
+	// --------------------------------------------------------------------
+	uint64_t gateway::received() const
+	{
+		return _received.load(std::memory_order_relaxed);
+	}
+
+	uint64_t gateway::forwarded() const
+	{
+		return _forwarded.load(std::memory_order_relaxed);
+	}
+
+	uint64_t gateway::dropped() const
+	{
+		return _dropped.load(std::memory_order_relaxed);
+	}
+
+	uint64_t gateway::failed() const
+	{
+		return _failed.load(std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,234 @@
+///////////////////////////////////////////////////////////////////////
+// Interface statistics implementation
+///////////////////////////////////////////////////////////////////////
+#include <interfaces/include/interface_statistics.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
+
+namespace
+{
+	int64_t monotonic_time()
+	{
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+	}
+
+	// Upper bounds of the Prometheus latency buckets, in seconds
+	constexpr double prometheus_bounds[] = { 1e-6, 2.5e-6, 5e-6, 1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4, 1e-3, 2.5e-3, 5e-3, 1e-2, 2.5e-2, 5e-2, 0.1, 0.25, 0.5, 1.0 };
+
+	struct metric
+	{
+		const char* name;
+		const char* help;
+		uint64_t can::interfaces::interface_counters::* counter;
+	};
+
+	constexpr metric prometheus_metrics[] = {
+		{ "cantools_frames_received_total", "Frames received", &can::interfaces::interface_counters::frames_received },
+		{ "cantools_bytes_received_total", "Data bytes received", &can::interfaces::interface_counters::bytes_received },
+		{ "cantools_receive_calls_total", "System calls reading frames", &can::interfaces::interface_counters::receive_calls },
+		{ "cantools_poll_timeouts_total", "Requests without frames within the timeout", &can::interfaces::interface_counters::poll_timeouts },
+		{ "cantools_short_reads_total", "Frames of unexpected size", &can::interfaces::interface_counters::short_reads },
+		{ "cantools_receive_errors_total", "Failed reads", &can::interfaces::interface_counters::receive_errors },
+		{ "cantools_overflow_drops_total", "Frames dropped by the kernel", &can::interfaces::interface_counters::overflow_drops },
+		{ "cantools_frames_sent_total", "Frames sent", &can::interfaces::interface_counters::frames_sent },
+		{ "cantools_bytes_sent_total", "Data bytes sent", &can::interfaces::interface_counters::bytes_sent },
+		{ "cantools_send_calls_total", "System calls writing frames", &can::interfaces::interface_counters::send_calls },
+		{ "cantools_send_retries_total", "Waits for a full transmit queue", &can::interfaces::interface_counters::send_retries },
+		{ "cantools_write_failures_total", "Requests not sent completely", &can::interfaces::interface_counters::write_failures },
+	};
+
+	void append(std::string& text, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+	void append(std::string& text, const char* format, ...)
+	{
+		char buffer[256];
+		va_list arguments;
+		va_start(arguments, format);
+		auto length = std::vsnprintf(buffer, sizeof(buffer), format, arguments);
+		va_end(arguments);
+		if(length > 0)
+			text.append(buffer, std::min<std::size_t>(static_cast<std::size_t>(length), sizeof(buffer) - 1));
+	}
+}
+
+namespace can::interfaces
+{
+	// --------------------------------------------------------------------
+	// Latency histogram
+	// --------------------------------------------------------------------
+	// Copies the bucket counts
+	void latency_histogram::copy_buckets(bucket_array& buckets) const
+	{
+		for(std::size_t i = 0; i < bucket_count; i++)
+			buckets[i] = _buckets[i].value();
+	}
+
+	// Returns a percentile of all values recorded
+	uint64_t latency_histogram::percentile(double percent) const
+	{
+		bucket_array buckets;
+		copy_buckets(buckets);
+		return percentile(buckets, percent);
+	}
+
+	// Returns the largest value of the bucket holding a percentile - 0 if nothing was counted
+	uint64_t latency_histogram::percentile(const bucket_array& buckets, double percent)
+	{
+		uint64_t total = 0;
+		for(auto count : buckets)
+			total += count;
+		if(total == 0)
+			return 0;
+
+		auto target = static_cast<uint64_t>(std::ceil(total * std::min(std::max(percent, 0.0), 100.0) / 100.0));
+		target = std::max<uint64_t>(target, 1);
+
+		uint64_t seen = 0;
+		for(std::size_t i = 0; i < bucket_count; i++)
+		{
+			seen += buckets[i];
+			if(seen >= target)
+				return bucket_upper(i);
+		}
+		return bucket_upper(bucket_count - 1);
+	}
+
+	// --------------------------------------------------------------------
+	// Interface statistics
+	// --------------------------------------------------------------------
+	// Counts received frames - the latency is measured once for all of them
+	void interface_statistics::record_received(const can::Message* messages, std::size_t count)
+	{
+		if(count == 0)
+			return;
+
+		timespec now;
+		clock_gettime(CLOCK_REALTIME, &now);
+		auto time = static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+
+		uint64_t bytes = 0;
+		for(std::size_t i = 0; i < count; i++)
+		{
+			bytes += messages[i].size();
+			const auto& timestamp = messages[i].get_timestamp();
+			auto latency = time - (static_cast<int64_t>(timestamp.tv_sec) * 1000000000 + timestamp.tv_nsec);
+			receive_latency.record(static_cast<uint64_t>(std::max<int64_t>(latency, 0)));
+		}
+
+		frames_received.add(count);
+		bytes_received.add(bytes);
+	}
+
+	// Returns a copy of the counters
+	interface_counters interface_statistics::counters() const
+	{
+		interface_counters result;
+		result.frames_received = frames_received.value();
+		result.bytes_received = bytes_received.value();
+		result.receive_calls = receive_calls.value();
+		result.poll_timeouts = poll_timeouts.value();
+		result.short_reads = short_reads.value();
+		result.receive_errors = receive_errors.value();
+		result.overflow_drops = overflow_drops.value();
+		result.frames_sent = frames_sent.value();
+		result.bytes_sent = bytes_sent.value();
+		result.send_calls = send_calls.value();
+		result.send_retries = send_retries.value();
+		result.write_failures = write_failures.value();
+		return result;
+	}
+
+	// Returns the counters and latency buckets at the current time
+	statistics_sample interface_statistics::sample() const
+	{
+		statistics_sample result;
+		result.time = monotonic_time();
+		result.counters = counters();
+		receive_latency.copy_buckets(result.latency);
+		result.latency_count = receive_latency.count();
+		result.latency_sum = receive_latency.sum();
+		return result;
+	}
+
+	// --------------------------------------------------------------------
+	// Formatting
+	// --------------------------------------------------------------------
+	// Formats the rates between two samples, and the latency percentiles of the frames received between them
+	std::string format_statistics_line(const std::string& name, const statistics_sample& current, const statistics_sample& previous)
+	{
+		auto seconds = (current.time - previous.time) / 1e9;
+		if(seconds <= 0)
+			seconds = 1;
+
+		const auto& c = current.counters;
+		const auto& p = previous.counters;
+		auto rate = [seconds](uint64_t now, uint64_t before) { return (now - before) / seconds; };
+
+		latency_histogram::bucket_array latency;
+		for(std::size_t i = 0; i < latency.size(); i++)
+			latency[i] = current.latency[i] - previous.latency[i];
+
+		std::string line = name + ":";
+		append(line, " rx %.0f fr/s %.1f kB/s, tx %.0f fr/s %.1f kB/s",
+			rate(c.frames_received, p.frames_received), rate(c.bytes_received, p.bytes_received) / 1000.0,
+			rate(c.frames_sent, p.frames_sent), rate(c.bytes_sent, p.bytes_sent) / 1000.0);
+		append(line, ", timeouts %llu, short %llu, errors %llu/%llu, drops %llu, retries %llu",
+			static_cast<unsigned long long>(c.poll_timeouts - p.poll_timeouts),
+			static_cast<unsigned long long>(c.short_reads - p.short_reads),
+			static_cast<unsigned long long>(c.receive_errors - p.receive_errors),
+			static_cast<unsigned long long>(c.write_failures - p.write_failures),
+			static_cast<unsigned long long>(c.overflow_drops - p.overflow_drops),
+			static_cast<unsigned long long>(c.send_retries - p.send_retries));
+
+		if(current.latency_count > previous.latency_count)
+			append(line, ", latency us p50 %.1f p99 %.1f p99.9 %.1f max %.1f",
+				latency_histogram::percentile(latency, 50) / 1000.0,
+				latency_histogram::percentile(latency, 99) / 1000.0,
+				latency_histogram::percentile(latency, 99.9) / 1000.0,
+				latency_histogram::percentile(latency, 100) / 1000.0);
+
+		return line;
+	}
+
+	// Formats counters and latency histograms in the Prometheus text format
+	std::string format_prometheus(const std::vector<std::pair<std::string,statistics_sample>>& samples)
+	{
+		std::string text;
+		for(const auto& m : prometheus_metrics)
+		{
+			append(text, "# HELP %s %s\n# TYPE %s counter\n", m.name, m.help, m.name);
+			for(const auto& [name, sample] : samples)
+				append(text, "%s{interface=\"%s\"} %llu\n", m.name, name.c_str(), static_cast<unsigned long long>(sample.counters.*m.counter));
+		}
+
+		const char* histogram = "cantools_receive_latency_seconds";
+		append(text, "# HELP %s Time from the kernel receive timestamp to handing out the frame\n# TYPE %s histogram\n", histogram, histogram);
+		for(const auto& [name, sample] : samples)
+		{
+			// Buckets are counted below a bound if all their values are
+			std::size_t bucket = 0;
+			uint64_t cumulative = 0;
+			for(auto bound : prometheus_bounds)
+			{
+				while(bucket < latency_histogram::bucket_count && latency_histogram::bucket_upper(bucket) <= static_cast<uint64_t>(bound * 1e9))
+					cumulative += sample.latency[bucket++];
+				append(text, "%s_bucket{interface=\"%s\",le=\"%g\"} %llu\n", histogram, name.c_str(), bound, static_cast<unsigned long long>(cumulative));
+			}
+
+			// The total is taken from the same bucket copy, as the separate count may be read while a value is being added
+			while(bucket < latency_histogram::bucket_count)
+				cumulative += sample.latency[bucket++];
+			append(text, "%s_bucket{interface=\"%s\",le=\"+Inf\"} %llu\n", histogram, name.c_str(), static_cast<unsigned long long>(cumulative));
+			append(text, "%s_sum{interface=\"%s\"} %.9f\n", histogram, name.c_str(), sample.latency_sum / 1e9);
+			append(text, "%s_count{interface=\"%s\"} %llu\n", histogram, name.c_str(), static_cast<unsigned long long>(cumulative));
+		}
+
+		return text;
+	}
+}
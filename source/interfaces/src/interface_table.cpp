@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////
+// Interface table implementation
+//
+// Translates between interface indices, as stored in can::Message,
+// and interface names. Kernel interfaces are looked up once and then
+// cached, so the receive path only ever handles the integer index.
+// Names unknown to the kernel (e.g. from log files) are assigned
+// synthetic indices.
+///////////////////////////////////////////////////////////////////////
+#include <interfaces/include/interface_table.h>
+
+#include <map>
+#include <mutex>
+#include <net/if.h>
+
+namespace
+{
+	// Cache shared by all users of the interface table
+	struct table_cache
+	{
+		std::mutex mutex;
+		std::map<int,std::string> names;
+		std::map<std::string,int> indices;
+		int nextSyntheticIndex = can::interfaces::interface_table::synthetic_index_base;
+
+		void add(int index, const std::string& name)
+		{
+			names[index] = name;
+			indices[name] = index;
+		}
+	};
+
+	table_cache& cache()
+	{
+		static table_cache instance;
+		return instance;
+	}
+}
+
+namespace can::interfaces
+{
+	// Returns the name of an interface index - index 0 means "any"
+	std::string interface_table::name(int index)
+	{
+		if(index == 0)
+			return "any";
+
+		auto& c = cache();
+		std::lock_guard<std::mutex> lock(c.mutex);
+
+		auto entry = c.names.find(index);
+		if(entry != c.names.end())
+			return entry->second;
+
+		// Synthetic indices are only known through the cache
+		char name[IF_NAMESIZE];
+		if(index >= synthetic_index_base || if_indextoname(static_cast<unsigned int>(index), name) == nullptr)
+			return "unknown";
+
+		c.add(index, name);
+		return name;
+	}
+
+	// Returns the index of an interface name, assigning a synthetic index if the kernel does not know it
+	int interface_table::index(const std::string& name)
+	{
+		if(name.compare("any") == 0)
+			return 0;
+
+		auto& c = cache();
+		std::lock_guard<std::mutex> lock(c.mutex);
+
+		auto entry = c.indices.find(name);
+		if(entry != c.indices.end())
+			return entry->second;
+
+		auto index = static_cast<int>(if_nametoindex(name.c_str()));
+		if(index == 0)
+			index = c.nextSyntheticIndex++;
+
+		c.add(index, name);
+		return index;
+	}
+}
@@ -0,0 +1,473 @@
+///////////////////////////////////////////////////////////////////////
+// Simulated bus implementation
+///////////////////////////////////////////////////////////////////////
+#include <interfaces/include/simulated_bus.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <ctime>
+#include <deque>
+#include <map>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <can/include/timestamp.h>
+#include <interfaces/include/interface_table.h>
+
+namespace
+{
+	int64_t clock_time(clockid_t clock)
+	{
+		timespec now;
+		clock_gettime(clock, &now);
+		return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+	}
+
+	// Order of arbitration - the dominant (lower) value wins, bit by bit as on the bus
+	uint64_t arbitration_key(const can_frame& frame)
+	{
+		uint64_t rtr = (frame.can_id & CAN_RTR_FLAG) ? 1 : 0;
+		if(frame.can_id & CAN_EFF_FLAG)
+		{
+			// Base identifier, SRR (recessive), IDE (recessive), identifier extension, RTR
+			uint64_t id = frame.can_id & CAN_EFF_MASK;
+			return ((id >> 18) << 21) | (uint64_t{1} << 20) | (uint64_t{1} << 19) | ((id & 0x3FFFF) << 1) | rtr;
+		}
+
+		// Identifier, RTR, IDE (dominant)
+		return ((frame.can_id & CAN_SFF_MASK) << 21) | (rtr << 20);
+	}
+
+	// A stuff bit of the opposite value follows every five equal bits, and counts towards the next run
+	unsigned int stuff_bits(const uint8_t* bits, std::size_t size)
+	{
+		unsigned int stuffed = 0;
+		unsigned int run = 1;
+		auto last = bits[0];
+		for(std::size_t i = 1; i < size; i++)
+		{
+			if(bits[i] == last)
+			{
+				run++;
+			}
+			else
+			{
+				last = bits[i];
+				run = 1;
+			}
+
+			if(run == 5)
+			{
+				stuffed++;
+				last = !last;
+				run = 1;
+			}
+		}
+		return stuffed;
+	}
+
+	// Wakes a receiver waiting for frames
+	void signal(can::interfaces::simulated_bus::endpoint& e)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(e.armed.load(std::memory_order_relaxed) && e.armed.exchange(false))
+		{
+			uint64_t one = 1;
+			auto written = write(e.event, &one, sizeof(one));
+			(void)written;
+		}
+	}
+
+	// The generation of an endpoint's connection, and the number of its frames waiting for the bus
+	constexpr uint64_t transmit_count_mask = 0xFFFFFFFF;
+
+	uint32_t generation(const can::interfaces::simulated_bus::endpoint& e)
+	{
+		return static_cast<uint32_t>(e.transmitting.load(std::memory_order_relaxed) >> 32);
+	}
+
+	// Returns room in the transmit queue - frames of an earlier connection of the endpoint no longer count
+	void release(can::interfaces::simulated_bus::endpoint& e, uint32_t generation, std::size_t count)
+	{
+		auto state = e.transmitting.load(std::memory_order_relaxed);
+		while((state >> 32) == generation && !e.transmitting.compare_exchange_weak(state, state - count, std::memory_order_relaxed))
+			;
+	}
+
+	// Buses by name - a bus lives as long as an interface is connected to it
+	std::mutex registry_mutex;
+	std::map<std::string,std::weak_ptr<can::interfaces::simulated_bus>> registry;
+}
+
+namespace can::interfaces
+{
+	// --------------------------------------------------------------------
+	// Constructors / destructor
+	// --------------------------------------------------------------------
+	simulated_bus::simulated_bus(const std::string& name, uint32_t bitrate) :
+		_name(name),
+		_index(interface_table::index(name)),
+		_bitrate(bitrate),
+		_endpointMutex(),
+		_storage(),
+		_endpoints(),
+		_endpointCount(0),
+		_pending(),
+		_thread(),
+		_wakeMutex(),
+		_wake(),
+		_idle(false),
+		_running(bitrate > 0),
+		_frames(0),
+		_bits(0)
+	{
+		for(auto& e : _endpoints)
+			e.store(nullptr, std::memory_order_relaxed);
+
+		if(_bitrate > 0)
+			_thread = std::thread(&simulated_bus::Run, this);
+	}
+
+	simulated_bus::~simulated_bus()
+	{
+		if(_thread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(_wakeMutex);
+				_running = false;
+			}
+			_wake.notify_all();
+			_thread.join();
+		}
+
+		for(auto& e : _storage)
+			if(e && e->event >= 0)
+				close(e->event);
+	}
+
+	// --------------------------------------------------------------------
+	// Static methods
+	// --------------------------------------------------------------------
+	// Returns the bus of a name, creating it if needed
+	std::shared_ptr<simulated_bus> simulated_bus::open(const std::string& name, uint32_t bitrate)
+	{
+		std::lock_guard<std::mutex> lock(registry_mutex);
+
+		auto bus = registry[name].lock();
+		if(bus)
+			return (bitrate == 0 || bitrate == bus->bitrate()) ? bus : nullptr;
+
+		bus = std::make_shared<simulated_bus>(name, bitrate);
+		registry[name] = bus;
+		return bus;
+	}
+
+	// Counts the bits of a frame - SOF to CRC are stuffed, followed by 13 fixed bits (delimiters, ACK, EOF and IFS)
+	unsigned int simulated_bus::frame_bits(const can_frame& frame)
+	{
+		std::array<uint8_t,160> bits{};
+		std::size_t size = 0;
+		auto append = [&](uint32_t value, unsigned int count)
+		{
+			for(unsigned int i = count; i > 0; i--)
+				bits[size++] = (value >> (i - 1)) & 1;
+		};
+
+		auto rtr = (frame.can_id & CAN_RTR_FLAG) ? 1u : 0u;
+		auto length = std::min<unsigned int>(frame.len, CAN_MAX_DLEN);
+		append(0, 1);	// SOF
+		if(frame.can_id & CAN_EFF_FLAG)
+		{
+			auto id = frame.can_id & CAN_EFF_MASK;
+			append(id >> 18, 11);
+			append(0b11, 2);	// SRR, IDE
+			append(id & 0x3FFFF, 18);
+			append(rtr, 1);
+			append(0, 2);	// r1, r0
+		}
+		else
+		{
+			append(frame.can_id & CAN_SFF_MASK, 11);
+			append(rtr, 1);
+			append(0, 2);	// IDE, r0
+		}
+		append(length, 4);
+		if(!rtr)
+			for(unsigned int i = 0; i < length; i++)
+				append(frame.data[i], 8);
+
+		// CRC-15
+		uint32_t crc = 0;
+		for(std::size_t i = 0; i < size; i++)
+		{
+			auto next = bits[i] ^ ((crc >> 14) & 1);
+			crc = (crc << 1) & 0x7FFF;
+			if(next)
+				crc ^= 0x4599;
+		}
+		append(crc, 15);
+
+		return static_cast<unsigned int>(size) + stuff_bits(bits.data(), size) + 13;
+	}
+
+	// Counts the bits of a CAN FD frame - SOF to the data are stuffed, followed by the stuff count and CRC with fixed stuff bits
+	unsigned int simulated_bus::frame_bits(const canfd_frame& frame)
+	{
+		std::array<uint8_t,48 + 8*CANFD_MAX_DLEN> bits{};
+		std::size_t size = 0;
+		auto append = [&](uint32_t value, unsigned int count)
+		{
+			for(unsigned int i = count; i > 0; i--)
+				bits[size++] = (value >> (i - 1)) & 1;
+		};
+
+		auto length = can::fd_length(std::min<unsigned int>(frame.len, CANFD_MAX_DLEN));
+		auto dlc = (length <= 8) ? length : (length <= 24) ? 6 + length/4 : (length == 32) ? 13 : (length == 48) ? 14 : 15;
+		append(0, 1);	// SOF
+		if(frame.can_id & CAN_EFF_FLAG)
+		{
+			auto id = frame.can_id & CAN_EFF_MASK;
+			append(id >> 18, 11);
+			append(0b11, 2);	// SRR, IDE
+			append(id & 0x3FFFF, 18);
+			append(0, 1);	// RRS
+		}
+		else
+		{
+			append(frame.can_id & CAN_SFF_MASK, 11);
+			append(0, 2);	// RRS, IDE
+		}
+		append(0b10, 2);	// FDF, res
+		append((frame.flags & CANFD_BRS) ? 1 : 0, 1);
+		append((frame.flags & CANFD_ESI) ? 1 : 0, 1);
+		append(dlc, 4);
+		for(unsigned int i = 0; i < length; i++)
+			append(frame.data[i], 8);
+
+		// Stuff count (4 bits) and CRC-17 or CRC-21, with a fixed stuff bit before every 4 bits
+		auto crc = (length > 16) ? 21u : 17u;
+		return static_cast<unsigned int>(size) + stuff_bits(bits.data(), size) + 4 + crc + (4 + crc + 3) / 4 + 13;
+	}
+
+	// --------------------------------------------------------------------
+	// Endpoints
+	// --------------------------------------------------------------------
+	// Connects an endpoint, reusing the storage of disconnected endpoints
+	simulated_bus::endpoint* simulated_bus::attach()
+	{
+		std::lock_guard<std::mutex> lock(_endpointMutex);
+
+		for(std::size_t i = 0; i < max_endpoints; i++)
+		{
+			auto& e = _storage[i];
+			if(e && e->active.load(std::memory_order_relaxed))
+				continue;
+
+			if(!e)
+			{
+				e = std::make_unique<endpoint>();
+				e->event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			}
+			else
+			{
+				// Forget frames queued for the previous connection - a new generation drops its transmit queue
+				can::Message discarded;
+				while(e->queue.pop(discarded))
+					;
+				e->transmitting.store((uint64_t{ generation(*e) } + 1) << 32, std::memory_order_relaxed);
+				uint64_t value;
+				auto cleared = read(e->event, &value, sizeof(value));
+				(void)cleared;
+			}
+
+			e->slot = i;
+			e->armed = false;
+			e->active = true;
+			_endpoints[i].store(e.get(), std::memory_order_release);
+			if(_endpointCount.load(std::memory_order_relaxed) <= i)
+				_endpointCount.store(i + 1, std::memory_order_release);
+			return e.get();
+		}
+
+		return nullptr;
+	}
+
+	// Disconnects an endpoint - frames already queued for transmission are still sent, unless the endpoint is reused
+	void simulated_bus::detach(endpoint* e)
+	{
+		if(e == nullptr)
+			return;
+
+		std::lock_guard<std::mutex> lock(_endpointMutex);
+		_endpoints[e->slot].store(nullptr, std::memory_order_release);
+		e->active = false;
+	}
+
+	// --------------------------------------------------------------------
+	// Transmission
+	// --------------------------------------------------------------------
+	// Sends frames, directly without a bitrate, and through the bus thread otherwise
+	std::size_t simulated_bus::transmit(const endpoint& sender, const can::Message* messages, std::size_t count)
+	{
+		if(_bitrate == 0)
+		{
+			_frames.fetch_add(count, std::memory_order_relaxed);
+			Deliver(messages, count, sender.slot, can::to_timespec(clock_time(CLOCK_REALTIME)));
+			return count;
+		}
+
+		// Reserve room in the transmit queue of the sender - a full queue pushes back on the sender
+		auto& e = *_storage[sender.slot];
+		auto state = e.transmitting.load(std::memory_order_relaxed);
+		std::size_t reserved = 0;
+		do
+			reserved = std::min<uint64_t>(count, transmit_queue_size - std::min<uint64_t>(state & transmit_count_mask, transmit_queue_size));
+		while(reserved > 0 && !e.transmitting.compare_exchange_weak(state, state + reserved, std::memory_order_relaxed));
+
+		auto connection = static_cast<uint32_t>(state >> 32);
+		auto arrival = clock_time(CLOCK_MONOTONIC);
+		std::size_t accepted = 0;
+		while(accepted < reserved && _pending.push(pending{ messages[accepted], arrival, sender.slot, connection }))
+			accepted++;
+		if(accepted < reserved)
+			release(e, connection, reserved - accepted);
+
+		// Wake the bus thread if it waits for frames
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(accepted > 0 && _idle.load(std::memory_order_relaxed))
+		{
+			{
+				std::lock_guard<std::mutex> lock(_wakeMutex);
+				_idle = false;
+			}
+			_wake.notify_one();
+		}
+
+		return accepted;
+	}
+
+	// --------------------------------------------------------------------
+	// Properties
+	// --------------------------------------------------------------------
+	const std::string& simulated_bus::name() const
+	{
+		return _name;
+	}
+
+	int simulated_bus::index() const
+	{
+		return _index;
+	}
+
+	uint32_t simulated_bus::bitrate() const
+	{
+		return _bitrate;
+	}
+
+	uint64_t simulated_bus::frames() const
+	{
+		return _frames.load(std::memory_order_relaxed);
+	}
+
+	uint64_t simulated_bus::bits() const
+	{
+		return _bits.load(std::memory_order_relaxed);
+	}
+
+	// --------------------------------------------------------------------
+	// Private methods
+	// --------------------------------------------------------------------
+	// Queues frames at every endpoint but the sender, as received on the bus at a time
+	void simulated_bus::Deliver(const can::Message* messages, std::size_t count, std::size_t sender, const timespec& timestamp)
+	{
+		auto endpoints = _endpointCount.load(std::memory_order_acquire);
+		for(std::size_t i = 0; i < endpoints; i++)
+		{
+			auto e = _endpoints[i].load(std::memory_order_acquire);
+			if(e == nullptr || i == sender)
+				continue;
+
+			for(std::size_t j = 0; j < count; j++)
+			{
+				auto message = messages[j];
+				message.get_timestamp() = timestamp;
+				message.set_interface(_index);
+				e->queue.push(message);
+			}
+			signal(*e);
+		}
+	}
+
+	// Bus thread - arbitrates between the endpoints and delivers frames at the end of their transmission
+	void simulated_bus::Run()
+	{
+		std::array<std::deque<pending>,max_endpoints> queues;	// Frames waiting per endpoint, in the order sent
+		auto offset = clock_time(CLOCK_REALTIME) - clock_time(CLOCK_MONOTONIC);
+		int64_t idleFrom = 0;	// Bus time at which the bus becomes idle
+
+		while(_running.load(std::memory_order_relaxed))
+		{
+			pending p;
+			while(_pending.pop(p))
+				queues[p.sender].push_back(p);
+
+			// The bus becomes busy at the earliest arrival after it became idle - frames of a previous connection of a reused endpoint are dropped
+			int64_t earliest = INT64_MAX;
+			for(std::size_t i = 0; i < max_endpoints; i++)
+			{
+				auto& q = queues[i];
+				while(!q.empty() && q.front().generation != generation(*_storage[i]))
+					q.pop_front();
+				if(!q.empty())
+					earliest = std::min(earliest, q.front().arrival);
+			}
+
+			if(earliest == INT64_MAX)
+			{
+				_idle = true;
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if(!_pending.empty())
+				{
+					_idle = false;
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(_wakeMutex);
+				_wake.wait(lock, [this]() { return !_idle || !_running; });
+				continue;
+			}
+
+			// All endpoints with a frame waiting at the start take part in arbitration
+			auto start = std::max(idleFrom, earliest);
+			std::size_t winner = max_endpoints;
+			uint64_t winnerKey = 0;
+			for(std::size_t i = 0; i < max_endpoints; i++)
+			{
+				if(queues[i].empty() || queues[i].front().arrival > start)
+					continue;
+
+				auto key = arbitration_key(queues[i].front().message.get_frame());
+				if(winner == max_endpoints || key < winnerKey)
+				{
+					winner = i;
+					winnerKey = key;
+				}
+			}
+
+			auto message = queues[winner].front().message;
+			release(*_storage[winner], queues[winner].front().generation, 1);
+			queues[winner].pop_front();
+
+			auto bits = message.is_fd() ? frame_bits(message.get_fd_frame()) : frame_bits(message.get_frame());
+			auto end = start + static_cast<int64_t>(bits) * 1000000000 / _bitrate;
+			timespec deadline{ static_cast<time_t>(end / 1000000000), static_cast<long>(end % 1000000000) };
+			while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+				;
+
+			_frames.fetch_add(1, std::memory_order_relaxed);
+			_bits.fetch_add(bits, std::memory_order_relaxed);
+			Deliver(&message, 1, winner, can::to_timespec(end + offset));
+			idleFrom = end;
+		}
+	}
+}
@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////
+// Statistics reporter implementation
+///////////////////////////////////////////////////////////////////////
+#include <interfaces/include/statistics_reporter.h>
+
+#include <cstdio>
+#include <fstream>
+
+namespace can::interfaces
+{
+	// --------------------------------------------------------------------
+	// Constructors / destructor
+	// --------------------------------------------------------------------
+	statistics_reporter::statistics_reporter(std::chrono::milliseconds interval) :
+		_entries(),
+		_interval(interval),
+		_output(nullptr),
+		_path(),
+		_thread(),
+		_mutex(),
+		_wake(),
+		_running(false)
+	{
+	}
+
+	statistics_reporter::~statistics_reporter()
+	{
+		stop();
+	}
+
+	// --------------------------------------------------------------------
+	// Configuration
+	// --------------------------------------------------------------------
+	// Adds an interface to report on
+	bool statistics_reporter::add(const std::string& name, const ICANInterface& interface)
+	{
+		auto statistics = interface.GetInterfaceStatistics();
+		if(statistics == nullptr || _running)
+			return false;
+
+		_entries.push_back(entry{ name, statistics, statistics->sample() });
+		return true;
+	}
+
+	// Sets the stream of the stats lines
+	void statistics_reporter::set_output(std::ostream* output)
+	{
+		_output = output;
+	}
+
+	// Sets the path of the Prometheus file
+	void statistics_reporter::set_file(const std::string& path)
+	{
+		_path = path;
+	}
+
+	// --------------------------------------------------------------------
+	// Reporting
+	// --------------------------------------------------------------------
+	// Starts reporting periodically
+	bool statistics_reporter::start()
+	{
+		if(_running || _interval.count() <= 0)
+			return false;
+
+		_running = true;
+		_thread = std::thread(&statistics_reporter::Run, this);
+		return true;
+	}
+
+	// Stops reporting
+	void statistics_reporter::stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if(!_running)
+				return;
+			_running = false;
+		}
+
+		_wake.notify_all();
+		_thread.join();
+		report();
+	}
+
+	// Writes the stats lines and the Prometheus file
+	bool statistics_reporter::report()
+	{
+		std::vector<std::pair<std::string,statistics_sample>> samples;
+		for(auto& e : _entries)
+		{
+			auto current = e.statistics->sample();
+			if(_output != nullptr)
+				*_output << format_statistics_line(e.name, current, e.previous) << std::endl;
+			if(!_path.empty())
+				samples.emplace_back(e.name, current);
+			e.previous = current;
+		}
+
+		if(_path.empty())
+			return true;
+
+		// Replace the file atomically
+		auto temporary = _path + ".tmp";
+		{
+			std::ofstream file(temporary, std::ios::trunc);
+			file << format_prometheus(samples);
+			if(!file.flush())
+				return false;
+		}
+		return (std::rename(temporary.c_str(), _path.c_str()) == 0);
+	}
+
+	// --------------------------------------------------------------------
+	// Private methods
+	// --------------------------------------------------------------------
+	// Thread function
+	void statistics_reporter::Run()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		auto next = std::chrono::steady_clock::now() + _interval;
+		while(_running)
+		{
+			if(_wake.wait_until(lock, next, [this]() { return !_running; }))
+				break;
+
+			lock.unlock();
+			report();
+			lock.lock();
+			next += _interval;
+		}
+	}
+}
@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////
+// Binary log format
+//
+// Layout of the binary capture log:
+//
+//   file_header
+//   block 0: record, record, ...
+//   block 1: ...
+//   index: index_entry per block
+//   names: name_entry per interface index used in the log
+//   footer
+//
+// Records are self-delimiting (header plus payload padded to 8 bytes),
+// so a log without footer (e.g. after a crash) can still be read by
+// scanning. The index holds the time range and a bitmap of the CAN IDs
+// of each block, so seeking and filtering only touch matching blocks.
+// All values are stored in host (little-endian) byte order.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <can/include/Message.h>	// CAN FD definitions
+
+namespace can::logging::binary_log
+{
+	constexpr std::array<char,8> file_magic{{ 'C', 'A', 'N', 'T', 'L', 'O', 'G', '1' }};
+	constexpr std::array<char,8> footer_magic{{ 'C', 'A', 'N', 'T', 'I', 'D', 'X', '1' }};
+	constexpr uint32_t version = 1;
+
+	// Size of the blocks written at a time, and covered by one index entry
+	constexpr std::size_t block_size = 1 << 16;
+
+	// Number of bits in the CAN ID bitmap of an index entry
+	constexpr std::size_t id_bitmap_bits = 2048;
+
+	struct file_header
+	{
+		std::array<char,8> magic;
+		uint32_t version;
+		uint32_t header_size;
+		uint64_t reserved[2];
+	};
+
+	struct record_header
+	{
+		uint64_t timestamp;	// Nanoseconds since the epoch
+		uint32_t can_id;
+		int32_t interface;	// Interface index, translated through the name table
+		uint8_t length;		// Number of payload bytes following the header
+		uint8_t flags;		// CANFD_FDF, CANFD_BRS and CANFD_ESI of CAN FD frames, 0 for classic frames
+		uint16_t reserved1;
+		uint32_t reserved2;
+	};
+
+	struct index_entry
+	{
+		uint64_t offset;	// File offset of the first record
+		uint64_t size;		// Number of bytes in the block
+		uint64_t first_timestamp;
+		uint64_t last_timestamp;
+		uint64_t record_count;
+		std::array<uint8_t,id_bitmap_bits / 8> id_bitmap;
+	};
+
+	struct name_entry
+	{
+		int32_t interface;
+		char name[28];
+	};
+
+	struct footer
+	{
+		uint64_t index_offset;
+		uint64_t index_count;
+		uint64_t names_offset;
+		uint64_t names_count;
+		std::array<char,8> magic;
+	};
+
+	static_assert(sizeof(file_header) == 32);
+	static_assert(sizeof(record_header) == 24);
+	static_assert(sizeof(name_entry) == 32);
+	static_assert(sizeof(footer) == 40);
+
+	// Largest payload of a record
+	constexpr uint8_t max_length(uint8_t flags)
+	{
+		return (flags & CANFD_FDF) ? CANFD_MAX_DLEN : CAN_MAX_DLEN;
+	}
+
+	// Size of a record, including the padded payload
+	constexpr std::size_t record_size(uint8_t length)
+	{
+		return sizeof(record_header) + ((static_cast<std::size_t>(length) + 7) & ~static_cast<std::size_t>(7));
+	}
+
+	// Bit of a CAN ID in the bitmap - extended IDs are folded onto the 11-bit range
+	constexpr std::size_t id_bit(canid_t id)
+	{
+		if(id & CAN_EFF_FLAG)
+			id = id ^ (id >> 11) ^ (id >> 22);
+		return id & (id_bitmap_bits - 1);
+	}
+}
@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////
+// Binary log reader
+//
+// Reads a binary capture log (see binary_log.h) through a memory
+// mapping. Seeking to a timestamp and filtering by CAN ID use the
+// index, so only blocks which may contain matching records are read.
+// Logs without index (e.g. not closed properly) are indexed when
+// opened, by scanning the records once.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <can/include/Message.h>
+#include <logging/include/binary_log.h>
+
+namespace can::logging
+{
+	class binary_log_reader
+	{
+		private:
+			int _file;
+			const uint8_t* _data;
+			std::size_t _size;
+			bool _indexed;	// Whether the index was read from the footer
+			std::vector<binary_log::index_entry> _index;
+			std::vector<std::pair<int32_t,int>> _interfaces;	// Logged interface index to local interface index
+
+			// Read position
+			std::size_t _block;
+			uint64_t _position;
+			uint64_t _blockEnd;
+			uint64_t _startTime;
+
+			// Filter
+			std::vector<canid_t> _filter;
+			std::array<uint8_t,binary_log::id_bitmap_bits / 8> _filterBitmap;
+
+			bool ReadFooter();
+			void BuildIndex();
+			bool Reindex(uint64_t position);
+			bool EnterBlock(std::size_t block);
+			bool BlockMatches(const binary_log::index_entry& entry) const;
+			int TranslateInterface(int32_t interface) const;
+
+		public:
+			// Constructor / destructor
+			binary_log_reader();
+			~binary_log_reader();
+
+			// Do not allow copying
+			binary_log_reader(const binary_log_reader&) = delete;
+			binary_log_reader& operator=(const binary_log_reader&) = delete;
+
+			// Opening and closing
+			bool open(const std::string& path);
+			void close();
+			bool is_open() const;
+			bool indexed() const;
+
+			// Information from the index
+			uint64_t size() const;	// Number of records
+			uint64_t first_timestamp() const;
+			uint64_t last_timestamp() const;
+
+			// Positioning - timestamps are nanoseconds since the epoch
+			bool seek(uint64_t timestamp);	// Moves to the first record at or after the timestamp
+			void rewind();
+
+			// Filtering - only messages with one of the CAN IDs are read
+			void set_filter(std::vector<canid_t> ids);
+			void clear_filter();
+
+			// Reading
+			bool read(can::Message& message);
+			std::size_t read(can::Message* messages, std::size_t count);	// Returns the number of messages read
+	};
+}
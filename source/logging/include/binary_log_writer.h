@@ -0,0 +1,49 @@
+///////////////////////////////////////////////////////////////////////
+// Binary log writer
+//
+// Writes messages to a binary capture log (see binary_log.h). Records
+// are collected in a block buffer and written a block at a time; the
+// index and interface names are written as a footer when closing.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <can/include/Message.h>
+#include <logging/include/binary_log.h>
+
+namespace can::logging
+{
+	class binary_log_writer
+	{
+		private:
+			int _file;
+			std::vector<uint8_t> _block;
+			std::size_t _blockUsed;
+			uint64_t _offset;	// File offset of the current block
+			binary_log::index_entry _entry;	// Index entry of the current block
+			std::vector<binary_log::index_entry> _index;
+			std::vector<int> _interfaces;
+
+			bool WriteAll(const void* data, std::size_t size);
+			bool WriteFooter();
+
+		public:
+			// Constructor / destructor
+			binary_log_writer();
+			~binary_log_writer();
+
+			// Do not allow copying
+			binary_log_writer(const binary_log_writer&) = delete;
+			binary_log_writer& operator=(const binary_log_writer&) = delete;
+
+			// Public interface
+			bool open(const std::string& path);	// Creates or truncates the file
+			bool write(const can::Message& message);
+			std::size_t write(const can::Message* messages, std::size_t count);	// Returns the number of messages written
+			bool flush();	// Writes the current block
+			bool close();	// Writes the current block and the footer
+			bool is_open() const;
+	};
+}
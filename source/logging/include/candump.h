@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////
+// candump log format
+//
+// Parsing and formatting of the text format written by "candump -l"
+// and read by "canplayer", one frame per line:
+//
+//   (1436509052.249713) vcan0 123#DEADBEEF
+//   (1436509052.249714) vcan0 12345678#R
+//   (1436509052.249715) vcan0 123##1DEADBEEF
+//
+// CAN FD frames are written with "##" and a hex digit of CAN FD flags
+// (CANFD_BRS, CANFD_ESI) before the up to 64 data bytes.
+//
+// Parsing works on the text in place and does not allocate; the hex
+// payload is decoded with SSE2 where available, 16 characters at once.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <can/include/Message.h>
+
+namespace can::logging::candump
+{
+	// Maximum length of a formatted line, including the line break
+	constexpr std::size_t max_line_length = 256;
+
+	// Translates interface names in the log to interface indices and back, looking up each name only once
+	class interface_names
+	{
+		private:
+			struct entry
+			{
+				int index;
+				std::string name;
+			};
+
+			std::vector<entry> _entries;
+
+		public:
+			int index(const char* name, std::size_t length);
+			const std::string& name(int index);
+	};
+
+	// Decodes "count" bytes from 2*count hex characters - returns false on invalid characters
+	bool decode_hex(const char* text, std::size_t count, uint8_t* bytes);
+
+	// Parses a line (without line break) - returns false if the line is not a valid frame
+	bool parse_line(const char* begin, const char* end, can::Message& message, interface_names& names);
+
+	// Formats a message as a line, including the line break - returns the number of characters written
+	std::size_t format_line(const can::Message& message, interface_names& names, char* line);
+}
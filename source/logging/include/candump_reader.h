@@ -0,0 +1,45 @@
+///////////////////////////////////////////////////////////////////////
+// candump log reader
+//
+// Reads a candump text log (see candump.h) through a memory mapping,
+// parsing the lines in place. Lines which are not valid frames (e.g.
+// comments) are skipped and counted.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <string>
+
+#include <can/include/Message.h>
+#include <logging/include/candump.h>
+
+namespace can::logging
+{
+	class candump_reader
+	{
+		private:
+			int _file;
+			const char* _data;
+			std::size_t _size;
+			std::size_t _position;
+			uint64_t _skipped;
+			candump::interface_names _names;
+
+		public:
+			// Constructor / destructor
+			candump_reader();
+			~candump_reader();
+
+			// Do not allow copying
+			candump_reader(const candump_reader&) = delete;
+			candump_reader& operator=(const candump_reader&) = delete;
+
+			// Public interface
+			bool open(const std::string& path);
+			void close();
+			bool is_open() const;
+			void rewind();
+			bool read(can::Message& message);
+			std::size_t read(can::Message* messages, std::size_t count);	// Returns the number of messages read
+			uint64_t skipped() const;	// Number of lines skipped as invalid
+	};
+}
@@ -0,0 +1,45 @@
+///////////////////////////////////////////////////////////////////////
+// candump log writer
+//
+// Writes messages as a candump text log (see candump.h). Lines are
+// formatted into a block buffer, which is written a block at a time.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <can/include/Message.h>
+#include <logging/include/candump.h>
+
+namespace can::logging
+{
+	class candump_writer
+	{
+		private:
+			// Size of the blocks written at a time
+			static constexpr std::size_t _blockSize = 1 << 16;
+
+			int _file;
+			std::vector<char> _block;
+			std::size_t _blockUsed;
+			candump::interface_names _names;
+
+		public:
+			// Constructor / destructor
+			candump_writer();
+			~candump_writer();
+
+			// Do not allow copying
+			candump_writer(const candump_writer&) = delete;
+			candump_writer& operator=(const candump_writer&) = delete;
+
+			// Public interface
+			bool open(const std::string& path);	// Creates or truncates the file
+			bool write(const can::Message& message);
+			std::size_t write(const can::Message* messages, std::size_t count);	// Returns the number of messages written
+			bool flush();
+			bool close();
+			bool is_open() const;
+	};
+}
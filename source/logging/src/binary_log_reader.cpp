@@ -0,0 +1,391 @@
+///////////////////////////////////////////////////////////////////////
+// Binary log reader implementation
+//
+// Reads a binary capture log (see binary_log.h) through a memory
+// mapping. Seeking to a timestamp and filtering by CAN ID use the
+// index, so only blocks which may contain matching records are read.
+// Logs without index (e.g. not closed properly) are indexed when
+// opened, by scanning the records once.
+///////////////////////////////////////////////////////////////////////
+#include <logging/include/binary_log_reader.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <interfaces/include/interface_table.h>
+
+namespace can::logging
+{
+	// --------------------------------------------------------------------
+	// Constructors / destructor
+	// --------------------------------------------------------------------
+	binary_log_reader::binary_log_reader() :
+		_file(-1),
+		_data(nullptr),
+		_size(0),
+		_indexed(false),
+		_index(),
+		_interfaces(),
+		_block(0),
+		_position(0),
+		_blockEnd(0),
+		_startTime(0),
+		_filter(),
+		_filterBitmap{}
+	{
+	}
+
+	binary_log_reader::~binary_log_reader()
+	{
+		close();
+	}
+
+	// --------------------------------------------------------------------
+	// Private methods
+	// --------------------------------------------------------------------
+	// Reads the index and interface names from the footer - returns false if there is no valid footer
+	bool binary_log_reader::ReadFooter()
+	{
+		if(_size < sizeof(binary_log::file_header) + sizeof(binary_log::footer))
+			return false;
+
+		binary_log::footer footer;
+		std::memcpy(&footer, _data + _size - sizeof(footer), sizeof(footer));
+		if(footer.magic != binary_log::footer_magic)
+			return false;
+
+		// Validate the footer against the file size, with the counts limited first so the sizes cannot overflow
+		if(footer.index_count > _size / sizeof(binary_log::index_entry) || footer.names_count > _size / sizeof(binary_log::name_entry))
+			return false;
+
+		auto indexBytes = footer.index_count * sizeof(binary_log::index_entry);
+		auto namesBytes = footer.names_count * sizeof(binary_log::name_entry);
+		if(footer.index_offset < sizeof(binary_log::file_header)
+			|| footer.index_offset > _size
+			|| footer.index_offset + indexBytes != footer.names_offset
+			|| footer.names_offset + namesBytes + sizeof(footer) != _size)
+			return false;
+
+		_index.resize(footer.index_count);
+		std::memcpy(_index.data(), _data + footer.index_offset, indexBytes);
+
+		// Blocks must lie between the file header and the index, in file order
+		uint64_t blocksEnd = sizeof(binary_log::file_header);
+		for(const auto& entry : _index)
+		{
+			if(entry.offset < blocksEnd || entry.offset > footer.index_offset || entry.size > footer.index_offset - entry.offset)
+			{
+				_index.clear();
+				return false;
+			}
+			blocksEnd = entry.offset + entry.size;
+		}
+
+		for(uint64_t i = 0; i < footer.names_count; i++)
+		{
+			binary_log::name_entry entry;
+			std::memcpy(&entry, _data + footer.names_offset + i * sizeof(entry), sizeof(entry));
+			entry.name[sizeof(entry.name) - 1] = '\0';
+			_interfaces.emplace_back(entry.interface, can::interfaces::interface_table::index(entry.name));
+		}
+
+		return true;
+	}
+
+	// Builds the index by scanning all records, stopping at the first incomplete or invalid record
+	void binary_log_reader::BuildIndex()
+	{
+		binary_log::index_entry entry{};
+		uint64_t position = sizeof(binary_log::file_header);
+		entry.offset = position;
+
+		while(position + sizeof(binary_log::record_header) <= _size)
+		{
+			binary_log::record_header header;
+			std::memcpy(&header, _data + position, sizeof(header));
+			auto size = binary_log::record_size(header.length);
+			if(position + size > _size || header.length > binary_log::max_length(header.flags) || header.reserved1 != 0 || header.reserved2 != 0)
+				break;
+
+			// Start a new entry once a block worth of records has been scanned
+			if(position - entry.offset + size > binary_log::block_size)
+			{
+				entry.size = position - entry.offset;
+				_index.push_back(entry);
+				entry = binary_log::index_entry{};
+				entry.offset = position;
+			}
+
+			if(entry.record_count == 0)
+				entry.first_timestamp = header.timestamp;
+			entry.last_timestamp = std::max(entry.last_timestamp, header.timestamp);
+			entry.record_count++;
+			auto bit = binary_log::id_bit(header.can_id);
+			entry.id_bitmap[bit / 8] |= static_cast<uint8_t>(1 << (bit % 8));
+
+			position += size;
+		}
+
+		if(entry.record_count > 0)
+		{
+			entry.size = position - entry.offset;
+			_index.push_back(entry);
+		}
+	}
+
+	// Replaces an index read from the footer which does not match the records, continuing at "position"
+	bool binary_log_reader::Reindex(uint64_t position)
+	{
+		_indexed = false;
+		_index.clear();
+		BuildIndex();
+
+		// Scanning stops at the first invalid record, so there is no block to continue in if the record itself is invalid
+		auto block = std::partition_point(_index.begin(), _index.end(), [position](const auto& entry) { return entry.offset + entry.size <= position; });
+		auto blockIndex = static_cast<std::size_t>(block - _index.begin());
+		if(!EnterBlock(blockIndex))
+			return false;
+
+		if(_block == blockIndex)
+			_position = std::max<uint64_t>(_position, position);
+		return true;
+	}
+
+	// Checks whether a block may contain records passing the filter and the start time
+	bool binary_log_reader::BlockMatches(const binary_log::index_entry& entry) const
+	{
+		if(entry.last_timestamp < _startTime)
+			return false;
+
+		if(_filter.empty())
+			return true;
+
+		for(std::size_t i = 0; i < _filterBitmap.size(); i++)
+			if(entry.id_bitmap[i] & _filterBitmap[i])
+				return true;
+
+		return false;
+	}
+
+	// Moves to the first block from "block" which may contain matching records
+	bool binary_log_reader::EnterBlock(std::size_t block)
+	{
+		while(block < _index.size() && !BlockMatches(_index[block]))
+			block++;
+
+		_block = block;
+		if(block >= _index.size())
+		{
+			_position = _blockEnd = 0;
+			return false;
+		}
+
+		_position = _index[block].offset;
+		_blockEnd = _index[block].offset + _index[block].size;
+		return true;
+	}
+
+	// Translates an interface index from the log to the local interface index
+	int binary_log_reader::TranslateInterface(int32_t interface) const
+	{
+		for(const auto& entry : _interfaces)
+			if(entry.first == interface)
+				return entry.second;
+
+		return interface;
+	}
+
+	// --------------------------------------------------------------------
+	// Public methods
+	// --------------------------------------------------------------------
+	// Maps the log file and reads or builds its index
+	bool binary_log_reader::open(const std::string& path)
+	{
+		if(is_open())
+			return false;
+
+		_file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if(_file < 0)
+			return false;
+
+		struct stat status;
+		if(fstat(_file, &status) < 0 || static_cast<std::size_t>(status.st_size) < sizeof(binary_log::file_header))
+		{
+			close();
+			return false;
+		}
+
+		_size = static_cast<std::size_t>(status.st_size);
+		void* data = mmap(nullptr, _size, PROT_READ, MAP_SHARED, _file, 0);
+		if(data == MAP_FAILED)
+		{
+			close();
+			return false;
+		}
+		_data = static_cast<const uint8_t*>(data);
+		madvise(data, _size, MADV_SEQUENTIAL);
+
+		// Validate the file header
+		binary_log::file_header header;
+		std::memcpy(&header, _data, sizeof(header));
+		if(header.magic != binary_log::file_magic || header.version != binary_log::version || header.header_size != sizeof(header))
+		{
+			close();
+			return false;
+		}
+
+		_indexed = ReadFooter();
+		if(!_indexed)
+			BuildIndex();
+
+		rewind();
+		return true;
+	}
+
+	// Unmaps and closes the log file
+	void binary_log_reader::close()
+	{
+		if(_data != nullptr)
+			munmap(const_cast<uint8_t*>(_data), _size);
+		if(_file >= 0)
+			::close(_file);
+
+		_file = -1;
+		_data = nullptr;
+		_size = 0;
+		_indexed = false;
+		_index.clear();
+		_interfaces.clear();
+		_block = 0;
+		_position = _blockEnd = 0;
+	}
+
+	bool binary_log_reader::is_open() const
+	{
+		return (_data != nullptr);
+	}
+
+	// Whether the index was read from the log, rather than built when opening
+	bool binary_log_reader::indexed() const
+	{
+		return _indexed;
+	}
+
+	// Returns the number of records in the log
+	uint64_t binary_log_reader::size() const
+	{
+		uint64_t count = 0;
+		for(const auto& entry : _index)
+			count += entry.record_count;
+		return count;
+	}
+
+	uint64_t binary_log_reader::first_timestamp() const
+	{
+		return _index.empty() ? 0 : _index.front().first_timestamp;
+	}
+
+	uint64_t binary_log_reader::last_timestamp() const
+	{
+		return _index.empty() ? 0 : _index.back().last_timestamp;
+	}
+
+	// Moves to the first record at or after the timestamp - logs are expected to be in time order
+	bool binary_log_reader::seek(uint64_t timestamp)
+	{
+		_startTime = timestamp;
+		auto block = std::partition_point(_index.begin(), _index.end(), [timestamp](const auto& entry) { return entry.last_timestamp < timestamp; });
+		return EnterBlock(static_cast<std::size_t>(block - _index.begin()));
+	}
+
+	// Moves to the first record
+	void binary_log_reader::rewind()
+	{
+		_startTime = 0;
+		EnterBlock(0);
+	}
+
+	// Sets the CAN IDs to read - takes effect from the next block
+	void binary_log_reader::set_filter(std::vector<canid_t> ids)
+	{
+		_filter = std::move(ids);
+		_filterBitmap.fill(0);
+		for(auto id : _filter)
+		{
+			auto bit = binary_log::id_bit(id);
+			_filterBitmap[bit / 8] |= static_cast<uint8_t>(1 << (bit % 8));
+		}
+	}
+
+	void binary_log_reader::clear_filter()
+	{
+		set_filter({});
+	}
+
+	// Reads the next matching message
+	bool binary_log_reader::read(can::Message& message)
+	{
+		while(_block < _index.size())
+		{
+			// Move on to the next block once the current block is read
+			if(_position >= _blockEnd)
+			{
+				if(!EnterBlock(_block + 1))
+					return false;
+				continue;
+			}
+
+			// Records must lie within their block - a scanned index only holds complete records, so only a footer index is replaced
+			binary_log::record_header header{};
+			if(_position + sizeof(header) <= _blockEnd)
+				std::memcpy(&header, _data + _position, sizeof(header));
+			if(_position + sizeof(header) > _blockEnd
+				|| _position + binary_log::record_size(header.length) > _blockEnd
+				|| header.length > binary_log::max_length(header.flags))
+			{
+				if(!_indexed || !Reindex(_position))
+				{
+					_block = _index.size();
+					_position = _blockEnd = 0;
+					return false;
+				}
+				continue;
+			}
+
+			auto payload = _data + _position + sizeof(header);
+			_position += binary_log::record_size(header.length);
+
+			// Skip records before the start time, or not passing the filter
+			if(header.timestamp < _startTime)
+				continue;
+			if(!_filter.empty() && std::find(_filter.begin(), _filter.end(), header.can_id) == _filter.end())
+				continue;
+
+			canfd_frame& frame = message.get_fd_frame();
+			frame = canfd_frame{};
+			frame.can_id = header.can_id;
+			frame.flags = (header.flags & CANFD_FDF) ? header.flags : 0;
+			frame.len = std::min<uint8_t>(header.length, binary_log::max_length(header.flags));
+			std::memcpy(frame.data, payload, frame.len);
+			message.set_interface(TranslateInterface(header.interface));
+			message.get_timestamp().tv_sec = static_cast<time_t>(header.timestamp / 1000000000ull);
+			message.get_timestamp().tv_nsec = static_cast<long>(header.timestamp % 1000000000ull);
+			return true;
+		}
+
+		return false;
+	}
+
+	// Reads up to "count" matching messages
+	std::size_t binary_log_reader::read(can::Message* messages, std::size_t count)
+	{
+		std::size_t result = 0;
+		while(result < count && read(messages[result]))
+			result++;
+		return result;
+	}
+}
@@ -0,0 +1,209 @@
+///////////////////////////////////////////////////////////////////////
+// Binary log writer implementation
+//
+// Writes messages to a binary capture log (see binary_log.h). Records
+// are collected in a block buffer and written a block at a time; the
+// index and interface names are written as a footer when closing.
+///////////////////////////////////////////////////////////////////////
+#include <logging/include/binary_log_writer.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <interfaces/include/interface_table.h>
+
+namespace can::logging
+{
+	// --------------------------------------------------------------------
+	// Constructors / destructor
+	// --------------------------------------------------------------------
+	binary_log_writer::binary_log_writer() :
+		_file(-1),
+		_block(binary_log::block_size),
+		_blockUsed(0),
+		_offset(0),
+		_entry{},
+		_index(),
+		_interfaces()
+	{
+	}
+
+	binary_log_writer::~binary_log_writer()
+	{
+		close();
+	}
+
+	// --------------------------------------------------------------------
+	// Private methods
+	// --------------------------------------------------------------------
+	// Writes a buffer completely, retrying on partial writes
+	bool binary_log_writer::WriteAll(const void* data, std::size_t size)
+	{
+		auto bytes = static_cast<const uint8_t*>(data);
+		while(size > 0)
+		{
+			auto count = ::write(_file, bytes, size);
+			if(count < 0 && errno == EINTR)
+				continue;
+			if(count <= 0)
+				return false;
+
+			bytes += count;
+			size -= static_cast<std::size_t>(count);
+		}
+
+		return true;
+	}
+
+	// Writes the index, the interface names and the footer
+	bool binary_log_writer::WriteFooter()
+	{
+		binary_log::footer footer{};
+		footer.index_offset = _offset;
+		footer.index_count = _index.size();
+		footer.names_offset = _offset + _index.size() * sizeof(binary_log::index_entry);
+		footer.names_count = _interfaces.size();
+		footer.magic = binary_log::footer_magic;
+
+		std::vector<binary_log::name_entry> names(_interfaces.size());
+		for(std::size_t i = 0; i < _interfaces.size(); i++)
+		{
+			names[i].interface = _interfaces[i];
+			auto name = can::interfaces::interface_table::name(_interfaces[i]);
+			std::strncpy(names[i].name, name.c_str(), sizeof(names[i].name) - 1);
+		}
+
+		return WriteAll(_index.data(), _index.size() * sizeof(binary_log::index_entry))
+			&& WriteAll(names.data(), names.size() * sizeof(binary_log::name_entry))
+			&& WriteAll(&footer, sizeof(footer));
+	}
+
+	// --------------------------------------------------------------------
+	// Public methods
+	// --------------------------------------------------------------------
+	// Creates the log file and writes the file header
+	bool binary_log_writer::open(const std::string& path)
+	{
+		if(is_open())
+			return false;
+
+		_file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if(_file < 0)
+			return false;
+
+		binary_log::file_header header{};
+		header.magic = binary_log::file_magic;
+		header.version = binary_log::version;
+		header.header_size = sizeof(header);
+
+		_blockUsed = 0;
+		_offset = sizeof(header);
+		_entry = binary_log::index_entry{};
+		_index.clear();
+		_interfaces.clear();
+
+		if(!WriteAll(&header, sizeof(header)))
+		{
+			::close(_file);
+			_file = -1;
+			return false;
+		}
+
+		return true;
+	}
+
+	// Appends a message to the current block, writing the block when full
+	bool binary_log_writer::write(const can::Message& message)
+	{
+		if(!is_open())
+			return false;
+
+		const canfd_frame& frame = message.get_fd_frame();
+		auto length = std::min<uint8_t>(frame.len, message.max_size());
+		auto size = binary_log::record_size(length);
+		if(_blockUsed + size > _block.size() && !flush())
+			return false;
+
+		// Fill in the record
+		const timespec& time = message.get_timestamp();
+		binary_log::record_header header{};
+		header.timestamp = static_cast<uint64_t>(time.tv_sec) * 1000000000ull + static_cast<uint64_t>(time.tv_nsec);
+		header.can_id = frame.can_id;
+		header.interface = message.get_interface();
+		header.length = length;
+		header.flags = message.is_fd() ? frame.flags : 0;
+
+		auto record = _block.data() + _blockUsed;
+		std::memcpy(record, &header, sizeof(header));
+		std::memcpy(record + sizeof(header), frame.data, length);
+		std::memset(record + sizeof(header) + length, 0, size - sizeof(header) - length);
+		_blockUsed += size;
+
+		// Update the index entry of the block
+		if(_entry.record_count == 0)
+			_entry.first_timestamp = header.timestamp;
+		_entry.last_timestamp = std::max(_entry.last_timestamp, header.timestamp);
+		_entry.record_count++;
+		auto bit = binary_log::id_bit(frame.can_id);
+		_entry.id_bitmap[bit / 8] |= static_cast<uint8_t>(1 << (bit % 8));
+
+		// Remember the interfaces, so their names can be stored
+		if(std::find(_interfaces.begin(), _interfaces.end(), header.interface) == _interfaces.end())
+			_interfaces.push_back(header.interface);
+
+		return true;
+	}
+
+	// Appends a number of messages
+	std::size_t binary_log_writer::write(const can::Message* messages, std::size_t count)
+	{
+		std::size_t written = 0;
+		while(written < count && write(messages[written]))
+			written++;
+		return written;
+	}
+
+	// Writes the current block and adds it to the index
+	bool binary_log_writer::flush()
+	{
+		if(!is_open())
+			return false;
+
+		if(_blockUsed == 0)
+			return true;
+
+		if(!WriteAll(_block.data(), _blockUsed))
+			return false;
+
+		_entry.offset = _offset;
+		_entry.size = _blockUsed;
+		_index.push_back(_entry);
+
+		_offset += _blockUsed;
+		_blockUsed = 0;
+		_entry = binary_log::index_entry{};
+		return true;
+	}
+
+	// Completes the log
+	bool binary_log_writer::close()
+	{
+		if(!is_open())
+			return false;
+
+		auto result = flush() && WriteFooter();
+		result = (::close(_file) == 0) && result;
+		_file = -1;
+
+		return result;
+	}
+
+	// Checks whether a log file is open for writing
+	bool binary_log_writer::is_open() const
+	{
+		return (_file >= 0);
+	}
+}
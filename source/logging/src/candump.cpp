@@ -0,0 +1,352 @@
+///////////////////////////////////////////////////////////////////////
+// candump log format implementation
+//
+// Parsing and formatting of the text format written by "candump -l"
+// and read by "canplayer". Parsing works on the text in place and does
+// not allocate; the hex payload is decoded with SSE2 where available,
+// 16 characters at once.
+///////////////////////////////////////////////////////////////////////
+#include <logging/include/candump.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <net/if.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <interfaces/include/interface_table.h>
+
+namespace
+{
+	constexpr uint8_t invalid_hex = 0xFF;
+
+	// Value of each character as a hex digit
+	constexpr auto hex_table = []()
+	{
+		std::array<uint8_t,256> table{};
+		for(auto& value : table)
+			value = invalid_hex;
+		for(int i = 0; i < 10; i++)
+			table['0' + i] = static_cast<uint8_t>(i);
+		for(int i = 0; i < 6; i++)
+		{
+			table['a' + i] = static_cast<uint8_t>(10 + i);
+			table['A' + i] = static_cast<uint8_t>(10 + i);
+		}
+		return table;
+	}();
+
+	constexpr char hex_digits[] = "0123456789ABCDEF";
+
+	inline uint8_t hex_value(char c)
+	{
+		return hex_table[static_cast<uint8_t>(c)];
+	}
+
+	// Parses a hex number of up to 8 digits - returns the number of digits
+	inline std::size_t parse_hex_number(const char* text, const char* end, uint32_t& value)
+	{
+		value = 0;
+		std::size_t digits = 0;
+		while(text + digits < end && digits < 8)
+		{
+			auto digit = hex_value(text[digits]);
+			if(digit == invalid_hex)
+				break;
+			value = (value << 4) | digit;
+			digits++;
+		}
+		return digits;
+	}
+
+	// Writes "count" hex digits of a value
+	inline char* format_hex(char* line, uint32_t value, int count)
+	{
+		for(int i = count - 1; i >= 0; i--)
+			*line++ = hex_digits[(value >> (4*i)) & 0xF];
+		return line;
+	}
+
+	// Writes a zero-padded decimal number of at least "width" digits
+	inline char* format_decimal(char* line, uint64_t value, int width)
+	{
+		char digits[20];
+		int count = 0;
+		do
+		{
+			digits[count++] = static_cast<char>('0' + value % 10);
+			value /= 10;
+		} while(value > 0);
+
+		for(int i = count; i < width; i++)
+			*line++ = '0';
+		while(count > 0)
+			*line++ = digits[--count];
+		return line;
+	}
+
+#ifdef __SSE2__
+	// Decodes 16 hex characters into 8 bytes - returns false on invalid characters
+	inline bool decode_hex16(const char* text, uint8_t* bytes)
+	{
+		auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text));
+		auto lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+
+		// Classify each character as digit or letter
+		auto digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+		auto letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+		if(_mm_movemask_epi8(_mm_or_si128(digit, letter)) != 0xFFFF)
+			return false;
+
+		// Nibble values
+		auto values = _mm_or_si128(
+			_mm_and_si128(digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+			_mm_and_si128(letter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+
+		// Combine pairs of nibbles - the first character of a pair is the high nibble
+		auto high = _mm_and_si128(_mm_slli_epi16(values, 4), _mm_set1_epi16(0x00F0));
+		auto low = _mm_srli_epi16(values, 8);
+		auto packed = _mm_packus_epi16(_mm_or_si128(high, low), _mm_setzero_si128());
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(bytes), packed);
+		return true;
+	}
+#endif
+}
+
+namespace can::logging::candump
+{
+	// --------------------------------------------------------------------
+	// Interface names
+	// --------------------------------------------------------------------
+	// Returns the interface index of a name
+	int interface_names::index(const char* name, std::size_t length)
+	{
+		for(const auto& e : _entries)
+			if(e.name.size() == length && std::memcmp(e.name.data(), name, length) == 0)
+				return e.index;
+
+		std::string text(name, length);
+		auto index = can::interfaces::interface_table::index(text);
+		_entries.push_back(entry{ index, std::move(text) });
+		return index;
+	}
+
+	// Returns the name of an interface index
+	const std::string& interface_names::name(int index)
+	{
+		for(const auto& e : _entries)
+			if(e.index == index)
+				return e.name;
+
+		_entries.push_back(entry{ index, can::interfaces::interface_table::name(index) });
+		return _entries.back().name;
+	}
+
+	// --------------------------------------------------------------------
+	// Parsing
+	// --------------------------------------------------------------------
+	// Decodes pairs of hex characters into bytes
+	bool decode_hex(const char* text, std::size_t count, uint8_t* bytes)
+	{
+		std::size_t i = 0;
+
+#ifdef __SSE2__
+		for(; i + 8 <= count; i += 8)
+			if(!decode_hex16(text + 2*i, bytes + i))
+				return false;
+#endif
+
+		for(; i < count; i++)
+		{
+			auto high = hex_value(text[2*i]);
+			auto low = hex_value(text[2*i + 1]);
+			if(high == invalid_hex || low == invalid_hex)
+				return false;
+			bytes[i] = static_cast<uint8_t>((high << 4) | low);
+		}
+
+		return true;
+	}
+
+	// Parses "(seconds.fraction) interface id#data"
+	bool parse_line(const char* begin, const char* end, can::Message& message, interface_names& names)
+	{
+		// Ignore trailing whitespace, e.g. from CRLF line breaks
+		while(end > begin && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t'))
+			end--;
+
+		// Timestamp
+		auto p = begin;
+		if(p == end || *p++ != '(')
+			return false;
+
+		uint64_t seconds = 0;
+		while(p < end && *p >= '0' && *p <= '9')
+			seconds = seconds * 10 + static_cast<uint64_t>(*p++ - '0');
+		if(p == end || *p++ != '.')
+			return false;
+
+		uint64_t microseconds = 0;
+		int digits = 0;
+		while(p < end && *p >= '0' && *p <= '9')
+		{
+			if(digits++ < 6)
+				microseconds = microseconds * 10 + static_cast<uint64_t>(*p - '0');
+			p++;
+		}
+		for(; digits < 6; digits++)
+			microseconds *= 10;
+		if(p == end || *p++ != ')')
+			return false;
+
+		// Interface name
+		while(p < end && *p == ' ')
+			p++;
+		auto name = p;
+		while(p < end && *p != ' ')
+			p++;
+		if(p == name || p == end)
+			return false;
+		auto nameLength = static_cast<std::size_t>(p - name);
+		while(p < end && *p == ' ')
+			p++;
+
+		// CAN ID - 3 digits for standard frames, 8 digits for extended and error frames
+		canfd_frame frame{};
+		uint32_t id = 0;
+		auto idDigits = parse_hex_number(p, end, id);
+		p += idDigits;
+		if(p == end || *p++ != '#')
+			return false;
+
+		if(idDigits == 3)
+			frame.can_id = id;
+		else if(idDigits == 8)
+			frame.can_id = (id & CAN_ERR_FLAG) ? (id & (CAN_ERR_MASK | CAN_ERR_FLAG)) : ((id & CAN_EFF_MASK) | CAN_EFF_FLAG);
+		else
+			return false;
+
+		// CAN FD frames have a second '#' and a digit of flags
+		uint8_t maxLength = CAN_MAX_DLEN;
+		if(p < end && *p == '#')
+		{
+			p++;
+			if(p == end || hex_value(*p) > 0xF)
+				return false;
+			frame.flags = static_cast<uint8_t>(hex_value(*p++) | CANFD_FDF);
+			maxLength = CANFD_MAX_DLEN;
+		}
+
+		// Remote frames have an optional length instead of data
+		if(maxLength == CAN_MAX_DLEN && p < end && (*p == 'R' || *p == 'r'))
+		{
+			frame.can_id |= CAN_RTR_FLAG;
+			p++;
+			if(p < end)
+			{
+				auto length = hex_value(*p++);
+				if(length > CAN_MAX_DLEN || p != end)
+					return false;
+				frame.len = length;
+			}
+		}
+		else
+		{
+			// Data, optionally with '.' between bytes
+			auto count = static_cast<std::size_t>(end - p);
+			if(std::find(p, end, '.') == end)
+			{
+				if(count % 2 != 0 || count / 2 > maxLength || !decode_hex(p, count / 2, frame.data))
+					return false;
+				frame.len = static_cast<uint8_t>(count / 2);
+			}
+			else
+			{
+				while(p < end)
+				{
+					if(*p == '.')
+					{
+						p++;
+						continue;
+					}
+					if(end - p < 2 || frame.len >= maxLength || !decode_hex(p, 1, &frame.data[frame.len]))
+						return false;
+					frame.len++;
+					p += 2;
+				}
+			}
+
+			// CAN FD frames only carry lengths a DLC can express
+			if(maxLength == CANFD_MAX_DLEN && frame.len != can::fd_length(frame.len))
+				return false;
+		}
+
+		message.get_fd_frame() = frame;
+		message.set_interface(names.index(name, nameLength));
+		message.get_timestamp().tv_sec = static_cast<time_t>(seconds);
+		message.get_timestamp().tv_nsec = static_cast<long>(microseconds * 1000);
+		return true;
+	}
+
+	// --------------------------------------------------------------------
+	// Formatting
+	// --------------------------------------------------------------------
+	// Formats "(seconds.microseconds) interface id#data"
+	std::size_t format_line(const can::Message& message, interface_names& names, char* line)
+	{
+		auto p = line;
+		const canfd_frame& frame = message.get_fd_frame();
+		const timespec& time = message.get_timestamp();
+
+		// Timestamp
+		*p++ = '(';
+		p = format_decimal(p, static_cast<uint64_t>(time.tv_sec), 10);
+		*p++ = '.';
+		p = format_decimal(p, static_cast<uint64_t>(time.tv_nsec / 1000), 6);
+		*p++ = ')';
+		*p++ = ' ';
+
+		// Interface name, limited to the length of interface names
+		const std::string& name = names.name(message.get_interface());
+		auto nameLength = std::min<std::size_t>(name.size(), IFNAMSIZ);
+		std::memcpy(p, name.data(), nameLength);
+		p += nameLength;
+		*p++ = ' ';
+
+		// CAN ID
+		if(frame.can_id & CAN_ERR_FLAG)
+			p = format_hex(p, frame.can_id & (CAN_ERR_MASK | CAN_ERR_FLAG), 8);
+		else if(frame.can_id & CAN_EFF_FLAG)
+			p = format_hex(p, frame.can_id & CAN_EFF_MASK, 8);
+		else
+			p = format_hex(p, frame.can_id & CAN_SFF_MASK, 3);
+		*p++ = '#';
+
+		// CAN FD flags
+		if(message.is_fd())
+		{
+			*p++ = '#';
+			*p++ = hex_digits[frame.flags & (CANFD_BRS | CANFD_ESI)];
+		}
+
+		// Data, or the length of remote frames
+		auto length = std::min<uint8_t>(frame.len, message.max_size());
+		if(!message.is_fd() && (frame.can_id & CAN_RTR_FLAG))
+		{
+			*p++ = 'R';
+			if(length > 0)
+				*p++ = hex_digits[length];
+		}
+		else
+		{
+			for(uint8_t i = 0; i < length; i++)
+				p = format_hex(p, frame.data[i], 2);
+		}
+
+		*p++ = '\n';
+		return static_cast<std::size_t>(p - line);
+	}
+}
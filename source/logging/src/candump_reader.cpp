@@ -0,0 +1,130 @@
+///////////////////////////////////////////////////////////////////////
+// candump log reader implementation
+//
+// Reads a candump text log (see candump.h) through a memory mapping,
+// parsing the lines in place. Lines which are not valid frames (e.g.
+// comments) are skipped and counted.
+///////////////////////////////////////////////////////////////////////
+#include <logging/include/candump_reader.h>
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace can::logging
+{
+	// --------------------------------------------------------------------
+	// Constructors / destructor
+	// --------------------------------------------------------------------
+	candump_reader::candump_reader() :
+		_file(-1),
+		_data(nullptr),
+		_size(0),
+		_position(0),
+		_skipped(0),
+		_names()
+	{
+	}
+
+	candump_reader::~candump_reader()
+	{
+		close();
+	}
+
+	// --------------------------------------------------------------------
+	// Public methods
+	// --------------------------------------------------------------------
+	// Maps the log file
+	bool candump_reader::open(const std::string& path)
+	{
+		if(is_open())
+			return false;
+
+		_file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if(_file < 0)
+			return false;
+
+		struct stat status;
+		if(fstat(_file, &status) < 0 || status.st_size == 0)
+		{
+			close();
+			return false;
+		}
+
+		_size = static_cast<std::size_t>(status.st_size);
+		void* data = mmap(nullptr, _size, PROT_READ, MAP_SHARED, _file, 0);
+		if(data == MAP_FAILED)
+		{
+			close();
+			return false;
+		}
+		_data = static_cast<const char*>(data);
+		madvise(data, _size, MADV_SEQUENTIAL);
+
+		rewind();
+		return true;
+	}
+
+	// Unmaps and closes the log file
+	void candump_reader::close()
+	{
+		if(_data != nullptr)
+			munmap(const_cast<char*>(_data), _size);
+		if(_file >= 0)
+			::close(_file);
+
+		_file = -1;
+		_data = nullptr;
+		_size = 0;
+		_position = 0;
+	}
+
+	bool candump_reader::is_open() const
+	{
+		return (_data != nullptr);
+	}
+
+	// Moves to the first line
+	void candump_reader::rewind()
+	{
+		_position = 0;
+		_skipped = 0;
+	}
+
+	// Reads the next valid line
+	bool candump_reader::read(can::Message& message)
+	{
+		while(_position < _size)
+		{
+			auto begin = _data + _position;
+			auto lineEnd = static_cast<const char*>(std::memchr(begin, '\n', _size - _position));
+			auto end = (lineEnd != nullptr) ? lineEnd : (_data + _size);
+			_position = static_cast<std::size_t>(end - _data) + 1;
+
+			if(candump::parse_line(begin, end, message, _names))
+				return true;
+
+			// Empty lines are not counted as invalid
+			if(end != begin && !(end - begin == 1 && *begin == '\r'))
+				_skipped++;
+		}
+
+		return false;
+	}
+
+	// Reads up to "count" messages
+	std::size_t candump_reader::read(can::Message* messages, std::size_t count)
+	{
+		std::size_t result = 0;
+		while(result < count && read(messages[result]))
+			result++;
+		return result;
+	}
+
+	uint64_t candump_reader::skipped() const
+	{
+		return _skipped;
+	}
+}
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////
+// candump log writer implementation
+//
+// Writes messages as a candump text log (see candump.h). Lines are
+// formatted into a block buffer, which is written a block at a time.
+///////////////////////////////////////////////////////////////////////
+#include <logging/include/candump_writer.h>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace can::logging
+{
+	// --------------------------------------------------------------------
+	// Constructors / destructor
+	// --------------------------------------------------------------------
+	candump_writer::candump_writer() :
+		_file(-1),
+		_block(_blockSize),
+		_blockUsed(0),
+		_names()
+	{
+	}
+
+	candump_writer::~candump_writer()
+	{
+		close();
+	}
+
+	// --------------------------------------------------------------------
+	// Public methods
+	// --------------------------------------------------------------------
+	// Creates the log file
+	bool candump_writer::open(const std::string& path)
+	{
+		if(is_open())
+			return false;
+
+		_file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		_blockUsed = 0;
+		return is_open();
+	}
+
+	// Formats a message into the block buffer, writing the block when full
+	bool candump_writer::write(const can::Message& message)
+	{
+		if(!is_open())
+			return false;
+
+		if(_blockUsed + candump::max_line_length > _block.size() && !flush())
+			return false;
+
+		_blockUsed += candump::format_line(message, _names, _block.data() + _blockUsed);
+		return true;
+	}
+
+	// Formats a number of messages
+	std::size_t candump_writer::write(const can::Message* messages, std::size_t count)
+	{
+		std::size_t written = 0;
+		while(written < count && write(messages[written]))
+			written++;
+		return written;
+	}
+
+	// Writes the block buffer, retrying on partial writes
+	bool candump_writer::flush()
+	{
+		if(!is_open())
+			return false;
+
+		std::size_t offset = 0;
+		while(offset < _blockUsed)
+		{
+			auto count = ::write(_file, _block.data() + offset, _blockUsed - offset);
+			if(count < 0 && errno == EINTR)
+				continue;
+			if(count <= 0)
+				return false;
+			offset += static_cast<std::size_t>(count);
+		}
+
+		_blockUsed = 0;
+		return true;
+	}
+
+	// Writes the remaining lines and closes the file
+	bool candump_writer::close()
+	{
+		if(!is_open())
+			return false;
+
+		auto result = flush();
+		result = (::close(_file) == 0) && result;
+		_file = -1;
+
+		return result;
+	}
+
+	bool candump_writer::is_open() const
+	{
+		return (_file >= 0);
+	}
+}
@@ -1,20 +1,192 @@
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
 #include <iostream>
 #include <interfaces/include/connection_factory.h>
+#include <interfaces/include/CANReplay.h>
+#include <interfaces/include/gateway.h>
+#include <interfaces/include/interface_table.h>
+#include <interfaces/include/statistics_reporter.h>
 #include <utility/include/cmdargs_parser.h>
 
 /*
 For testing:
 sudo ip link add dev vcan0 type vcan
 sudo ifconfig vcan0 up
+
+Converting logs:
+cantool --input candump capture.log --output canlog capture.bin
+
+Bridging two buses, moving 0x181 to 0x281 and dropping the heartbeat of node 1:
+cantool --input can can0 --output can can1 --rules 0x181=0x281,0x701=drop
+
+Replaying a log onto a bus at twice the recorded speed (0 is as fast as possible):
+cantool --input replay capture.bin --output can vcan0 --speed 2
+
+Recording the traffic of an in-process simulated bus (modelled at 500 kbit/s):
+cantool --input sim sim0@500000 --output canlog capture.bin
+
+Bridging with a stats line every 5 seconds, and the counters in a file for the Prometheus node exporter:
+cantool --input can can0 --output can can1 --stats 5 --stats-file /var/lib/node_exporter/cantool.prom
+
+Without --stats, the file is refreshed every 10 seconds and no stats lines are printed.
 */
 
+namespace
+{
+	void print_message(can::Message& msg)
+	{
+		std::cout << "Recieved message from 0x" << std::hex << msg.id() << " (0x" << static_cast<int>(msg.id_short()) << ") ["
+				  << static_cast<int>(msg.size()) << "]:";
+		for(int i = 0; i < msg.size(); i++)
+			std::cout << " " << std::hex << static_cast<int>(msg[i]);
+		std::cout << " (interface: " << can::interfaces::interface_table::name(msg.get_interface()) << ")";
+		std::cout << std::endl;
+	}
+
+	// Refresh interval of the statistics file when no interval is given
+	constexpr double default_statistics_interval = 10.0;
+
+	// The gateway to stop on SIGINT/SIGTERM
+	can::interfaces::gateway* active_gateway = nullptr;
+
+	void stop_gateway(int)
+	{
+		if(active_gateway != nullptr)
+			active_gateway->stop();
+	}
+
+	// Parses a non-negative number, rejecting text which is not entirely a number
+	bool parse_non_negative(const std::string& text, double& value)
+	{
+		char* end = nullptr;
+		value = std::strtod(text.c_str(), &end);
+		return (!text.empty() && *end == '\0' && std::isfinite(value) && value >= 0.0);
+	}
+
+	bool is_log_file(const std::string& type)
+	{
+		return (type.compare("candump") == 0 || type.compare("canlog") == 0 || type.compare("replay") == 0);
+	}
+
+	void print_statistics(const can::interfaces::replay_statistics& statistics)
+	{
+		std::cout << std::dec << "Replayed " << statistics.frames << " messages, jitter (us): min " << statistics.min_jitter / 1000.0
+				  << ", max " << statistics.max_jitter / 1000.0 << ", mean " << statistics.mean_jitter / 1000.0
+				  << ", stddev " << statistics.stddev_jitter / 1000.0 << std::endl;
+	}
+}
+
 int main(int argc, const char** argv)
 {
 	utility::cmdargs_parser args{ argc, argv };
 
-	auto interface = can::interfaces::connection_factory::create(args.get(utility::cmdargs_parser::values::input_interface_type));
+	auto inputType = args.get(utility::cmdargs_parser::values::input_interface_type);
+	auto interface = can::interfaces::connection_factory::create(inputType);
+	if(!args.valid() || interface == nullptr)
+	{
+		std::cout << "Usage: cantool [--input <type> [name]] [--output <type> [name]] [--speed <factor>] [--rules <id>=<pass|drop|id>,...] [--stats <seconds>] [--stats-file <path>]" << std::endl;
+		return 1;
+	}
+
 	interface->Connect(args.get(utility::cmdargs_parser::values::input_interface_name));
 	interface->SetBlockingMode(false);
+
+	// Replay waits for every message to be due
+	auto replay = dynamic_cast<can::interfaces::CANReplay*>(interface.get());
+	if(replay != nullptr)
+	{
+		double speed = 0.0;
+		if(!parse_non_negative(args.get(utility::cmdargs_parser::values::replay_speed), speed))
+		{
+			std::cout << "Invalid replay speed - expected a factor, or 0 for as fast as possible." << std::endl;
+			return 1;
+		}
+
+		replay->SetReplaySpeed(speed);
+		replay->SetBlockingMode(true);
+	}
+
+	// Forward from the input to the output, when specified
+	if(args.is_set(utility::cmdargs_parser::values::output_interface_type))
+	{
+		auto output = can::interfaces::connection_factory::create(args.get(utility::cmdargs_parser::values::output_interface_type));
+		if(output == nullptr || !output->Connect(args.get(utility::cmdargs_parser::values::output_interface_name)))
+		{
+			std::cout << "Failed to open the output interface." << std::endl;
+			return 1;
+		}
+
+		can::interfaces::gateway gateway(*interface, *output);
+		if(!gateway.parse_rules(args.get(utility::cmdargs_parser::values::gateway_rules)))
+		{
+			std::cout << "Invalid gateway rules." << std::endl;
+			return 1;
+		}
+
+		// Statistics of the interfaces which keep them, periodically and when done
+		double seconds = 0.0;
+		if(!parse_non_negative(args.get(utility::cmdargs_parser::values::statistics_interval), seconds))
+		{
+			std::cout << "Invalid statistics interval - expected a number of seconds." << std::endl;
+			return 1;
+		}
+
+		// A file alone is still refreshed periodically, as exporters read it while the gateway runs
+		auto statisticsFile = args.get(utility::cmdargs_parser::values::statistics_file);
+		if(seconds == 0.0 && !statisticsFile.empty())
+			seconds = default_statistics_interval;
+
+		auto interval = std::chrono::milliseconds(static_cast<long long>(std::ceil(seconds * 1000)));
+		can::interfaces::statistics_reporter reporter(interval);
+		reporter.add(args.get(utility::cmdargs_parser::values::input_interface_name), *interface);
+		reporter.add(args.get(utility::cmdargs_parser::values::output_interface_name), *output);
+		if(args.is_set(utility::cmdargs_parser::values::statistics_interval))
+			reporter.set_output(&std::cout);
+		reporter.set_file(statisticsFile);
+		auto reporting = reporter.start();
+
+		// Log files are forwarded until their end, buses until interrupted
+		if(is_log_file(inputType))
+		{
+			gateway.forward_all();
+		}
+		else
+		{
+			active_gateway = &gateway;
+			std::signal(SIGINT, stop_gateway);
+			std::signal(SIGTERM, stop_gateway);
+			gateway.run();
+			active_gateway = nullptr;
+		}
+
+		if(reporting)
+			reporter.stop();
+
+		std::cout << std::dec << "Forwarded " << gateway.forwarded() << " of " << gateway.received()
+				  << " messages, dropped " << gateway.dropped() << "." << std::endl;
+		if(replay != nullptr)
+			print_statistics(replay->GetStatistics());
+
+		if(gateway.failed() > 0)
+		{
+			std::cout << "Failed to write messages." << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	// Print the contents of log files
+	if(is_log_file(inputType))
+	{
+		can::Message msg;
+		while(interface->RequestMessage(msg))
+			print_message(msg);
+		if(replay != nullptr)
+			print_statistics(replay->GetStatistics());
+		return 0;
+	}
+
 	can_frame frame;
 	frame.can_id = 0x182;
 	frame.data[0] = 0xDE;
@@ -28,12 +200,7 @@ int main(int argc, const char** argv)
 	bool status = interface->RequestMessage(msg);
 	if(status)
 	{
-		std::cout << "Recieved message from 0x" << std::hex << msg.id() << " (0x" << static_cast<int>(msg.id_short()) << ") ["
-				  << static_cast<int>(msg.size()) << "]:";
-		for(int i = 0; i < msg.size(); i++)
-			std::cout << " " << std::hex << static_cast<int>(msg[i]);
-		std::cout << " (interface: " << msg.get_interface() << ")";
-		std::cout << std::endl;
+		print_message(msg);
 	}
 	else
 	{
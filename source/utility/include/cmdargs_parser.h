@@ -23,6 +23,10 @@ namespace utility
 				output_interface_type,
 				input_interface_name,
 				output_interface_name,
+				replay_speed,
+				gateway_rules,
+				statistics_interval,
+				statistics_file,
 			};
 
 		public:
@@ -36,6 +40,7 @@ namespace utility
 
 			// Public interface
 			std::string get(values parameter);
+			bool is_set(values parameter) const;	// Whether the parameter was specified, rather than defaulted
 			bool valid() const;
 
 		private:
@@ -0,0 +1,233 @@
+///////////////////////////////////////////////////////////////////////
+// Lock-free ring buffer
+//
+// Bounded ring buffer for passing trivially copyable values (e.g.
+// can::Message) between threads without locking. Producers are either
+// a single thread (SPSC) or several threads (MPSC). When the ring is
+// full, new values are either dropped, or overwrite the oldest value,
+// and both cases are counted.
+//
+// Based on the bounded queue with per-slot sequence numbers by
+// Dmitry Vyukov. With the overwrite policy, producers discard the
+// oldest value themselves, so dequeuing is always safe to race with.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace utility
+{
+	enum class ring_producers
+	{
+		single,		// Only one thread pushes values
+		multiple,	// Any number of threads push values
+	};
+
+	enum class ring_overflow
+	{
+		drop,		// Values pushed to a full ring are dropped
+		overwrite,	// Values pushed to a full ring replace the oldest value
+	};
+
+	template <typename T, std::size_t capacity, ring_producers producers = ring_producers::single, ring_overflow overflow = ring_overflow::drop>
+	class lockfree_ring
+	{
+		static_assert(capacity >= 2 && (capacity & (capacity - 1)) == 0, "Capacity must be a power of two");
+		static_assert(std::is_trivially_copyable<T>::value, "Values are copied as plain memory");
+
+		private:
+			static constexpr std::size_t _mask = capacity - 1;
+			static constexpr std::size_t _cacheLine = 64;
+
+			// Producers discarding values compete with the consumer
+			static constexpr bool _racingConsumers = (overflow == ring_overflow::overwrite);
+
+			struct slot
+			{
+				std::atomic<std::size_t> sequence;
+				T value;
+			};
+
+			alignas(_cacheLine) std::array<slot,capacity> _slots;
+			alignas(_cacheLine) std::atomic<std::size_t> _head;	// Next position to write
+			alignas(_cacheLine) std::atomic<std::size_t> _tail;	// Next position to read
+			alignas(_cacheLine) std::atomic<uint64_t> _dropped;
+			std::atomic<uint64_t> _overwritten;
+
+			// Claims the next position for writing - returns false if the ring is full
+			bool claim_head(std::size_t& position)
+			{
+				position = _head.load(std::memory_order_relaxed);
+				for(;;)
+				{
+					auto sequence = _slots[position & _mask].sequence.load(std::memory_order_acquire);
+					auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+					if(difference < 0)
+						return false;
+
+					if(difference == 0)
+					{
+						if constexpr (producers == ring_producers::single)
+						{
+							_head.store(position + 1, std::memory_order_relaxed);
+							return true;
+						}
+						else if(_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+						{
+							return true;
+						}
+					}
+					else
+					{
+						position = _head.load(std::memory_order_relaxed);
+					}
+				}
+			}
+
+			// Claims the next position for reading - returns false if the ring is empty
+			bool claim_tail(std::size_t& position)
+			{
+				position = _tail.load(std::memory_order_relaxed);
+				for(;;)
+				{
+					auto sequence = _slots[position & _mask].sequence.load(std::memory_order_acquire);
+					auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+
+					if(difference < 0)
+						return false;
+
+					if(difference == 0)
+					{
+						if constexpr (!_racingConsumers)
+						{
+							_tail.store(position + 1, std::memory_order_relaxed);
+							return true;
+						}
+						else if(_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+						{
+							return true;
+						}
+					}
+					else
+					{
+						position = _tail.load(std::memory_order_relaxed);
+					}
+				}
+			}
+
+		public:
+			// Constructor
+			lockfree_ring() :
+				_head(0),
+				_tail(0),
+				_dropped(0),
+				_overwritten(0)
+			{
+				for(std::size_t i = 0; i < capacity; i++)
+					_slots[i].sequence.store(i, std::memory_order_relaxed);
+			}
+
+			// Do not allow copying
+			lockfree_ring(const lockfree_ring&) = delete;
+			lockfree_ring& operator=(const lockfree_ring&) = delete;
+
+			// Pushes a value - returns false if the value was dropped
+			bool push(const T& value)
+			{
+				std::size_t position;
+				while(!claim_head(position))
+				{
+					if constexpr (overflow == ring_overflow::drop)
+					{
+						_dropped.fetch_add(1, std::memory_order_relaxed);
+						return false;
+					}
+					else
+					{
+						// Discard the oldest value to make room
+						T discarded;
+						if(pop(discarded))
+							_overwritten.fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+
+				auto& s = _slots[position & _mask];
+				s.value = value;
+				s.sequence.store(position + 1, std::memory_order_release);
+				return true;
+			}
+
+			// Pushes a number of values - returns the number of values not dropped
+			std::size_t push(const T* values, std::size_t count)
+			{
+				std::size_t pushed = 0;
+				for(std::size_t i = 0; i < count; i++)
+					pushed += push(values[i]) ? 1 : 0;
+				return pushed;
+			}
+
+			// Pops the oldest value - returns false if the ring is empty
+			bool pop(T& value)
+			{
+				std::size_t position;
+				if(!claim_tail(position))
+					return false;
+
+				auto& s = _slots[position & _mask];
+				value = s.value;
+				s.sequence.store(position + capacity, std::memory_order_release);
+				return true;
+			}
+
+			// Pops up to "count" values - returns the number of values popped
+			std::size_t pop(T* values, std::size_t count)
+			{
+				std::size_t popped = 0;
+				while(popped < count && pop(values[popped]))
+					popped++;
+				return popped;
+			}
+
+			// Approximate number of values in the ring
+			std::size_t size() const
+			{
+				auto head = _head.load(std::memory_order_acquire);
+				auto tail = _tail.load(std::memory_order_acquire);
+				return (head > tail) ? (head - tail) : 0;
+			}
+
+			bool empty() const
+			{
+				return (size() == 0);
+			}
+
+			static constexpr std::size_t max_size()
+			{
+				return capacity;
+			}
+
+			// Overflow counters
+			uint64_t dropped() const
+			{
+				return _dropped.load(std::memory_order_relaxed);
+			}
+
+			uint64_t overwritten() const
+			{
+				return _overwritten.load(std::memory_order_relaxed);
+			}
+	};
+
+	// Single producer, single consumer ring
+	template <typename T, std::size_t capacity, ring_overflow overflow = ring_overflow::drop>
+	using spsc_ring = lockfree_ring<T, capacity, ring_producers::single, overflow>;
+
+	// Multiple producers, single consumer ring
+	template <typename T, std::size_t capacity, ring_overflow overflow = ring_overflow::drop>
+	using mpsc_ring = lockfree_ring<T, capacity, ring_producers::multiple, overflow>;
+}
@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////
+// Sequence lock
+//
+// Publishes a trivially copyable value from one writer thread to any
+// number of reader threads. Writers never wait for readers; readers
+// copy the value and retry if a write happened meanwhile, so readers
+// never block the writer, and never modify shared cache lines.
+//
+// The value is stored as relaxed atomic words, ordered by fences
+// around the sequence counter (see H.-J. Boehm, "Can seqlocks get
+// along with programming language memory models?").
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace utility
+{
+	template <typename T>
+	class seqlock
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Values are copied as plain memory");
+		static_assert(std::is_default_constructible<T>::value);
+
+		private:
+			static constexpr std::size_t _words = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+			std::atomic<uint64_t> _sequence;	// Odd while a write is in progress
+			std::array<std::atomic<uint64_t>,_words> _data;
+
+			// Copies the words - returns false if a write was in progress or happened meanwhile
+			bool TryLoad(uint64_t* words) const
+			{
+				auto before = _sequence.load(std::memory_order_acquire);
+				if(before & 1)
+					return false;
+
+				for(std::size_t i = 0; i < _words; i++)
+					words[i] = _data[i].load(std::memory_order_relaxed);
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+				return (_sequence.load(std::memory_order_relaxed) == before);
+			}
+
+		public:
+			// Constructor
+			seqlock() :
+				_sequence(0)
+			{
+				uint64_t words[_words]{};
+				T value{};
+				std::memcpy(words, &value, sizeof(T));
+				for(std::size_t i = 0; i < _words; i++)
+					_data[i].store(words[i], std::memory_order_relaxed);
+			}
+
+			// Do not allow copying
+			seqlock(const seqlock&) = delete;
+			seqlock& operator=(const seqlock&) = delete;
+
+			// Publishes a value - only one thread may store values
+			void store(const T& value)
+			{
+				uint64_t words[_words]{};
+				std::memcpy(words, &value, sizeof(T));
+
+				auto sequence = _sequence.load(std::memory_order_relaxed);
+				_sequence.store(sequence + 1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+
+				for(std::size_t i = 0; i < _words; i++)
+					_data[i].store(words[i], std::memory_order_relaxed);
+
+				_sequence.store(sequence + 2, std::memory_order_release);
+			}
+
+			// Returns a consistent copy of the value
+			T load() const
+			{
+				uint64_t words[_words];
+				while(!TryLoad(words))
+				{
+#if defined(__x86_64__) || defined(__i386__)
+					__builtin_ia32_pause();
+#endif
+				}
+
+				T value;
+				std::memcpy(&value, words, sizeof(T));
+				return value;
+			}
+
+			// Copies the value without retrying - returns false if a write was in progress
+			bool try_load(T& value) const
+			{
+				uint64_t words[_words];
+				if(!TryLoad(words))
+					return false;
+
+				std::memcpy(&value, words, sizeof(T));
+				return true;
+			}
+
+			// Number of values stored, e.g. for readers to skip unchanged values
+			uint64_t version() const
+			{
+				return _sequence.load(std::memory_order_acquire) / 2;
+			}
+	};
+}
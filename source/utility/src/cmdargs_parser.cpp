@@ -8,6 +8,15 @@
 ///////////////////////////////////////////////////////////////////////
 #include <utility/include/cmdargs_parser.h>
 
+namespace
+{
+	// Checks whether an argument is an option keyword, rather than a value
+	bool is_option(const char* argument)
+	{
+		return std::string(argument).compare(0, 2, "--") == 0;
+	}
+}
+
 // Constructor - parses the commandline arguments
 utility::cmdargs_parser::cmdargs_parser(int argc, const char** argv) :
 	_valid(false),
@@ -22,18 +31,52 @@ utility::cmdargs_parser::cmdargs_parser(int argc, const char** argv) :
 		{
 			if(i+1 >= argc)		// Require the interface type to be specified
 				isOK = false;
-			else if(i+2 < argc)	// The interface name is optional - parse if supplied
-				_values[values::input_interface_name] = argv[i+2];
-			i += 2;
+			else
+				_values[values::input_interface_type] = argv[++i];
+			if(i+1 < argc && !is_option(argv[i+1]))	// The interface name is optional - parse if supplied
+				_values[values::input_interface_name] = argv[++i];
 		}
 		// Parse output interface specification
 		else if(std::string(argv[i]).compare("--output") == 0)
 		{
 			if(i+1 >= argc)		// Require the interface type to be specified
 				isOK = false;
-			else if(i+2 < argc)	// The interface name is optional - parse if supplied
-				_values[values::output_interface_name] = argv[i+2];
-			i += 2;
+			else
+				_values[values::output_interface_type] = argv[++i];
+			if(i+1 < argc && !is_option(argv[i+1]))	// The interface name is optional - parse if supplied
+				_values[values::output_interface_name] = argv[++i];
+		}
+		// Parse replay speed factor
+		else if(std::string(argv[i]).compare("--speed") == 0)
+		{
+			if(i+1 >= argc)		// Require the speed factor to be specified
+				isOK = false;
+			else
+				_values[values::replay_speed] = argv[++i];
+		}
+		// Parse gateway routing rules
+		else if(std::string(argv[i]).compare("--rules") == 0)
+		{
+			if(i+1 >= argc)		// Require the rules to be specified
+				isOK = false;
+			else
+				_values[values::gateway_rules] = argv[++i];
+		}
+		// Parse interval of the statistics reports
+		else if(std::string(argv[i]).compare("--stats") == 0)
+		{
+			if(i+1 >= argc)		// Require the interval to be specified
+				isOK = false;
+			else
+				_values[values::statistics_interval] = argv[++i];
+		}
+		// Parse file of the Prometheus statistics
+		else if(std::string(argv[i]).compare("--stats-file") == 0)
+		{
+			if(i+1 >= argc)		// Require the path to be specified
+				isOK = false;
+			else
+				_values[values::statistics_file] = argv[++i];
 		}
 	}
 
@@ -54,6 +97,13 @@ std::string utility::cmdargs_parser::get(values parameter)
 		case values::input_interface_name:
 		case values::output_interface_name:
 			return "any";
+		case values::replay_speed:
+			return "1";
+		case values::gateway_rules:
+		case values::statistics_file:
+			return "";
+		case values::statistics_interval:
+			return "0";
 		default:
 			break;
 	}
@@ -61,6 +111,12 @@ std::string utility::cmdargs_parser::get(values parameter)
 	return "can";
 }
 
+// Checks whether a parameter was specified on the commandline
+bool utility::cmdargs_parser::is_set(values parameter) const
+{
+	return (_values.find(parameter) != _values.end());
+}
+
 // Returns a status indicating whether valid commandline arguments were specified
 bool utility::cmdargs_parser::valid() const
 {
@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the bit field extraction
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+#include <can/include/bitfield.h>
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+	constexpr can_frame make_frame(std::initializer_list<uint8_t> data)
+	{
+		can_frame frame{};
+		frame.len = 8;
+		std::size_t i = 0;
+		for(auto byte : data)
+			frame.data[i++] = byte;
+		return frame;
+	}
+}
+
+TEST(BitField, extract_little_endian)
+{
+	auto frame = make_frame({ 0x34, 0x12, 0xF0, 0xFF, 0x00, 0x00, 0x00, 0x80 });
+
+	EXPECT_EQ(can::extract_unsigned(frame, 0, 16), 0x1234u);
+	EXPECT_EQ(can::extract_unsigned(frame, 4, 8), 0x23u);
+	EXPECT_EQ(can::extract_unsigned(frame, 63, 1), 1u);
+	EXPECT_EQ(can::extract_signed(frame, 20, 12), -1);
+	EXPECT_EQ(can::extract_signed(frame, 16, 8), -16);
+	EXPECT_EQ(can::extract_signed(frame, 0, 16), 0x1234);
+	EXPECT_EQ(can::extract_unsigned(frame, 0, 64), 0x80000000FFF01234u);
+}
+
+TEST(BitField, extract_big_endian)
+{
+	// A 12-bit Motorola signal with start bit 7 covers byte 0 and the high nibble of byte 1
+	auto frame = make_frame({ 0xAB, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x12, 0x34 });
+
+	EXPECT_EQ(can::extract_unsigned(frame, 7, 12, can::byte_order::big_endian), 0xABCu);
+	EXPECT_EQ(can::extract_unsigned(frame, 7, 8, can::byte_order::big_endian), 0xABu);
+	EXPECT_EQ(can::extract_unsigned(frame, 55, 16, can::byte_order::big_endian), 0x1234u);
+	EXPECT_EQ(can::extract_unsigned(frame, 3, 4, can::byte_order::big_endian), 0xBu);
+	EXPECT_EQ(can::extract_signed(frame, 7, 12, can::byte_order::big_endian), static_cast<int64_t>(0xABC) - 0x1000);
+}
+
+TEST(BitField, extract_at_compile_time)
+{
+	constexpr auto frame = make_frame({ 0x34, 0x12, 0xF0, 0xFF, 0x00, 0x00, 0x00, 0x80 });
+
+	static_assert(can::extract_bits<0, 16>(frame) == 0x1234u);
+	static_assert(can::extract_bits<16, 8, can::byte_order::little_endian, int8_t>(frame) == -16);
+	static_assert(can::extract_bits<7, 8, can::byte_order::big_endian, uint8_t>(frame) == 0x34);
+
+	static_assert(can::valid_bitfield(60, 4, can::byte_order::little_endian));
+	static_assert(!can::valid_bitfield(60, 5, can::byte_order::little_endian));
+	static_assert(can::valid_bitfield(7, 64, can::byte_order::big_endian));
+	static_assert(can::valid_bitfield(0, 2, can::byte_order::big_endian));
+	static_assert(!can::valid_bitfield(56, 2, can::byte_order::big_endian));
+	static_assert(!can::valid_bitfield(56, 9, can::byte_order::big_endian));
+}
+
+TEST(BitField, insert_round_trip)
+{
+	std::mt19937_64 random{ 42 };
+	for(auto order : { can::byte_order::little_endian, can::byte_order::big_endian })
+		for(std::size_t start = 0; start < 64; start++)
+			for(std::size_t length = 1; length <= 64; length++)
+			{
+				if(!can::valid_bitfield(start, length, order))
+					continue;
+
+				auto frame = make_frame({});
+				auto background = random();
+				can::insert_bits(frame, 0, 64, can::byte_order::little_endian, background);
+
+				auto value = random() & can::bitfield_mask(length);
+				can::insert_bits(frame, start, length, order, value);
+				ASSERT_EQ(can::extract_unsigned(frame, start, length, order), value) << start << " " << length;
+
+				// The other bits are left unchanged
+				can::insert_bits(frame, start, length, order, 0);
+				auto cleared = can::extract_unsigned(frame, 0, 64);
+				auto mask = can::bitfield_mask(length) << can::bitfield_shift(start, length, order);
+				if(order == can::byte_order::big_endian)
+					mask = __builtin_bswap64(mask);
+				ASSERT_EQ(cleared, background & ~mask);
+			}
+}
+
+TEST(BitField, batch_matches_scalar)
+{
+	std::mt19937_64 random{ 7 };
+	std::vector<can::Message> messages(1003);
+	for(auto& message : messages)
+	{
+		message.set_size(8);
+		can::insert_bits(message.get_frame(), 0, 64, can::byte_order::little_endian, random());
+	}
+
+	std::vector<uint64_t> unsignedValues(messages.size());
+	std::vector<int64_t> signedValues(messages.size());
+	const std::tuple<std::size_t,std::size_t,can::byte_order> signals[] = {
+		{ 0, 1, can::byte_order::little_endian }, { 3, 12, can::byte_order::little_endian },
+		{ 40, 24, can::byte_order::little_endian }, { 0, 64, can::byte_order::little_endian },
+		{ 7, 1, can::byte_order::big_endian }, { 7, 12, can::byte_order::big_endian },
+		{ 21, 16, can::byte_order::big_endian }, { 7, 64, can::byte_order::big_endian } };
+	for(auto [start, length, order] : signals)
+	{
+		ASSERT_TRUE(can::valid_bitfield(start, length, order));
+		can::extract_unsigned(messages.data(), messages.size(), start, length, order, unsignedValues.data());
+		can::extract_signed(messages.data(), messages.size(), start, length, order, signedValues.data());
+		for(std::size_t i = 0; i < messages.size(); i++)
+		{
+			ASSERT_EQ(unsignedValues[i], can::extract_unsigned(messages[i].get_frame(), start, length, order));
+			ASSERT_EQ(signedValues[i], can::extract_signed(messages[i].get_frame(), start, length, order));
+		}
+	}
+}
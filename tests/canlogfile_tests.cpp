@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the CAN log file interface
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <vector>
+
+#include <interfaces/include/CANLogFile.h>
+
+namespace
+{
+	std::string temp_path(const std::string& name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	std::vector<can::Message> test_messages(std::size_t count)
+	{
+		std::vector<can::Message> messages(count);
+		for(std::size_t i = 0; i < count; i++)
+		{
+			messages[i].set_id(0x100 + (i % 0x100));
+			messages[i].set_size(2);
+			messages[i][0] = static_cast<uint8_t>(i);
+			messages[i][1] = static_cast<uint8_t>(i >> 8);
+			messages[i].get_timestamp().tv_sec = 100 + static_cast<time_t>(i);
+		}
+		return messages;
+	}
+}
+
+TEST(CANLogFile, not_ready_before_connect)
+{
+	can::interfaces::CANLogFile file(can::interfaces::CANLogFile::log_format::candump);
+	can::Message message;
+
+	EXPECT_FALSE(file.IsReady());
+	EXPECT_FALSE(file.RequestMessage(message));
+	EXPECT_FALSE(file.SendMessage(message));
+	EXPECT_EQ(file.GetFileDescriptor(), -1);
+}
+
+// Converting a text log to a binary log and back
+TEST(CANLogFile, convert_between_formats)
+{
+	auto textPath = temp_path("cantools_logfile_test.log");
+	auto binaryPath = temp_path("cantools_logfile_test.bin");
+	auto messages = test_messages(1000);
+
+	{
+		can::interfaces::CANLogFile text(can::interfaces::CANLogFile::log_format::candump);
+		ASSERT_TRUE(text.Connect(textPath));
+		EXPECT_EQ(text.SendMessages(messages.data(), messages.size()), messages.size());
+	}
+
+	{
+		can::interfaces::CANLogFile text(can::interfaces::CANLogFile::log_format::candump);
+		can::interfaces::CANLogFile binary(can::interfaces::CANLogFile::log_format::binary);
+		ASSERT_TRUE(text.Connect(textPath));
+		ASSERT_TRUE(binary.Connect(binaryPath));
+
+		std::vector<can::Message> batch(64);
+		while(auto count = text.RequestMessages(batch.data(), batch.size()))
+			ASSERT_EQ(binary.SendMessages(batch.data(), count), count);
+
+		// The file being read is not overwritten
+		EXPECT_FALSE(text.SendMessage(messages[0]));
+	}
+
+	can::interfaces::CANLogFile binary(can::interfaces::CANLogFile::log_format::binary);
+	ASSERT_TRUE(binary.Connect(binaryPath));
+	std::vector<can::Message> result(messages.size() + 1);
+	ASSERT_EQ(binary.RequestMessages(result.data(), result.size()), messages.size());
+	for(std::size_t i = 0; i < messages.size(); i++)
+	{
+		EXPECT_EQ(result[i].id(), messages[i].id());
+		EXPECT_EQ(result[i][0], messages[i][0]);
+		EXPECT_EQ(result[i][1], messages[i][1]);
+		EXPECT_EQ(result[i].get_timestamp().tv_sec, messages[i].get_timestamp().tv_sec);
+	}
+
+	std::filesystem::remove(textPath);
+	std::filesystem::remove(binaryPath);
+}
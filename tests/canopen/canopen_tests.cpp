@@ -17,6 +17,26 @@ TEST(CANOpen, generate_message)
 		EXPECT_EQ(msg.data[i], i);
 }
 
+TEST(CANOpen, generate_fd_message)
+{
+	std::array<canopen::data_type,10> data{};
+	for(std::size_t i = 0; i < data.size(); i++)
+		data[i] = static_cast<canopen::data_type>(i + 1);
+
+	// Padded to the next CAN FD length
+	auto msg = canopen::message_fd(canopen::tpdo_id<1>(5), data);
+	EXPECT_EQ(msg.can_id, 0x185u);
+	EXPECT_EQ(msg.len, 12);
+	EXPECT_EQ(msg.flags, CANFD_BRS | CANFD_FDF);
+	EXPECT_EQ(msg.data[9], 10);
+	EXPECT_EQ(msg.data[10], 0);
+
+	can::Message message(msg);
+	EXPECT_TRUE(message.is_fd());
+	EXPECT_TRUE(canopen::is_tpdo<1>(message.get_frame()));
+	EXPECT_EQ(canopen::get_id(message.get_frame()), 5);
+}
+
 TEST(CANOpen, generate_sdo_read)
 {
 	const decltype(can_frame::can_id) id{ 0x12 };
@@ -57,6 +77,38 @@ TEST(CANOpen, generate_sdo_write_1byte)
 	EXPECT_EQ(msg.data[7], 0);
 }
 
+TEST(CANOpen, generate_sdo_request_to_node)
+{
+	constexpr auto msg = canopen::message_sdo_request(0x12, canopen::as_data(canopen::sdo_type::write_2bytes), 0x3456, 0x78, {{ 0xCD, 0xAB }});
+
+	EXPECT_EQ(msg.can_id, 0x612u);
+	EXPECT_EQ(msg.len, 8);
+	EXPECT_EQ(msg.data[0], 0x2b);
+	EXPECT_EQ(msg.data[1], 0x56);
+	EXPECT_EQ(msg.data[2], 0x34);
+	EXPECT_EQ(msg.data[3], 0x78);
+	EXPECT_EQ(msg.data[4], 0xCD);
+	EXPECT_EQ(msg.data[5], 0xAB);
+	EXPECT_EQ(msg.data[6], 0);
+	EXPECT_EQ(msg.data[7], 0);
+	EXPECT_EQ(canopen::sdo_response_id(0x12), 0x592u);
+}
+
+TEST(CANOpen, generate_sdo_abort)
+{
+	auto msg = canopen::message_sdo_abort(0x7F, 0x1018, 0x01, 0x05040000);
+
+	EXPECT_EQ(msg.can_id, 0x67Fu);
+	EXPECT_EQ(canopen::get_sdo_function_code(msg), canopen::sdo_type::abort);
+	EXPECT_EQ(msg.data[1], 0x18);
+	EXPECT_EQ(msg.data[2], 0x10);
+	EXPECT_EQ(msg.data[3], 0x01);
+	EXPECT_EQ(msg.data[4], 0x00);
+	EXPECT_EQ(msg.data[5], 0x00);
+	EXPECT_EQ(msg.data[6], 0x04);
+	EXPECT_EQ(msg.data[7], 0x05);
+}
+
 TEST(CANOpen, generate_sdo_write_2bytes)
 {
 	const decltype(can_frame::can_id) id{ 0x12 };
@@ -120,3 +172,113 @@ TEST(CANOpen, generate_nmt_reset)
 	EXPECT_EQ(msg.data[0], 0x81);
 	EXPECT_EQ(msg.data[1], id);
 }
+
+// Kernel filters must accept exactly the frames accepted by the classifiers
+TEST(CANOpen, filters_match_classifiers)
+{
+	for(canid_t id = 0; id <= CAN_SFF_MASK; id++)
+	{
+		can_frame msg{};
+		msg.can_id = id;
+
+		EXPECT_EQ(canopen::passes_filter(msg, canopen::filter_nmt()), canopen::is_nmt(msg));
+		EXPECT_EQ(canopen::passes_filter(msg, canopen::filter_emcy()), canopen::is_emcy(msg));
+		EXPECT_EQ(canopen::passes_filter(msg, canopen::filter_lss()), canopen::is_lss(msg));
+		EXPECT_EQ(canopen::passes_filter(msg, canopen::filter_tpdo<1>()), canopen::is_tpdo<1>(msg));
+		EXPECT_EQ(canopen::passes_filter(msg, canopen::filter_tpdo<4>()), canopen::is_tpdo<4>(msg));
+		EXPECT_EQ(canopen::passes_filter(msg, canopen::filter_rpdo<1>()), canopen::is_rpdo<1>(msg));
+		EXPECT_EQ(canopen::passes_filter(msg, canopen::filter_rpdo<4>()), canopen::is_rpdo<4>(msg));
+		EXPECT_EQ(canopen::passes_filter(msg, canopen::filter_sdo_request()), canopen::is_sdo_request(msg));
+		EXPECT_EQ(canopen::passes_filter(msg, canopen::filter_sdo_response()), canopen::is_sdo_response(msg));
+		EXPECT_EQ(canopen::passes_filter(msg, canopen::filter_sdo()), canopen::is_sdo(msg));
+		EXPECT_TRUE(canopen::passes_filter(msg, canopen::filter_all()));
+	}
+}
+
+TEST(CANOpen, node_filters_match_single_node)
+{
+	const canopen::id_type node = 5;
+
+	for(canid_t id = 0; id <= CAN_SFF_MASK; id++)
+	{
+		can_frame msg{};
+		msg.can_id = id;
+		auto fromNode = (canopen::get_id(msg) == node);
+
+		EXPECT_EQ(canopen::passes_filter(msg, canopen::filter_sdo_response(node)), canopen::is_sdo_response(msg) && fromNode);
+		EXPECT_EQ(canopen::passes_filter(msg, canopen::filter_emcy(node)), canopen::is_emcy(msg) && fromNode);
+		EXPECT_EQ(canopen::passes_filter(msg, canopen::filter_tpdo<2>(node)), canopen::is_tpdo<2>(msg) && fromNode);
+		EXPECT_EQ(canopen::passes_filter(msg, canopen::filter_heartbeat(node)), id == 0x705);
+	}
+}
+
+// E.g. "only SDO responses from node 5 plus all EMCY"
+TEST(CANOpen, combine_filters)
+{
+	constexpr auto filters = canopen::combine(canopen::filter_sdo_response(5), canopen::filter_emcy());
+	static_assert(filters.size() == 2);
+
+	can_frame msg{};
+	msg.can_id = 0x585;
+	EXPECT_TRUE(canopen::passes_filter(msg, filters));
+	msg.can_id = 0x586;
+	EXPECT_FALSE(canopen::passes_filter(msg, filters));
+	msg.can_id = 0x0A0;
+	EXPECT_TRUE(canopen::passes_filter(msg, filters));
+	msg.can_id = 0x182;
+	EXPECT_FALSE(canopen::passes_filter(msg, filters));
+}
+
+TEST(CANOpen, read_sdo_index)
+{
+	can_frame frame{};
+	frame.can_id = canopen::sdo_response_id(5);
+	frame.len = 8;
+	frame.data[0] = 0x43;
+	frame.data[1] = 0x56;
+	frame.data[2] = 0x34;
+	frame.data[3] = 0x02;
+
+	EXPECT_EQ(canopen::get_sdo_cobid(frame), 0x3456);
+	EXPECT_EQ(canopen::get_sdo_subindex(frame), 0x02);
+
+	static_assert(canopen::map_from_data<uint32_t,4>({{ 0x78, 0x56, 0x34, 0x12 }}) == 0x12345678u);
+}
+
+TEST(CANOpen, generate_and_read_emcy)
+{
+	auto msg = canopen::message_emcy(0x12, 0x8130, 0x11, {{ 1, 2, 3, 4, 5 }});
+
+	EXPECT_EQ(msg.can_id, 0x092u);
+	EXPECT_EQ(msg.len, 8);
+	EXPECT_TRUE(canopen::is_emcy(msg));
+	EXPECT_EQ(msg.data[0], 0x30);
+	EXPECT_EQ(msg.data[1], 0x81);
+	EXPECT_EQ(msg.data[2], 0x11);
+
+	auto emcy = canopen::get_emcy(msg);
+	EXPECT_EQ(emcy.error_code, 0x8130);
+	EXPECT_EQ(emcy.error_register, 0x11);
+	EXPECT_EQ(emcy.manufacturer[0], 1);
+	EXPECT_EQ(emcy.manufacturer[4], 5);
+
+	// Short frames leave the missing fields at 0
+	msg.len = 2;
+	emcy = canopen::get_emcy(msg);
+	EXPECT_EQ(emcy.error_code, 0x8130);
+	EXPECT_EQ(emcy.error_register, 0);
+	EXPECT_EQ(emcy.manufacturer[0], 0);
+}
+
+TEST(CANOpen, emcy_error_classes)
+{
+	static_assert(canopen::get_emcy_class(0x0000) == canopen::emcy_class::no_error);
+	static_assert(canopen::get_emcy_class(0x1000) == canopen::emcy_class::generic);
+	static_assert(canopen::get_emcy_class(0x2310) == canopen::emcy_class::current);
+	static_assert(canopen::get_emcy_class(0x4210) == canopen::emcy_class::temperature);
+	static_assert(canopen::get_emcy_class(0x8130) == canopen::emcy_class::monitoring);
+	static_assert(canopen::get_emcy_class(0xF001) == canopen::emcy_class::additional_functions);
+	static_assert(canopen::get_emcy_class(0xFF42) == canopen::emcy_class::device_specific);
+	static_assert(canopen::get_emcy_class(0x0500) == canopen::emcy_class::unknown);
+	static_assert(canopen::get_emcy_class(0xA000) == canopen::emcy_class::unknown);
+}
@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the CANOpen frame dispatcher
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <map>
+
+#include <can/include/dispatcher.h>
+
+namespace
+{
+	can::Message make_message(canid_t id)
+	{
+		can_frame frame{};
+		frame.can_id = id;
+		return can::Message(frame);
+	}
+}
+
+// The table agrees with the classifiers for every standard ID
+TEST(CANOpenDispatch, function_code_table_matches_classifiers)
+{
+	for(canid_t id = 0; id <= CAN_SFF_MASK; id++)
+	{
+		can_frame msg{};
+		msg.can_id = id;
+		auto code = canopen::get_function_code(msg);
+
+		EXPECT_EQ(code == canopen::function_code::lss, canopen::is_lss(msg));
+		EXPECT_EQ(code == canopen::function_code::nmt || code == canopen::function_code::heartbeat, canopen::is_nmt(msg) && !canopen::is_lss(msg));
+		EXPECT_EQ(code == canopen::function_code::emcy || code == canopen::function_code::sync, canopen::is_emcy(msg));
+		EXPECT_EQ(code == canopen::function_code::tpdo3, canopen::is_tpdo<3>(msg));
+		EXPECT_EQ(code == canopen::function_code::rpdo2, canopen::is_rpdo<2>(msg));
+		EXPECT_EQ(code == canopen::function_code::sdo_request, canopen::is_sdo_request(msg));
+		EXPECT_EQ(code == canopen::function_code::sdo_response, canopen::is_sdo_response(msg));
+	}
+
+	can_frame extended{};
+	extended.can_id = 0x181 | CAN_EFF_FLAG;
+	EXPECT_EQ(canopen::get_function_code(extended), canopen::function_code::unknown);
+	can_frame remote{};
+	remote.can_id = 0x181 | CAN_RTR_FLAG;
+	EXPECT_EQ(canopen::get_function_code(remote), canopen::function_code::unknown);
+	static_assert(canopen::function_code_table[0x100] == canopen::function_code::time);
+	static_assert(canopen::function_code_table[0x7E5] == canopen::function_code::lss);
+}
+
+TEST(CANOpenDispatch, routes_by_function_code_and_node)
+{
+	canopen::dispatcher dispatcher;
+	std::map<std::string,int> calls;
+	auto count = [&calls](const std::string& name) { return [&calls, name](const can::Message&) { calls[name]++; }; };
+
+	EXPECT_TRUE(dispatcher.on(canopen::function_code::tpdo1, count("tpdo1")));
+	EXPECT_TRUE(dispatcher.on(canopen::function_code::tpdo1, 5, count("tpdo1 node 5")));
+	EXPECT_TRUE(dispatcher.on(canopen::function_code::heartbeat, count("heartbeat")));
+	EXPECT_TRUE(dispatcher.on(canopen::function_code::sync, 42, count("sync")));
+	EXPECT_TRUE(dispatcher.on_id(0x18FF0001 | CAN_EFF_FLAG, count("j1939")));
+	EXPECT_TRUE(dispatcher.on_id(0x00000181 | CAN_EFF_FLAG, count("extended 0x181")));
+	EXPECT_FALSE(dispatcher.on(canopen::function_code::emcy, 0, count("emcy node 0")));	// 0x080 is SYNC
+	EXPECT_FALSE(dispatcher.on(canopen::function_code::unknown, count("unknown")));
+
+	std::vector<can::Message> messages{ make_message(0x181), make_message(0x185), make_message(0x1FF), make_message(0x705),
+		make_message(0x080), make_message(0x18FF0001 | CAN_EFF_FLAG), make_message(0x181 | CAN_EFF_FLAG),
+		make_message(0x18FF0002 | CAN_EFF_FLAG), make_message(0x601) };
+
+	EXPECT_EQ(dispatcher.dispatch(messages.data(), messages.size()), 7u);
+	EXPECT_EQ(calls["tpdo1"], 2);
+	EXPECT_EQ(calls["tpdo1 node 5"], 1);
+	EXPECT_EQ(calls["heartbeat"], 1);
+	EXPECT_EQ(calls["sync"], 1);
+	EXPECT_EQ(calls["j1939"], 1);
+	EXPECT_EQ(calls["extended 0x181"], 1);
+}
+
+TEST(CANOpenDispatch, default_handler_and_clear)
+{
+	canopen::dispatcher dispatcher;
+	int handled = 0, unhandled = 0;
+	dispatcher.on(canopen::function_code::emcy, [&handled](const can::Message&) { handled++; });
+	EXPECT_FALSE(dispatcher.dispatch(make_message(0x701)));
+
+	dispatcher.set_default([&unhandled](const can::Message&) { unhandled++; });
+	EXPECT_TRUE(dispatcher.dispatch(make_message(0x701)));
+	EXPECT_TRUE(dispatcher.dispatch(make_message(0x081)));
+	EXPECT_TRUE(dispatcher.dispatch(make_message(0x12345 | CAN_EFF_FLAG)));
+	EXPECT_EQ(handled, 1);
+	EXPECT_EQ(unhandled, 2);
+
+	dispatcher.clear();
+	EXPECT_FALSE(dispatcher.dispatch(make_message(0x081)));
+	EXPECT_FALSE(dispatcher.dispatch(make_message(0x701)));
+}
+
+// Remote requests for a PDO carry no data, so they must not reach the PDO handler
+TEST(CANOpenDispatch, remote_requests_go_to_default_handler)
+{
+	canopen::dispatcher dispatcher;
+	int pdos = 0, unhandled = 0;
+	dispatcher.on(canopen::function_code::tpdo1, [&pdos](const can::Message&) { pdos++; });
+	dispatcher.on_id(0x18FF0001 | CAN_EFF_FLAG, [&pdos](const can::Message&) { pdos++; });
+	EXPECT_FALSE(dispatcher.dispatch(make_message(0x181 | CAN_RTR_FLAG)));
+	EXPECT_FALSE(dispatcher.dispatch(make_message(0x18FF0001 | CAN_EFF_FLAG | CAN_RTR_FLAG)));
+
+	dispatcher.set_default([&unhandled](const can::Message&) { unhandled++; });
+	EXPECT_TRUE(dispatcher.dispatch(make_message(0x181 | CAN_RTR_FLAG)));
+	EXPECT_TRUE(dispatcher.dispatch(make_message(0x181)));
+	EXPECT_EQ(pdos, 1);
+	EXPECT_EQ(unhandled, 1);
+}
@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the CANOpen emergency history
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <can/include/emcy_history.h>
+
+namespace
+{
+	can::Message emcy(canopen::id_type node, uint16_t code, long seconds = 1, uint8_t errorRegister = 0x01)
+	{
+		can::Message message(canopen::message_emcy(node, code, errorRegister));
+		message.get_timestamp() = timespec{ seconds, 0 };
+		return message;
+	}
+}
+
+TEST(CANOpenEMCY, non_emcy_frames_are_ignored)
+{
+	canopen::emcy_history history;
+	can::Message sync(canopen::message_emcy(0, 0x1000, 0));
+
+	EXPECT_FALSE(history.process(sync));
+	EXPECT_FALSE(history.process(can::Message(canopen::message_sdo_abort(5, 0x1000, 0, 0))));
+	EXPECT_EQ(history.total(0), 0u);
+	EXPECT_EQ(history.size(5), 0u);
+}
+
+TEST(CANOpenEMCY, events_are_kept_latest_first)
+{
+	canopen::emcy_history history(4);
+
+	EXPECT_TRUE(history.process(emcy(5, 0x2310, 10, 0x03)));
+	EXPECT_TRUE(history.process(emcy(5, 0x0000, 11)));
+	ASSERT_EQ(history.size(5), 2u);
+	EXPECT_EQ(history.total(5), 2u);
+
+	EXPECT_EQ(history.event(5, 0).emcy.error_code, 0x0000);
+	EXPECT_EQ(history.event(5, 0).timestamp.tv_sec, 11);
+	EXPECT_EQ(history.event(5, 1).emcy.error_code, 0x2310);
+	EXPECT_EQ(history.event(5, 1).emcy.error_register, 0x03);
+	EXPECT_EQ(history.size(6), 0u);
+}
+
+TEST(CANOpenEMCY, history_wraps_around)
+{
+	canopen::emcy_history history(4);
+	for(long i = 0; i < 10; i++)
+		history.process(emcy(7, static_cast<uint16_t>(0x1000 + i), i + 1));
+
+	EXPECT_EQ(history.capacity(), 4u);
+	ASSERT_EQ(history.size(7), 4u);
+	EXPECT_EQ(history.total(7), 10u);
+	for(std::size_t i = 0; i < 4; i++)
+		EXPECT_EQ(history.event(7, i).emcy.error_code, 0x1009 - i);
+}
+
+TEST(CANOpenEMCY, counters_per_node_code_and_class)
+{
+	canopen::emcy_history history;
+	for(int i = 0; i < 5; i++)
+		history.process(emcy(1, 0x8130));
+	for(int i = 0; i < 3; i++)
+		history.process(emcy(2, 0x8130));
+	history.process(emcy(2, 0x3210));
+	history.process(emcy(2, 0x0000));
+
+	EXPECT_EQ(history.count(1, 0x8130), 5u);
+	EXPECT_EQ(history.count(2, 0x8130), 3u);
+	EXPECT_EQ(history.count(3, 0x8130), 0u);
+	EXPECT_EQ(history.count(uint16_t{ 0x8130 }), 8u);
+	EXPECT_EQ(history.count(canopen::emcy_class::voltage), 1u);
+	EXPECT_EQ(history.count(canopen::emcy_class::no_error), 1u);
+
+	auto counts = history.counts();
+	ASSERT_EQ(counts.size(), 4u);
+	EXPECT_EQ(counts[0].node, 1);
+	EXPECT_EQ(counts[0].count, 5u);
+	EXPECT_EQ(counts[1].node, 2);
+	EXPECT_EQ(counts[1].error_code, 0x0000);
+	EXPECT_EQ(counts[3].error_code, 0x8130);
+
+	history.clear();
+	EXPECT_EQ(history.total(1), 0u);
+	EXPECT_EQ(history.count(1, 0x8130), 0u);
+	EXPECT_TRUE(history.counts().empty());
+}
+
+TEST(CANOpenEMCY, codes_beyond_the_table_are_untracked)
+{
+	canopen::emcy_history history(8, 4);
+	for(uint16_t code = 0; code < 10; code++)
+	{
+		history.process(emcy(3, code));
+		history.process(emcy(3, code));
+	}
+
+	EXPECT_EQ(history.counts().size(), 4u);
+	EXPECT_EQ(history.untracked(), 12u);
+	EXPECT_EQ(history.total(3), 20u);
+
+	// Tracked codes keep counting
+	history.process(emcy(3, 0));
+	EXPECT_EQ(history.count(3, 0), 3u);
+	EXPECT_EQ(history.untracked(), 12u);
+}
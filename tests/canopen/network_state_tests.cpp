@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the CANOpen network state
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include <can/include/network_state.h>
+
+namespace
+{
+	can::Message make_message(canid_t id, std::initializer_list<uint8_t> data)
+	{
+		can::Message message;
+		message.set_id(id);
+		message.set_size(static_cast<uint8_t>(data.size()));
+		uint8_t i = 0;
+		for(auto byte : data)
+			message[i++] = byte;
+		return message;
+	}
+
+	can::Message heartbeat(canopen::id_type node, uint8_t state, long seconds, long microseconds = 0)
+	{
+		auto message = make_message(0x700u + node, { state });
+		message.get_timestamp() = timespec{ seconds, microseconds * 1000 };
+		return message;
+	}
+
+	timespec at(long seconds, long microseconds = 0)
+	{
+		return timespec{ seconds, microseconds * 1000 };
+	}
+}
+
+TEST(CANOpenNetwork, unknown_nodes)
+{
+	canopen::network_state network;
+	auto status = network.node(5);
+
+	EXPECT_EQ(status.state, canopen::nmt_type::unknown);
+	EXPECT_EQ(status.heartbeats, 0u);
+	EXPECT_EQ(network.changes(), 0u);
+	EXPECT_EQ(network.node(200).state, canopen::nmt_type::unknown);
+}
+
+TEST(CANOpenNetwork, heartbeats_update_state)
+{
+	canopen::network_state network;
+
+	EXPECT_TRUE(network.process(heartbeat(5, 0x00, 10)));
+	EXPECT_TRUE(network.process(heartbeat(5, 0x7F, 11)));
+	EXPECT_TRUE(network.process(heartbeat(5, 0x85, 12, 500)));	// Toggle bit set
+
+	auto status = network.node(5);
+	EXPECT_EQ(status.state, canopen::nmt_type::state_operational);
+	EXPECT_EQ(status.boot_ups, 1u);
+	EXPECT_EQ(status.heartbeats, 3u);
+	EXPECT_EQ(status.last_heartbeat.tv_sec, 12);
+	EXPECT_EQ(status.last_heartbeat.tv_nsec, 500000);
+	EXPECT_EQ(network.changes(), 3u);
+
+	// Other frames are ignored
+	EXPECT_FALSE(network.process(make_message(0x185, { 1, 2 })));
+	EXPECT_FALSE(network.process(make_message(0x605, { 0x40, 0x00, 0x10, 0x00, 0, 0, 0, 0 })));
+	EXPECT_FALSE(network.process(make_message(0x705 | CAN_EFF_FLAG, { 0x05 })));
+	EXPECT_EQ(network.node(6).state, canopen::nmt_type::unknown);
+}
+
+TEST(CANOpenNetwork, boot_ups_are_counted)
+{
+	canopen::network_state network;
+	const can::Message messages[] = { heartbeat(3, 0x00, 1), heartbeat(3, 0x05, 2), heartbeat(3, 0x00, 3), heartbeat(3, 0x7F, 4) };
+
+	EXPECT_EQ(network.process(messages, 4), 4u);
+	EXPECT_EQ(network.node(3).boot_ups, 2u);
+	EXPECT_EQ(network.node(3).state, canopen::nmt_type::state_preoperational);
+}
+
+TEST(CANOpenNetwork, nmt_commands_are_recorded)
+{
+	canopen::network_state network;
+
+	EXPECT_TRUE(network.process(can::Message(canopen::message_nmt<canopen::nmt_type::command_operational>(7))));
+	EXPECT_EQ(network.node(7).command, canopen::nmt_type::command_operational);
+	EXPECT_EQ(network.node(8).command, canopen::nmt_type::unknown);
+
+	// Node 0 addresses all nodes
+	EXPECT_TRUE(network.process(can::Message(canopen::message_nmt<canopen::nmt_type::command_stopped>(0))));
+	auto snapshot = network.snapshot();
+	EXPECT_EQ(snapshot[1].command, canopen::nmt_type::command_stopped);
+	EXPECT_EQ(snapshot[7].command, canopen::nmt_type::command_stopped);
+	EXPECT_EQ(snapshot[127].command, canopen::nmt_type::command_stopped);
+
+	// The command does not change the reported state
+	EXPECT_EQ(snapshot[7].state, canopen::nmt_type::unknown);
+}
+
+TEST(CANOpenNetwork, heartbeat_timeouts)
+{
+	using namespace std::chrono_literals;
+	canopen::network_state network;
+	network.set_heartbeat_timeout(100ms);
+	network.set_heartbeat_timeout(4, 0ms);
+
+	network.process(heartbeat(2, 0x05, 10));
+	network.process(heartbeat(3, 0x05, 10, 50000));
+	network.process(heartbeat(4, 0x05, 10));
+
+	EXPECT_EQ(network.check_timeouts(at(10, 100000)), 0u);
+	EXPECT_EQ(network.check_timeouts(at(10, 100001)), 1u);
+	EXPECT_TRUE(network.node(2).timed_out);
+	EXPECT_FALSE(network.node(3).timed_out);
+
+	// Timeouts are reported once, until the next heartbeat
+	EXPECT_EQ(network.check_timeouts(at(11)), 1u);
+	EXPECT_EQ(network.check_timeouts(at(12)), 0u);
+	EXPECT_TRUE(network.node(3).timed_out);
+	EXPECT_FALSE(network.node(4).timed_out);
+
+	network.process(heartbeat(2, 0x05, 12));
+	EXPECT_FALSE(network.node(2).timed_out);
+	EXPECT_EQ(network.node(2).timeouts, 1u);
+	EXPECT_EQ(network.check_timeouts(at(13)), 1u);
+	EXPECT_EQ(network.node(2).timeouts, 2u);
+
+	network.reset();
+	EXPECT_EQ(network.node(2).heartbeats, 0u);
+	EXPECT_EQ(network.check_timeouts(at(20)), 0u);
+}
+
+TEST(CANOpenNetwork, messages_without_timestamp_use_the_clock)
+{
+	canopen::network_state network;
+	network.process(make_message(0x70A, { 0x05 }));
+
+	timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	EXPECT_NEAR(static_cast<double>(network.node(10).last_heartbeat.tv_sec), static_cast<double>(now.tv_sec), 2.0);
+}
+
+TEST(CANOpenNetwork, concurrent_readers)
+{
+	canopen::network_state network;
+	std::atomic<bool> done{ false };
+	std::atomic<uint64_t> inconsistent{ 0 };
+
+	// Each heartbeat of a node carries its count as timestamp
+	std::thread reader([&]()
+	{
+		while(!done.load(std::memory_order_relaxed))
+			for(canopen::id_type node = 1; node < 4; node++)
+			{
+				auto status = network.node(node);
+				if(static_cast<uint64_t>(status.last_heartbeat.tv_sec) != status.heartbeats)
+					inconsistent++;
+			}
+	});
+
+	for(long i = 1; i <= 100000; i++)
+		network.process(heartbeat(static_cast<canopen::id_type>(1 + i % 3), 0x05, (i + 2) / 3));
+	done = true;
+	reader.join();
+
+	EXPECT_EQ(inconsistent.load(), 0u);
+	EXPECT_EQ(network.changes(), 100000u);
+}
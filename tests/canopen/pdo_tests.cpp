@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the CANOpen PDO mapping
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+#include <can/include/canopen.h>
+
+namespace
+{
+	// Statusword, actual position and a few flags of a drive
+	using drive_status = canopen::pdo_mapping<
+		canopen::pdo_entry<0x6041, 0, 16>,
+		canopen::pdo_entry<0x6064, 0, 32, int32_t>,
+		canopen::pdo_entry<0x2000, 1, 1, bool>,
+		canopen::pdo_entry<0x2000, 2, 3>,
+		canopen::pdo_entry<0x2000, 3, 12, int16_t>>;
+}
+
+TEST(CANOpenPDO, mapping_layout)
+{
+	static_assert(drive_status::size == 5);
+	static_assert(drive_status::bit_length == 64);
+	static_assert(drive_status::data_length == 8);
+	static_assert(std::is_same<drive_status::values_type, std::tuple<uint16_t,int32_t,bool,uint8_t,int16_t>>::value);
+
+	constexpr auto mapping = drive_status::mapping();
+	EXPECT_EQ(mapping[0], 0x60410010u);
+	EXPECT_EQ(mapping[1], 0x60640020u);
+	EXPECT_EQ(mapping[2], 0x20000101u);
+	EXPECT_EQ(mapping[4], 0x2000030Cu);
+
+	using short_mapping = canopen::pdo_mapping<canopen::pdo_entry<0x6040, 0, 16>, canopen::pdo_entry<0x6060, 0, 4>>;
+	static_assert(short_mapping::data_length == 3);
+}
+
+TEST(CANOpenPDO, unpack_little_endian_bit_packed)
+{
+	can_frame frame{};
+	frame.can_id = canopen::tpdo_id<1>(5);
+	frame.len = 8;
+	const uint8_t data[8] = { 0x37, 0x16, 0xFE, 0xFF, 0xFF, 0xFF, 0x0B, 0x80 };
+	std::copy(data, data + 8, frame.data);
+
+	ASSERT_TRUE(drive_status::matches(frame));
+	auto [statusword, position, enabled, mode, offset] = drive_status::unpack(frame);
+	EXPECT_EQ(frame.can_id, 0x185u);
+	EXPECT_EQ(statusword, 0x1637);
+	EXPECT_EQ(position, -2);
+	EXPECT_TRUE(enabled);
+	EXPECT_EQ(mode, 5);
+	EXPECT_EQ(offset, -2048);
+	EXPECT_EQ(drive_status::get<1>(frame), -2);
+	EXPECT_EQ(drive_status::get<4>(frame), -2048);
+
+	frame.len = 7;
+	EXPECT_FALSE(drive_status::matches(frame));
+}
+
+TEST(CANOpenPDO, pack_round_trip)
+{
+	constexpr auto frame = drive_status::message(canopen::rpdo_id<1>(5), { 0xBEEF, -123456, false, 7, 2047 });
+	static_assert(frame.can_id == 0x205);
+	static_assert(frame.len == 8);
+	static_assert(drive_status::get<1>(frame) == -123456);
+
+	auto values = drive_status::unpack(frame);
+	EXPECT_EQ(values, std::make_tuple(uint16_t{0xBEEF}, int32_t{-123456}, false, uint8_t{7}, int16_t{2047}));
+	EXPECT_EQ(frame.data[0], 0xEF);
+	EXPECT_EQ(frame.data[1], 0xBE);
+
+	// Values outside the bit length are truncated
+	auto data = canopen::pdo_mapping<canopen::pdo_entry<0x2000, 1, 4>, canopen::pdo_entry<0x2000, 2, 4>>::pack({ 0x1F, 0x2 });
+	ASSERT_EQ(data.size(), 1u);
+	EXPECT_EQ(data[0], 0x2F);
+}
+
+TEST(CANOpenPDO, full_64_bit_entry)
+{
+	using counter = canopen::pdo_mapping<canopen::pdo_entry<0x2100, 0, 64, int64_t>>;
+	constexpr auto frame = counter::message(0x181, { INT64_MIN + 1 });
+	static_assert(counter::get<0>(frame) == INT64_MIN + 1);
+	EXPECT_EQ(frame.data[7], 0x80);
+	EXPECT_EQ(frame.data[0], 0x01);
+}
@@ -0,0 +1,423 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the CANOpen SDO client
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include <can/include/sdo_client.h>
+#include <can/include/sdo_server.h>
+
+#include "../fake_interface.h"
+
+namespace
+{
+	// Answers the SDO requests sent since the last call, in reverse order, using the responder
+	template <typename responder_type>
+	std::size_t answer_requests(tests::fake_interface& interface, std::size_t& answered, responder_type responder)
+	{
+		auto sent = interface.sent();
+		std::vector<can::Message> responses;
+		for(std::size_t i = answered; i < sent.size(); i++)
+		{
+			const auto& request = sent[i].get_frame();
+			if(!canopen::is_sdo_request(request))
+				continue;
+
+			can_frame response = request;
+			response.can_id = canopen::sdo_response_id(canopen::get_id(request));
+			if(responder(request, response))
+				responses.emplace_back(response);
+		}
+		answered = sent.size();
+
+		std::reverse(responses.begin(), responses.end());
+		for(const auto& response : responses)
+			interface.queue(response);
+		return responses.size();
+	}
+
+	// Passes the requests sent since the last call to the server, and queues its responses - "drop" may lose requests
+	template <typename drop_type>
+	void exchange(tests::fake_interface& interface, canopen::sdo_server& server, std::size_t& answered, drop_type drop)
+	{
+		auto sent = interface.sent();
+		std::vector<can::Message> responses;
+		for(std::size_t i = answered; i < sent.size(); i++)
+			if(!drop(sent[i]))
+				server.process(sent[i], responses);
+		answered = sent.size();
+
+		for(const auto& response : responses)
+			interface.queue(response);
+	}
+
+	// Runs the client against the server until all transfers are complete
+	template <typename drop_type>
+	void run_with_server(canopen::sdo_client& client, tests::fake_interface& interface, canopen::sdo_server& server, drop_type drop)
+	{
+		auto answered = interface.sent().size();
+		while(!client.idle())
+		{
+			client.poll();
+			exchange(interface, server, answered, drop);
+			client.run_once();
+		}
+	}
+
+	void run_with_server(canopen::sdo_client& client, tests::fake_interface& interface, canopen::sdo_server& server)
+	{
+		run_with_server(client, interface, server, [](const can::Message&) { return false; });
+	}
+
+	std::vector<canopen::data_type> test_data(std::size_t size)
+	{
+		std::vector<canopen::data_type> data(size);
+		for(std::size_t i = 0; i < size; i++)
+			data[i] = static_cast<canopen::data_type>(i * 7 + (i >> 8));
+		return data;
+	}
+
+	// Answers reads with a value made from the node and subindex, and acknowledges writes
+	bool answer_expedited(const can_frame& request, can_frame& response)
+	{
+		if(request.data[0] == canopen::as_data(canopen::sdo_type::read))
+		{
+			response.data[0] = 0x4B;	// Expedited, 2 bytes
+			response.data[4] = canopen::get_id(request);
+			response.data[5] = request.data[3];
+			response.data[6] = 0xFF;	// Not part of the data
+			response.data[7] = 0xFF;
+		}
+		else
+		{
+			response.data[0] = 0x60;
+		}
+		return true;
+	}
+}
+
+// Reads from 60 nodes run in parallel, one outstanding transfer per node
+TEST(sdo_client, parallel_reads_across_nodes)
+{
+	tests::fake_interface interface;
+	canopen::sdo_client client(interface);
+
+	std::vector<canopen::sdo_result> results;
+	for(canopen::subindex_type subindex = 1; subindex <= 3; subindex++)
+		for(canopen::id_type node = 1; node <= 60; node++)
+			client.read(node, 0x2000, subindex, [&results](const canopen::sdo_result& r) { results.push_back(r); });
+	EXPECT_EQ(client.pending(), 180u);
+
+	// Every node gets its first request at once
+	std::size_t answered = 0;
+	client.poll();
+	EXPECT_EQ(interface.sent().size(), 60u);
+
+	for(int round = 0; round < 3; round++)
+	{
+		EXPECT_EQ(answer_requests(interface, answered, answer_expedited), 60u);
+		client.run_once();
+	}
+
+	EXPECT_TRUE(client.idle());
+	ASSERT_EQ(results.size(), 180u);
+	for(const auto& result : results)
+	{
+		EXPECT_EQ(result.status, canopen::sdo_status::success);
+		EXPECT_EQ(result.index, 0x2000);
+		ASSERT_EQ(result.data.size(), 2u);
+		EXPECT_EQ(result.value(), static_cast<uint32_t>(result.node | (result.subindex << 8)));
+	}
+	EXPECT_EQ(interface.sent().size(), 180u);
+}
+
+TEST(sdo_client, expedited_write)
+{
+	tests::fake_interface interface;
+	canopen::sdo_client client(interface);
+
+	auto result = client.write(5, 0x1017, 0, { 0xE8, 0x03 });
+	client.poll();
+
+	auto sent = interface.sent();
+	ASSERT_EQ(sent.size(), 1u);
+	EXPECT_EQ(sent[0].id(), 0x605u);
+	EXPECT_EQ(sent[0][0], 0x2B);
+	EXPECT_EQ(sent[0][1], 0x17);
+	EXPECT_EQ(sent[0][2], 0x10);
+	EXPECT_EQ(sent[0][4], 0xE8);
+	EXPECT_EQ(sent[0][5], 0x03);
+
+	std::size_t answered = 0;
+	answer_requests(interface, answered, answer_expedited);
+	client.run_until_idle();
+
+	ASSERT_EQ(result.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+	auto r = result.get();
+	EXPECT_EQ(r.status, canopen::sdo_status::success);
+	EXPECT_EQ(r.node, 5);
+	EXPECT_TRUE(r.data.empty());
+}
+
+TEST(sdo_client, invalid_requests_fail_at_once)
+{
+	tests::fake_interface interface;
+	canopen::sdo_client client(interface);
+
+	auto noData = client.write(5, 0x1017, 0, {});
+	auto noBlockData = client.write_block(5, 0x1017, 0, {});
+	auto broadcast = client.read(0, 0x1000, 0);
+	auto badNode = client.read(128, 0x1000, 0);
+
+	EXPECT_EQ(noData.get().status, canopen::sdo_status::failed);
+	EXPECT_EQ(noBlockData.get().status, canopen::sdo_status::failed);
+	EXPECT_EQ(broadcast.get().status, canopen::sdo_status::failed);
+	EXPECT_EQ(badNode.get().status, canopen::sdo_status::failed);
+	EXPECT_TRUE(client.idle());
+}
+
+TEST(sdo_client, abort_from_node)
+{
+	tests::fake_interface interface;
+	canopen::sdo_client client(interface);
+
+	auto result = client.read(7, 0x6000, 1);
+	client.poll();
+
+	std::size_t answered = 0;
+	answer_requests(interface, answered, [](const can_frame&, can_frame& response)
+	{
+		response.data[0] = 0x80;
+		response.data[4] = 0x00;
+		response.data[5] = 0x00;
+		response.data[6] = 0x02;
+		response.data[7] = 0x06;	// Object does not exist
+		return true;
+	});
+	client.run_until_idle();
+
+	auto r = result.get();
+	EXPECT_EQ(r.status, canopen::sdo_status::aborted);
+	EXPECT_EQ(r.abort_code, 0x06020000u);
+}
+
+// Responses for another index, subindex or node do not complete the transfer
+TEST(sdo_client, ignores_mismatched_responses)
+{
+	tests::fake_interface interface;
+	canopen::sdo_client client(interface);
+
+	auto result = client.read(7, 0x6000, 1);
+	client.poll();
+
+	can_frame response = canopen::message_sdo_request(7, 0x4F, 0x6000, 2, {{ 0x11 }});
+	response.can_id = canopen::sdo_response_id(7);
+	interface.queue(response);	// Wrong subindex
+	response.data[3] = 1;
+	response.can_id = canopen::sdo_response_id(8);
+	interface.queue(response);	// Wrong node
+	response.can_id = canopen::sdo_request_id(7);
+	interface.queue(response);	// A request, not a response
+	client.run_once();
+	EXPECT_EQ(client.pending(), 1u);
+
+	response.can_id = canopen::sdo_response_id(7);
+	interface.queue(response);
+	client.run_once();
+
+	auto r = result.get();
+	EXPECT_EQ(r.status, canopen::sdo_status::success);
+	ASSERT_EQ(r.data.size(), 1u);
+	EXPECT_EQ(r.data[0], 0x11);
+}
+
+// An unanswered transfer times out and is aborted towards the node, and the next one starts
+TEST(sdo_client, timeout_aborts_transfer)
+{
+	tests::fake_interface interface;
+	interface.SetTimeout(1);
+	canopen::sdo_client client(interface, std::chrono::milliseconds(10));
+
+	auto first = client.read(3, 0x1008, 0);
+	auto second = client.read(3, 0x1009, 0);
+	auto start = std::chrono::steady_clock::now();
+	while(client.pending() == 2)
+		client.run_once();
+	EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(10));
+
+	auto r = first.get();
+	EXPECT_EQ(r.status, canopen::sdo_status::timeout);
+	EXPECT_EQ(r.abort_code, canopen::sdo_abort_code::timeout);
+
+	auto sent = interface.sent();
+	ASSERT_EQ(sent.size(), 3u);
+	EXPECT_EQ(sent[1].id(), 0x603u);
+	EXPECT_EQ(sent[1][0], 0x80);
+	EXPECT_EQ(sent[1][1], 0x08);
+	EXPECT_EQ(sent[1][6], 0x04);
+	EXPECT_EQ(sent[1][7], 0x05);
+	EXPECT_EQ(sent[2][1], 0x09);	// The second transfer
+
+	client.run_until_idle();
+	EXPECT_EQ(second.get().status, canopen::sdo_status::timeout);
+}
+
+// A node answering with an unexpected command is aborted
+TEST(sdo_client, unexpected_response_aborts)
+{
+	tests::fake_interface interface;
+	canopen::sdo_client client(interface);
+
+	auto result = client.read(9, 0x1000, 0);
+	client.poll();
+
+	std::size_t answered = 0;
+	answer_requests(interface, answered, [](const can_frame&, can_frame& response)
+	{
+		response.data[0] = 0x60;	// A download response to an upload
+		return true;
+	});
+	client.run_until_idle();
+
+	auto r = result.get();
+	EXPECT_EQ(r.status, canopen::sdo_status::aborted);
+	EXPECT_EQ(r.abort_code, canopen::sdo_abort_code::invalid_command);
+	EXPECT_EQ(interface.sent().back()[0], 0x80);
+}
+
+TEST(sdo_client, crc_matches_ccitt_check_value)
+{
+	constexpr std::array<canopen::data_type,9> check{{ '1', '2', '3', '4', '5', '6', '7', '8', '9' }};
+	static_assert(canopen::sdo_crc(check.data(), check.size()) == 0x31C3);
+	EXPECT_EQ(canopen::sdo_crc(check.data(), 4, canopen::sdo_crc(nullptr, 0)), canopen::sdo_crc(check.data(), 4));
+	EXPECT_EQ(canopen::sdo_crc(check.data() + 4, 5, canopen::sdo_crc(check.data(), 4)), 0x31C3);
+}
+
+// Expedited and segmented transfers of all sizes around the segment boundaries
+TEST(sdo_client, segmented_transfers)
+{
+	tests::fake_interface interface;
+	canopen::sdo_client client(interface);
+	canopen::sdo_server server(4);
+
+	for(std::size_t size : { 1, 4, 5, 7, 8, 14, 15, 100, 1000 })
+	{
+		auto data = test_data(size);
+		auto written = client.write(4, 0x2000, 1, data);
+		run_with_server(client, interface, server);
+		EXPECT_EQ(written.get().status, canopen::sdo_status::success);
+		ASSERT_TRUE(server.get(0x2000, 1) != nullptr);
+		EXPECT_EQ(*server.get(0x2000, 1), data);
+
+		auto read = client.read(4, 0x2000, 1);
+		run_with_server(client, interface, server);
+		auto r = read.get();
+		EXPECT_EQ(r.status, canopen::sdo_status::success);
+		EXPECT_EQ(r.data, data);
+	}
+
+	// 1000 bytes take 143 segments, each answered, plus the initiate requests
+	EXPECT_GT(interface.sent().size(), 286u);
+}
+
+TEST(sdo_client, block_transfers)
+{
+	tests::fake_interface interface;
+	canopen::sdo_client client(interface);
+	canopen::sdo_server server(4);
+	server.set_block_size(16);
+	client.set_block_size(32);
+
+	for(std::size_t size : { 1, 6, 7, 8, 111, 112, 113, 10000 })
+	{
+		auto data = test_data(size);
+		auto written = client.write_block(4, 0x1F50, 1, data);
+		run_with_server(client, interface, server);
+		EXPECT_EQ(written.get().status, canopen::sdo_status::success);
+		ASSERT_TRUE(server.get(0x1F50, 1) != nullptr);
+		EXPECT_EQ(*server.get(0x1F50, 1), data);
+
+		auto read = client.read_block(4, 0x1F50, 1);
+		run_with_server(client, interface, server);
+		auto r = read.get();
+		EXPECT_EQ(r.status, canopen::sdo_status::success);
+		EXPECT_EQ(r.data, data);
+	}
+}
+
+// A lost segment is acknowledged short, and the block continues from there
+TEST(sdo_client, block_download_recovers_lost_segment)
+{
+	tests::fake_interface interface;
+	canopen::sdo_client client(interface);
+	canopen::sdo_server server(4);
+	server.set_block_size(10);
+
+	auto data = test_data(500);
+	auto written = client.write_block(4, 0x1F50, 1, data);
+
+	auto dropped = 0;
+	run_with_server(client, interface, server, [&dropped](const can::Message& message)
+	{
+		// Lose the 5th segment of the first block once
+		if(dropped > 0 || message.get_frame().data[0] != 5)
+			return false;
+		dropped++;
+		return true;
+	});
+
+	EXPECT_EQ(dropped, 1);
+	EXPECT_EQ(written.get().status, canopen::sdo_status::success);
+	ASSERT_TRUE(server.get(0x1F50, 1) != nullptr);
+	EXPECT_EQ(*server.get(0x1F50, 1), data);
+}
+
+// Corrupted data is detected by the CRC at the end of the block transfer
+TEST(sdo_client, block_download_detects_corruption)
+{
+	tests::fake_interface interface;
+	canopen::sdo_client client(interface);
+	canopen::sdo_server server(4);
+
+	auto written = client.write_block(4, 0x1F50, 1, test_data(100));
+	std::size_t answered = 0;
+	while(!client.idle())
+	{
+		client.poll();
+
+		// Flip a bit in the data of the third segment
+		auto sent = interface.sent();
+		std::vector<can::Message> responses;
+		for(std::size_t i = answered; i < sent.size(); i++)
+		{
+			if(sent[i][0] == 3)
+				sent[i][4] ^= 0x01;
+			server.process(sent[i], responses);
+		}
+		answered = sent.size();
+		for(const auto& response : responses)
+			interface.queue(response);
+
+		client.run_once();
+	}
+
+	auto r = written.get();
+	EXPECT_EQ(r.status, canopen::sdo_status::aborted);
+	EXPECT_EQ(r.abort_code, canopen::sdo_abort_code::crc_error);
+	EXPECT_TRUE(server.get(0x1F50, 1) == nullptr);
+}
+
+TEST(sdo_client, read_of_missing_object_is_aborted)
+{
+	tests::fake_interface interface;
+	canopen::sdo_client client(interface);
+	canopen::sdo_server server(4);
+
+	auto read = client.read(4, 0x2001, 0);
+	auto readBlock = client.read_block(4, 0x2001, 0);
+	run_with_server(client, interface, server);
+
+	EXPECT_EQ(read.get().abort_code, canopen::sdo_abort_code::no_object);
+	EXPECT_EQ(readBlock.get().abort_code, canopen::sdo_abort_code::no_object);
+}
@@ -0,0 +1,268 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the simulated CANOpen nodes and the node farm
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <vector>
+
+#include <can/include/network_state.h>
+#include <can/include/node_farm.h>
+#include <can/include/sdo_client.h>
+#include <interfaces/include/CANSimulation.h>
+
+namespace
+{
+	constexpr int64_t ms = 1000000;
+
+	can::Message nmt(canopen::nmt_type command, canopen::id_type node)
+	{
+		can_frame frame{};
+		frame.len = 2;
+		frame.data[0] = static_cast<uint8_t>(command);
+		frame.data[1] = node;
+		return can::Message(frame);
+	}
+
+	// Expedited download of up to 4 bytes
+	can::Message download(canopen::id_type node, canopen::index_type index, canopen::subindex_type subindex, uint32_t value, uint8_t size)
+	{
+		auto command = static_cast<canopen::data_type>(0x23 | ((4 - size) << 2));
+		std::array<canopen::data_type,4> data{{ static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24) }};
+		return can::Message(canopen::message_sdo_request(node, command, index, subindex, data));
+	}
+}
+
+TEST(CANOpenSimulatedNode, boot_up_when_started)
+{
+	canopen::simulated_node node(5);
+	std::vector<can::Message> output;
+
+	EXPECT_FALSE(node.process(nmt(canopen::nmt_type::command_operational, 5), 0, output));
+	EXPECT_EQ(node.state(), canopen::nmt_type::unknown);
+
+	node.start(0, output);
+	ASSERT_EQ(output.size(), 1u);
+	EXPECT_EQ(output[0].id(), 0x705u);
+	EXPECT_EQ(output[0].size(), 1u);
+	EXPECT_EQ(output[0][0], 0x00);
+	EXPECT_EQ(node.state(), canopen::nmt_type::state_preoperational);
+}
+
+TEST(CANOpenSimulatedNode, nmt_state_machine)
+{
+	canopen::simulated_node node(5);
+	std::vector<can::Message> output;
+	node.start(0, output);
+	output.clear();
+
+	EXPECT_TRUE(node.process(nmt(canopen::nmt_type::command_operational, 5), 0, output));
+	EXPECT_EQ(node.state(), canopen::nmt_type::state_operational);
+
+	EXPECT_FALSE(node.process(nmt(canopen::nmt_type::command_stopped, 6), 0, output));
+	EXPECT_EQ(node.state(), canopen::nmt_type::state_operational);
+
+	EXPECT_TRUE(node.process(nmt(canopen::nmt_type::command_stopped, 0), 0, output));
+	EXPECT_EQ(node.state(), canopen::nmt_type::state_stopped);
+
+	EXPECT_TRUE(node.process(nmt(canopen::nmt_type::command_preoperational, 5), 0, output));
+	EXPECT_EQ(node.state(), canopen::nmt_type::state_preoperational);
+	EXPECT_TRUE(output.empty());
+
+	EXPECT_TRUE(node.process(nmt(canopen::nmt_type::command_reset_communication, 5), 0, output));
+	EXPECT_EQ(node.state(), canopen::nmt_type::state_preoperational);
+	ASSERT_EQ(output.size(), 1u);
+	EXPECT_EQ(output[0].id(), 0x705u);
+}
+
+TEST(CANOpenSimulatedNode, heartbeats_without_bursts)
+{
+	canopen::simulated_node node(5);
+	std::vector<can::Message> output;
+	node.set_heartbeat(std::chrono::milliseconds(100));
+	node.start(0, output);
+	output.clear();
+	EXPECT_EQ(node.next_deadline(), 100*ms);
+
+	node.poll(50*ms, output);
+	EXPECT_TRUE(output.empty());
+
+	node.poll(100*ms, output);
+	ASSERT_EQ(output.size(), 1u);
+	EXPECT_EQ(output[0].id(), 0x705u);
+	EXPECT_EQ(output[0][0], 0x7F);
+	EXPECT_EQ(node.next_deadline(), 200*ms);
+
+	// Missed heartbeats are not caught up on
+	output.clear();
+	node.poll(1000*ms, output);
+	EXPECT_EQ(output.size(), 1u);
+	EXPECT_EQ(node.next_deadline(), 1100*ms);
+}
+
+TEST(CANOpenSimulatedNode, tpdos_when_operational)
+{
+	canopen::simulated_node node(5);
+	std::vector<can::Message> output;
+	node.set(0x6000, 1, { 0x34, 0x12 });
+	node.set(0x6001, 0, { 0xAB });
+	ASSERT_TRUE(node.set_tpdo(1, { 0x60000110, 0x60010008 }, std::chrono::milliseconds(10)));
+	node.start(0, output);
+	output.clear();
+
+	node.poll(20*ms, output);
+	EXPECT_TRUE(output.empty());
+	EXPECT_EQ(node.next_deadline(), INT64_MAX);
+
+	node.process(nmt(canopen::nmt_type::command_operational, 0), 20*ms, output);
+	EXPECT_EQ(node.next_deadline(), 30*ms);
+	node.poll(30*ms, output);
+	ASSERT_EQ(output.size(), 1u);
+	EXPECT_EQ(output[0].id(), 0x185u);
+	ASSERT_EQ(output[0].size(), 3u);
+	EXPECT_EQ(output[0][0], 0x34);
+	EXPECT_EQ(output[0][1], 0x12);
+	EXPECT_EQ(output[0][2], 0xAB);
+
+	// Mapped objects are read when sending
+	output.clear();
+	node.set(0x6001, 0, { 0xCD });
+	node.poll(40*ms, output);
+	ASSERT_EQ(output.size(), 1u);
+	EXPECT_EQ(output[0][2], 0xCD);
+}
+
+TEST(CANOpenSimulatedNode, configuration_over_sdo)
+{
+	canopen::simulated_node node(5);
+	std::vector<can::Message> output;
+	node.start(0, output);
+	output.clear();
+
+	EXPECT_TRUE(node.process(download(5, 0x1017, 0, 50, 2), 0, output));
+	ASSERT_EQ(output.size(), 1u);
+	EXPECT_EQ(output[0].id(), 0x585u);
+	EXPECT_EQ(output[0][0], 0x60);
+	EXPECT_EQ(node.next_deadline(), 50*ms);
+
+	// Enable TPDO 2 with one mapped byte, every 5 ms
+	output.clear();
+	node.set(0x2000, 0, { 0x42 });
+	node.process(download(5, 0x1A01, 1, 0x20000008, 4), 0, output);
+	node.process(download(5, 0x1A01, 0, 1, 1), 0, output);
+	node.process(download(5, 0x1801, 5, 5, 2), 0, output);
+	node.process(download(5, 0x1801, 1, canopen::tpdo_id<2>(5), 4), 0, output);
+	node.process(nmt(canopen::nmt_type::command_operational, 5), 0, output);
+	output.clear();
+
+	node.poll(5*ms, output);
+	ASSERT_EQ(output.size(), 1u);
+	EXPECT_EQ(output[0].id(), 0x285u);
+	EXPECT_EQ(output[0][0], 0x42);
+
+	// No SDO while stopped
+	output.clear();
+	node.process(nmt(canopen::nmt_type::command_stopped, 5), 0, output);
+	EXPECT_TRUE(node.process(download(5, 0x1017, 0, 0, 2), 0, output));
+	EXPECT_TRUE(output.empty());
+	EXPECT_FALSE(node.process(download(6, 0x1017, 0, 0, 2), 0, output));
+}
+
+TEST(CANOpenSimulatedNode, invalid_tpdos)
+{
+	canopen::simulated_node node(5);
+
+	EXPECT_FALSE(node.set_tpdo(0, { 0x60000108 }, std::chrono::milliseconds(10)));
+	EXPECT_FALSE(node.set_tpdo(5, { 0x60000108 }, std::chrono::milliseconds(10)));
+	EXPECT_FALSE(node.set_tpdo(1, { 0x60000140, 0x60000208 }, std::chrono::milliseconds(10)));
+	EXPECT_TRUE(node.set_tpdo(4, { 0x60000140 }, std::chrono::milliseconds(10)));
+}
+
+TEST(CANOpenNodeFarm, nodes)
+{
+	can::interfaces::CANSimulation interface;
+	canopen::node_farm farm(interface, 2);
+
+	EXPECT_FALSE(farm.start());
+	EXPECT_EQ(farm.add(0), nullptr);
+	EXPECT_EQ(farm.add(128), nullptr);
+	EXPECT_NE(farm.add(1), nullptr);
+	EXPECT_EQ(farm.add(1), nullptr);
+	EXPECT_EQ(farm.node(1)->node(), 1);
+	EXPECT_EQ(farm.node(2), nullptr);
+	EXPECT_EQ(farm.size(), 1u);
+}
+
+TEST(CANOpenNodeFarm, full_network)
+{
+	can::interfaces::CANSimulation farmInterface;
+	can::interfaces::CANSimulation master;
+	ASSERT_TRUE(farmInterface.Connect("node_farm_test"));
+	ASSERT_TRUE(master.Connect("node_farm_test"));
+	master.SetBlockingMode(false);
+	master.SetTimeout(10);
+
+	canopen::node_farm farm(farmInterface, 4);
+	for(canopen::id_type id = 1; id < 128; id++)
+	{
+		auto node = farm.add(id);
+		node->set_heartbeat(std::chrono::milliseconds(50));
+		node->set(0x6000, 0, { id });
+		node->set_tpdo(1, { 0x60000008 }, std::chrono::milliseconds(20));
+	}
+	ASSERT_TRUE(farm.start());
+
+	canopen::network_state network;
+	canopen::sdo_client client(master, std::chrono::milliseconds(1000));
+	std::vector<can::Message> batch(256);
+	std::size_t tpdos = 0;
+	auto exchange = [&]()
+	{
+		auto received = master.RequestMessages(batch.data(), batch.size());
+		network.process(batch.data(), received);
+		client.process(batch.data(), received);
+		for(std::size_t i = 0; i < received; i++)
+			if(batch[i].id() == canopen::tpdo_id<1>(static_cast<canopen::id_type>(batch[i][0])))
+				tpdos++;
+		client.poll();
+	};
+	auto count_state = [&](canopen::nmt_type state)
+	{
+		std::size_t count = 0;
+		for(canopen::id_type id = 1; id < 128; id++)
+			count += (network.node(id).state == state) ? 1 : 0;
+		return count;
+	};
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while(count_state(canopen::nmt_type::state_preoperational) < 127 && std::chrono::steady_clock::now() < deadline)
+		exchange();
+	EXPECT_EQ(count_state(canopen::nmt_type::state_preoperational), 127u);
+
+	ASSERT_TRUE(master.SendMessage(nmt(canopen::nmt_type::command_operational, 0)));
+	while(count_state(canopen::nmt_type::state_operational) < 127 && std::chrono::steady_clock::now() < deadline)
+		exchange();
+	EXPECT_EQ(count_state(canopen::nmt_type::state_operational), 127u);
+
+	// Serial numbers hold the node IDs
+	std::vector<std::future<canopen::sdo_result>> reads;
+	for(canopen::id_type id = 1; id < 128; id += 21)
+		reads.push_back(client.read(id, 0x1018, 4));
+	while(!client.idle() && std::chrono::steady_clock::now() < deadline)
+		exchange();
+	for(std::size_t i = 0; i < reads.size(); i++)
+	{
+		auto result = reads[i].get();
+		EXPECT_EQ(result.status, canopen::sdo_status::success);
+		EXPECT_EQ(result.value(), 1 + 21*i);
+	}
+
+	while(tpdos < 127 && std::chrono::steady_clock::now() < deadline)
+		exchange();
+	EXPECT_GE(tpdos, 127u);
+
+	farm.stop();
+	EXPECT_GE(farm.received(), reads.size() + 1);
+	EXPECT_EQ(farm.dropped(), 0u);
+}
@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the CAN packet ring interface
+//
+// Connecting requires CAP_NET_RAW - tests depending on a connection are
+// skipped otherwise.
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <interfaces/include/CANPacketRing.h>
+
+namespace
+{
+	can::Message empty_message()
+	{
+		can_frame frame{};
+		return can::Message(frame);
+	}
+}
+
+TEST(CANPacketRing, request_messages_when_not_connected)
+{
+	can::interfaces::CANPacketRing ring;
+	std::vector<can::Message> messages(4, empty_message());
+
+	EXPECT_FALSE(ring.IsReady());
+	EXPECT_EQ(ring.RequestMessages(messages.data(), messages.size()), 0u);
+	EXPECT_FALSE(ring.RequestMessage(messages[0]));
+}
+
+TEST(CANPacketRing, sending_is_not_supported)
+{
+	can::interfaces::CANPacketRing ring;
+	std::vector<can::Message> messages(4, empty_message());
+
+	EXPECT_FALSE(ring.SendMessage(messages[0]));
+	EXPECT_EQ(ring.SendMessages(messages.data(), messages.size()), 0u);
+}
+
+TEST(CANPacketRing, connect_to_missing_interface_fails)
+{
+	can::interfaces::CANPacketRing ring;
+
+	EXPECT_FALSE(ring.Connect("nosuchcan0"));
+	EXPECT_FALSE(ring.IsReady());
+}
+
+TEST(CANPacketRing, request_times_out_without_traffic)
+{
+	can::interfaces::CANPacketRing ring;
+	if(!ring.Connect("any"))
+		GTEST_SKIP() << "packet sockets are not permitted";
+
+	std::vector<can::Message> messages(4, empty_message());
+	ring.SetBlockingMode(false);
+	ring.SetTimeout(20);
+
+	EXPECT_TRUE(ring.IsReady());
+	EXPECT_EQ(ring.RequestMessages(messages.data(), messages.size()), 0u);
+
+	// Reconnecting requires a disconnect first
+	EXPECT_FALSE(ring.Connect("any"));
+	ring.Disconnect();
+	EXPECT_FALSE(ring.IsReady());
+}
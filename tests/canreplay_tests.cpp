@@ -0,0 +1,149 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the CAN replay interface
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+#include <interfaces/include/CANReplay.h>
+
+namespace
+{
+	std::string temp_path(const std::string& name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	// Writes messages spaced by the given interval (us) to a log file
+	std::string write_log(const std::string& name, can::interfaces::CANLogFile::log_format format, std::size_t count, long interval)
+	{
+		auto path = temp_path(name);
+		std::filesystem::remove(path);
+
+		can::interfaces::CANLogFile file(format);
+		file.Connect(path);
+		for(std::size_t i = 0; i < count; i++)
+		{
+			can::Message message;
+			message.set_id(0x180 + i);
+			message.set_size(1);
+			message[0] = static_cast<uint8_t>(i);
+			message.get_timestamp().tv_sec = 1000 + static_cast<time_t>((i * interval) / 1000000);
+			message.get_timestamp().tv_nsec = static_cast<long>((i * interval) % 1000000) * 1000;
+			file.SendMessage(message);
+		}
+
+		return path;
+	}
+
+	// Replays all messages and returns the elapsed time in milliseconds
+	double replay_all(can::interfaces::CANReplay& replay, std::vector<can::Message>& messages)
+	{
+		auto start = std::chrono::steady_clock::now();
+		can::Message message;
+		while(replay.RequestMessage(message))
+			messages.push_back(message);
+		return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+TEST(CANReplay, not_ready_before_connect)
+{
+	can::interfaces::CANReplay replay;
+	can::Message message;
+
+	EXPECT_FALSE(replay.IsReady());
+	EXPECT_FALSE(replay.RequestMessage(message));
+	EXPECT_EQ(replay.GetFileDescriptor(), -1);
+	EXPECT_FALSE(replay.Connect(temp_path("cantools_replay_missing.log")));
+}
+
+TEST(CANReplay, sending_is_not_supported)
+{
+	auto path = write_log("cantools_replay_send.log", can::interfaces::CANLogFile::log_format::candump, 1, 0);
+	can::interfaces::CANReplay replay;
+	can::Message message;
+
+	ASSERT_TRUE(replay.Connect(path));
+	EXPECT_FALSE(replay.SendMessage(message));
+	EXPECT_EQ(replay.SendMessages(&message, 1), 0u);
+}
+
+// Both log formats are detected from the file contents
+TEST(CANReplay, replays_both_formats_in_order)
+{
+	auto formats = { can::interfaces::CANLogFile::log_format::candump, can::interfaces::CANLogFile::log_format::binary };
+	for(auto format : formats)
+	{
+		auto path = write_log("cantools_replay_order.log", format, 100, 10);
+		can::interfaces::CANReplay replay;
+		replay.SetReplaySpeed(0);
+		ASSERT_TRUE(replay.Connect(path));
+
+		std::vector<can::Message> messages;
+		replay_all(replay, messages);
+
+		ASSERT_EQ(messages.size(), 100u);
+		for(std::size_t i = 0; i < messages.size(); i++)
+		{
+			EXPECT_EQ(messages[i].id(), 0x180 + i);
+			EXPECT_EQ(messages[i][0], static_cast<uint8_t>(i));
+		}
+		EXPECT_EQ(messages[99].get_timestamp().tv_nsec, 990000);
+		EXPECT_EQ(replay.GetStatistics().frames, 100u);
+	}
+}
+
+// Ten messages 5 ms apart take at least 45 ms, and half of that at double speed
+TEST(CANReplay, paces_with_recorded_timing)
+{
+	auto path = write_log("cantools_replay_pacing.log", can::interfaces::CANLogFile::log_format::binary, 10, 5000);
+
+	can::interfaces::CANReplay replay;
+	ASSERT_TRUE(replay.Connect(path));
+	std::vector<can::Message> messages;
+	auto elapsed = replay_all(replay, messages);
+	EXPECT_EQ(messages.size(), 10u);
+	EXPECT_GE(elapsed, 45.0);
+
+	can::interfaces::CANReplay fast;
+	fast.SetReplaySpeed(2.0);
+	ASSERT_TRUE(fast.Connect(path));
+	messages.clear();
+	elapsed = replay_all(fast, messages);
+	EXPECT_EQ(messages.size(), 10u);
+	EXPECT_GE(elapsed, 22.5);
+	EXPECT_LT(elapsed, 45.0);
+
+	// Messages are never handed out before they are due
+	auto statistics = replay.GetStatistics();
+	EXPECT_EQ(statistics.frames, 10u);
+	EXPECT_GE(statistics.min_jitter, 0);
+	EXPECT_GE(statistics.max_jitter, statistics.min_jitter);
+	EXPECT_GE(statistics.mean_jitter, 0.0);
+}
+
+// In non-blocking mode, requests give up after the timeout when the next message is not due
+TEST(CANReplay, non_blocking_request_times_out)
+{
+	auto path = write_log("cantools_replay_timeout.log", can::interfaces::CANLogFile::log_format::candump, 2, 1000000);
+
+	can::interfaces::CANReplay replay;
+	replay.SetBlockingMode(false);
+	replay.SetTimeout(10);
+	ASSERT_TRUE(replay.Connect(path));
+
+	std::array<can::Message,4> messages;
+	EXPECT_EQ(replay.RequestMessages(messages.data(), messages.size()), 1u);
+
+	auto start = std::chrono::steady_clock::now();
+	EXPECT_EQ(replay.RequestMessages(messages.data(), messages.size()), 0u);
+	EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+
+	// Speeding up makes the second message due at once
+	replay.SetReplaySpeed(0);
+	EXPECT_EQ(replay.RequestMessages(messages.data(), messages.size()), 1u);
+	EXPECT_EQ(messages[0].id(), 0x181u);
+}
@@ -0,0 +1,370 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the simulated bus and its interface
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <interfaces/include/CANSimulation.h>
+#include <interfaces/include/interface_table.h>
+
+namespace
+{
+	can::Message make_message(canid_t id, uint8_t size = 8)
+	{
+		can_frame frame{};
+		frame.can_id = id;
+		frame.len = size;
+		for(uint8_t i = 0; i < size; i++)
+			frame.data[i] = static_cast<uint8_t>(id + i);
+		return can::Message(frame);
+	}
+
+	// Receives "count" frames, waiting up to a timeout (in milliseconds) for each
+	std::vector<can::Message> receive(can::interfaces::CANSimulation& interface, std::size_t count, int timeout = 1000)
+	{
+		interface.SetBlockingMode(false);
+		interface.SetTimeout(timeout);
+
+		std::vector<can::Message> messages(count);
+		std::size_t received = 0;
+		while(received < count)
+		{
+			auto result = interface.RequestMessages(messages.data() + received, count - received);
+			if(result == 0)
+				break;
+			received += result;
+		}
+		messages.resize(received);
+		return messages;
+	}
+
+	int64_t microseconds(const timespec& time)
+	{
+		return static_cast<int64_t>(time.tv_sec) * 1000000 + time.tv_nsec / 1000;
+	}
+}
+
+TEST(CANSimulation, requests_when_not_connected)
+{
+	can::interfaces::CANSimulation sim;
+	can::Message message;
+
+	EXPECT_FALSE(sim.IsReady());
+	EXPECT_FALSE(sim.SendMessage(make_message(0x100)));
+	EXPECT_FALSE(sim.RequestMessage(message));
+	EXPECT_EQ(sim.GetFileDescriptor(), -1);
+	EXPECT_EQ(sim.GetBus(), nullptr);
+}
+
+TEST(CANSimulation, connect_validates_names)
+{
+	can::interfaces::CANSimulation sim;
+
+	EXPECT_FALSE(sim.Connect(""));
+	EXPECT_FALSE(sim.Connect("@500000"));
+	EXPECT_FALSE(sim.Connect("sim_names@"));
+	EXPECT_FALSE(sim.Connect("sim_names@fast"));
+	EXPECT_FALSE(sim.Connect("sim_names@0"));
+	EXPECT_TRUE(sim.Connect("sim_names@500000"));
+	EXPECT_FALSE(sim.Connect("sim_names"));	// Already connected
+	EXPECT_EQ(sim.GetBus()->bitrate(), 500000u);
+}
+
+TEST(CANSimulation, bitrates_of_a_bus_must_match)
+{
+	can::interfaces::CANSimulation first;
+	can::interfaces::CANSimulation second;
+	can::interfaces::CANSimulation third;
+
+	ASSERT_TRUE(first.Connect("sim_bitrates@250000"));
+	EXPECT_FALSE(second.Connect("sim_bitrates@500000"));
+	EXPECT_TRUE(second.Connect("sim_bitrates"));
+	EXPECT_TRUE(third.Connect("sim_bitrates@250000"));
+	EXPECT_EQ(first.GetBus(), second.GetBus());
+}
+
+TEST(CANSimulation, frames_reach_all_other_interfaces)
+{
+	can::interfaces::CANSimulation sender;
+	can::interfaces::CANSimulation first;
+	can::interfaces::CANSimulation second;
+	ASSERT_TRUE(sender.Connect("sim_delivery"));
+	ASSERT_TRUE(first.Connect("sim_delivery"));
+	ASSERT_TRUE(second.Connect("sim_delivery"));
+
+	std::vector<can::Message> messages;
+	for(canid_t id = 0x100; id < 0x110; id++)
+		messages.push_back(make_message(id, static_cast<uint8_t>(id % 9)));
+	EXPECT_EQ(sender.SendMessages(messages.data(), messages.size()), messages.size());
+
+	for(auto receiver : { &first, &second })
+	{
+		auto received = receive(*receiver, messages.size());
+		ASSERT_EQ(received.size(), messages.size());
+		for(std::size_t i = 0; i < messages.size(); i++)
+		{
+			EXPECT_EQ(received[i].id(), messages[i].id());
+			EXPECT_EQ(received[i].size(), messages[i].size());
+			EXPECT_EQ(can::interfaces::interface_table::name(received[i].get_interface()), "sim_delivery");
+			EXPECT_NE(received[i].get_timestamp().tv_sec, 0);
+		}
+		EXPECT_EQ(receiver->GetInterfaceStatistics()->counters().frames_received, messages.size());
+	}
+
+	// Not looped back to the sender
+	sender.SetBlockingMode(false);
+	sender.SetTimeout(0);
+	can::Message message;
+	EXPECT_FALSE(sender.RequestMessage(message));
+	EXPECT_EQ(sender.GetInterfaceStatistics()->counters().frames_sent, messages.size());
+	EXPECT_EQ(sender.GetBus()->frames(), messages.size());
+}
+
+TEST(CANSimulation, full_queues_drop_frames)
+{
+	can::interfaces::CANSimulation sender;
+	can::interfaces::CANSimulation receiver;
+	ASSERT_TRUE(sender.Connect("sim_overflow"));
+	ASSERT_TRUE(receiver.Connect("sim_overflow"));
+
+	const std::size_t count = can::interfaces::simulated_bus::queue_size + 100;
+	std::vector<can::Message> messages(count, make_message(0x123));
+	EXPECT_EQ(sender.SendMessages(messages.data(), count), count);
+
+	auto received = receive(receiver, count, 10);
+	EXPECT_EQ(received.size(), can::interfaces::simulated_bus::queue_size);
+	EXPECT_EQ(receiver.GetInterfaceStatistics()->counters().overflow_drops, 100u);
+
+	// Drops are counted per connection
+	receiver.Disconnect();
+	ASSERT_TRUE(receiver.Connect("sim_overflow"));
+	EXPECT_EQ(receive(receiver, 1, 10).size(), 0u);
+	EXPECT_EQ(receiver.GetInterfaceStatistics()->counters().overflow_drops, 0u);
+}
+
+TEST(CANSimulation, blocking_request_waits_for_frames)
+{
+	can::interfaces::CANSimulation sender;
+	can::interfaces::CANSimulation receiver;
+	ASSERT_TRUE(sender.Connect("sim_blocking"));
+	ASSERT_TRUE(receiver.Connect("sim_blocking"));
+	receiver.SetBlockingMode(true);
+
+	std::thread thread([&sender]()
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		sender.SendMessage(make_message(0x42));
+	});
+
+	can::Message message;
+	EXPECT_TRUE(receiver.RequestMessage(message));
+	EXPECT_EQ(message.id(), 0x42u);
+	thread.join();
+}
+
+// Everything sent by one thread is either received by another, or counted as dropped
+TEST(CANSimulation, high_rate_between_threads)
+{
+	can::interfaces::CANSimulation sender;
+	can::interfaces::CANSimulation receiver;
+	ASSERT_TRUE(sender.Connect("sim_rate"));
+	ASSERT_TRUE(receiver.Connect("sim_rate"));
+	receiver.SetBlockingMode(false);
+	receiver.SetTimeout(200);
+
+	const std::size_t count = 1000000;
+	std::thread thread([&sender]()
+	{
+		std::vector<can::Message> batch(64);
+		for(std::size_t sent = 0; sent < count; sent += batch.size())
+		{
+			for(std::size_t i = 0; i < batch.size(); i++)
+				batch[i] = make_message(static_cast<canid_t>((sent + i) & CAN_SFF_MASK));
+			sender.SendMessages(batch.data(), batch.size());
+		}
+	});
+
+	std::vector<can::Message> batch(64);
+	std::size_t received = 0;
+	bool ordered = true;
+	canid_t last = CAN_SFF_MASK;
+	for(;;)
+	{
+		auto result = receiver.RequestMessages(batch.data(), batch.size());
+		if(result == 0)
+			break;
+		for(std::size_t i = 0; i < result; i++)
+		{
+			auto id = batch[i].id();
+			ordered &= (receiver.GetInterfaceStatistics()->counters().overflow_drops > 0 || id == ((last + 1) & CAN_SFF_MASK));
+			last = id;
+		}
+		received += result;
+	}
+	thread.join();
+
+	EXPECT_TRUE(ordered);
+	EXPECT_EQ(received + receiver.GetInterfaceStatistics()->counters().overflow_drops, count);
+}
+
+TEST(simulated_bus, frame_bits)
+{
+	can_frame frame{};
+	frame.can_id = 0x555;	// Alternating bits - stuffing depends on the data and CRC only
+
+	for(uint8_t length = 0; length <= 8; length++)
+	{
+		frame.len = length;
+		auto bits = can::interfaces::simulated_bus::frame_bits(frame);
+		EXPECT_GE(bits, 47u + 8 * length);
+		EXPECT_LE(bits, 47u + 8 * length + (34 + 8 * length - 1) / 4);
+	}
+
+	// Five dominant bits after SOF for identifier 0 force stuff bits
+	can_frame zeros{};
+	EXPECT_GT(can::interfaces::simulated_bus::frame_bits(zeros), 47u);
+
+	// Remote frames carry no data
+	can_frame remote{};
+	remote.can_id = 0x555 | CAN_RTR_FLAG;
+	remote.len = 8;
+	EXPECT_LT(can::interfaces::simulated_bus::frame_bits(remote), 47u + 64);
+
+	can_frame extended{};
+	extended.can_id = 0x15555555 | CAN_EFF_FLAG;
+	EXPECT_GE(can::interfaces::simulated_bus::frame_bits(extended), 67u);
+}
+
+TEST(simulated_bus, fd_frame_bits)
+{
+	canfd_frame frame{};
+	frame.can_id = 0x555;
+	frame.flags = CANFD_FDF;
+
+	// Header, stuff count, CRC-17 with fixed stuff bits, and the fixed bits at the end
+	auto empty = can::interfaces::simulated_bus::frame_bits(frame);
+	EXPECT_GE(empty, 62u);
+	EXPECT_LE(empty, 62u + 5);
+
+	// Payloads are padded to CAN FD lengths, with a CRC-21 above 16 bytes
+	frame.len = 64;
+	auto full = can::interfaces::simulated_bus::frame_bits(frame);
+	EXPECT_GE(full, 579u);
+	frame.len = 63;
+	EXPECT_EQ(can::interfaces::simulated_bus::frame_bits(frame), full);
+}
+
+TEST(CANSimulation, fd_frames)
+{
+	can::interfaces::CANSimulation sender;
+	can::interfaces::CANSimulation receiver;
+	ASSERT_TRUE(sender.Connect("sim_fd@1000000"));
+	ASSERT_TRUE(receiver.Connect("sim_fd"));
+
+	canfd_frame frame{};
+	frame.can_id = 0x123;
+	frame.len = 64;
+	frame.data[63] = 0x42;
+	ASSERT_TRUE(sender.SendMessage(can::Message(frame)));
+
+	auto received = receive(receiver, 1);
+	ASSERT_EQ(received.size(), 1u);
+	EXPECT_TRUE(received[0].is_fd());
+	EXPECT_EQ(received[0].size(), 64);
+	EXPECT_EQ(received[0][63], 0x42);
+	EXPECT_EQ(sender.GetBus()->bits(), can::interfaces::simulated_bus::frame_bits(frame));
+}
+
+// Frames are delivered one frame duration after another
+TEST(simulated_bus, bitrate_paces_frames)
+{
+	can::interfaces::CANSimulation sender;
+	can::interfaces::CANSimulation receiver;
+	ASSERT_TRUE(sender.Connect("sim_timing@1000000"));
+	ASSERT_TRUE(receiver.Connect("sim_timing"));
+
+	std::vector<can::Message> messages;
+	for(canid_t id = 0x100; id < 0x120; id++)
+		messages.push_back(make_message(id));
+	EXPECT_EQ(sender.SendMessages(messages.data(), messages.size()), messages.size());
+
+	auto received = receive(receiver, messages.size());
+	ASSERT_EQ(received.size(), messages.size());
+	for(std::size_t i = 1; i < received.size(); i++)
+	{
+		auto expected = can::interfaces::simulated_bus::frame_bits(received[i].get_frame());	// Microseconds at 1 Mbit/s
+		auto difference = microseconds(received[i].get_timestamp()) - microseconds(received[i - 1].get_timestamp());
+		EXPECT_LE(std::abs(difference - static_cast<int64_t>(expected)), 1);
+	}
+
+	EXPECT_EQ(sender.GetBus()->frames(), messages.size());
+	EXPECT_GE(sender.GetBus()->bits(), 111u * messages.size());
+}
+
+// Waiting frames of several interfaces are arbitrated by identifier, frames of one interface stay in order
+TEST(simulated_bus, arbitration_by_identifier)
+{
+	can::interfaces::CANSimulation first;
+	can::interfaces::CANSimulation second;
+	can::interfaces::CANSimulation third;
+	can::interfaces::CANSimulation receiver;
+	ASSERT_TRUE(first.Connect("sim_arbitration@20000"));
+	ASSERT_TRUE(second.Connect("sim_arbitration"));
+	ASSERT_TRUE(third.Connect("sim_arbitration"));
+	ASSERT_TRUE(receiver.Connect("sim_arbitration"));
+
+	// The bus is busy with the first frame for several milliseconds while the others are queued
+	ASSERT_TRUE(first.SendMessage(make_message(0x7FF)));
+	std::vector<can::Message> queued{ make_message(0x300), make_message(0x050) };
+	ASSERT_EQ(second.SendMessages(queued.data(), queued.size()), queued.size());
+	ASSERT_TRUE(third.SendMessage(make_message(0x100)));
+
+	auto received = receive(receiver, 4);
+	ASSERT_EQ(received.size(), 4u);
+	EXPECT_EQ(received[0].id(), 0x7FFu);
+	EXPECT_EQ(received[1].id(), 0x100u);	// Wins against 0x300, queued first by the other interface
+	EXPECT_EQ(received[2].id(), 0x300u);
+	EXPECT_EQ(received[3].id(), 0x050u);
+}
+
+// A sender faster than the bus finds its transmit queue full, instead of queueing without limit
+TEST(simulated_bus, transmit_queue_pushes_back_on_the_sender)
+{
+	can::interfaces::CANSimulation sender;
+	can::interfaces::CANSimulation other;
+	ASSERT_TRUE(sender.Connect("sim_backlog@10000"));	// About 11 ms per frame
+	ASSERT_TRUE(other.Connect("sim_backlog"));
+	sender.SetTimeout(20);
+
+	const auto limit = can::interfaces::simulated_bus::transmit_queue_size;
+	std::vector<can::Message> messages(4 * limit, make_message(0x100));
+	auto sent = sender.SendMessages(messages.data(), messages.size());
+	EXPECT_GE(sent, limit);
+	EXPECT_LT(sent, limit + 5);
+	EXPECT_EQ(sender.GetInterfaceStatistics()->counters().write_failures, 1u);
+
+	// Every endpoint has its own transmit queue
+	EXPECT_TRUE(other.SendMessage(make_message(0x050)));
+}
+
+// A reused endpoint starts with an empty transmit queue, although frames of the previous connection were still waiting
+TEST(simulated_bus, reused_endpoint_starts_with_empty_transmit_queue)
+{
+	auto bus = can::interfaces::simulated_bus::open("sim_reuse", 10000);	// About 11 ms per frame
+	ASSERT_NE(bus, nullptr);
+
+	const auto limit = can::interfaces::simulated_bus::transmit_queue_size;
+	std::vector<can::Message> messages(limit, make_message(0x100));
+	auto first = bus->attach();
+	ASSERT_NE(first, nullptr);
+	EXPECT_EQ(bus->transmit(*first, messages.data(), messages.size()), limit);
+	bus->detach(first);
+
+	auto second = bus->attach();
+	ASSERT_EQ(second, first);
+	EXPECT_EQ(bus->transmit(*second, messages.data(), messages.size()), limit);
+	bus->detach(second);
+}
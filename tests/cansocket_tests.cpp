@@ -0,0 +1,260 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the CAN socket interface
+//
+// Tests requiring a bus are skipped unless a "vcan0" device exists:
+// sudo ip link add dev vcan0 type vcan
+// sudo ifconfig vcan0 up
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <can/include/canopen.h>
+#include <interfaces/include/CANSocket.h>
+#include <interfaces/include/interface_table.h>
+
+namespace
+{
+	can::Message empty_message()
+	{
+		can_frame frame{};
+		return can::Message(frame);
+	}
+}
+
+TEST(CANSocket, request_messages_when_not_connected)
+{
+	can::interfaces::CANSocket socket;
+	std::vector<can::Message> messages(4, empty_message());
+
+	EXPECT_FALSE(socket.IsReady());
+	EXPECT_EQ(socket.RequestMessages(messages.data(), messages.size()), 0u);
+	EXPECT_FALSE(socket.RequestMessage(messages[0]));
+	EXPECT_EQ(socket.GetInterfaceStatistics()->counters().frames_received, 0u);
+}
+
+TEST(CANSocket, send_messages_when_not_connected)
+{
+	can::interfaces::CANSocket socket;
+	std::vector<can::Message> messages(4, empty_message());
+
+	EXPECT_EQ(socket.SendMessages(messages.data(), messages.size()), 0u);
+	EXPECT_FALSE(socket.SendMessage(messages[0]));
+}
+
+// Filters set before connecting are applied when connecting
+TEST(CANSocket, set_filters_when_not_connected)
+{
+	can::interfaces::CANSocket socket;
+
+	EXPECT_TRUE(socket.SetFilters(canopen::combine(canopen::filter_sdo_response(5), canopen::filter_emcy())));
+	EXPECT_TRUE(socket.SetErrorFilter(CAN_ERR_MASK));
+	EXPECT_TRUE(socket.ClearFilters());
+	EXPECT_FALSE(socket.SetFilters(nullptr, 1));
+}
+
+TEST(CANSocket, connect_to_missing_interface_fails)
+{
+	can::interfaces::CANSocket socket;
+
+	EXPECT_FALSE(socket.Connect("nosuchcan0"));
+	EXPECT_FALSE(socket.IsReady());
+}
+
+TEST(CANSocket, batched_receive_on_vcan)
+{
+	can::interfaces::CANSocket sender;
+	can::interfaces::CANSocket receiver;
+	if(!sender.Connect("vcan0") || !receiver.Connect("vcan0"))
+		GTEST_SKIP() << "vcan0 is not available";
+
+	const std::size_t count = 50;
+	for(std::size_t i = 0; i < count; i++)
+	{
+		can_frame frame{};
+		frame.can_id = 0x100 + i;
+		frame.len = 1;
+		frame.data[0] = static_cast<uint8_t>(i);
+		ASSERT_TRUE(sender.SendMessage(can::Message(frame)));
+	}
+
+	std::vector<can::Message> messages(count, empty_message());
+	std::size_t received = 0;
+	receiver.SetBlockingMode(false);
+	while(received < count)
+	{
+		auto result = receiver.RequestMessages(messages.data() + received, count - received);
+		if(result == 0)
+			break;
+		received += result;
+	}
+
+	ASSERT_EQ(received, count);
+	for(std::size_t i = 0; i < count; i++)
+	{
+		EXPECT_EQ(messages[i].id(), 0x100 + i);
+		EXPECT_EQ(messages[i][0], i);
+		EXPECT_EQ(can::interfaces::interface_table::name(messages[i].get_interface()), "vcan0");
+		EXPECT_NE(messages[i].get_timestamp().tv_sec, 0);
+	}
+
+	auto counters = receiver.GetInterfaceStatistics()->counters();
+	EXPECT_EQ(counters.frames_received, count);
+	EXPECT_EQ(counters.bytes_received, count);
+	EXPECT_EQ(counters.short_reads, 0u);
+	EXPECT_EQ(receiver.GetInterfaceStatistics()->receive_latency.count(), count);
+	EXPECT_EQ(sender.GetInterfaceStatistics()->counters().frames_sent, count);
+}
+
+// Classic and CAN FD frames share the receive batch
+TEST(CANSocket, fd_frames_on_vcan)
+{
+	can::interfaces::CANSocket sender;
+	can::interfaces::CANSocket receiver;
+	if(!sender.Connect("vcan0") || !receiver.Connect("vcan0"))
+		GTEST_SKIP() << "vcan0 is not available";
+
+	canfd_frame fd{};
+	fd.can_id = 0x123;
+	fd.len = 64;
+	fd.flags = CANFD_BRS;
+	fd.data[63] = 0x42;
+	can_frame classic{};
+	classic.can_id = 0x124;
+	classic.len = 8;
+	classic.data[7] = 0x24;
+	std::vector<can::Message> sent{ can::Message(fd), can::Message(classic) };
+	if(sender.SendMessages(sent.data(), sent.size()) != sent.size())
+		GTEST_SKIP() << "vcan0 does not accept CAN FD frames (mtu 72)";
+
+	std::vector<can::Message> messages(2, empty_message());
+	std::size_t received = 0;
+	receiver.SetBlockingMode(false);
+	while(received < messages.size())
+	{
+		auto result = receiver.RequestMessages(messages.data() + received, messages.size() - received);
+		if(result == 0)
+			break;
+		received += result;
+	}
+
+	ASSERT_EQ(received, 2u);
+	EXPECT_TRUE(messages[0].is_fd());
+	EXPECT_EQ(messages[0].size(), 64);
+	EXPECT_EQ(messages[0][63], 0x42);
+	EXPECT_TRUE(messages[0].get_fd_frame().flags & CANFD_BRS);
+	EXPECT_FALSE(messages[1].is_fd());
+	EXPECT_EQ(messages[1][7], 0x24);
+	EXPECT_EQ(receiver.GetInterfaceStatistics()->counters().bytes_received, 72u);
+}
+
+// Receive timestamps are in nanoseconds on CLOCK_REALTIME - vcan has no hardware clock, so requesting it falls back to software
+TEST(CANSocket, timestamps_on_vcan)
+{
+	can::interfaces::CANSocket sender;
+	can::interfaces::CANSocket receiver;
+	receiver.SetHardwareTimestamps(true);
+	if(!sender.Connect("vcan0") || !receiver.Connect("vcan0"))
+		GTEST_SKIP() << "vcan0 is not available";
+
+	auto before = can::clock_nanoseconds(CLOCK_REALTIME);
+	std::vector<can::Message> sent(10, empty_message());
+	ASSERT_EQ(sender.SendMessages(sent.data(), sent.size()), sent.size());
+
+	std::vector<can::Message> messages(sent.size(), empty_message());
+	std::size_t received = 0;
+	receiver.SetBlockingMode(false);
+	while(received < messages.size())
+	{
+		auto result = receiver.RequestMessages(messages.data() + received, messages.size() - received);
+		if(result == 0)
+			break;
+		received += result;
+	}
+	auto after = can::clock_nanoseconds(CLOCK_REALTIME);
+
+	ASSERT_EQ(received, messages.size());
+	for(std::size_t i = 0; i < received; i++)
+	{
+		auto time = can::to_nanoseconds(messages[i].get_timestamp());
+		EXPECT_GE(time, before);
+		EXPECT_LE(time, after);
+		EXPECT_EQ(messages[i].get_timestamp_source(), can::timestamp_source::software);
+		if(i > 0)
+		{
+			EXPECT_GE(time, can::to_nanoseconds(messages[i - 1].get_timestamp()));
+		}
+	}
+	EXPECT_FALSE(receiver.GetHardwareClock().valid());
+}
+
+TEST(CANSocket, batched_send_on_vcan)
+{
+	can::interfaces::CANSocket sender;
+	can::interfaces::CANSocket receiver;
+	if(!sender.Connect("vcan0") || !receiver.Connect("vcan0"))
+		GTEST_SKIP() << "vcan0 is not available";
+
+	// More frames than a single sendmmsg batch
+	const std::size_t count = 100;
+	std::vector<can::Message> messages(count, empty_message());
+	for(std::size_t i = 0; i < count; i++)
+	{
+		messages[i].set_id(0x200 + i);
+		messages[i].set_size(1);
+		messages[i][0] = static_cast<uint8_t>(i);
+	}
+
+	EXPECT_EQ(sender.SendMessages(messages.data(), count), count);
+
+	std::vector<can::Message> received(count, empty_message());
+	std::size_t total = 0;
+	receiver.SetBlockingMode(false);
+	while(total < count)
+	{
+		auto result = receiver.RequestMessages(received.data() + total, count - total);
+		if(result == 0)
+			break;
+		total += result;
+	}
+
+	ASSERT_EQ(total, count);
+	for(std::size_t i = 0; i < count; i++)
+		EXPECT_EQ(received[i].id(), 0x200 + i);
+
+	auto counters = sender.GetInterfaceStatistics()->counters();
+	EXPECT_EQ(counters.frames_sent, count);
+	EXPECT_EQ(counters.bytes_sent, count);
+	EXPECT_GE(counters.send_calls, 2u);
+	EXPECT_EQ(counters.write_failures, 0u);
+}
+
+TEST(CANSocket, kernel_filters_on_vcan)
+{
+	can::interfaces::CANSocket sender;
+	can::interfaces::CANSocket receiver;
+	if(!sender.Connect("vcan0") || !receiver.Connect("vcan0"))
+		GTEST_SKIP() << "vcan0 is not available";
+
+	// Change the filters while connected
+	ASSERT_TRUE(receiver.SetFilters(canopen::combine(canopen::filter_sdo_response(5), canopen::filter_emcy())));
+
+	const canid_t ids[]{ 0x585, 0x586, 0x182, 0x081, 0x705 };
+	for(auto id : ids)
+	{
+		can_frame frame{};
+		frame.can_id = id;
+		ASSERT_TRUE(sender.SendMessage(can::Message(frame)));
+	}
+
+	std::vector<can::Message> messages(5, empty_message());
+	receiver.SetBlockingMode(false);
+	receiver.SetTimeout(50);
+	std::size_t received = 0;
+	while(auto count = receiver.RequestMessages(messages.data() + received, messages.size() - received))
+		received += count;
+
+	ASSERT_EQ(received, 2u);
+	EXPECT_EQ(messages[0].id(), 0x585u);
+	EXPECT_EQ(messages[1].id(), 0x081u);
+}
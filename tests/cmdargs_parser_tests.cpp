@@ -145,3 +145,104 @@ TEST(cmdargs_parser, specify_output_interface_type_and_name2)
 	EXPECT_STREQ(parser.get(utility::cmdargs_parser::values::output_interface_name).c_str(), interface_name.c_str());
 	EXPECT_TRUE(parser.valid());
 }
+
+TEST(cmdargs_parser, specify_other_input_interface_type)
+{
+	const std::string input = "candump";
+	const std::string interface_name = "capture.log";
+	const int argc = 4;
+	const char* argv[argc] { "cantool", "--input", input.c_str(), interface_name.c_str() };
+	utility::cmdargs_parser parser{ argc, argv };
+
+	EXPECT_STREQ(parser.get(utility::cmdargs_parser::values::input_interface_type).c_str(), input.c_str());
+	EXPECT_STREQ(parser.get(utility::cmdargs_parser::values::input_interface_name).c_str(), interface_name.c_str());
+	EXPECT_TRUE(parser.is_set(utility::cmdargs_parser::values::input_interface_type));
+	EXPECT_FALSE(parser.is_set(utility::cmdargs_parser::values::output_interface_type));
+	EXPECT_TRUE(parser.valid());
+}
+
+// The optional interface name must not consume the next option
+TEST(cmdargs_parser, specify_input_and_output_without_names)
+{
+	const int argc = 5;
+	const char* argv[argc] { "cantool", "--input", "candump", "--output", "canlog" };
+	utility::cmdargs_parser parser{ argc, argv };
+
+	EXPECT_STREQ(parser.get(utility::cmdargs_parser::values::input_interface_type).c_str(), "candump");
+	EXPECT_STREQ(parser.get(utility::cmdargs_parser::values::input_interface_name).c_str(), "any");
+	EXPECT_STREQ(parser.get(utility::cmdargs_parser::values::output_interface_type).c_str(), "canlog");
+	EXPECT_STREQ(parser.get(utility::cmdargs_parser::values::output_interface_name).c_str(), "any");
+	EXPECT_TRUE(parser.is_set(utility::cmdargs_parser::values::output_interface_type));
+	EXPECT_TRUE(parser.valid());
+}
+
+TEST(cmdargs_parser, replay_speed_defaults_to_recorded_timing)
+{
+	const int argc = 1;
+	const char* argv[argc] { "cantool" };
+	utility::cmdargs_parser parser{ argc, argv };
+
+	EXPECT_EQ(parser.get(utility::cmdargs_parser::values::replay_speed), "1");
+	EXPECT_FALSE(parser.is_set(utility::cmdargs_parser::values::replay_speed));
+}
+
+TEST(cmdargs_parser, specify_replay_speed)
+{
+	const int argc = 5;
+	const char* argv[argc] { "cantool", "--input", "replay", "--speed", "2.5" };
+	utility::cmdargs_parser parser{ argc, argv };
+
+	EXPECT_EQ(parser.get(utility::cmdargs_parser::values::input_interface_type), "replay");
+	EXPECT_EQ(parser.get(utility::cmdargs_parser::values::input_interface_name), "any");
+	EXPECT_EQ(parser.get(utility::cmdargs_parser::values::replay_speed), "2.5");
+	EXPECT_TRUE(parser.valid());
+}
+
+TEST(cmdargs_parser, require_replay_speed_after_keyword)
+{
+	const int argc = 2;
+	const char* argv[argc] { "cantool", "--speed" };
+	utility::cmdargs_parser parser{ argc, argv };
+
+	EXPECT_FALSE(parser.valid());
+}
+
+TEST(cmdargs_parser, specify_gateway_rules)
+{
+	const int argc = 7;
+	const char* argv[argc] { "cantool", "--input", "can", "can0", "--rules", "0x181=0x281,*=drop", "--output" };
+	utility::cmdargs_parser parser{ argc, argv };
+
+	EXPECT_EQ(parser.get(utility::cmdargs_parser::values::gateway_rules), "0x181=0x281,*=drop");
+	EXPECT_FALSE(parser.valid());	// The output type is missing
+}
+
+TEST(cmdargs_parser, gateway_rules_default_to_none)
+{
+	const int argc = 1;
+	const char* argv[argc] { "cantool" };
+	utility::cmdargs_parser parser{ argc, argv };
+
+	EXPECT_EQ(parser.get(utility::cmdargs_parser::values::gateway_rules), "");
+}
+
+TEST(cmdargs_parser, specify_statistics)
+{
+	const int argc = 7;
+	const char* argv[argc] { "cantool", "--input", "can", "--stats", "5", "--stats-file", "/tmp/cantool.prom" };
+	utility::cmdargs_parser parser{ argc, argv };
+
+	EXPECT_TRUE(parser.valid());
+	EXPECT_EQ(parser.get(utility::cmdargs_parser::values::statistics_interval), "5");
+	EXPECT_EQ(parser.get(utility::cmdargs_parser::values::statistics_file), "/tmp/cantool.prom");
+}
+
+TEST(cmdargs_parser, statistics_default_to_off)
+{
+	const int argc = 1;
+	const char* argv[argc] { "cantool" };
+	utility::cmdargs_parser parser{ argc, argv };
+
+	EXPECT_EQ(parser.get(utility::cmdargs_parser::values::statistics_interval), "0");
+	EXPECT_EQ(parser.get(utility::cmdargs_parser::values::statistics_file), "");
+}
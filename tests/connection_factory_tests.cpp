@@ -8,6 +8,10 @@
 
 #include <interfaces/include/connection_factory.h>
 #include <interfaces/include/CANSocket.h>
+#include <interfaces/include/CANPacketRing.h>
+#include <interfaces/include/CANLogFile.h>
+#include <interfaces/include/CANReplay.h>
+#include <interfaces/include/CANSimulation.h>
 
 TEST(connection_factory, string_bad_interface_specification_returns_nullptr)
 {
@@ -35,3 +39,57 @@ TEST(connection_factory, enum_create_can_socket)
 	EXPECT_TRUE(interface != nullptr);
 	EXPECT_TRUE(dynamic_cast<can::interfaces::CANSocket*>(interface.get()) != nullptr);
 }
+
+TEST(connection_factory, string_create_can_packet_ring)
+{
+	auto interface = can::interfaces::connection_factory::create("can-mmap");
+	EXPECT_TRUE(interface != nullptr);
+	EXPECT_TRUE(dynamic_cast<can::interfaces::CANPacketRing*>(interface.get()) != nullptr);
+}
+
+TEST(connection_factory, enum_create_can_packet_ring)
+{
+	auto interface = can::interfaces::connection_factory::create(can::interfaces::interface_type::socket_can_mmap);
+	EXPECT_TRUE(interface != nullptr);
+	EXPECT_TRUE(dynamic_cast<can::interfaces::CANPacketRing*>(interface.get()) != nullptr);
+}
+
+TEST(connection_factory, string_create_log_files)
+{
+	auto candump = can::interfaces::connection_factory::create("candump");
+	auto canlog = can::interfaces::connection_factory::create("canlog");
+	auto candumpFile = dynamic_cast<can::interfaces::CANLogFile*>(candump.get());
+	auto canlogFile = dynamic_cast<can::interfaces::CANLogFile*>(canlog.get());
+
+	ASSERT_TRUE(candumpFile != nullptr);
+	ASSERT_TRUE(canlogFile != nullptr);
+	EXPECT_EQ(candumpFile->GetFormat(), can::interfaces::CANLogFile::log_format::candump);
+	EXPECT_EQ(canlogFile->GetFormat(), can::interfaces::CANLogFile::log_format::binary);
+}
+
+TEST(connection_factory, enum_create_log_files)
+{
+	auto candump = can::interfaces::connection_factory::create(can::interfaces::interface_type::candump_file);
+	auto canlog = can::interfaces::connection_factory::create(can::interfaces::interface_type::binary_log_file);
+
+	EXPECT_TRUE(dynamic_cast<can::interfaces::CANLogFile*>(candump.get()) != nullptr);
+	EXPECT_TRUE(dynamic_cast<can::interfaces::CANLogFile*>(canlog.get()) != nullptr);
+}
+
+TEST(connection_factory, create_log_replay)
+{
+	auto fromString = can::interfaces::connection_factory::create("replay");
+	auto fromEnum = can::interfaces::connection_factory::create(can::interfaces::interface_type::log_replay);
+
+	EXPECT_TRUE(dynamic_cast<can::interfaces::CANReplay*>(fromString.get()) != nullptr);
+	EXPECT_TRUE(dynamic_cast<can::interfaces::CANReplay*>(fromEnum.get()) != nullptr);
+}
+
+TEST(connection_factory, create_simulation)
+{
+	auto fromString = can::interfaces::connection_factory::create("sim");
+	auto fromEnum = can::interfaces::connection_factory::create(can::interfaces::interface_type::simulation);
+
+	EXPECT_TRUE(dynamic_cast<can::interfaces::CANSimulation*>(fromString.get()) != nullptr);
+	EXPECT_TRUE(dynamic_cast<can::interfaces::CANSimulation*>(fromEnum.get()) != nullptr);
+}
@@ -0,0 +1,197 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the DBC database
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <can/include/dbc.h>
+
+namespace
+{
+	const char* const example_dbc = R"(VERSION ""
+
+NS_ :
+	NS_DESC_
+	CM_
+
+BS_:
+
+BU_: Engine Gateway
+
+BO_ 256 EngineData: 8 Engine
+ SG_ Speed : 0|16@1+ (0.25,0) [0|16383.75] "rpm" Gateway
+ SG_ Temperature : 16|8@1- (1,-40) [-40|215] "degC" Gateway
+ SG_ Pressure : 31|12@0+ (0.5,0) [0|2047.5] "kPa" Gateway
+ SG_ Load : 40|24@1- (1,0) [-8388608|8388607] "%" Gateway
+
+BO_ 2566839550 Diagnostics: 8 Gateway
+ SG_ Mode M : 0|8@1+ (1,0) [0|255] "" Engine
+ SG_ Voltage m1 : 8|16@1+ (0.001,0) [0|65.535] "V" Engine
+ SG_ Current m2 : 8|16@1- (0.01,0) [-327.68|327.67] "A" Engine
+ SG_ Ratio : 32|32@1+ (1,0) [0|1] "" Engine
+
+BO_ 3221225472 VECTOR__INDEPENDENT_SIG_MSG: 0 Vector__XXX
+ SG_ Orphan : 0|8@1+ (1,0) [0|0] "" Vector__XXX
+
+CM_ SG_ 256 Speed "Engine speed,
+BO_ 300 NotAMessage: 8 Engine
+over several lines";
+BA_DEF_ BO_ "GenMsgCycleTime" INT 0 10000;
+SIG_VALTYPE_ 2566839550 Ratio : 1;
+)";
+
+	can::Message make_message(canid_t id, std::initializer_list<uint8_t> data)
+	{
+		can::Message message;
+		message.set_id(id);
+		message.set_size(static_cast<uint8_t>(data.size()));
+		uint8_t i = 0;
+		for(auto byte : data)
+			message[i++] = byte;
+		return message;
+	}
+}
+
+TEST(DBC, parse_messages_and_signals)
+{
+	can::dbc::database database;
+	ASSERT_TRUE(database.parse(example_dbc));
+	EXPECT_EQ(database.skipped(), 0u);
+	ASSERT_EQ(database.messages().size(), 2u);
+
+	const auto* engine = database.find(0x100);
+	ASSERT_NE(engine, nullptr);
+	EXPECT_EQ(engine->name, "EngineData");
+	EXPECT_EQ(engine->size, 8);
+	EXPECT_EQ(engine->transmitter, "Engine");
+	ASSERT_EQ(engine->signals.size(), 4u);
+
+	const auto& pressure = engine->signals[2];
+	EXPECT_EQ(pressure.name, "Pressure");
+	EXPECT_EQ(pressure.start, 31);
+	EXPECT_EQ(pressure.length, 12);
+	EXPECT_EQ(pressure.order, can::byte_order::big_endian);
+	EXPECT_FALSE(pressure.is_signed);
+	EXPECT_DOUBLE_EQ(pressure.factor, 0.5);
+	EXPECT_DOUBLE_EQ(pressure.maximum, 2047.5);
+	EXPECT_EQ(pressure.unit, "kPa");
+	EXPECT_TRUE(engine->signals[1].is_signed);
+
+	// Bit 31 of the DBC ID marks an extended ID
+	const auto* diagnostics = database.find("Diagnostics");
+	ASSERT_NE(diagnostics, nullptr);
+	EXPECT_EQ(diagnostics->id, 0x18FEDCFEu | CAN_EFF_FLAG);
+	EXPECT_EQ(database.find(0x18FEDCFEu | CAN_EFF_FLAG), diagnostics);
+	EXPECT_EQ(diagnostics->signals[0].mux, can::dbc::multiplexing::multiplexor);
+	EXPECT_EQ(diagnostics->signals[2].mux, can::dbc::multiplexing::multiplexed);
+	EXPECT_EQ(diagnostics->signals[2].mux_value, 2u);
+	EXPECT_EQ(diagnostics->signals[3].type, can::dbc::value_type::float32);
+
+	// Statements inside comments are ignored
+	EXPECT_EQ(database.find(300), nullptr);
+	EXPECT_EQ(database.find(0x18FEDCFE), nullptr);
+}
+
+TEST(DBC, skip_invalid_statements)
+{
+	can::dbc::database database;
+	EXPECT_FALSE(database.parse("BO_ 1 Valid: 8 Node\n SG_ A : 0|8@1+ (1,0) [0|0] \"\" X\n SG_ B : 60|8@1+ (1,0) [0|0] \"\" X\n SG_ C : 0|8@2+ (1,0) [0|0] \"\" X\nBO_ x Invalid: 8 Node\n"));
+	EXPECT_EQ(database.skipped(), 3u);
+	ASSERT_NE(database.find(1), nullptr);
+	EXPECT_EQ(database.find(1)->signals.size(), 1u);
+}
+
+// Float value types are only valid for signals of exactly 32 (float) or 64 (double) bits
+TEST(DBC, float_types_need_matching_length)
+{
+	can::dbc::database database;
+	EXPECT_FALSE(database.parse("BO_ 1 Values: 8 Node\n SG_ Short : 0|16@1+ (1,0) [0|0] \"\" X\n SG_ Single : 0|32@1+ (1,0) [0|0] \"\" X\n SG_ Double : 0|64@1+ (1,0) [0|0] \"\" X\n"
+		"SIG_VALTYPE_ 1 Short : 1;\nSIG_VALTYPE_ 1 Single : 2;\nSIG_VALTYPE_ 1 Double : 2;\n"));
+	EXPECT_EQ(database.skipped(), 2u);
+
+	auto m = database.find(1);
+	ASSERT_NE(m, nullptr);
+	ASSERT_EQ(m->signals.size(), 3u);
+	EXPECT_EQ(m->signals[0].type, can::dbc::value_type::integer);
+	EXPECT_EQ(m->signals[1].type, can::dbc::value_type::integer);
+	EXPECT_EQ(m->signals[2].type, can::dbc::value_type::float64);
+}
+
+TEST(DBC, decode_physical_values)
+{
+	can::dbc::database database;
+	ASSERT_TRUE(database.parse(example_dbc));
+
+	// Speed 0x1F40 * 0.25, temperature -2 - 40, pressure 0x7D0 * 0.5 in Motorola order, load -5
+	auto message = make_message(0x100, { 0x40, 0x1F, 0xFE, 0x7D, 0x00, 0xFB, 0xFF, 0xFF });
+	double values[4]{};
+	ASSERT_EQ(database.decode(message, values), 4u);
+	EXPECT_DOUBLE_EQ(values[0], 2000.0);
+	EXPECT_DOUBLE_EQ(values[1], -42.0);
+	EXPECT_DOUBLE_EQ(values[2], 1000.0);
+	EXPECT_DOUBLE_EQ(values[3], -5.0);
+
+	// Unknown IDs, frames shorter than the message, and remote frames are not decoded
+	EXPECT_EQ(database.decode(make_message(0x101, { 0, 0, 0, 0, 0, 0, 0, 0 }), values), 0u);
+	EXPECT_EQ(database.decode(make_message(0x100, { 0, 0, 0, 0 }), values), 0u);
+	EXPECT_EQ(database.decode(make_message(0x100 | CAN_RTR_FLAG, { 0, 0, 0, 0, 0, 0, 0, 0 }), values), 0u);
+}
+
+TEST(DBC, decode_multiplexed_and_float_signals)
+{
+	can::dbc::database database;
+	ASSERT_TRUE(database.parse(example_dbc));
+
+	float ratio = 0.75f;
+	uint8_t bits[4];
+	std::memcpy(bits, &ratio, sizeof(bits));
+
+	auto message = make_message(0x18FEDCFE | CAN_EFF_FLAG, { 2, 0x9C, 0xFF, 0, bits[0], bits[1], bits[2], bits[3] });
+	double values[4]{};
+	ASSERT_EQ(database.decode(message, values), 4u);
+	EXPECT_DOUBLE_EQ(values[0], 2.0);
+	EXPECT_TRUE(std::isnan(values[1]));
+	EXPECT_NEAR(values[2], -1.0, 1e-9);
+	EXPECT_DOUBLE_EQ(values[3], 0.75);
+
+	message[0] = 1;
+	ASSERT_EQ(database.decode(message, values), 4u);
+	EXPECT_NEAR(values[1], 65.436, 1e-9);
+	EXPECT_TRUE(std::isnan(values[2]));
+}
+
+TEST(DBC, later_messages_replace_earlier_ones)
+{
+	can::dbc::database database;
+	ASSERT_TRUE(database.parse("BO_ 10 First: 8 Node\n SG_ A : 0|8@1+ (1,0) [0|0] \"\" X\n"));
+	ASSERT_TRUE(database.parse("BO_ 10 Second: 1 Node\n SG_ B : 0|8@1+ (2,0) [0|0] \"\" X\n"));
+
+	EXPECT_EQ(database.find(10)->name, "Second");
+	double value = 0;
+	ASSERT_EQ(database.decode(make_message(10, { 21 }), &value), 1u);
+	EXPECT_DOUBLE_EQ(value, 42.0);
+
+	database.clear();
+	EXPECT_EQ(database.find(10), nullptr);
+	EXPECT_TRUE(database.messages().empty());
+}
+
+TEST(DBC, load_file)
+{
+	auto path = (std::filesystem::temp_directory_path() / "cantools_dbc_test.dbc").string();
+	{
+		std::ofstream file(path);
+		file << example_dbc;
+	}
+
+	can::dbc::database database;
+	EXPECT_TRUE(database.load(path));
+	EXPECT_EQ(database.messages().size(), 2u);
+	std::filesystem::remove(path);
+
+	EXPECT_FALSE(database.load(path));
+}
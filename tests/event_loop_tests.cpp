@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the event loop
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <map>
+#include <vector>
+
+#include <interfaces/include/event_loop.h>
+
+#include "fake_interface.h"
+
+namespace
+{
+	can::Message message(canid_t id)
+	{
+		can_frame frame{};
+		frame.can_id = id;
+		return can::Message(frame);
+	}
+}
+
+TEST(event_loop, requires_file_descriptor_and_handler)
+{
+	can::interfaces::event_loop loop;
+	tests::fake_interface interface;
+
+	EXPECT_FALSE(loop.add(interface, nullptr));
+
+	interface.Disconnect();
+	EXPECT_FALSE(loop.add(interface, [](auto&, auto, auto) {}));
+	EXPECT_EQ(loop.size(), 0u);
+}
+
+TEST(event_loop, registration_switches_to_non_blocking)
+{
+	can::interfaces::event_loop loop;
+	tests::fake_interface interface;
+
+	EXPECT_TRUE(loop.add(interface, [](auto&, auto, auto) {}));
+	EXPECT_FALSE(interface.blocking());
+	EXPECT_EQ(interface.timeout(), 0);
+	EXPECT_EQ(loop.size(), 1u);
+
+	EXPECT_TRUE(loop.remove(interface));
+	EXPECT_FALSE(loop.remove(interface));
+	EXPECT_EQ(loop.size(), 0u);
+}
+
+TEST(event_loop, times_out_without_messages)
+{
+	can::interfaces::event_loop loop;
+	tests::fake_interface interface;
+	loop.add(interface, [](auto&, auto, auto) { FAIL(); });
+
+	EXPECT_EQ(loop.run_once(10), 0u);
+}
+
+TEST(event_loop, dispatches_to_the_handler_of_each_interface)
+{
+	can::interfaces::event_loop loop;
+	std::vector<std::unique_ptr<tests::fake_interface>> interfaces;
+	std::map<can::interfaces::ICANInterface*,std::vector<canid_t>> received;
+
+	for(int i = 0; i < 8; i++)
+	{
+		interfaces.push_back(std::make_unique<tests::fake_interface>());
+		loop.add(*interfaces.back(), [&received](auto& interface, auto messages, auto count)
+		{
+			for(std::size_t j = 0; j < count; j++)
+				received[&interface].push_back(messages[j].id());
+		});
+	}
+
+	for(std::size_t i = 0; i < interfaces.size(); i++)
+		for(canid_t id = 0; id < 10; id++)
+			interfaces[i]->queue(message(0x100 * i + id));
+
+	EXPECT_EQ(loop.run_once(100), 80u);
+	for(std::size_t i = 0; i < interfaces.size(); i++)
+	{
+		auto& ids = received[interfaces[i].get()];
+		ASSERT_EQ(ids.size(), 10u);
+		for(canid_t id = 0; id < 10; id++)
+			EXPECT_EQ(ids[id], 0x100 * i + id);
+	}
+
+	// Messages arriving later trigger a new edge
+	interfaces[3]->queue(message(0x7FF));
+	EXPECT_EQ(loop.run_once(100), 1u);
+	EXPECT_EQ(received[interfaces[3].get()].back(), 0x7FFu);
+}
+
+// A busy interface is drained over several rounds, without blocking the others
+TEST(event_loop, busy_interface_does_not_starve_others)
+{
+	can::interfaces::event_loop loop;
+	tests::fake_interface busy;
+	tests::fake_interface quiet;
+	std::size_t busyCount = 0;
+	std::size_t quietCount = 0;
+
+	loop.add(busy, [&busyCount](auto&, auto, auto count) { busyCount += count; });
+	loop.add(quiet, [&quietCount](auto&, auto, auto count) { quietCount += count; });
+
+	for(int i = 0; i < 5000; i++)
+		busy.queue(message(0x1));
+	quiet.queue(message(0x2));
+
+	loop.run_once(100);
+	EXPECT_LT(busyCount, 5000u);
+	EXPECT_EQ(quietCount, 1u);
+
+	// Remaining messages are dispatched without new edges
+	while(busyCount < 5000 && loop.run_once(0) > 0) {}
+	EXPECT_EQ(busyCount, 5000u);
+}
+
+TEST(event_loop, stop_from_handler)
+{
+	can::interfaces::event_loop loop;
+	tests::fake_interface interface;
+	loop.add(interface, [&loop](auto&, auto, auto) { loop.stop(); });
+
+	interface.queue(message(0x1));
+	loop.run();
+	SUCCEED();
+}
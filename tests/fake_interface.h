@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////
+// Fake CAN interface for tests
+//
+// Delivers queued messages on request and records sent messages. An
+// eventfd signals queued messages, so the fake can be waited upon.
+///////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <interfaces/include/ICANInterface.h>
+
+namespace tests
+{
+	class fake_interface : public can::interfaces::ICANInterface
+	{
+		private:
+			mutable std::mutex _mutex;
+			std::deque<can::Message> _incoming;
+			std::vector<can::Message> _sent;
+			bool _connected = true;
+			bool _blocking = true;
+			int _timeout = 0;
+			int _event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+		public:
+			fake_interface() = default;
+			~fake_interface() { close(_event); }
+
+			fake_interface(const fake_interface&) = delete;
+			fake_interface& operator=(const fake_interface&) = delete;
+
+			// Queues a message for the next request
+			void queue(const can::Message& message)
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_incoming.push_back(message);
+
+				uint64_t one = 1;
+				write(_event, &one, sizeof(one));
+			}
+
+			std::vector<can::Message> sent() const
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				return _sent;
+			}
+
+			int timeout() const { return _timeout; }
+			bool blocking() const { return _blocking; }
+
+			// ICANInterface interface
+			bool SendMessage(const can::Message& message) override
+			{
+				return (SendMessages(&message, 1) == 1);
+			}
+
+			std::size_t SendMessages(const can::Message* messages, std::size_t count) override
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_sent.insert(_sent.end(), messages, messages + count);
+				return count;
+			}
+
+			bool RequestMessage(can::Message& message) override
+			{
+				return (RequestMessages(&message, 1) == 1);
+			}
+
+			std::size_t RequestMessages(can::Message* messages, std::size_t count) override
+			{
+				std::size_t received = 0;
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					while(received < count && !_incoming.empty())
+					{
+						messages[received++] = _incoming.front();
+						_incoming.pop_front();
+					}
+
+					// Reset the event once everything has been read
+					uint64_t value;
+					if(_incoming.empty())
+						read(_event, &value, sizeof(value));
+				}
+
+				// Emulate waiting for data
+				if(received == 0 && _timeout > 0)
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+				return received;
+			}
+
+			bool Connect(const std::string&) override { _connected = true; return true; }
+			void Disconnect() override { _connected = false; }
+			bool IsReady() const override { return _connected; }
+			int GetFileDescriptor() const override { return _connected ? _event : -1; }
+			void SetTimeout(int timeout) override { _timeout = timeout; }
+			void SetBlockingMode(bool blocking) override { _blocking = blocking; }
+	};
+}
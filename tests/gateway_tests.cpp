@@ -0,0 +1,162 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the gateway
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <linux/can/error.h>
+#include <thread>
+
+#include <interfaces/include/gateway.h>
+
+#include "fake_interface.h"
+
+namespace
+{
+	can::Message make_message(uint32_t id, uint8_t value)
+	{
+		can::Message message;
+		message.set_id(id);
+		message.set_size(1);
+		message[0] = value;
+		return message;
+	}
+
+	// Output interface rejecting everything
+	class full_interface : public tests::fake_interface
+	{
+		public:
+			std::size_t SendMessages(const can::Message*, std::size_t) override { return 0; }
+	};
+}
+
+TEST(gateway, forwards_everything_by_default)
+{
+	tests::fake_interface input, output;
+	can::interfaces::gateway gateway(input, output);
+
+	for(uint8_t i = 0; i < 10; i++)
+		input.queue(make_message(0x100 + i, i));
+	input.queue(make_message(0x12345678 | CAN_EFF_FLAG, 10));
+
+	EXPECT_EQ(gateway.forward_all(), 11u);
+	auto sent = output.sent();
+	ASSERT_EQ(sent.size(), 11u);
+	EXPECT_EQ(sent[3].id(), 0x103u);
+	EXPECT_EQ(sent[3][0], 3);
+	EXPECT_EQ(sent[10].id(), 0x12345678u | CAN_EFF_FLAG);
+	EXPECT_EQ(gateway.received(), 11u);
+	EXPECT_EQ(gateway.forwarded(), 11u);
+	EXPECT_EQ(gateway.dropped(), 0u);
+	EXPECT_EQ(gateway.failed(), 0u);
+}
+
+TEST(gateway, drops_and_rewrites_by_id)
+{
+	tests::fake_interface input, output;
+	can::interfaces::gateway gateway(input, output);
+	gateway.drop(0x701);
+	gateway.rewrite(0x181, 0x281);
+	gateway.rewrite(0x182, 0x1ABCDE);	// Rewritten to an extended ID
+	gateway.drop(0x1000);
+
+	input.queue(make_message(0x701, 0));
+	input.queue(make_message(0x181, 1));
+	input.queue(make_message(0x182 | CAN_RTR_FLAG, 2));
+	input.queue(make_message(0x1000 | CAN_EFF_FLAG, 3));
+	input.queue(make_message(0x183, 4));
+	input.queue(make_message(CAN_ERR_FLAG | CAN_ERR_BUSOFF, 5));
+
+	EXPECT_EQ(gateway.forward_once(), 6u);
+	auto sent = output.sent();
+	ASSERT_EQ(sent.size(), 3u);
+	EXPECT_EQ(sent[0].id(), 0x281u);
+	EXPECT_EQ(sent[0][0], 1);
+	EXPECT_EQ(sent[1].id(), 0x1ABCDEu | CAN_EFF_FLAG | CAN_RTR_FLAG);
+	EXPECT_EQ(sent[2].id(), 0x183u);
+	EXPECT_EQ(gateway.forwarded(), 3u);
+	EXPECT_EQ(gateway.dropped(), 3u);
+}
+
+// Rules keep their route when the default changes
+TEST(gateway, default_route_applies_to_ids_without_rules)
+{
+	tests::fake_interface input, output;
+	can::interfaces::gateway gateway(input, output);
+	gateway.forward(0x181);
+	gateway.forward(0x10000);
+	gateway.set_default(false);
+
+	input.queue(make_message(0x181, 0));
+	input.queue(make_message(0x182, 1));
+	input.queue(make_message(0x10000 | CAN_EFF_FLAG, 2));
+	input.queue(make_message(0x10001 | CAN_EFF_FLAG, 3));
+	gateway.forward_all();
+
+	auto sent = output.sent();
+	ASSERT_EQ(sent.size(), 2u);
+	EXPECT_EQ(sent[0].id(), 0x181u);
+	EXPECT_EQ(sent[1].id(), 0x10000u | CAN_EFF_FLAG);
+
+	gateway.clear_rules();
+	input.queue(make_message(0x182, 1));
+	gateway.forward_all();
+	EXPECT_EQ(output.sent().size(), 3u);
+}
+
+TEST(gateway, parse_rules)
+{
+	tests::fake_interface input, output;
+	can::interfaces::gateway gateway(input, output);
+	EXPECT_TRUE(gateway.parse_rules(""));
+	EXPECT_FALSE(gateway.parse_rules("0x181"));
+	EXPECT_FALSE(gateway.parse_rules("0x181=nowhere"));
+	EXPECT_FALSE(gateway.parse_rules("*=0x100"));
+	EXPECT_FALSE(gateway.parse_rules("0x181=pass,0x20000000=drop"));
+	ASSERT_TRUE(gateway.parse_rules("0x181=0x281,386=pass,*=drop"));
+
+	input.queue(make_message(0x181, 0));
+	input.queue(make_message(0x182, 1));
+	input.queue(make_message(0x183, 2));
+	gateway.forward_all();
+
+	auto sent = output.sent();
+	ASSERT_EQ(sent.size(), 2u);
+	EXPECT_EQ(sent[0].id(), 0x281u);
+	EXPECT_EQ(sent[1].id(), 0x182u);
+	EXPECT_EQ(gateway.dropped(), 1u);
+	EXPECT_EQ(gateway.failed(), 0u);
+}
+
+TEST(gateway, counts_messages_rejected_by_the_output)
+{
+	tests::fake_interface input;
+	full_interface output;
+	can::interfaces::gateway gateway(input, output);
+
+	input.queue(make_message(0x181, 0));
+	input.queue(make_message(0x182, 1));
+	gateway.forward_all();
+
+	EXPECT_EQ(gateway.received(), 2u);
+	EXPECT_EQ(gateway.forwarded(), 0u);
+	EXPECT_EQ(gateway.dropped(), 2u);
+	EXPECT_EQ(gateway.failed(), 2u);
+}
+
+TEST(gateway, runs_until_stopped)
+{
+	tests::fake_interface input, output;
+	can::interfaces::gateway gateway(input, output, 5);
+
+	std::thread thread([&gateway]() { gateway.run(); });
+	input.queue(make_message(0x181, 0));
+	while(gateway.forwarded() == 0)
+		std::this_thread::yield();
+
+	gateway.stop();
+	thread.join();
+	EXPECT_FALSE(gateway.running());
+	EXPECT_FALSE(input.blocking());
+	EXPECT_EQ(input.timeout(), 5);
+	EXPECT_EQ(output.sent().size(), 1u);
+}
@@ -0,0 +1,215 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the interface statistics and their reporting
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <interfaces/include/statistics_reporter.h>
+
+#include "fake_interface.h"
+
+namespace
+{
+	using can::interfaces::latency_histogram;
+
+	// The fake interface, keeping statistics
+	class counting_interface : public tests::fake_interface
+	{
+		public:
+			can::interfaces::interface_statistics statistics;
+
+			const can::interfaces::interface_statistics* GetInterfaceStatistics() const override { return &statistics; }
+	};
+
+	std::string read_file(const std::filesystem::path& path)
+	{
+		std::ifstream file(path);
+		std::stringstream text;
+		text << file.rdbuf();
+		return text.str();
+	}
+}
+
+TEST(latency_histogram, small_values_are_exact)
+{
+	for(uint64_t value = 0; value < 64; value++)
+	{
+		auto index = latency_histogram::bucket_index(value);
+		EXPECT_EQ(latency_histogram::bucket_lower(index), value);
+		EXPECT_EQ(latency_histogram::bucket_upper(index), value);
+	}
+}
+
+TEST(latency_histogram, buckets_cover_values)
+{
+	for(uint64_t value : { 64ull, 65ull, 100ull, 1000ull, 4095ull, 4096ull, 123456789ull, (1ull << 40) - 1 })
+	{
+		auto index = latency_histogram::bucket_index(value);
+		EXPECT_LE(latency_histogram::bucket_lower(index), value);
+		EXPECT_GE(latency_histogram::bucket_upper(index), value);
+
+		// Resolution within about 3%
+		EXPECT_LE(latency_histogram::bucket_upper(index) - latency_histogram::bucket_lower(index), value / 32);
+	}
+
+	// Buckets follow each other without gaps
+	for(std::size_t i = 1; i < latency_histogram::bucket_count; i++)
+		EXPECT_EQ(latency_histogram::bucket_lower(i), latency_histogram::bucket_upper(i - 1) + 1);
+
+	EXPECT_EQ(latency_histogram::bucket_index(1ull << 40), latency_histogram::bucket_count - 1);
+	EXPECT_EQ(latency_histogram::bucket_index(~0ull), latency_histogram::bucket_count - 1);
+}
+
+TEST(latency_histogram, percentiles)
+{
+	latency_histogram histogram;
+	EXPECT_EQ(histogram.percentile(50), 0u);
+
+	for(uint64_t value = 1; value <= 100; value++)
+		histogram.record(value * 1000);
+
+	EXPECT_EQ(histogram.count(), 100u);
+	EXPECT_EQ(histogram.sum(), 5050000u);
+	EXPECT_EQ(histogram.max(), 100000u);
+
+	auto p50 = histogram.percentile(50);
+	EXPECT_GE(p50, 50000u);
+	EXPECT_LE(p50, 50000u * 33 / 32);
+	EXPECT_GE(histogram.percentile(100), 100000u);
+	EXPECT_LE(histogram.percentile(100), 100000u * 33 / 32);
+	EXPECT_EQ(histogram.percentile(0), latency_histogram::bucket_upper(latency_histogram::bucket_index(1000)));
+}
+
+TEST(interface_statistics, record_received_counts_frames_and_bytes)
+{
+	can::interfaces::interface_statistics statistics;
+	std::vector<can::Message> messages(3);
+	for(auto& message : messages)
+	{
+		message.set_size(4);
+		clock_gettime(CLOCK_REALTIME, &message.get_timestamp());
+	}
+
+	statistics.record_received(messages.data(), messages.size());
+	statistics.record_received(messages.data(), 0);
+
+	auto counters = statistics.counters();
+	EXPECT_EQ(counters.frames_received, 3u);
+	EXPECT_EQ(counters.bytes_received, 12u);
+	EXPECT_EQ(statistics.receive_latency.count(), 3u);
+	EXPECT_LT(statistics.receive_latency.max(), 1000000000u);
+}
+
+TEST(interface_statistics, format_statistics_line)
+{
+	can::interfaces::interface_statistics statistics;
+	auto previous = statistics.sample();
+	previous.time = 0;
+
+	statistics.frames_received.add(2000);
+	statistics.bytes_received.add(16000);
+	statistics.frames_sent.add(100);
+	statistics.overflow_drops.set(7);
+	statistics.receive_latency.record(10000);
+	auto current = statistics.sample();
+	current.time = 2000000000;
+
+	auto line = can::interfaces::format_statistics_line("can0", current, previous);
+	EXPECT_EQ(line.rfind("can0: rx 1000 fr/s 8.0 kB/s, tx 50 fr/s 0.0 kB/s", 0), 0u) << line;
+	EXPECT_NE(line.find("drops 7"), std::string::npos) << line;
+	EXPECT_NE(line.find("latency us p50 10.2"), std::string::npos) << line;
+
+	// No latencies without frames in the interval
+	line = can::interfaces::format_statistics_line("can0", current, current);
+	EXPECT_EQ(line.find("latency"), std::string::npos) << line;
+}
+
+TEST(interface_statistics, format_prometheus)
+{
+	can::interfaces::interface_statistics statistics;
+	statistics.frames_received.add(42);
+	statistics.receive_latency.record(3000);		// 3 us
+	statistics.receive_latency.record(2000000);	// 2 ms
+
+	auto text = can::interfaces::format_prometheus({ { "can0", statistics.sample() }, { "can1", {} } });
+	EXPECT_NE(text.find("# TYPE cantools_frames_received_total counter\n"), std::string::npos);
+	EXPECT_NE(text.find("cantools_frames_received_total{interface=\"can0\"} 42\n"), std::string::npos);
+	EXPECT_NE(text.find("cantools_frames_received_total{interface=\"can1\"} 0\n"), std::string::npos);
+	EXPECT_NE(text.find("# TYPE cantools_receive_latency_seconds histogram\n"), std::string::npos);
+	EXPECT_NE(text.find("cantools_receive_latency_seconds_bucket{interface=\"can0\",le=\"1e-06\"} 0\n"), std::string::npos);
+	EXPECT_NE(text.find("cantools_receive_latency_seconds_bucket{interface=\"can0\",le=\"5e-06\"} 1\n"), std::string::npos);
+	EXPECT_NE(text.find("cantools_receive_latency_seconds_bucket{interface=\"can0\",le=\"0.0025\"} 2\n"), std::string::npos);
+	EXPECT_NE(text.find("cantools_receive_latency_seconds_bucket{interface=\"can0\",le=\"+Inf\"} 2\n"), std::string::npos);
+	EXPECT_NE(text.find("cantools_receive_latency_seconds_count{interface=\"can0\"} 2\n"), std::string::npos);
+}
+
+// The total of a scrape agrees with its buckets, even if the separate count was read before a value was added
+TEST(interface_statistics, format_prometheus_counts_buckets)
+{
+	can::interfaces::interface_statistics statistics;
+	statistics.receive_latency.record(3000);
+	statistics.receive_latency.record(20000000000);	// 20 s, above the largest bound
+	auto sample = statistics.sample();
+	sample.latency_count = 1;
+
+	auto text = can::interfaces::format_prometheus({ { "can0", sample } });
+	EXPECT_NE(text.find("cantools_receive_latency_seconds_bucket{interface=\"can0\",le=\"+Inf\"} 2\n"), std::string::npos) << text;
+	EXPECT_NE(text.find("cantools_receive_latency_seconds_count{interface=\"can0\"} 2\n"), std::string::npos) << text;
+}
+
+TEST(statistics_reporter, interfaces_without_statistics_are_not_added)
+{
+	tests::fake_interface interface;
+	can::interfaces::statistics_reporter reporter(std::chrono::milliseconds(10));
+
+	EXPECT_EQ(interface.GetInterfaceStatistics(), nullptr);
+	EXPECT_FALSE(reporter.add("fake", interface));
+}
+
+TEST(statistics_reporter, report_writes_lines_and_file)
+{
+	auto path = std::filesystem::temp_directory_path() / "cantool_statistics_test.prom";
+	std::filesystem::remove(path);
+
+	counting_interface interface;
+	std::ostringstream output;
+	can::interfaces::statistics_reporter reporter(std::chrono::milliseconds(10));
+	ASSERT_TRUE(reporter.add("vcan0", interface));
+	reporter.set_output(&output);
+	reporter.set_file(path.string());
+
+	interface.statistics.frames_sent.add(5);
+	EXPECT_TRUE(reporter.report());
+
+	EXPECT_EQ(output.str().rfind("vcan0: rx 0 fr/s", 0), 0u) << output.str();
+	EXPECT_NE(read_file(path).find("cantools_frames_sent_total{interface=\"vcan0\"} 5\n"), std::string::npos);
+	EXPECT_FALSE(std::filesystem::exists(path.string() + ".tmp"));
+
+	std::filesystem::remove(path);
+}
+
+TEST(statistics_reporter, reports_periodically_until_stopped)
+{
+	counting_interface interface;
+	std::ostringstream output;
+	can::interfaces::statistics_reporter reporter(std::chrono::milliseconds(5));
+	ASSERT_TRUE(reporter.add("vcan0", interface));
+	reporter.set_output(&output);
+
+	EXPECT_FALSE(can::interfaces::statistics_reporter(std::chrono::milliseconds(0)).start());
+	ASSERT_TRUE(reporter.start());
+	EXPECT_FALSE(reporter.start());
+	std::this_thread::sleep_for(std::chrono::milliseconds(30));
+	reporter.stop();
+
+	// At least one periodic report, and the last one when stopping
+	std::size_t lines = 0;
+	for(auto c : output.str())
+		lines += (c == '\n') ? 1 : 0;
+	EXPECT_GE(lines, 2u);
+
+	reporter.stop();
+}
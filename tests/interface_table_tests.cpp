@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the interface table
+//
+// The interface table translates between the interface indices stored
+// in messages and interface names.
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <net/if.h>
+
+#include <interfaces/include/interface_table.h>
+
+TEST(interface_table, any_is_index_zero)
+{
+	EXPECT_EQ(can::interfaces::interface_table::index("any"), 0);
+	EXPECT_EQ(can::interfaces::interface_table::name(0), "any");
+}
+
+TEST(interface_table, kernel_interface_uses_kernel_index)
+{
+	auto index = static_cast<int>(if_nametoindex("lo"));
+	if(index == 0)
+		GTEST_SKIP() << "no loopback interface";
+
+	EXPECT_EQ(can::interfaces::interface_table::index("lo"), index);
+	EXPECT_EQ(can::interfaces::interface_table::name(index), "lo");
+}
+
+TEST(interface_table, unknown_name_gets_stable_synthetic_index)
+{
+	auto index = can::interfaces::interface_table::index("logcan7");
+
+	EXPECT_GE(index, can::interfaces::interface_table::synthetic_index_base);
+	EXPECT_EQ(can::interfaces::interface_table::index("logcan7"), index);
+	EXPECT_EQ(can::interfaces::interface_table::name(index), "logcan7");
+	EXPECT_NE(can::interfaces::interface_table::index("logcan8"), index);
+}
+
+TEST(interface_table, unknown_index_has_unknown_name)
+{
+	EXPECT_EQ(can::interfaces::interface_table::name(can::interfaces::interface_table::synthetic_index_base - 1), "unknown");
+}
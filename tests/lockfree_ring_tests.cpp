@@ -0,0 +1,144 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the lock-free ring buffer
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <can/include/Message.h>
+#include <utility/include/lockfree_ring.h>
+
+TEST(lockfree_ring, pop_from_empty_ring)
+{
+	utility::spsc_ring<int,4> ring;
+	int value = 0;
+
+	EXPECT_TRUE(ring.empty());
+	EXPECT_FALSE(ring.pop(value));
+}
+
+TEST(lockfree_ring, values_are_popped_in_order)
+{
+	utility::spsc_ring<int,8> ring;
+	for(int i = 0; i < 5; i++)
+		EXPECT_TRUE(ring.push(i));
+
+	EXPECT_EQ(ring.size(), 5u);
+	for(int i = 0; i < 5; i++)
+	{
+		int value = -1;
+		EXPECT_TRUE(ring.pop(value));
+		EXPECT_EQ(value, i);
+	}
+	EXPECT_TRUE(ring.empty());
+}
+
+TEST(lockfree_ring, full_ring_drops_new_values)
+{
+	utility::spsc_ring<int,4> ring;
+	const int values[6]{ 0, 1, 2, 3, 4, 5 };
+
+	EXPECT_EQ(ring.push(values, 6), 4u);
+	EXPECT_EQ(ring.dropped(), 2u);
+	EXPECT_EQ(ring.overwritten(), 0u);
+
+	int popped[4];
+	ASSERT_EQ(ring.pop(popped, 4), 4u);
+	for(int i = 0; i < 4; i++)
+		EXPECT_EQ(popped[i], i);
+}
+
+TEST(lockfree_ring, full_ring_overwrites_oldest_values)
+{
+	utility::spsc_ring<int,4,utility::ring_overflow::overwrite> ring;
+	const int values[6]{ 0, 1, 2, 3, 4, 5 };
+
+	EXPECT_EQ(ring.push(values, 6), 6u);
+	EXPECT_EQ(ring.dropped(), 0u);
+	EXPECT_EQ(ring.overwritten(), 2u);
+
+	int popped[4];
+	ASSERT_EQ(ring.pop(popped, 4), 4u);
+	for(int i = 0; i < 4; i++)
+		EXPECT_EQ(popped[i], i + 2);
+}
+
+TEST(lockfree_ring, ring_of_messages)
+{
+	utility::spsc_ring<can::Message,4> ring;
+	can_frame frame{};
+	frame.can_id = 0x123;
+
+	EXPECT_TRUE(ring.push(can::Message(frame)));
+
+	can::Message msg;
+	EXPECT_TRUE(ring.pop(msg));
+	EXPECT_EQ(msg.id(), 0x123u);
+}
+
+TEST(lockfree_ring, spsc_transfer_between_threads)
+{
+	auto ring = std::make_unique<utility::spsc_ring<uint64_t,64>>();
+	const uint64_t count = 100000;
+
+	std::thread producer([&]()
+	{
+		for(uint64_t i = 0; i < count; i++)
+			while(!ring->push(i))
+				std::this_thread::yield();
+	});
+
+	uint64_t expected = 0;
+	while(expected < count)
+	{
+		uint64_t value;
+		if(ring->pop(value))
+			ASSERT_EQ(value, expected++);
+		else
+			std::this_thread::yield();
+	}
+	producer.join();
+}
+
+TEST(lockfree_ring, mpsc_transfer_between_threads)
+{
+	auto ring = std::make_unique<utility::mpsc_ring<uint64_t,256>>();
+	const uint64_t producers = 4;
+	const uint64_t count = 20000;
+
+	// Each producer tags its values, so per-producer order can be checked
+	std::vector<std::thread> threads;
+	for(uint64_t p = 0; p < producers; p++)
+	{
+		threads.emplace_back([&ring, p, count]()
+		{
+			for(uint64_t i = 0; i < count; i++)
+				while(!ring->push((p << 32) | i))
+					std::this_thread::yield();
+		});
+	}
+
+	std::vector<uint64_t> next(producers, 0);
+	uint64_t total = 0;
+	while(total < producers * count)
+	{
+		uint64_t value;
+		if(!ring->pop(value))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		auto p = value >> 32;
+		ASSERT_LT(p, producers);
+		ASSERT_EQ(value & 0xFFFFFFFF, next[p]);
+		next[p]++;
+		total++;
+	}
+
+	for(auto& thread : threads)
+		thread.join();
+	EXPECT_TRUE(ring->empty());
+}
@@ -0,0 +1,306 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the binary log writer and reader
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include <interfaces/include/interface_table.h>
+#include <logging/include/binary_log_reader.h>
+#include <logging/include/binary_log_writer.h>
+
+namespace
+{
+	// Spans several blocks
+	const uint64_t message_count = 10000;
+
+	// Messages 1 ms apart, cycling through 16 IDs
+	can::Message test_message(uint64_t i, int interface)
+	{
+		can_frame frame{};
+		frame.can_id = 0x180 + (i % 16);
+		frame.len = static_cast<uint8_t>(i % 9);
+		for(int j = 0; j < frame.len; j++)
+			frame.data[j] = static_cast<uint8_t>(i + j);
+
+		can::Message message(frame);
+		message.set_interface(interface);
+		message.get_timestamp().tv_sec = 1000 + static_cast<time_t>(i / 1000);
+		message.get_timestamp().tv_nsec = static_cast<long>((i % 1000) * 1000000 + 17);
+		return message;
+	}
+
+	// Number of bytes used by the first "count" records
+	uint64_t records_size(uint64_t count)
+	{
+		uint64_t size = 0;
+		for(uint64_t i = 0; i < count; i++)
+			size += can::logging::binary_log::record_size(test_message(i, 0).size());
+		return size;
+	}
+
+	uint64_t timestamp_ns(uint64_t i)
+	{
+		return 1000000000000ull + i * 1000000ull + 17;	// Nanoseconds are kept
+	}
+
+	class binary_log : public ::testing::Test
+	{
+		protected:
+			std::string path = (std::filesystem::temp_directory_path() / "cantools_binary_log_test.bin").string();
+			int interface = can::interfaces::interface_table::index("logtest0");
+
+			void write_log(bool complete = true)
+			{
+				can::logging::binary_log_writer writer;
+				ASSERT_TRUE(writer.open(path));
+				for(uint64_t i = 0; i < message_count; i++)
+					ASSERT_TRUE(writer.write(test_message(i, interface)));
+				ASSERT_TRUE(writer.close());
+
+				// Cut the log in the middle of the last record, as if the writer crashed
+				if(!complete)
+				{
+					can::logging::binary_log_reader reader;
+					ASSERT_TRUE(reader.open(path));
+					auto recordsEnd = reader.size();
+					reader.close();
+
+					std::filesystem::resize_file(path, sizeof(can::logging::binary_log::file_header) + records_size(recordsEnd) - 5);
+				}
+			}
+
+			// Overwrites part of the log, e.g. to corrupt the footer
+			template <typename T>
+			void patch(uint64_t offset, const T& value)
+			{
+				std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+				file.seekp(static_cast<std::streamoff>(offset));
+				file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+			}
+
+			can::logging::binary_log::footer read_footer()
+			{
+				can::logging::binary_log::footer footer{};
+				std::ifstream file(path, std::ios::binary);
+				file.seekg(-static_cast<std::streamoff>(sizeof(footer)), std::ios::end);
+				file.read(reinterpret_cast<char*>(&footer), sizeof(footer));
+				return footer;
+			}
+
+			// Reads all messages, checking them against the written messages
+			void expect_all_messages(can::logging::binary_log_reader& reader)
+			{
+				can::Message message;
+				uint64_t count = 0;
+				while(reader.read(message))
+				{
+					ASSERT_LT(count, message_count);
+					ASSERT_EQ(message.id(), test_message(count, interface).id());
+					ASSERT_EQ(message.size(), test_message(count, interface).size());
+					count++;
+				}
+				EXPECT_EQ(count, message_count);
+			}
+
+			void TearDown() override
+			{
+				std::filesystem::remove(path);
+			}
+	};
+}
+
+TEST_F(binary_log, open_missing_file_fails)
+{
+	can::logging::binary_log_reader reader;
+	EXPECT_FALSE(reader.open(path));
+	EXPECT_FALSE(reader.is_open());
+}
+
+TEST_F(binary_log, write_without_open_fails)
+{
+	can::logging::binary_log_writer writer;
+	EXPECT_FALSE(writer.write(test_message(0, interface)));
+	EXPECT_FALSE(writer.close());
+}
+
+TEST_F(binary_log, read_back_all_messages)
+{
+	write_log();
+
+	can::logging::binary_log_reader reader;
+	ASSERT_TRUE(reader.open(path));
+	EXPECT_TRUE(reader.indexed());
+	EXPECT_EQ(reader.size(), message_count);
+	EXPECT_EQ(reader.first_timestamp(), timestamp_ns(0));
+	EXPECT_EQ(reader.last_timestamp(), timestamp_ns(message_count - 1));
+
+	for(uint64_t i = 0; i < message_count; i++)
+	{
+		can::Message message;
+		ASSERT_TRUE(reader.read(message));
+
+		auto expected = test_message(i, interface);
+		ASSERT_EQ(message.id(), expected.id());
+		ASSERT_EQ(message.size(), expected.size());
+		for(int j = 0; j < message.size(); j++)
+			ASSERT_EQ(message[j], expected[j]);
+		ASSERT_EQ(message.get_interface(), interface);
+		ASSERT_EQ(message.get_timestamp().tv_sec, expected.get_timestamp().tv_sec);
+		ASSERT_EQ(message.get_timestamp().tv_nsec, expected.get_timestamp().tv_nsec);
+	}
+
+	can::Message message;
+	EXPECT_FALSE(reader.read(message));
+}
+
+TEST_F(binary_log, seek_to_timestamp)
+{
+	write_log();
+
+	can::logging::binary_log_reader reader;
+	ASSERT_TRUE(reader.open(path));
+
+	// Between two messages - the later one is read first
+	ASSERT_TRUE(reader.seek(timestamp_ns(7321) - 1));
+	can::Message message;
+	ASSERT_TRUE(reader.read(message));
+	EXPECT_EQ(message.get_timestamp().tv_sec, 1007);
+	EXPECT_EQ(message.get_timestamp().tv_nsec, 321000017);
+
+	EXPECT_FALSE(reader.seek(timestamp_ns(message_count)));
+	EXPECT_FALSE(reader.read(message));
+
+	reader.rewind();
+	ASSERT_TRUE(reader.read(message));
+	EXPECT_EQ(message.get_timestamp().tv_sec, 1000);
+	EXPECT_EQ(message.get_timestamp().tv_nsec, 17);
+}
+
+TEST_F(binary_log, filter_by_id)
+{
+	write_log();
+
+	can::logging::binary_log_reader reader;
+	ASSERT_TRUE(reader.open(path));
+	reader.set_filter({ 0x185, 0x18F });
+
+	std::vector<can::Message> messages(message_count);
+	auto count = reader.read(messages.data(), messages.size());
+	EXPECT_EQ(count, message_count / 8);
+	for(std::size_t i = 0; i < count; i++)
+		EXPECT_TRUE(messages[i].id() == 0x185 || messages[i].id() == 0x18F);
+
+	// IDs not in the log skip all blocks
+	reader.set_filter({ 0x700 });
+	reader.rewind();
+	EXPECT_EQ(reader.read(messages.data(), messages.size()), 0u);
+}
+
+TEST_F(binary_log, read_log_without_footer)
+{
+	write_log(false);
+
+	can::logging::binary_log_reader reader;
+	ASSERT_TRUE(reader.open(path));
+	EXPECT_FALSE(reader.indexed());
+	EXPECT_EQ(reader.size(), message_count - 1);
+
+	ASSERT_TRUE(reader.seek(timestamp_ns(5000)));
+	can::Message message;
+	ASSERT_TRUE(reader.read(message));
+	EXPECT_EQ(message.id(), test_message(5000, interface).id());
+}
+
+// Footers pointing outside the file are ignored, and the records scanned instead
+TEST_F(binary_log, corrupted_footer)
+{
+	write_log();
+	auto footer = read_footer();
+	auto footerOffset = std::filesystem::file_size(path) - sizeof(footer);
+
+	// A count whose size overflows
+	patch(footerOffset + offsetof(can::logging::binary_log::footer, index_count), uint64_t{ 1 } << 59);
+	{
+		can::logging::binary_log_reader reader;
+		ASSERT_TRUE(reader.open(path));
+		EXPECT_FALSE(reader.indexed());
+		EXPECT_EQ(reader.size(), message_count);
+		expect_all_messages(reader);
+	}
+	patch(footerOffset, footer);
+
+	// A block beyond the end of the records
+	auto entryOffset = footer.index_offset + sizeof(can::logging::binary_log::index_entry);
+	patch(entryOffset + offsetof(can::logging::binary_log::index_entry, offset), footer.index_offset + 8);
+	{
+		can::logging::binary_log_reader reader;
+		ASSERT_TRUE(reader.open(path));
+		EXPECT_FALSE(reader.indexed());
+		expect_all_messages(reader);
+	}
+}
+
+// Blocks not ending on a record boundary are detected while reading, and the records scanned instead
+TEST_F(binary_log, corrupted_index_entry)
+{
+	write_log();
+	auto footer = read_footer();
+
+	can::logging::binary_log::index_entry entry;
+	{
+		std::ifstream file(path, std::ios::binary);
+		file.seekg(static_cast<std::streamoff>(footer.index_offset));
+		file.read(reinterpret_cast<char*>(&entry), sizeof(entry));
+	}
+	entry.size -= 8;
+	patch(footer.index_offset, entry);
+
+	can::logging::binary_log_reader reader;
+	ASSERT_TRUE(reader.open(path));
+	EXPECT_TRUE(reader.indexed());
+	expect_all_messages(reader);
+	EXPECT_FALSE(reader.indexed());
+}
+
+TEST_F(binary_log, fd_frames)
+{
+	{
+		can::logging::binary_log_writer writer;
+		ASSERT_TRUE(writer.open(path));
+		for(uint8_t length : { 0, 12, 64 })
+		{
+			canfd_frame frame{};
+			frame.can_id = 0x100u + length;
+			frame.len = length;
+			frame.flags = CANFD_BRS;
+			for(int j = 0; j < length; j++)
+				frame.data[j] = static_cast<uint8_t>(j + 1);
+			ASSERT_TRUE(writer.write(can::Message(frame)));
+		}
+		ASSERT_TRUE(writer.write(test_message(8, interface)));
+		ASSERT_TRUE(writer.close());
+	}
+
+	can::logging::binary_log_reader reader;
+	ASSERT_TRUE(reader.open(path));
+	can::Message message;
+	for(uint8_t length : { 0, 12, 64 })
+	{
+		ASSERT_TRUE(reader.read(message));
+		EXPECT_TRUE(message.is_fd());
+		EXPECT_EQ(message.get_fd_frame().flags, CANFD_BRS | CANFD_FDF);
+		EXPECT_EQ(message.id(), 0x100u + length);
+		ASSERT_EQ(message.size(), length);
+		if(length > 0)
+		{
+			EXPECT_EQ(message[length - 1], length);
+		}
+	}
+
+	ASSERT_TRUE(reader.read(message));
+	EXPECT_FALSE(message.is_fd());
+	EXPECT_EQ(message.size(), 8);
+}
@@ -0,0 +1,226 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the candump log format
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <interfaces/include/interface_table.h>
+#include <logging/include/candump.h>
+#include <logging/include/candump_reader.h>
+#include <logging/include/candump_writer.h>
+
+namespace
+{
+	bool parse(const std::string& line, can::Message& message)
+	{
+		can::logging::candump::interface_names names;
+		return can::logging::candump::parse_line(line.data(), line.data() + line.size(), message, names);
+	}
+
+	std::string format(const can::Message& message)
+	{
+		can::logging::candump::interface_names names;
+		char line[can::logging::candump::max_line_length];
+		auto length = can::logging::candump::format_line(message, names, line);
+		return std::string(line, length);
+	}
+}
+
+TEST(candump, decode_hex)
+{
+	const char text[] = "0123456789abcdefABCDEF00";
+	uint8_t bytes[12]{};
+
+	ASSERT_TRUE(can::logging::candump::decode_hex(text, 12, bytes));
+	const uint8_t expected[12]{ 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0xAB, 0xCD, 0xEF, 0x00 };
+	for(int i = 0; i < 12; i++)
+		EXPECT_EQ(bytes[i], expected[i]);
+}
+
+TEST(candump, decode_invalid_hex)
+{
+	uint8_t bytes[8]{};
+
+	// Invalid characters in the vectorised and in the scalar part
+	EXPECT_FALSE(can::logging::candump::decode_hex("0123456789abcdeg", 8, bytes));
+	EXPECT_FALSE(can::logging::candump::decode_hex("01234567 9abcdef", 8, bytes));
+	EXPECT_FALSE(can::logging::candump::decode_hex("0x", 1, bytes));
+	EXPECT_FALSE(can::logging::candump::decode_hex("G0", 1, bytes));
+	EXPECT_FALSE(can::logging::candump::decode_hex("\xC0""0123456789abcde", 8, bytes));
+}
+
+TEST(candump, parse_standard_frame)
+{
+	can::Message message;
+	ASSERT_TRUE(parse("(1436509052.249713) vcan0 123#DEADBEEF", message));
+
+	EXPECT_EQ(message.id(), 0x123u);
+	EXPECT_EQ(message.size(), 4);
+	EXPECT_EQ(message[0], 0xDE);
+	EXPECT_EQ(message[3], 0xEF);
+	EXPECT_EQ(message.get_timestamp().tv_sec, 1436509052);
+	EXPECT_EQ(message.get_timestamp().tv_nsec, 249713000);
+	EXPECT_EQ(can::interfaces::interface_table::name(message.get_interface()), "vcan0");
+}
+
+TEST(candump, parse_extended_frame)
+{
+	can::Message message;
+	ASSERT_TRUE(parse("(0000000001.000001) can1 1ABCDEF0#0011223344556677", message));
+
+	EXPECT_EQ(message.id(), 0x1ABCDEF0u | CAN_EFF_FLAG);
+	EXPECT_EQ(message.size(), 8);
+	EXPECT_EQ(message[7], 0x77);
+}
+
+TEST(candump, parse_remote_and_error_frames)
+{
+	can::Message message;
+	ASSERT_TRUE(parse("(1.0) can0 123#R", message));
+	EXPECT_EQ(message.id(), 0x123u | CAN_RTR_FLAG);
+	EXPECT_EQ(message.size(), 0);
+
+	ASSERT_TRUE(parse("(1.0) can0 123#R4", message));
+	EXPECT_EQ(message.size(), 4);
+
+	ASSERT_TRUE(parse("(1.0) can0 20000080#0000000000000000", message));
+	EXPECT_EQ(message.id(), 0x80u | CAN_ERR_FLAG);
+}
+
+TEST(candump, parse_empty_and_separated_data)
+{
+	can::Message message;
+	ASSERT_TRUE(parse("(1.5) can0 7FF#\r", message));
+	EXPECT_EQ(message.size(), 0);
+	EXPECT_EQ(message.get_timestamp().tv_nsec, 500000000);
+
+	ASSERT_TRUE(parse("(1.0) can0 100#11.22.33", message));
+	EXPECT_EQ(message.size(), 3);
+	EXPECT_EQ(message[2], 0x33);
+}
+
+TEST(candump, parse_invalid_lines)
+{
+	can::Message message;
+	EXPECT_FALSE(parse("", message));
+	EXPECT_FALSE(parse("# comment", message));
+	EXPECT_FALSE(parse("(1.0) can0", message));
+	EXPECT_FALSE(parse("(1.0) can0 12#00", message));
+	EXPECT_FALSE(parse("(1.0) can0 123#001", message));
+	EXPECT_FALSE(parse("(1.0) can0 123#001122334455667788", message));
+	EXPECT_FALSE(parse("(1.0) can0 123#R9", message));
+	EXPECT_FALSE(parse("1.0 can0 123#00", message));
+}
+
+TEST(candump, format_frames)
+{
+	can_frame frame{};
+	frame.can_id = 0x1A;
+	frame.len = 3;
+	frame.data[0] = 0x01;
+	frame.data[1] = 0xAB;
+	frame.data[2] = 0xFF;
+	can::Message message(frame);
+	message.set_interface(can::interfaces::interface_table::index("vcan3"));
+	message.get_timestamp().tv_sec = 12;
+	message.get_timestamp().tv_nsec = 3400999;	// Cut to microseconds
+
+	EXPECT_EQ(format(message), "(0000000012.003400) vcan3 01A#01ABFF\n");
+
+	message.set_id(0x12345 | CAN_EFF_FLAG);
+	EXPECT_EQ(format(message), "(0000000012.003400) vcan3 00012345#01ABFF\n");
+
+	message.set_id(0x7FF | CAN_RTR_FLAG);
+	EXPECT_EQ(format(message), "(0000000012.003400) vcan3 7FF#R3\n");
+}
+
+TEST(candump, parse_and_format_fd_frames)
+{
+	can::Message message;
+	std::string data;
+	for(int i = 0; i < 64; i++)
+		data += "A5";
+
+	ASSERT_TRUE(parse("(1.000000) can0 123##1" + data, message));
+	EXPECT_TRUE(message.is_fd());
+	EXPECT_EQ(message.get_fd_frame().flags, CANFD_BRS | CANFD_FDF);
+	EXPECT_EQ(message.size(), 64);
+	EXPECT_EQ(message[63], 0xA5);
+	EXPECT_EQ(format(message), "(0000000001.000000) can0 123##1" + data + "\n");
+
+	ASSERT_TRUE(parse("(1.0) can0 123##0", message));
+	EXPECT_TRUE(message.is_fd());
+	EXPECT_EQ(message.size(), 0);
+
+	EXPECT_FALSE(parse("(1.0) can0 123##", message));
+	EXPECT_FALSE(parse("(1.0) can0 123##X00", message));
+	EXPECT_FALSE(parse("(1.0) can0 123##1R", message));
+	EXPECT_FALSE(parse("(1.0) can0 123##1" + data + "00", message));
+
+	// Only lengths of a DLC: 0-8, 12, 16, 20, 24, 32, 48 and 64
+	ASSERT_TRUE(parse("(1.0) can0 123##1" + data.substr(0, 2 * 12), message));
+	EXPECT_EQ(message.size(), 12);
+	ASSERT_TRUE(parse("(1.0) can0 123##1" + data.substr(0, 2 * 48), message));
+	EXPECT_EQ(message.size(), 48);
+	EXPECT_FALSE(parse("(1.0) can0 123##1" + data.substr(0, 2 * 9), message));
+	EXPECT_FALSE(parse("(1.0) can0 123##1" + data.substr(0, 2 * 33), message));
+	EXPECT_FALSE(parse("(1.0) can0 123##1" + data.substr(0, 2 * 63), message));
+	EXPECT_FALSE(parse("(1.0) can0 123##1A5.A5.A5.A5.A5.A5.A5.A5.A5.A5", message));
+}
+
+TEST(candump, format_and_parse_round_trip)
+{
+	can::Message message;
+	const std::string line = "(1436509052.249713) vcan0 1F334455#1122334455667788";
+	ASSERT_TRUE(parse(line, message));
+	EXPECT_EQ(format(message), line + "\n");
+}
+
+TEST(candump, write_and_read_file)
+{
+	auto path = (std::filesystem::temp_directory_path() / "cantools_candump_test.log").string();
+	const uint32_t count = 5000;
+
+	{
+		can::logging::candump_writer writer;
+		ASSERT_TRUE(writer.open(path));
+		for(uint32_t i = 0; i < count; i++)
+		{
+			can_frame frame{};
+			frame.can_id = i & CAN_SFF_MASK;
+			frame.len = i % 9;
+			std::memset(frame.data, static_cast<int>(i & 0xFF), frame.len);
+			can::Message message(frame);
+			message.get_timestamp().tv_sec = i;
+			ASSERT_TRUE(writer.write(message));
+		}
+		ASSERT_TRUE(writer.close());
+	}
+
+	// Lines which are not frames are skipped
+	{
+		std::ofstream file(path, std::ios::app);
+		file << "\n# not a frame\n";
+	}
+
+	can::logging::candump_reader reader;
+	ASSERT_TRUE(reader.open(path));
+	for(uint32_t i = 0; i < count; i++)
+	{
+		can::Message message;
+		ASSERT_TRUE(reader.read(message));
+		ASSERT_EQ(message.id(), i & CAN_SFF_MASK);
+		ASSERT_EQ(message.size(), i % 9);
+		ASSERT_EQ(message.get_timestamp().tv_sec, static_cast<time_t>(i));
+	}
+
+	can::Message message;
+	EXPECT_FALSE(reader.read(message));
+	EXPECT_EQ(reader.skipped(), 1u);
+
+	reader.close();
+	std::filesystem::remove(path);
+}
@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the CAN message
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstring>
+
+#include <can/include/Message.h>
+
+TEST(Message, default_constructed_message_is_empty)
+{
+	can::Message msg;
+
+	EXPECT_EQ(msg.id(), 0u);
+	EXPECT_EQ(msg.size(), 0);
+	EXPECT_EQ(msg.get_interface(), 0);
+	EXPECT_EQ(msg.get_timestamp().tv_sec, 0);
+	EXPECT_EQ(msg.get_timestamp().tv_nsec, 0);
+	EXPECT_EQ(msg.get_timestamp_source(), can::timestamp_source::software);
+}
+
+TEST(Message, construct_from_frame)
+{
+	can_frame frame{};
+	frame.can_id = 0x181;
+	frame.len = 2;
+	frame.data[0] = 0xAB;
+	frame.data[1] = 0xCD;
+
+	can::Message msg(frame);
+
+	EXPECT_EQ(msg.id(), 0x181u);
+	EXPECT_EQ(msg.id_short(), 0x01);
+	EXPECT_EQ(msg.size(), 2);
+	EXPECT_EQ(msg[0], 0xAB);
+	EXPECT_EQ(msg[1], 0xCD);
+}
+
+// Messages must be copyable as plain memory, e.g. into ring buffers
+TEST(Message, copy_with_memcpy)
+{
+	can_frame frame{};
+	frame.can_id = 0x7FF;
+	frame.len = 1;
+	frame.data[0] = 0x42;
+
+	std::array<can::Message,2> messages{ can::Message(frame), can::Message() };
+	messages[0].set_interface(3);
+	messages[0].get_timestamp().tv_sec = 12;
+	std::memcpy(&messages[1], &messages[0], sizeof(can::Message));
+
+	EXPECT_EQ(messages[1].id(), 0x7FFu);
+	EXPECT_EQ(messages[1][0], 0x42);
+	EXPECT_EQ(messages[1].get_interface(), 3);
+	EXPECT_EQ(messages[1].get_timestamp().tv_sec, 12);
+}
+
+TEST(Message, construct_from_fd_frame)
+{
+	canfd_frame frame{};
+	frame.can_id = 0x123;
+	frame.len = 64;
+	frame.flags = CANFD_BRS;
+	frame.data[63] = 0x5A;
+
+	can::Message msg(frame);
+
+	EXPECT_TRUE(msg.is_fd());
+	EXPECT_EQ(msg.get_fd_frame().flags, CANFD_BRS | CANFD_FDF);
+	EXPECT_EQ(msg.size(), 64);
+	EXPECT_EQ(msg.max_size(), 64);
+	EXPECT_EQ(msg.mtu(), CANFD_MTU);
+	EXPECT_EQ(msg[63], 0x5A);
+	EXPECT_EQ(msg.get_frame().can_id, 0x123u);
+
+	// Classic frames hold up to 8 bytes
+	msg.set_fd(false);
+	EXPECT_FALSE(msg.is_fd());
+	EXPECT_EQ(msg.size(), 8);
+	EXPECT_EQ(msg.mtu(), CAN_MTU);
+	EXPECT_EQ(&msg[63], &msg[7]);
+
+	can_frame classic{};
+	classic.len = 8;
+	EXPECT_FALSE(can::Message(classic).is_fd());
+}
+
+TEST(Message, fd_lengths)
+{
+	EXPECT_EQ(can::fd_length(0), 0);
+	EXPECT_EQ(can::fd_length(8), 8);
+	EXPECT_EQ(can::fd_length(9), 12);
+	EXPECT_EQ(can::fd_length(24), 24);
+	EXPECT_EQ(can::fd_length(25), 32);
+	EXPECT_EQ(can::fd_length(33), 48);
+	EXPECT_EQ(can::fd_length(49), 64);
+}
@@ -0,0 +1,146 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the receive thread
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <thread>
+
+#include <interfaces/include/CANLogFile.h>
+#include <interfaces/include/receive_thread.h>
+#include <utility/include/lockfree_ring.h>
+
+#include "fake_interface.h"
+
+namespace
+{
+	using ring_type = utility::mpsc_ring<can::Message,1024>;
+
+	can::Message message(canid_t id)
+	{
+		can_frame frame{};
+		frame.can_id = id;
+		return can::Message(frame);
+	}
+
+	// Log file counting the requests for messages
+	class counting_log_file : public can::interfaces::CANLogFile
+	{
+		public:
+			std::atomic<std::size_t> requests{ 0 };
+
+			counting_log_file() : can::interfaces::CANLogFile(log_format::candump) {}
+
+			std::size_t RequestMessages(can::Message* messages, std::size_t count) override
+			{
+				requests++;
+				return can::interfaces::CANLogFile::RequestMessages(messages, count);
+			}
+	};
+
+	// Pops "count" messages from the ring, giving up after a second
+	std::size_t drain(ring_type& ring, can::Message* messages, std::size_t count)
+	{
+		std::size_t popped = 0;
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+		while(popped < count && std::chrono::steady_clock::now() < deadline)
+			popped += ring.pop(messages + popped, count - popped);
+		return popped;
+	}
+}
+
+TEST(receive_thread, forwards_messages_to_ring)
+{
+	tests::fake_interface interface;
+	auto ring = std::make_unique<ring_type>();
+	can::interfaces::receive_thread<ring_type> receiver(interface, *ring);
+
+	for(canid_t id = 0; id < 200; id++)
+		interface.queue(message(id));
+
+	ASSERT_TRUE(receiver.start());
+	EXPECT_FALSE(interface.blocking());
+
+	can::Message messages[200];
+	ASSERT_EQ(drain(*ring, messages, 200), 200u);
+	for(canid_t id = 0; id < 200; id++)
+		EXPECT_EQ(messages[id].id(), id);
+
+	receiver.stop();
+	EXPECT_FALSE(receiver.running());
+	EXPECT_EQ(receiver.received(), 200u);
+}
+
+TEST(receive_thread, several_threads_share_a_ring)
+{
+	tests::fake_interface interface1;
+	tests::fake_interface interface2;
+	auto ring = std::make_unique<ring_type>();
+	can::interfaces::receive_thread<ring_type> receiver1(interface1, *ring);
+	can::interfaces::receive_thread<ring_type> receiver2(interface2, *ring);
+
+	for(canid_t id = 0; id < 100; id++)
+	{
+		interface1.queue(message(id));
+		interface2.queue(message(0x400 + id));
+	}
+
+	ASSERT_TRUE(receiver1.start());
+	ASSERT_TRUE(receiver2.start());
+
+	can::Message messages[200];
+	EXPECT_EQ(drain(*ring, messages, 200), 200u);
+}
+
+TEST(receive_thread, does_not_start_twice)
+{
+	tests::fake_interface interface;
+	auto ring = std::make_unique<ring_type>();
+	can::interfaces::receive_thread<ring_type> receiver(interface, *ring);
+
+	EXPECT_TRUE(receiver.start());
+	EXPECT_FALSE(receiver.start());
+	EXPECT_TRUE(receiver.running());
+}
+
+TEST(receive_thread, does_not_start_without_connection)
+{
+	tests::fake_interface interface;
+	auto ring = std::make_unique<ring_type>();
+	can::interfaces::receive_thread<ring_type> receiver(interface, *ring);
+
+	interface.Disconnect();
+	EXPECT_FALSE(receiver.start());
+}
+
+// At the end of a log file, requests return at once - the thread must wait between them instead of spinning
+TEST(receive_thread, waits_at_end_of_log_file)
+{
+	auto path = (std::filesystem::temp_directory_path() / "cantools_receive_thread_test.log").string();
+	{
+		can::interfaces::CANLogFile writer(can::interfaces::CANLogFile::log_format::candump);
+		ASSERT_TRUE(writer.Connect(path));
+		for(canid_t id = 0; id < 10; id++)
+			ASSERT_TRUE(writer.SendMessage(message(id)));
+	}
+
+	counting_log_file file;
+	ASSERT_TRUE(file.Connect(path));
+	auto ring = std::make_unique<ring_type>();
+	can::interfaces::receive_thread<ring_type> receiver(file, *ring, 10);
+	ASSERT_TRUE(receiver.start());
+
+	can::Message messages[10];
+	ASSERT_EQ(drain(*ring, messages, 10), 10u);
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	auto start = std::chrono::steady_clock::now();
+	receiver.stop();
+	EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+	EXPECT_EQ(receiver.received(), 10u);
+	EXPECT_LT(file.requests.load(), 50u);
+	std::filesystem::remove(path);
+}
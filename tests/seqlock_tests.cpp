@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the sequence lock
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <utility/include/seqlock.h>
+
+namespace
+{
+	// Every field holds the same value, so torn copies are detected
+	struct record
+	{
+		uint64_t values[7];
+		uint8_t tail;
+	};
+}
+
+TEST(seqlock, initial_value_is_default)
+{
+	utility::seqlock<record> lock;
+	auto value = lock.load();
+
+	EXPECT_EQ(value.values[0], 0u);
+	EXPECT_EQ(value.tail, 0);
+	EXPECT_EQ(lock.version(), 0u);
+}
+
+TEST(seqlock, load_returns_stored_value)
+{
+	utility::seqlock<record> lock;
+	record value{ { 1, 2, 3, 4, 5, 6, 7 }, 8 };
+	lock.store(value);
+
+	auto loaded = lock.load();
+	for(int i = 0; i < 7; i++)
+		EXPECT_EQ(loaded.values[i], value.values[i]);
+	EXPECT_EQ(loaded.tail, 8);
+	EXPECT_EQ(lock.version(), 1u);
+
+	record tried{};
+	EXPECT_TRUE(lock.try_load(tried));
+	EXPECT_EQ(tried.values[6], 7u);
+}
+
+TEST(seqlock, readers_never_see_torn_values)
+{
+	utility::seqlock<record> lock;
+	std::atomic<bool> done{ false };
+	std::atomic<uint64_t> torn{ 0 };
+
+	std::vector<std::thread> readers;
+	for(int r = 0; r < 3; r++)
+		readers.emplace_back([&]()
+		{
+			uint64_t last = 0;
+			while(!done.load(std::memory_order_relaxed))
+			{
+				auto value = lock.load();
+				for(int i = 1; i < 7; i++)
+					if(value.values[i] != value.values[0])
+						torn++;
+				if(value.tail != static_cast<uint8_t>(value.values[0]) || value.values[0] < last)
+					torn++;
+				last = value.values[0];
+			}
+		});
+
+	for(uint64_t n = 1; n <= 200000; n++)
+	{
+		record value;
+		for(auto& v : value.values)
+			v = n;
+		value.tail = static_cast<uint8_t>(n);
+		lock.store(value);
+	}
+	done = true;
+
+	for(auto& reader : readers)
+		reader.join();
+	EXPECT_EQ(torn.load(), 0u);
+	EXPECT_EQ(lock.version(), 200000u);
+}
@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////
+// Tests for the timestamp conversions and clock alignment
+///////////////////////////////////////////////////////////////////////
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+#include <can/include/timestamp.h>
+
+TEST(Timestamp, nanosecond_conversions)
+{
+	EXPECT_EQ(can::to_nanoseconds(timespec{ 12, 345678901 }), 12345678901);
+
+	auto time = can::to_timespec(12345678901);
+	EXPECT_EQ(time.tv_sec, 12);
+	EXPECT_EQ(time.tv_nsec, 345678901);
+
+	// Nanoseconds stay positive before the epoch
+	time = can::to_timespec(-1);
+	EXPECT_EQ(time.tv_sec, -1);
+	EXPECT_EQ(time.tv_nsec, 999999999);
+	EXPECT_EQ(can::to_nanoseconds(time), -1);
+
+	static_assert(can::to_nanoseconds(can::to_timespec(1500000000)) == 1500000000);
+}
+
+TEST(Timestamp, realtime_to_monotonic)
+{
+	timespec realtime;
+	clock_gettime(CLOCK_REALTIME, &realtime);
+	auto expected = can::clock_nanoseconds(CLOCK_MONOTONIC);
+
+	// Within a millisecond, allowing for a preempted test
+	EXPECT_LT(std::llabs(can::to_monotonic(realtime) - expected), 1000000);
+
+	auto offset = can::monotonic_offset();
+	EXPECT_LT(std::llabs(offset - can::monotonic_offset()), 1000000);
+}
+
+TEST(Timestamp, alignment_is_invalid_without_samples)
+{
+	can::clock_alignment alignment;
+	EXPECT_FALSE(alignment.valid());
+	EXPECT_EQ(alignment.offset(), 0);
+	EXPECT_EQ(alignment.to_reference(100), 100);
+}
+
+// The reference clock reads later by a varying delay - the smallest difference is the offset
+TEST(Timestamp, alignment_uses_the_smallest_delay)
+{
+	can::clock_alignment alignment(std::chrono::milliseconds(100));
+	const int64_t offset = 5000000000;
+	const int64_t delays[] = { 30000, 12000, 45000, 8000, 20000 };
+
+	int64_t source = 1000000;
+	for(auto delay : delays)
+	{
+		alignment.update(source, source + offset + delay);
+		source += 1000000;
+	}
+
+	ASSERT_TRUE(alignment.valid());
+	EXPECT_EQ(alignment.offset(), offset + 8000);
+	EXPECT_EQ(alignment.to_reference(2000000), 2000000 + offset + 8000);
+}
+
+// Older windows are forgotten, so the estimate follows a drifting clock
+TEST(Timestamp, alignment_follows_drift)
+{
+	can::clock_alignment alignment(std::chrono::milliseconds(10));
+	alignment.update(0, 1000);
+	EXPECT_EQ(alignment.offset(), 1000);
+
+	// The next window still includes the previous one
+	alignment.update(10000000, 10000000 + 1500);
+	EXPECT_EQ(alignment.offset(), 1000);
+
+	// Two windows later the first one is gone
+	alignment.update(20000000, 20000000 + 2000);
+	EXPECT_EQ(alignment.offset(), 1500);
+
+	// A source clock going back starts over
+	alignment.update(0, 3000);
+	EXPECT_EQ(alignment.offset(), 3000);
+
+	alignment.reset();
+	EXPECT_FALSE(alignment.valid());
+}